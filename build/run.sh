@@ -6,8 +6,8 @@ echo ""
 echo "Escolha qual servidor executar:"
 echo "1 - Servidor Central"
 echo "2 - Servidor Térreo"
-echo "3 - Servidor 1º Andar"
-echo "4 - Servidor 2º Andar"
+echo "3 - Servidor dos Andares (todos do site.conf)"
+echo "4 - Servidor de um Andar"
 echo "0 - Sair"
 echo ""
 read -p "Opção: " opt
@@ -15,8 +15,8 @@ read -p "Opção: " opt
 case $opt in
     1) ./servidor_central_mock ;;
     2) ./servidor_terreo_mock ;;
-    3) ./servidor_andar1_mock ;;
-    4) ./servidor_andar2_mock ;;
+    3) ./servidor_andar_mock ;;
+    4) read -p "Andar: " andar; ./servidor_andar_mock "$andar" ;;
     0) echo "Saindo..." ;;
     *) echo "Opção inválida" ;;
 esac
@@ -10,12 +10,8 @@ sleep 1
 echo "✓ Servidor Térreo iniciado (PID: $!)"
 sleep 1
 
-./servidor_andar1_mock > logs/andar1.log 2>&1 &
-echo "✓ Servidor 1º Andar iniciado (PID: $!)"
-sleep 1
-
-./servidor_andar2_mock > logs/andar2.log 2>&1 &
-echo "✓ Servidor 2º Andar iniciado (PID: $!)"
+./servidor_andar_mock > logs/andar.log 2>&1 &
+echo "✓ Servidor dos Andares iniciado (PID: $!)"
 
 echo ""
 echo "✓ Todos os servidores iniciados!"
@@ -2,6 +2,5 @@
 echo "Parando servidores..."
 pkill -f servidor_central_mock
 pkill -f servidor_terreo_mock
-pkill -f servidor_andar1_mock
-pkill -f servidor_andar2_mock
+pkill -f servidor_andar_mock
 echo "✓ Servidores parados"
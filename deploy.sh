@@ -39,8 +39,8 @@ echo ""
 echo "Escolha qual servidor executar:"
 echo "1 - Servidor Central"
 echo "2 - Servidor Térreo"
-echo "3 - Servidor 1º Andar"
-echo "4 - Servidor 2º Andar"
+echo "3 - Servidor dos Andares (todos do site.conf)"
+echo "4 - Servidor de um Andar"
 echo "0 - Sair"
 echo ""
 read -p "Opção: " opt
@@ -48,8 +48,8 @@ read -p "Opção: " opt
 case $opt in
     1) ./servidor_central_mock ;;
     2) ./servidor_terreo_mock ;;
-    3) ./servidor_andar1_mock ;;
-    4) ./servidor_andar2_mock ;;
+    3) ./servidor_andar_mock ;;
+    4) read -p "Andar: " andar; ./servidor_andar_mock "$andar" ;;
     0) echo "Saindo..." ;;
     *) echo "Opção inválida" ;;
 esac
@@ -69,12 +69,8 @@ sleep 1
 echo "✓ Servidor Térreo iniciado (PID: $!)"
 sleep 1
 
-./servidor_andar1_mock > logs/andar1.log 2>&1 &
-echo "✓ Servidor 1º Andar iniciado (PID: $!)"
-sleep 1
-
-./servidor_andar2_mock > logs/andar2.log 2>&1 &
-echo "✓ Servidor 2º Andar iniciado (PID: $!)"
+./servidor_andar_mock > logs/andar.log 2>&1 &
+echo "✓ Servidor dos Andares iniciado (PID: $!)"
 
 echo ""
 echo "✓ Todos os servidores iniciados!"
@@ -92,8 +88,7 @@ cat > build/stop_all.sh << 'EOF'
 echo "Parando servidores..."
 pkill -f servidor_central_mock
 pkill -f servidor_terreo_mock
-pkill -f servidor_andar1_mock
-pkill -f servidor_andar2_mock
+pkill -f servidor_andar_mock
 echo "✓ Servidores parados"
 EOF
 
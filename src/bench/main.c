@@ -0,0 +1,361 @@
+/**
+ * @file bench/main.c
+ * @brief Benchmark do caminho quente sobre os backends mock
+ *
+ * Gera chegadas de Poisson e permanências exponenciais: cada chegada faz a
+ * captura LPR, aloca a vaga, ocupa o sensor simulado e abre a cancela de
+ * entrada; cada saída faz o checkout, libera o sensor e abre a de saída.
+ * Todos os andares são varridos a cada passo e o placar é atualizado a
+ * cada BENCH_DISPLAY_US. No fim imprime os histogramas de metrics.c e a
+ * vazão.
+ *
+ * Uso: bench [-d segundos] [-r chegadas/s] [-m permanência média s]
+ *            [-s semente] [-p orçamento p99 da varredura em µs]
+ * Termina com código 1 se algum histograma de metrics.c ficar sem amostras
+ * ou, com -p, se o p99 da varredura passar do orçamento.
+ */
+
+#include "parking_system.h"
+#include "system_logger.h"
+#include "gpio_control.h"
+#include "gate_control.h"
+#include "parking_logic.h"
+#include "site_config.h"
+#include "modbus_client.h"
+#include "metrics.h"
+#include <math.h>
+
+#define BENCH_TICK_US       10000   // Passo da simulação (uma varredura por andar)
+#define BENCH_GATE_HOLD_US  100000  // Cancela aberta após a última passagem
+#define BENCH_DISPLAY_US    1000000 // Intervalo de atualização do placar
+#define BENCH_MAX_VEHICLES  (MAX_FLOORS * MAX_PARKING_SPOTS_PER_FLOOR)
+
+typedef struct {
+    char plate[9];
+    uint64_t leave_us;
+} bench_vehicle_t;
+
+typedef struct {
+    gate_type_t type;
+    bool wanted;            // Passagem aguardando a cancela abrir
+    uint64_t hold_until_us;
+} bench_gate_t;
+
+static parking_status_t status;
+static bench_vehicle_t vehicles[BENCH_MAX_VEHICLES];
+static int vehicle_count = 0;
+static unsigned int seed = 1;
+
+// Latências do próprio benchmark (fora do registro do processo)
+static metrics_hist_t allocate_hist;
+static metrics_hist_t checkout_hist;
+
+static struct {
+    uint32_t arrivals;
+    uint32_t rejected;
+    uint32_t departures;
+    uint32_t scans;
+    uint32_t gate_errors;
+    uint32_t display_errors;
+} counters;
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+/**
+ * @brief Intervalo exponencial de média mean_us
+ */
+static uint64_t exponential_us(double mean_us) {
+    double u = ((double)rand_r(&seed) + 1.0) / ((double)RAND_MAX + 2.0);
+    return (uint64_t)(-log(u) * mean_us);
+}
+
+static void on_plate(camera_type_t camera, const plate_reading_t* result, int status_code,
+                     void* user_data) {
+    (void)camera;
+    (void)result;
+    (void)status_code;
+    *(bool*)user_data = true;
+}
+
+/**
+ * @brief Captura LPR pelo backend (mock: responde na própria chamada)
+ */
+static void capture_plate(camera_type_t camera) {
+    bool done = false;
+    uint64_t start_us = metrics_now_us();
+    if (modbus_camera_capture_async(camera, on_plate, &done) == 0 && done) {
+        metrics_observe_since(METRIC_LPR_ROUNDTRIP_US, start_us);
+    }
+}
+
+/**
+ * @brief Abre a cancela pedida e fecha as ociosas
+ */
+static void gate_step(bench_gate_t* gate, uint64_t now_us) {
+    switch (gate_get_state(gate->type)) {
+        case GATE_STATE_CLOSED:
+            if (gate->wanted) gate_open(gate->type);
+            break;
+        case GATE_STATE_OPEN:
+            gate->wanted = false;
+            if (now_us >= gate->hold_until_us) gate_close(gate->type);
+            break;
+        case GATE_STATE_ERROR:
+            counters.gate_errors++;
+            gate_reset_error(gate->type);
+            break;
+        default:
+            break;
+    }
+}
+
+static void request_gate(bench_gate_t* gate, uint64_t now_us) {
+    gate->wanted = true;
+    gate->hold_until_us = now_us + BENCH_GATE_HOLD_US;
+}
+
+static void vehicle_arrive(uint64_t now_us, double dwell_us, bench_gate_t* entry) {
+    bench_vehicle_t* v = &vehicles[vehicle_count];
+    snprintf(v->plate, sizeof(v->plate), "BEN%05u", counters.arrivals % 100000u);
+    counters.arrivals++;
+    
+    capture_plate(CAMERA_ENTRADA);
+    
+    // 5% PNE, 10% idoso, o resto comum; andar preferido sorteado
+    int roll = rand_r(&seed) % 100;
+    spot_type_t type = (roll < 5) ? SPOT_TYPE_PNE : (roll < 15) ? SPOT_TYPE_IDOSO : SPOT_TYPE_COMUM;
+    floor_id_t floor = (floor_id_t)(rand_r(&seed) % status.num_floors);
+    
+    uint64_t start_us = metrics_now_us();
+    bool ok = parking_allocate_spot(&status, v->plate, type, floor);
+    metrics_hist_record(&allocate_hist, (uint32_t)(metrics_now_us() - start_us));
+    
+    const vehicle_record_t* record = ok ? parking_find_vehicle(&status, v->plate) : NULL;
+    if (!record) {
+        counters.rejected++;
+        return;
+    }
+    
+    gpio_mock_set_spot((uint8_t)record->floor, record->spot, true);
+    v->leave_us = now_us + exponential_us(dwell_us);
+    vehicle_count++;
+    request_gate(entry, now_us);
+}
+
+static void vehicle_leave(int index, uint64_t now_us, bench_gate_t* exit_gate) {
+    bench_vehicle_t* v = &vehicles[index];
+    
+    capture_plate(CAMERA_SAIDA);
+    
+    vehicle_record_t record;
+    uint64_t start_us = metrics_now_us();
+    bool ok = parking_checkout_vehicle(&status, v->plate, &record);
+    metrics_hist_record(&checkout_hist, (uint32_t)(metrics_now_us() - start_us));
+    
+    if (ok) {
+        gpio_mock_set_spot((uint8_t)record.floor, record.spot, false);
+        counters.departures++;
+        request_gate(exit_gate, now_us);
+    }
+    
+    vehicles[index] = vehicles[--vehicle_count];
+}
+
+/**
+ * @brief Escreve as vagas livres no placar (transação com o escravo do display)
+ */
+static void update_display(void) {
+    display_info_t info;
+    memset(&info, 0, sizeof(info));
+    uint8_t* floors[3][3] = {
+        { &info.terreo_pne, &info.terreo_idoso, &info.terreo_comum },
+        { &info.andar1_pne, &info.andar1_idoso, &info.andar1_comum },
+        { &info.andar2_pne, &info.andar2_idoso, &info.andar2_comum },
+    };
+    for (int f = 0; f < status.num_floors && f < 3; f++) {
+        const floor_status_t* fl = &status.floors[f];
+        *floors[f][0] = (uint8_t)(fl->free_pne > 255 ? 255 : fl->free_pne);
+        *floors[f][1] = (uint8_t)(fl->free_idoso > 255 ? 255 : fl->free_idoso);
+        *floors[f][2] = (uint8_t)(fl->free_comum > 255 ? 255 : fl->free_comum);
+    }
+    info.total_pne = (uint8_t)(status.total_free_pne > 255 ? 255 : status.total_free_pne);
+    info.total_idoso = (uint8_t)(status.total_free_idoso > 255 ? 255 : status.total_free_idoso);
+    info.total_comum = (uint8_t)(status.total_free_comum > 255 ? 255 : status.total_free_comum);
+    info.lotado_geral = status.system_full;
+    if (modbus_display_update(&info) != 0) {
+        counters.display_errors++;
+    }
+}
+
+static void hist_label(metric_hist_id_t id, char* name, size_t size) {
+    const char* labels = metrics_hist_labels(id);
+    snprintf(name, size, labels[0] ? "%s{%s}" : "%s", metrics_hist_name(id), labels);
+}
+
+static void print_hist(const char* name, const metrics_hist_t* hist) {
+    if (hist->count == 0) {
+        printf("  %-36s %10s\n", name, "sem amostras");
+        return;
+    }
+    printf("  %-36s %10llu %10u %10u %10u %10u\n", name, (unsigned long long)hist->count,
+           metrics_hist_percentile(hist, 50.0), metrics_hist_percentile(hist, 90.0),
+           metrics_hist_percentile(hist, 99.0), hist->max);
+}
+
+static void print_report(double elapsed_s) {
+    printf("\n  %-36s %10s %10s %10s %10s %10s\n", "histograma", "amostras", "p50", "p90", "p99", "máx.");
+    for (int id = 0; id < METRIC_HIST_COUNT; id++) {
+        metrics_hist_t hist;
+        char name[64];
+        hist_label((metric_hist_id_t)id, name, sizeof(name));
+        metrics_get_hist((metric_hist_id_t)id, &hist);
+        print_hist(name, &hist);
+    }
+    print_hist("bench_allocate_us", &allocate_hist);
+    print_hist("bench_checkout_us", &checkout_hist);
+    
+    printf("\n  %-36s %10s %10s\n", "medidor", "atual", "máx.");
+    for (int id = 0; id < METRIC_GAUGE_COUNT; id++) {
+        metrics_gauge_t gauge;
+        metrics_get_gauge((metric_gauge_id_t)id, &gauge);
+        printf("  %-36s %10u %10u\n", metrics_gauge_name((metric_gauge_id_t)id), gauge.value, gauge.max);
+    }
+    
+    printf("\n  %.1f s: %u chegadas (%u recusadas), %u saídas, %u varreduras, %u erros de cancela, "
+           "%u erros de placar\n", elapsed_s, counters.arrivals, counters.rejected,
+           counters.departures, counters.scans, counters.gate_errors, counters.display_errors);
+    printf("  Vazão: %.1f veículos/s, %.0f varreduras/s\n",
+           (counters.arrivals - counters.rejected + counters.departures) / elapsed_s,
+           counters.scans / elapsed_s);
+}
+
+// =============================================================================
+// FUNÇÃO PRINCIPAL
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    double duration_s = 10.0;
+    double rate = 5.0;
+    double dwell_s = 3.0;
+    long scan_budget_us = -1;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "d:r:m:s:p:")) != -1) {
+        switch (opt) {
+            case 'd': duration_s = atof(optarg); break;
+            case 'r': rate = atof(optarg); break;
+            case 'm': dwell_s = atof(optarg); break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'p': scan_budget_us = strtol(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Uso: %s [-d segundos] [-r chegadas/s] [-m permanência s] "
+                        "[-s semente] [-p orçamento p99 µs]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (duration_s <= 0 || rate <= 0 || dwell_s <= 0) {
+        fprintf(stderr, "Duração, taxa e permanência devem ser positivas\n");
+        return 2;
+    }
+    
+    // Só o arquivo: o console fica para o relatório
+    logger_set_console(false);
+    if (logger_init(LOG_DIR) != 0) {
+        fprintf(stderr, "Falha ao iniciar logger\n");
+        return 1;
+    }
+    if (site_config_load(NULL) != 0) {
+        fprintf(stderr, "Topologia do estacionamento inválida\n");
+        logger_cleanup();
+        return 1;
+    }
+    
+    gpio_init();
+    gate_system_init();
+    modbus_init(MODBUS_DEFAULT_DEVICE, MODBUS_DEFAULT_BAUDRATE);
+    parking_init(&status);
+    metrics_reset();
+    
+    printf("Benchmark: %.0f s, %.1f chegadas/s, permanência média %.1f s, semente %u, "
+           "%u andares / %u vagas\n", duration_s, rate, dwell_s, seed,
+           site_floor_count(), site_total_spots());
+    
+    bench_gate_t entry = { GATE_ENTRY, false, 0 };
+    bench_gate_t exit_gate = { GATE_EXIT, false, 0 };
+    double arrival_mean_us = 1e6 / rate;
+    double dwell_us = dwell_s * 1e6;
+    
+    uint64_t start_us = metrics_now_us();
+    uint64_t end_us = start_us + (uint64_t)(duration_s * 1e6);
+    uint64_t next_arrival_us = start_us + exponential_us(arrival_mean_us);
+    uint64_t next_display_us = start_us;
+    uint64_t now_us;
+    
+    while ((now_us = metrics_now_us()) < end_us) {
+        while (next_arrival_us <= now_us) {
+            if (vehicle_count < BENCH_MAX_VEHICLES) {
+                vehicle_arrive(now_us, dwell_us, &entry);
+            }
+            next_arrival_us += exponential_us(arrival_mean_us);
+        }
+    
+        for (int i = vehicle_count - 1; i >= 0; i--) {
+            if (vehicles[i].leave_us <= now_us) {
+                vehicle_leave(i, now_us, &exit_gate);
+            }
+        }
+    
+        for (uint8_t f = 0; f < status.num_floors; f++) {
+            parking_scan_floor((floor_id_t)f, &site_floor((floor_id_t)f)->gpio, &status.floors[f]);
+            counters.scans++;
+        }
+    
+        gate_step(&entry, now_us);
+        gate_step(&exit_gate, now_us);
+    
+        if (now_us >= next_display_us) {
+            update_display();
+            next_display_us = now_us + BENCH_DISPLAY_US;
+        }
+    
+        uint64_t next_tick_us = now_us + BENCH_TICK_US;
+        uint64_t after_us = metrics_now_us();
+        if (after_us < next_tick_us) {
+            usleep((useconds_t)(next_tick_us - after_us));
+        }
+    }
+    
+    print_report((double)(metrics_now_us() - start_us) / 1e6);
+    
+    // Histograma vazio: o caminho medido não rodou ou o backend não o instrumenta
+    int exit_code = 0;
+    for (int id = 0; id < METRIC_HIST_COUNT; id++) {
+        metrics_hist_t hist;
+        metrics_get_hist((metric_hist_id_t)id, &hist);
+        if (hist.count == 0) {
+            char name[64];
+            hist_label((metric_hist_id_t)id, name, sizeof(name));
+            printf("  Histograma %s sem amostras\n", name);
+            exit_code = 1;
+        }
+    }
+    
+    if (scan_budget_us >= 0) {
+        metrics_hist_t scan;
+        metrics_get_hist(METRIC_SCAN_FLOOR_US, &scan);
+        uint32_t p99 = metrics_hist_percentile(&scan, 99.0);
+        bool within = p99 <= (uint32_t)scan_budget_us;
+        printf("  Varredura p99 %u µs %s orçamento de %ld µs\n", p99,
+               within ? "dentro do" : "ACIMA do", scan_budget_us);
+        if (!within) exit_code = 1;
+    }
+    
+    gate_system_cleanup();
+    modbus_cleanup();
+    gpio_cleanup();
+    logger_cleanup();
+    
+    return exit_code;
+}
@@ -1,126 +1,358 @@
 /**
  * @file gate_control.c
  * @brief Sistema de controle das cancelas de entrada e saída
+ *
+ * Um único reator atende todas as cancelas: bordas dos sensores (alerta do
+ * pigpio) e prazos numa roda de temporizadores acordam a mesma thread, que
+ * dorme enquanto nenhuma cancela se move. Sem alertas, os sensores são lidos
+ * a cada GATE_POLL_INTERVAL_MS apenas durante a abertura/fechamento.
  */
 
 #include "gate_control.h"
 #include "system_logger.h"
 #include "gpio_control.h"
+#include "metrics.h"
 #include <pthread.h>
 #include <unistd.h>
+#include <errno.h>
 
-typedef struct {
+#if (GATE_WHEEL_SLOTS & (GATE_WHEEL_SLOTS - 1)) != 0
+#error "GATE_WHEEL_SLOTS deve ser potência de 2"
+#endif
+
+#define GATE_COUNT 2
+
+// =============================================================================
+// RODA DE TEMPORIZADORES
+// =============================================================================
+
+struct gate_control;
+
+typedef struct gate_timer {
+    struct gate_timer* next;
+    struct gate_timer* prev;
+    uint64_t deadline_ms;       // CLOCK_MONOTONIC
+    bool armed;
+    struct gate_control* gate;
+    void (*expire)(struct gate_control* gate, uint64_t now_ms);
+} gate_timer_t;
+
+typedef struct gate_control {
     gate_state_t state;
     uint8_t motor_pin;
     uint8_t sensor_open_pin;
     uint8_t sensor_close_pin;
-    pthread_mutex_t mutex;
-    pthread_t control_thread;
-    bool thread_running;
+    bool sensor_open;           // Último nível conhecido (alerta ou leitura)
+    bool sensor_close;
+    bool edge_pending;          // Borda ainda não processada pelo reator
+    bool watched;               // Sensores entregues por alerta
+    bool motor_on;
+    gate_timer_t timeout;       // Prazo de GATE_TIMEOUT_MS do movimento
+    gate_timer_t poll;          // Leitura periódica (só sem alertas)
+    uint64_t motion_start_ms;
     time_t last_operation;
     uint32_t operation_count;
     gate_type_t gate_type;
 } gate_control_t;
 
-static gate_control_t entry_gate = {0};
-static gate_control_t exit_gate = {0};
+// Estado compartilhado por todas as cancelas e pelo reator
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                    // CLOCK_MONOTONIC
+    pthread_t thread;
+    bool running;
+    bool pending;                           // Borda ou comando a processar
+    gate_timer_t* slots[GATE_WHEEL_SLOTS];
+    uint64_t wheel_tick;                    // Último tick já encerrado
+    gate_control_t gates[GATE_COUNT];
+} reactor;
+
+// Fora do reator: pode ser definido antes de gate_system_init
+static gate_state_callback_t state_callback = NULL;
+static void* state_user_data = NULL;
+
 static bool gates_initialized = false;
 
+static uint64_t monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000u + (uint64_t)now.tv_nsec / 1000000u;
+}
+
+static const char* gate_name(const gate_control_t* gate) {
+    return (gate->gate_type == GATE_ENTRY) ? "ENTRADA" : "SAÍDA";
+}
+
+static gate_control_t* gate_for(gate_type_t gate_type) {
+    return &reactor.gates[gate_type == GATE_ENTRY ? GATE_ENTRY : GATE_EXIT];
+}
+
 /**
- * @brief 
+ * @brief Remove um temporizador da roda (nada se não estiver armado)
  */
-static void* gate_control_thread(void* arg) {
-    gate_control_t* gate = (gate_control_t*)arg;
-    const char* gate_name = (gate->gate_type == GATE_ENTRY) ? "ENTRADA" : "SAÍDA";
+static void timer_cancel(gate_timer_t* timer) {
+    if (!timer->armed) return;
     
-    LOG_INFO("GATE", "Thread de controle da cancela %s iniciada", gate_name);
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        reactor.slots[(timer->deadline_ms / GATE_WHEEL_TICK_MS) & (GATE_WHEEL_SLOTS - 1)] = timer->next;
+    }
+    if (timer->next) {
+        timer->next->prev = timer->prev;
+    }
+    timer->next = timer->prev = NULL;
+    timer->armed = false;
+}
+
+/**
+ * @brief (Re)arma um temporizador para now_ms + delay_ms
+ *
+ * O slot é o tick do prazo módulo GATE_WHEEL_SLOTS; prazos além de uma volta
+ * ficam no slot e só expiram quando o tick for alcançado.
+ */
+static void timer_arm(gate_timer_t* timer, uint64_t now_ms, uint32_t delay_ms) {
+    timer_cancel(timer);
+    
+    timer->deadline_ms = now_ms + delay_ms;
+    gate_timer_t** slot = &reactor.slots[(timer->deadline_ms / GATE_WHEEL_TICK_MS) & (GATE_WHEEL_SLOTS - 1)];
+    timer->prev = NULL;
+    timer->next = *slot;
+    if (*slot) {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+    timer->armed = true;
+}
+
+/**
+ * @brief Expira os temporizadores vencidos até now_ms
+ *
+ * Percorre os slots dos ticks desde o último completo até o atual; o tick
+ * atual fica para a próxima chamada, pois ainda pode receber prazos.
+ */
+static void wheel_advance(uint64_t now_ms) {
+    uint64_t now_tick = now_ms / GATE_WHEEL_TICK_MS;
     
-    while (gate->thread_running) {
-        pthread_mutex_lock(&gate->mutex);
-        
-        bool sensor_open = gpio_read_gate_sensor(gate->sensor_open_pin);
-        bool sensor_close = gpio_read_gate_sensor(gate->sensor_close_pin);
+    // Basta uma volta: os slots seguintes repetiriam os mesmos
+    if (now_tick - reactor.wheel_tick > GATE_WHEEL_SLOTS) {
+        reactor.wheel_tick = now_tick - GATE_WHEEL_SLOTS;
+    }
+    
+    for (uint64_t tick = reactor.wheel_tick + 1; tick <= now_tick; tick++) {
+        gate_timer_t** slot = &reactor.slots[tick & (GATE_WHEEL_SLOTS - 1)];
         
-        switch (gate->state) {
-            case GATE_STATE_CLOSED:
-                // Cancela fechada - motor desligado
-                gpio_set_gate_motor(gate->motor_pin, false);
-                break;
-                
-            case GATE_STATE_OPENING:
-                // Abrindo - motor ligado, verifica sensor de abertura
-                gpio_set_gate_motor(gate->motor_pin, true);
-                
-                if (sensor_open) {
-                    gate->state = GATE_STATE_OPEN;
-                    gate->last_operation = time(NULL);
-                    gate->operation_count++;
-                   LOG_INFO("GATE", "Cancela %s ABERTA (operação #%d)", 
-         gate_name, gate->operation_count);
-                }
-                
-                // Timeout de segurança
-                if ((time(NULL) - gate->last_operation) > (GATE_TIMEOUT_MS / 1000)) {
-                    gate->state = GATE_STATE_ERROR;
-                    LOG_ERROR("GATE", "Timeout ao abrir cancela %s", gate_name);
+        // expire() pode armar/cancelar outros temporizadores: recomeça o slot
+        bool fired;
+        do {
+            fired = false;
+            for (gate_timer_t* timer = *slot; timer; timer = timer->next) {
+                if (timer->deadline_ms <= now_ms) {
+                    timer_cancel(timer);
+                    timer->expire(timer->gate, now_ms);
+                    fired = true;
+                    break;
                 }
-                break;
-                
-            case GATE_STATE_OPEN:
-                // Aberta - motor desligado
-                gpio_set_gate_motor(gate->motor_pin, false);
-                break;
-                
-            case GATE_STATE_CLOSING:
-                // Fechando - motor ligado (direção reversa se aplicável)
-                gpio_set_gate_motor(gate->motor_pin, true);
-                
-                if (sensor_close) {
-                    gate->state = GATE_STATE_CLOSED;
-                    gate->last_operation = time(NULL);
-                    gate->operation_count++;
-                    LOG_INFO("GATE", "Cancela %s FECHADA (operação #%d)", 
-                             gate_name, gate->operation_count);
-                }
-                
-                // Timeout de segurança
-                if ((time(NULL) - gate->last_operation) > (GATE_TIMEOUT_MS / 1000)) {
-                    gate->state = GATE_STATE_ERROR;
-                    LOG_ERROR("GATE", "Timeout ao fechar cancela %s", gate_name);
-                }
-                break;
-                
-            case GATE_STATE_ERROR:
-                // Erro - motor desligado, aguarda reset
-                gpio_set_gate_motor(gate->motor_pin, false);
-                LOG_DEBUG("GATE", "Cancela %s em estado de erro", gate_name);
-                break;
+            }
+        } while (fired);
+    }
+    
+    reactor.wheel_tick = now_tick - 1;
+}
+
+/**
+ * @brief Prazo armado mais próximo (UINT64_MAX se a roda está vazia)
+ */
+static uint64_t wheel_next_deadline(void) {
+    uint64_t next = UINT64_MAX;
+    
+    for (int slot = 0; slot < GATE_WHEEL_SLOTS; slot++) {
+        for (gate_timer_t* timer = reactor.slots[slot]; timer; timer = timer->next) {
+            if (timer->deadline_ms < next) {
+                next = timer->deadline_ms;
+            }
         }
+    }
+    return next;
+}
+
+// =============================================================================
+// MÁQUINA DE ESTADOS (reactor.mutex travado)
+// =============================================================================
+
+static void set_state(gate_control_t* gate, gate_state_t state) {
+    gate->state = state;
+    if (state_callback) {
+        state_callback(gate->gate_type, state, state_user_data);
+    }
+}
+
+static void set_motor(gate_control_t* gate, bool on) {
+    if (gate->motor_on == on) return;
+    
+    gate->motor_on = on;
+    gpio_set_gate_motor(gate->motor_pin, on);
+}
+
+/**
+ * @brief Conclui o movimento ao atingir o sensor de fim de curso
+ */
+static void finish_motion(gate_control_t* gate, gate_state_t state, uint64_t now_ms) {
+    set_motor(gate, false);
+    timer_cancel(&gate->timeout);
+    timer_cancel(&gate->poll);
+    
+    set_state(gate, state);
+    gate->last_operation = time(NULL);
+    gate->operation_count++;
+    if (state == GATE_STATE_OPEN) {
+        metrics_observe(METRIC_GATE_OPEN_US, (now_ms - gate->motion_start_ms) * 1000);
+    }
+    
+    LOG_INFO("GATE", "Cancela %s %s em %llu ms (operação #%u)", gate_name(gate),
+             state == GATE_STATE_OPEN ? "ABERTA" : "FECHADA",
+             (unsigned long long)(now_ms - gate->motion_start_ms), gate->operation_count);
+}
+
+/**
+ * @brief Avalia os sensores conhecidos contra o estado atual
+ */
+static void gate_evaluate(gate_control_t* gate, uint64_t now_ms) {
+    if (gate->state == GATE_STATE_OPENING && gate->sensor_open) {
+        finish_motion(gate, GATE_STATE_OPEN, now_ms);
+    } else if (gate->state == GATE_STATE_CLOSING && gate->sensor_close) {
+        finish_motion(gate, GATE_STATE_CLOSED, now_ms);
+    }
+}
+
+static void read_sensors(gate_control_t* gate) {
+    gate->sensor_open = gpio_read_gate_sensor(gate->sensor_open_pin);
+    gate->sensor_close = gpio_read_gate_sensor(gate->sensor_close_pin);
+}
+
+static void on_timeout(gate_control_t* gate, uint64_t now_ms) {
+    (void)now_ms;
+    if (gate->state != GATE_STATE_OPENING && gate->state != GATE_STATE_CLOSING) return;
+    
+    bool opening = (gate->state == GATE_STATE_OPENING);
+    set_motor(gate, false);
+    timer_cancel(&gate->poll);
+    set_state(gate, GATE_STATE_ERROR);
+    LOG_ERROR("GATE", "Timeout ao %s cancela %s", opening ? "abrir" : "fechar", gate_name(gate));
+}
+
+static void on_poll(gate_control_t* gate, uint64_t now_ms) {
+    read_sensors(gate);
+    gate_evaluate(gate, now_ms);
+    
+    if (gate->state == GATE_STATE_OPENING || gate->state == GATE_STATE_CLOSING) {
+        timer_arm(&gate->poll, now_ms, GATE_POLL_INTERVAL_MS);
+    }
+}
+
+/**
+ * @brief Inicia abertura ou fechamento: motor, prazo e (sem alerta) leitura
+ */
+static void start_motion(gate_control_t* gate, gate_state_t state) {
+    uint64_t now_ms = monotonic_ms();
+    
+    set_state(gate, state);
+    gate->motion_start_ms = now_ms;
+    gate->last_operation = time(NULL);
+    
+    // Fechando: motor ligado (direção reversa se aplicável)
+    set_motor(gate, true);
+    timer_arm(&gate->timeout, now_ms, GATE_TIMEOUT_MS);
+    if (!gate->watched) {
+        read_sensors(gate);
+        timer_arm(&gate->poll, now_ms, GATE_POLL_INTERVAL_MS);
+    }
+    
+    // O fim de curso pode já estar ativo: o reator avalia na hora
+    gate->edge_pending = true;
+    reactor.pending = true;
+    pthread_cond_signal(&reactor.cond);
+}
+
+/**
+ * @brief Borda de sensor de cancela (thread do pigpio)
+ */
+static void sensor_edge(uint8_t pin, bool active, uint64_t time_us, void* userdata) {
+    gate_control_t* gate = (gate_control_t*)userdata;
+    (void)time_us;
+    
+    pthread_mutex_lock(&reactor.mutex);
+    if (pin == gate->sensor_open_pin) {
+        gate->sensor_open = active;
+    } else if (pin == gate->sensor_close_pin) {
+        gate->sensor_close = active;
+    }
+    gate->edge_pending = true;
+    reactor.pending = true;
+    pthread_cond_signal(&reactor.cond);
+    pthread_mutex_unlock(&reactor.mutex);
+}
+
+// =============================================================================
+// REATOR
+// =============================================================================
+
+static void* gate_reactor_thread(void* arg) {
+    (void)arg;
+    
+    LOG_INFO("GATE", "Reator das cancelas iniciado");
+    
+    pthread_mutex_lock(&reactor.mutex);
+    reactor.wheel_tick = monotonic_ms() / GATE_WHEEL_TICK_MS - 1;
+    
+    while (reactor.running) {
+        uint64_t now_ms = monotonic_ms();
+        
+        reactor.pending = false;
+        for (int i = 0; i < GATE_COUNT; i++) {
+            gate_control_t* gate = &reactor.gates[i];
+            if (gate->edge_pending) {
+                gate->edge_pending = false;
+                gate_evaluate(gate, now_ms);
+            }
+        }
+        
+        wheel_advance(now_ms);
         
-        pthread_mutex_unlock(&gate->mutex);
+        if (reactor.pending) {
+            continue;
+        }
         
-        // Sleep de 100ms
-        usleep(100000);
+        // Sem movimento a roda fica vazia e a thread dorme até um comando
+        uint64_t next = wheel_next_deadline();
+        if (next == UINT64_MAX) {
+            pthread_cond_wait(&reactor.cond, &reactor.mutex);
+        } else {
+            struct timespec deadline;
+            deadline.tv_sec = (time_t)(next / 1000u);
+            deadline.tv_nsec = (long)(next % 1000u) * 1000000L;
+            pthread_cond_timedwait(&reactor.cond, &reactor.mutex, &deadline);
+        }
     }
     
-    LOG_INFO("GATE", "Thread de controle da cancela %s finalizada", gate_name);
+    pthread_mutex_unlock(&reactor.mutex);
+    
+    LOG_INFO("GATE", "Reator das cancelas finalizado");
     return NULL;
 }
 
 /**
  * @brief Inicializa uma cancela específica
  */
-static int init_gate(gate_control_t* gate, gate_type_t type) {
+static void init_gate(gate_control_t* gate, gate_type_t type) {
+    memset(gate, 0, sizeof(*gate));
     gate->gate_type = type;
     gate->state = GATE_STATE_CLOSED;
     gate->last_operation = time(NULL);
-    gate->operation_count = 0;
-    gate->thread_running = true;
-    
-    if (pthread_mutex_init(&gate->mutex, NULL) != 0) {
-        LOG_ERROR("GATE", "Erro ao inicializar mutex da cancela %d", type);
-        return -1;
-    }
+    gate->timeout.gate = gate;
+    gate->timeout.expire = on_timeout;
+    gate->poll.gate = gate;
+    gate->poll.expire = on_poll;
     
     // Configura pinos conforme o tipo
     if (type == GATE_ENTRY) {
@@ -133,14 +365,25 @@ static int init_gate(gate_control_t* gate, gate_type_t type) {
         gate->sensor_close_pin = GPIO_TERREO_SENSOR_FECHAMENTO_SAIDA;
     }
     
-    // Inicia thread de controle
-    if (pthread_create(&gate->control_thread, NULL, gate_control_thread, gate) != 0) {
-        LOG_ERROR("GATE", "Erro ao criar thread da cancela %d", type);
-        pthread_mutex_destroy(&gate->mutex);
-        return -1;
+    gpio_set_gate_motor(gate->motor_pin, false);
+}
+
+/**
+ * @brief Registra os alertas dos sensores da cancela (reactor.mutex travado)
+ */
+static void watch_gate_sensors(gate_control_t* gate) {
+    if (gpio_input_watch_enable(gate->sensor_open_pin, sensor_edge, gate) == 0 &&
+        gpio_input_watch_enable(gate->sensor_close_pin, sensor_edge, gate) == 0) {
+        gate->watched = true;
+    } else {
+        gpio_input_watch_disable(gate->sensor_open_pin);
+        gate->watched = false;
+        LOG_WARN("GATE", "Alertas indisponíveis na cancela %s - leitura durante o movimento",
+                 gate_name(gate));
     }
     
-    return 0;
+    // Nível inicial; daqui em diante as bordas (ou a leitura periódica) atualizam
+    read_sensors(gate);
 }
 
 // =============================================================================
@@ -155,16 +398,37 @@ int gate_system_init(void) {
     
     LOG_INFO("GATE", "Inicializando sistema de controle de cancelas...");
     
-    // Inicializa cancela de entrada
-    if (init_gate(&entry_gate, GATE_ENTRY) != 0) {
-        LOG_ERROR("GATE", "Erro ao inicializar cancela de entrada");
+    memset(&reactor, 0, sizeof(reactor));
+    
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (pthread_mutex_init(&reactor.mutex, NULL) != 0 ||
+        pthread_cond_init(&reactor.cond, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
+        LOG_ERROR("GATE", "Erro ao inicializar sincronização das cancelas");
         return -1;
     }
+    pthread_condattr_destroy(&attr);
+    
+    init_gate(&reactor.gates[GATE_ENTRY], GATE_ENTRY);
+    init_gate(&reactor.gates[GATE_EXIT], GATE_EXIT);
     
-    // Inicializa cancela de saída
-    if (init_gate(&exit_gate, GATE_EXIT) != 0) {
-        LOG_ERROR("GATE", "Erro ao inicializar cancela de saída");
-        gate_system_cleanup();
+    pthread_mutex_lock(&reactor.mutex);
+    for (int i = 0; i < GATE_COUNT; i++) {
+        watch_gate_sensors(&reactor.gates[i]);
+    }
+    reactor.running = true;
+    pthread_mutex_unlock(&reactor.mutex);
+    
+    if (pthread_create(&reactor.thread, NULL, gate_reactor_thread, NULL) != 0) {
+        LOG_ERROR("GATE", "Erro ao criar thread do reator das cancelas");
+        for (int i = 0; i < GATE_COUNT; i++) {
+            gpio_input_watch_disable(reactor.gates[i].sensor_open_pin);
+            gpio_input_watch_disable(reactor.gates[i].sensor_close_pin);
+        }
+        pthread_cond_destroy(&reactor.cond);
+        pthread_mutex_destroy(&reactor.mutex);
         return -1;
     }
     
@@ -179,26 +443,26 @@ void gate_system_cleanup(void) {
     
     LOG_INFO("GATE", "Finalizando sistema de cancelas...");
     
-    // Para threads
-    entry_gate.thread_running = false;
-    exit_gate.thread_running = false;
-    
-    // Aguarda threads terminarem
-    if (entry_gate.control_thread) {
-        pthread_join(entry_gate.control_thread, NULL);
+    // Alertas primeiro: nenhuma borda chega depois daqui
+    for (int i = 0; i < GATE_COUNT; i++) {
+        gpio_input_watch_disable(reactor.gates[i].sensor_open_pin);
+        gpio_input_watch_disable(reactor.gates[i].sensor_close_pin);
     }
     
-    if (exit_gate.control_thread) {
-        pthread_join(exit_gate.control_thread, NULL);
-    }
+    pthread_mutex_lock(&reactor.mutex);
+    reactor.running = false;
+    pthread_cond_signal(&reactor.cond);
+    pthread_mutex_unlock(&reactor.mutex);
+    
+    pthread_join(reactor.thread, NULL);
     
     // Desliga motores
-    gpio_set_gate_motor(entry_gate.motor_pin, false);
-    gpio_set_gate_motor(exit_gate.motor_pin, false);
+    for (int i = 0; i < GATE_COUNT; i++) {
+        gpio_set_gate_motor(reactor.gates[i].motor_pin, false);
+    }
     
-    // Destroi mutexes
-    pthread_mutex_destroy(&entry_gate.mutex);
-    pthread_mutex_destroy(&exit_gate.mutex);
+    pthread_cond_destroy(&reactor.cond);
+    pthread_mutex_destroy(&reactor.mutex);
     
     gates_initialized = false;
     LOG_INFO("GATE", "Sistema de cancelas finalizado");
@@ -210,28 +474,26 @@ int gate_open(gate_type_t gate_type) {
         return -1;
     }
     
-    gate_control_t* gate = (gate_type == GATE_ENTRY) ? &entry_gate : &exit_gate;
-    const char* gate_name = (gate_type == GATE_ENTRY) ? "ENTRADA" : "SAÍDA";
+    gate_control_t* gate = gate_for(gate_type);
     
-    pthread_mutex_lock(&gate->mutex);
+    pthread_mutex_lock(&reactor.mutex);
     
     if (gate->state == GATE_STATE_ERROR) {
-        LOG_ERROR("GATE", "Cancela %s em estado de erro - não é possível abrir", gate_name);
-        pthread_mutex_unlock(&gate->mutex);
+        LOG_ERROR("GATE", "Cancela %s em estado de erro - não é possível abrir", gate_name(gate));
+        pthread_mutex_unlock(&reactor.mutex);
         return -1;
     }
     
     if (gate->state == GATE_STATE_OPEN || gate->state == GATE_STATE_OPENING) {
-        LOG_INFO("GATE", "Cancela %s já está aberta ou abrindo", gate_name);
-        pthread_mutex_unlock(&gate->mutex);
+        LOG_INFO("GATE", "Cancela %s já está aberta ou abrindo", gate_name(gate));
+        pthread_mutex_unlock(&reactor.mutex);
         return 0;
     }
     
-    LOG_INFO("GATE", "Comando para abrir cancela %s", gate_name);
-    gate->state = GATE_STATE_OPENING;
-    gate->last_operation = time(NULL);
+    LOG_INFO("GATE", "Comando para abrir cancela %s", gate_name(gate));
+    start_motion(gate, GATE_STATE_OPENING);
     
-    pthread_mutex_unlock(&gate->mutex);
+    pthread_mutex_unlock(&reactor.mutex);
     
     return 0;
 }
@@ -242,28 +504,26 @@ int gate_close(gate_type_t gate_type) {
         return -1;
     }
     
-    gate_control_t* gate = (gate_type == GATE_ENTRY) ? &entry_gate : &exit_gate;
-    const char* gate_name = (gate_type == GATE_ENTRY) ? "ENTRADA" : "SAÍDA";
+    gate_control_t* gate = gate_for(gate_type);
     
-    pthread_mutex_lock(&gate->mutex);
+    pthread_mutex_lock(&reactor.mutex);
     
     if (gate->state == GATE_STATE_ERROR) {
-        LOG_ERROR("GATE", "Cancela %s em estado de erro - não é possível fechar", gate_name);
-        pthread_mutex_unlock(&gate->mutex);
+        LOG_ERROR("GATE", "Cancela %s em estado de erro - não é possível fechar", gate_name(gate));
+        pthread_mutex_unlock(&reactor.mutex);
         return -1;
     }
     
     if (gate->state == GATE_STATE_CLOSED || gate->state == GATE_STATE_CLOSING) {
-        LOG_INFO("GATE", "Cancela %s já está fechada ou fechando", gate_name);
-        pthread_mutex_unlock(&gate->mutex);
+        LOG_INFO("GATE", "Cancela %s já está fechada ou fechando", gate_name(gate));
+        pthread_mutex_unlock(&reactor.mutex);
         return 0;
     }
     
-    LOG_INFO("GATE", "Comando para fechar cancela %s", gate_name);
-    gate->state = GATE_STATE_CLOSING;
-    gate->last_operation = time(NULL);
+    LOG_INFO("GATE", "Comando para fechar cancela %s", gate_name(gate));
+    start_motion(gate, GATE_STATE_CLOSING);
     
-    pthread_mutex_unlock(&gate->mutex);
+    pthread_mutex_unlock(&reactor.mutex);
     
     return 0;
 }
@@ -273,11 +533,11 @@ gate_state_t gate_get_state(gate_type_t gate_type) {
         return GATE_STATE_ERROR;
     }
     
-    gate_control_t* gate = (gate_type == GATE_ENTRY) ? &entry_gate : &exit_gate;
+    gate_control_t* gate = gate_for(gate_type);
     
-    pthread_mutex_lock(&gate->mutex);
+    pthread_mutex_lock(&reactor.mutex);
     gate_state_t state = gate->state;
-    pthread_mutex_unlock(&gate->mutex);
+    pthread_mutex_unlock(&reactor.mutex);
     
     return state;
 }
@@ -288,36 +548,47 @@ int gate_reset_error(gate_type_t gate_type) {
         return -1;
     }
     
-    gate_control_t* gate = (gate_type == GATE_ENTRY) ? &entry_gate : &exit_gate;
-    const char* gate_name = (gate_type == GATE_ENTRY) ? "ENTRADA" : "SAÍDA";
+    gate_control_t* gate = gate_for(gate_type);
     
-    pthread_mutex_lock(&gate->mutex);
+    pthread_mutex_lock(&reactor.mutex);
     
     if (gate->state == GATE_STATE_ERROR) {
-        LOG_INFO("GATE", "Resetando erro da cancela %s", gate_name);
+        LOG_INFO("GATE", "Resetando erro da cancela %s", gate_name(gate));
         
         // Determina estado baseado nos sensores
-        bool sensor_open = gpio_read_gate_sensor(gate->sensor_open_pin);
-        bool sensor_close = gpio_read_gate_sensor(gate->sensor_close_pin);
+        read_sensors(gate);
         
-        if (sensor_close) {
-            gate->state = GATE_STATE_CLOSED;
-        } else if (sensor_open) {
-            gate->state = GATE_STATE_OPEN;
+        if (gate->sensor_close) {
+            set_state(gate, GATE_STATE_CLOSED);
+        } else if (gate->sensor_open) {
+            set_state(gate, GATE_STATE_OPEN);
         } else {
             // Estado indeterminado, assume fechada
-            gate->state = GATE_STATE_CLOSED;
+            set_state(gate, GATE_STATE_CLOSED);
         }
         
         gate->last_operation = time(NULL);
-        LOG_INFO("GATE", "Cancela %s resetada para estado: %d", gate_name, gate->state);
+        LOG_INFO("GATE", "Cancela %s resetada para estado: %d", gate_name(gate), gate->state);
     }
     
-    pthread_mutex_unlock(&gate->mutex);
+    pthread_mutex_unlock(&reactor.mutex);
     
     return 0;
 }
 
+void gate_set_state_callback(gate_state_callback_t callback, void* user_data) {
+    if (!gates_initialized) {
+        state_callback = callback;
+        state_user_data = user_data;
+        return;
+    }
+    
+    pthread_mutex_lock(&reactor.mutex);
+    state_callback = callback;
+    state_user_data = user_data;
+    pthread_mutex_unlock(&reactor.mutex);
+}
+
 void gate_emergency_open_all(void) {
     if (!gates_initialized) return;
     
@@ -337,23 +608,23 @@ void gate_print_status(void) {
         "FECHADA", "ABRINDO", "ABERTA", "FECHANDO", "ERRO"
     };
     
+    // Cópia sob a trava; printf fora dela para não atrasar o reator
+    gate_control_t gates[GATE_COUNT];
+    pthread_mutex_lock(&reactor.mutex);
+    memcpy(gates, reactor.gates, sizeof(gates));
+    pthread_mutex_unlock(&reactor.mutex);
+    
     printf("\n=== STATUS DAS CANCELAS ===\n");
     
-    pthread_mutex_lock(&entry_gate.mutex);
-    printf("ENTRADA: %s (operações: %d)\n", 
-           state_names[entry_gate.state], entry_gate.operation_count);
-    printf("  Sensores: Abertura=%s, Fechamento=%s\n",
-           gpio_read_gate_sensor(entry_gate.sensor_open_pin) ? "ATIVO" : "INATIVO",
-           gpio_read_gate_sensor(entry_gate.sensor_close_pin) ? "ATIVO" : "INATIVO");
-    pthread_mutex_unlock(&entry_gate.mutex);
-    
-    pthread_mutex_lock(&exit_gate.mutex);
-    printf("SAÍDA: %s (operações: %d)\n", 
-           state_names[exit_gate.state], exit_gate.operation_count);
-    printf("  Sensores: Abertura=%s, Fechamento=%s\n",
-           gpio_read_gate_sensor(exit_gate.sensor_open_pin) ? "ATIVO" : "INATIVO",
-           gpio_read_gate_sensor(exit_gate.sensor_close_pin) ? "ATIVO" : "INATIVO");
-    pthread_mutex_unlock(&exit_gate.mutex);
+    for (int i = 0; i < GATE_COUNT; i++) {
+        const gate_control_t* gate = &gates[i];
+        printf("%s: %s (operações: %u)\n", gate_name(gate),
+               state_names[gate->state], gate->operation_count);
+        printf("  Sensores: Abertura=%s, Fechamento=%s (%s)\n",
+               gpio_read_gate_sensor(gate->sensor_open_pin) ? "ATIVO" : "INATIVO",
+               gpio_read_gate_sensor(gate->sensor_close_pin) ? "ATIVO" : "INATIVO",
+               gate->watched ? "alerta" : "leitura");
+    }
     
     printf("===========================\n\n");
 }
\ No newline at end of file
@@ -16,6 +16,14 @@ typedef enum {
     GATE_EXIT = 1      // Cancela de saída
 } gate_type_t;
 
+/**
+ * @brief Callback de mudança de estado de uma cancela
+ *
+ * Chamado com a trava interna das cancelas: deve ser curto e não pode chamar
+ * as funções gate_*.
+ */
+typedef void (*gate_state_callback_t)(gate_type_t gate_type, gate_state_t state, void* user_data);
+
 /**
  * @brief Inicializa o sistema de controle de cancelas
  * @return 0 se sucesso, -1 se erro
@@ -55,6 +63,13 @@ gate_state_t gate_get_state(gate_type_t gate_type);
  */
 int gate_reset_error(gate_type_t gate_type);
 
+/**
+ * @brief Define o callback de mudança de estado (NULL remove)
+ * @param callback Função chamada a cada transição
+ * @param user_data Contexto repassado ao callback
+ */
+void gate_set_state_callback(gate_state_callback_t callback, void* user_data);
+
 /**
  * @brief Abre todas as cancelas (emergência)
  */
@@ -12,10 +12,12 @@
 
 #include "gpio_control.h"
 #include "system_logger.h"
+#include "site_config.h"
 #include <pigpio.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 // =============================================================================
 // DEFINIÇÕES DO SISTEMA GPIO
@@ -24,6 +26,216 @@
 // Estado de inicialização
 static bool gpio_initialized = false;
 
+// =============================================================================
+// SENSORES DE VAGA POR ALERTA
+// =============================================================================
+//
+// Só a vaga selecionada no multiplexador chega ao pino do sensor de cada
+// banco. O alerta do pigpio entrega cada borda com o tick em que ocorreu;
+// bordas até GPIO_MUX_SETTLE_US depois de uma troca de endereço são
+// transitório da troca e não contam. O último estado de cada vaga fica em
+// spot_mask e só as diferenças viram evento, um por vaga (um evento pendente
+// é atualizado em vez de duplicado, então a fila nunca transborda).
+
+#define SENSOR_EVENT_QUEUE MAX_PARKING_SPOTS_PER_FLOOR
+
+struct sensor_watch;
+
+// Contexto do alerta de um pino de sensor: a vaga depende do banco
+typedef struct {
+    struct sensor_watch* watch;
+    uint8_t bank;
+} sensor_bank_t;
+
+typedef struct sensor_watch {
+    bool enabled;
+    const gpio_floor_config_t* config;
+    uint16_t scan_index;        // Posição na sequência Gray (gpio_gray_address)
+    uint8_t address;            // Endereço selecionado no multiplexador
+    uint32_t address_tick;      // gpioTick() da última troca de endereço
+    uint8_t edge_banks;         // Bancos com borda aceita no endereço atual
+    uint32_t idle_steps;        // Endereços percorridos desde o último evento
+    spot_mask_t spot_mask;      // Último estado conhecido (bit = ocupada)
+    spot_mask_t known_mask;     // Vagas já observadas
+    sensor_bank_t banks[GPIO_MAX_MUX_BANKS];
+    gpio_sensor_event_t events[SENSOR_EVENT_QUEUE];
+    int count;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        // CLOCK_MONOTONIC
+} sensor_watch_t;
+
+static sensor_watch_t sensor_watches[MAX_FLOORS];
+
+// Endereço escrito por último em cada multiplexador (gpio_init zera os pinos)
+static uint8_t mux_address[MAX_FLOORS];
+
+/**
+ * @brief Índice do andar na topologia (-1 se a configuração não é dela)
+ */
+static int floor_index(const gpio_floor_config_t* config) {
+    if (!config || config->floor >= site_floor_count()) return -1;
+    return config->floor;
+}
+
+/**
+ * @brief Localiza o estado de alerta do andar
+ */
+static sensor_watch_t* find_sensor_watch(const gpio_floor_config_t* config) {
+    int floor = floor_index(config);
+    return floor >= 0 ? &sensor_watches[floor] : NULL;
+}
+
+/**
+ * @brief Troca o endereço do multiplexador com escritas em bloco
+ *
+ * Só os bits que diferem do endereço atual são escritos: um store no
+ * registrador de clear e outro no de set (na ordem Gray, um único store).
+ */
+static void write_address(const gpio_floor_config_t* config, uint8_t address) {
+    int floor = floor_index(config);
+    uint8_t diff = floor >= 0 ? (uint8_t)(mux_address[floor] ^ address) : 0xFF;
+    uint32_t set_bits = 0;
+    uint32_t clear_bits = 0;
+    
+    for (int i = 0; i < config->num_address_bits; i++) {
+        if (!((diff >> i) & 0x01)) continue;
+        
+        uint32_t pin_bit = 1u << config->address_pins[i];
+        if ((address >> i) & 0x01) {
+            set_bits |= pin_bit;
+        } else {
+            clear_bits |= pin_bit;
+        }
+    }
+    
+    if (clear_bits) gpioWrite_Bits_0_31_Clear(clear_bits);
+    if (set_bits) gpioWrite_Bits_0_31_Set(set_bits);
+    
+    if (floor >= 0) {
+        mux_address[floor] = address;
+    }
+}
+
+/**
+ * @brief Maioria de GPIO_SENSOR_SAMPLES leituras do sensor (LOW = ocupado)
+ */
+static bool sample_parking_sensor(const gpio_floor_config_t* config, uint8_t bank) {
+    int low = 0;
+    for (int i = 0; i < GPIO_SENSOR_SAMPLES; i++) {
+        if (i > 0) gpioDelay(GPIO_SENSOR_SAMPLE_GAP_US);
+        if (gpioRead(config->sensor_pins[bank]) == 0) low++;
+    }
+    return low * 2 > GPIO_SENSOR_SAMPLES;
+}
+
+/**
+ * @brief Converte um gpioTick() passado em tempo de parede (us)
+ */
+static uint64_t tick_to_realtime_us(uint32_t tick) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t now_us = (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+    return now_us - (uint32_t)(gpioTick() - tick);
+}
+
+/**
+ * @brief Registra o estado observado de uma vaga (chamar com watch->mutex)
+ */
+static void record_spot_locked(sensor_watch_t* watch, uint16_t spot,
+                               bool occupied, uint32_t tick) {
+    if (spot_mask_test(&watch->known_mask, spot) &&
+        spot_mask_test(&watch->spot_mask, spot) == occupied) {
+        return;
+    }
+    
+    spot_mask_set(&watch->known_mask, spot);
+    if (occupied) {
+        spot_mask_set(&watch->spot_mask, spot);
+    } else {
+        spot_mask_clear(&watch->spot_mask, spot);
+    }
+    
+    // Só o estado mais recente de cada vaga importa
+    for (int i = 0; i < watch->count; i++) {
+        if (watch->events[i].spot == spot) {
+            watch->events[i].occupied = occupied;
+            watch->events[i].time_us = tick_to_realtime_us(tick);
+            return;
+        }
+    }
+    
+    gpio_sensor_event_t* ev = &watch->events[watch->count++];
+    ev->spot = spot;
+    ev->occupied = occupied;
+    ev->time_us = tick_to_realtime_us(tick);
+    pthread_cond_signal(&watch->cond);
+}
+
+/**
+ * @brief Callback de alerta do pigpio (thread do pigpio)
+ */
+static void sensor_alert(int gpio, int level, uint32_t tick, void* userdata) {
+    sensor_bank_t* bank = (sensor_bank_t*)userdata;
+    sensor_watch_t* watch = bank->watch;
+    (void)gpio;
+    
+    if (level == PI_TIMEOUT) return;
+    
+    pthread_mutex_lock(&watch->mutex);
+    uint16_t spot = (uint16_t)((bank->bank << watch->config->num_address_bits) | watch->address);
+    if (watch->enabled && spot < watch->config->num_spots &&
+        (int32_t)(tick - watch->address_tick) >= GPIO_MUX_SETTLE_US) {
+        record_spot_locked(watch, spot, level == 0, tick); // LOW = ocupado
+        watch->edge_banks |= (uint8_t)(1u << bank->bank);
+    }
+    pthread_mutex_unlock(&watch->mutex);
+}
+
+// Bordas de entradas avulsas (cancelas, passagem): um callback por pino
+#define GPIO_MAX_PINS 32
+
+typedef struct {
+    gpio_edge_callback_t callback;
+    void* userdata;
+} input_watch_t;
+
+static input_watch_t input_watches[GPIO_MAX_PINS];
+
+/**
+ * @brief Callback de alerta do pigpio para entradas avulsas
+ */
+static void input_alert(int gpio, int level, uint32_t tick, void* userdata) {
+    input_watch_t* watch = (input_watch_t*)userdata;
+    
+    if (level == PI_TIMEOUT || !watch->callback) return;
+    
+    watch->callback((uint8_t)gpio, level == 0, tick_to_realtime_us(tick), watch->userdata); // LOW = ativo
+}
+
+/**
+ * @brief Soma microssegundos a um instante monotônico
+ */
+static void deadline_after_us(const struct timespec* start, uint32_t us, struct timespec* out) {
+    out->tv_sec = start->tv_sec + us / 1000000;
+    out->tv_nsec = start->tv_nsec + (long)(us % 1000000) * 1000;
+    if (out->tv_nsec >= 1000000000L) {
+        out->tv_sec++;
+        out->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Espera até o prazo (ou um evento, se until_event) com watch->mutex
+ */
+static void watch_wait_locked(sensor_watch_t* watch, const struct timespec* deadline,
+                              bool until_event) {
+    while (watch->enabled && !(until_event && watch->count > 0)) {
+        if (pthread_cond_timedwait(&watch->cond, &watch->mutex, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+}
+
 // =============================================================================
 // FUNÇÕES PÚBLICAS
 // =============================================================================
@@ -47,22 +259,30 @@ int gpio_init(void) {
     
     LOG_INFO("GPIO", "pigpio inicializado - versão: %d", result);
     
-    // Configurar pinos de entrada (sensores)
-    for (int i = 0; i < NUM_SENSOR_PINS; i++) {
-        gpioSetMode(SENSOR_PINS[i], PI_INPUT);
-        gpioSetPullUpDown(SENSOR_PINS[i], PI_PUD_UP); // Pull-up interno
-    }
-    
-    // Configurar pinos de multiplexação (saída)
-    for (int i = 0; i < NUM_MUX_PINS; i++) {
-        gpioSetMode(MUX_PINS[i], PI_OUTPUT);
-        gpioWrite(MUX_PINS[i], 0); // Iniciar em LOW
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    for (int floor = 0; floor < MAX_FLOORS; floor++) {
+        memset(&sensor_watches[floor], 0, sizeof(sensor_watches[floor]));
+        pthread_mutex_init(&sensor_watches[floor].mutex, NULL);
+        pthread_cond_init(&sensor_watches[floor].cond, &cond_attr);
+        mux_address[floor] = 0;
     }
+    pthread_condattr_destroy(&cond_attr);
     
-    // Configurar pinos das cancelas (saída)
-    for (int i = 0; i < NUM_GATE_PINS; i++) {
-        gpioSetMode(GATE_PINS[i], PI_OUTPUT);
-        gpioWrite(GATE_PINS[i], 0); // Cancelas fechadas (LOW)
+    // Configurar multiplexação e sensores de vagas de cada andar da topologia
+    for (int floor = 0; floor < site_floor_count(); floor++) {
+        const gpio_floor_config_t* config = &site_floor((floor_id_t)floor)->gpio;
+        
+        for (int i = 0; i < config->num_address_bits; i++) {
+            gpioSetMode(config->address_pins[i], PI_OUTPUT);
+            gpioWrite(config->address_pins[i], 0); // Iniciar em LOW
+        }
+        
+        for (int bank = 0; bank < config->num_banks; bank++) {
+            gpioSetMode(config->sensor_pins[bank], PI_INPUT);
+            gpioSetPullUpDown(config->sensor_pins[bank], PI_PUD_UP); // Pull-up interno
+        }
     }
     
     // Configurar sensores específicos
@@ -79,18 +299,22 @@ int gpio_init(void) {
     gpioSetMode(GPIO_TERREO_SENSOR_FECHAMENTO_SAIDA, PI_INPUT);
     gpioSetPullUpDown(GPIO_TERREO_SENSOR_FECHAMENTO_SAIDA, PI_PUD_UP);
     
-    // Sensores de passagem dos andares
-    gpioSetMode(GPIO_ANDAR1_SENSOR_PASSAGEM_1, PI_INPUT);
-    gpioSetPullUpDown(GPIO_ANDAR1_SENSOR_PASSAGEM_1, PI_PUD_UP);
-    
-    gpioSetMode(GPIO_ANDAR1_SENSOR_PASSAGEM_2, PI_INPUT);
-    gpioSetPullUpDown(GPIO_ANDAR1_SENSOR_PASSAGEM_2, PI_PUD_UP);
+    // Sensores de presença diante das cancelas
+    gpioSetMode(GPIO_TERREO_SENSOR_PRESENCA_ENTRADA, PI_INPUT);
+    gpioSetPullUpDown(GPIO_TERREO_SENSOR_PRESENCA_ENTRADA, PI_PUD_UP);
     
-    gpioSetMode(GPIO_ANDAR2_SENSOR_PASSAGEM_1, PI_INPUT);
-    gpioSetPullUpDown(GPIO_ANDAR2_SENSOR_PASSAGEM_1, PI_PUD_UP);
+    gpioSetMode(GPIO_TERREO_SENSOR_PRESENCA_SAIDA, PI_INPUT);
+    gpioSetPullUpDown(GPIO_TERREO_SENSOR_PRESENCA_SAIDA, PI_PUD_UP);
     
-    gpioSetMode(GPIO_ANDAR2_SENSOR_PASSAGEM_2, PI_INPUT);
-    gpioSetPullUpDown(GPIO_ANDAR2_SENSOR_PASSAGEM_2, PI_PUD_UP);
+    // Sensores de passagem dos andares (site.conf)
+    for (int floor = 0; floor < site_floor_count(); floor++) {
+        const site_floor_t* site = site_floor((floor_id_t)floor);
+        if (!site->has_passage) continue;
+        for (int i = 0; i < 2; i++) {
+            gpioSetMode(site->passage_pins[i], PI_INPUT);
+            gpioSetPullUpDown(site->passage_pins[i], PI_PUD_UP);
+        }
+    }
     
     // Configurar motores das cancelas
     gpioSetMode(GPIO_TERREO_MOTOR_ENTRADA, PI_OUTPUT);
@@ -116,14 +340,23 @@ void gpio_cleanup(void) {
     gpioWrite(GPIO_TERREO_MOTOR_ENTRADA, 0);
     gpioWrite(GPIO_TERREO_MOTOR_SAIDA, 0);
     
-    // Zera todos os pinos de multiplexação
-    for (int i = 0; i < NUM_MUX_PINS; i++) {
-        gpioWrite(MUX_PINS[i], 0);
+    // Para os alertas e zera todos os pinos de multiplexação
+    for (int floor = 0; floor < site_floor_count(); floor++) {
+        const gpio_floor_config_t* config = &site_floor((floor_id_t)floor)->gpio;
+        gpio_sensor_events_disable(config);
+        for (int i = 0; i < config->num_address_bits; i++) {
+            gpioWrite(config->address_pins[i], 0);
+        }
     }
     
     // Finaliza pigpio
     gpioTerminate();
     
+    for (int floor = 0; floor < MAX_FLOORS; floor++) {
+        pthread_mutex_destroy(&sensor_watches[floor].mutex);
+        pthread_cond_destroy(&sensor_watches[floor].cond);
+    }
+    
     gpio_initialized = false;
     LOG_INFO("GPIO", "Cleanup do GPIO concluído");
 }
@@ -131,22 +364,21 @@ void gpio_cleanup(void) {
 /**
  * @brief Configura o endereço do multiplexador para um andar
  * @param config Configuração do andar
- * @param address Endereço (0-7)
+ * @param address Endereço (menor que config->num_addresses)
  * @return 0 se sucesso, -1 se erro
  */
 int gpio_set_address(const gpio_floor_config_t* config, uint8_t address) {
-    if (!gpio_initialized || !config || address > 7) {
+    if (!gpio_initialized || !config || address >= config->num_addresses) {
         LOG_ERROR("GPIO", "Parâmetros inválidos para set_address");
         return -1;
     }
     
-    // Configura os 3 bits de endereço (0-7)
-    gpioWrite(config->address_pins[0], address & 0x01);
-    gpioWrite(config->address_pins[1], (address & 0x02) >> 1);
-    gpioWrite(config->address_pins[2], (address & 0x04) >> 2);
+    // Configura os bits de endereço usados pelo andar
+    write_address(config, address);
     
-    // Aguarda um tempo para estabilizar o endereçamento
-    usleep(1000); // 1ms
+    // Aguarda estabilizar; gpioDelay faz espera ativa abaixo de 100 us,
+    // bem mais preciso que usleep nessa escala
+    gpioDelay(GPIO_MUX_SETTLE_US);
     
     return 0;
 }
@@ -154,17 +386,226 @@ int gpio_set_address(const gpio_floor_config_t* config, uint8_t address) {
 /**
  * @brief Lê um sensor de estacionamento multiplexado
  * @param config Configuração do andar
+ * @param bank Banco de multiplexador
  * @return true se vaga ocupada, false se livre
  */
-bool gpio_read_parking_sensor(const gpio_floor_config_t* config) {
-    if (!gpio_initialized || !config) {
+bool gpio_read_parking_sensor(const gpio_floor_config_t* config, uint8_t bank) {
+    if (!gpio_initialized || !config || bank >= config->num_banks) {
         LOG_ERROR("GPIO", "Parâmetros inválidos para read_parking_sensor");
         return false;
     }
     
     // Lê o estado do sensor (invertido - LOW = ocupado)
-    int value = gpioRead(config->sensor_pin);
-    return (value == 0); // LOW = ocupado (sensor ativo)
+    return sample_parking_sensor(config, bank);
+}
+
+/**
+ * @brief Registra alerta do pigpio nos sensores de vagas do andar
+ * @param config Configuração do andar
+ * @return 0 se sucesso, -1 se erro
+ */
+int gpio_sensor_events_enable(const gpio_floor_config_t* config) {
+    sensor_watch_t* watch = find_sensor_watch(config);
+    if (!gpio_initialized || !watch || config->num_spots == 0) {
+        LOG_ERROR("GPIO", "Parâmetros inválidos para sensor_events_enable");
+        return -1;
+    }
+    
+    pthread_mutex_lock(&watch->mutex);
+    watch->config = config;
+    watch->scan_index = (uint16_t)((1u << config->num_address_bits) - 1); // Próxima: endereço 0
+    watch->address = mux_address[floor_index(config)];
+    watch->address_tick = gpioTick();
+    watch->edge_banks = 0;
+    watch->idle_steps = 0;
+    memset(&watch->spot_mask, 0, sizeof(watch->spot_mask));
+    memset(&watch->known_mask, 0, sizeof(watch->known_mask));
+    watch->count = 0;
+    watch->enabled = true;
+    pthread_mutex_unlock(&watch->mutex);
+    
+    for (uint8_t bank = 0; bank < config->num_banks; bank++) {
+        watch->banks[bank].watch = watch;
+        watch->banks[bank].bank = bank;
+        if (gpioSetAlertFuncEx(config->sensor_pins[bank], sensor_alert, &watch->banks[bank]) != 0) {
+            LOG_ERROR("GPIO", "Falha ao registrar alerta no pino %d", config->sensor_pins[bank]);
+            while (bank > 0) {
+                gpioSetAlertFuncEx(config->sensor_pins[--bank], NULL, NULL);
+            }
+            pthread_mutex_lock(&watch->mutex);
+            watch->enabled = false;
+            pthread_mutex_unlock(&watch->mutex);
+            return -1;
+        }
+    }
+    
+    LOG_INFO("GPIO", "Alertas habilitados nos sensores de vagas do andar %d (%d banco(s))",
+             config->floor, config->num_banks);
+    return 0;
+}
+
+/**
+ * @brief Remove os alertas dos sensores de vagas do andar
+ * @param config Configuração do andar
+ */
+void gpio_sensor_events_disable(const gpio_floor_config_t* config) {
+    sensor_watch_t* watch = find_sensor_watch(config);
+    if (!gpio_initialized || !watch) return;
+    
+    pthread_mutex_lock(&watch->mutex);
+    bool was_enabled = watch->enabled;
+    watch->enabled = false;
+    pthread_cond_broadcast(&watch->cond);
+    pthread_mutex_unlock(&watch->mutex);
+    
+    if (was_enabled) {
+        for (uint8_t bank = 0; bank < config->num_banks; bank++) {
+            gpioSetAlertFuncEx(config->sensor_pins[bank], NULL, NULL);
+        }
+    }
+}
+
+/**
+ * @brief Percorre as vagas do andar e devolve as que mudaram
+ * @param config Configuração do andar
+ * @param events Saída
+ * @param max_events Tamanho de events
+ * @param cycle_ms Duração de uma volta completa
+ * @return Número de eventos, -1 se erro
+ */
+int gpio_sensor_sweep(const gpio_floor_config_t* config, gpio_sensor_event_t* events,
+                      int max_events, int cycle_ms) {
+    sensor_watch_t* watch = find_sensor_watch(config);
+    if (!watch || !events || max_events <= 0 || cycle_ms <= 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&watch->mutex);
+    if (!watch->enabled) {
+        pthread_mutex_unlock(&watch->mutex);
+        return -1;
+    }
+    
+    // Andar parado há GPIO_SENSOR_IDLE_SWEEPS voltas: girar mais devagar
+    if (watch->idle_steps >= (uint32_t)GPIO_SENSOR_IDLE_SWEEPS * config->num_addresses) {
+        cycle_ms *= GPIO_SENSOR_IDLE_SLOWDOWN;
+    }
+    
+    uint32_t dwell_us = (uint32_t)cycle_ms * 1000u / config->num_addresses;
+    if (dwell_us < GPIO_MUX_SETTLE_US) {
+        dwell_us = GPIO_MUX_SETTLE_US;
+    }
+    
+    uint16_t positions = (uint16_t)(1u << config->num_address_bits);
+    
+    for (int i = 0; i < config->num_addresses && watch->count == 0 && watch->enabled; i++) {
+        uint8_t address;
+        do {
+            watch->scan_index = (uint16_t)((watch->scan_index + 1) % positions);
+            address = gpio_gray_address((uint8_t)watch->scan_index);
+        } while (address >= config->num_addresses);
+        struct timespec start, settled, until;
+        
+        write_address(config, address);
+        watch->address = address;
+        watch->address_tick = gpioTick();
+        watch->edge_banks = 0;
+        watch->idle_steps++;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        
+        // Bordas do transitório são descartadas pelo próprio alerta
+        deadline_after_us(&start, GPIO_MUX_SETTLE_US, &settled);
+        watch_wait_locked(watch, &settled, false);
+        if (!watch->enabled) break;
+        
+        // A vaga pode ter mudado enquanto não estava selecionada (a borda cai no
+        // transitório): uma leitura por banco, e a maioria só se ela divergir
+        // do estado conhecido ou a vaga ainda não tiver sido observada
+        uint8_t known = 0, expected = 0, sampled = 0;
+        bool occupied[GPIO_MAX_MUX_BANKS];
+        uint32_t ticks[GPIO_MAX_MUX_BANKS];
+        uint8_t banks = 0;
+        for (; banks < config->num_banks; banks++) {
+            uint16_t spot = (uint16_t)((banks << config->num_address_bits) | address);
+            if (spot >= config->num_spots) break;
+            if (spot_mask_test(&watch->known_mask, spot)) known |= (uint8_t)(1u << banks);
+            if (spot_mask_test(&watch->spot_mask, spot)) expected |= (uint8_t)(1u << banks);
+        }
+        
+        // Leituras sem a trava: o alerta segue entregando bordas
+        pthread_mutex_unlock(&watch->mutex);
+        for (uint8_t bank = 0; bank < banks; bank++) {
+            uint8_t bit = (uint8_t)(1u << bank);
+            bool level = gpioRead(config->sensor_pins[bank]) == 0; // LOW = ocupado
+            if ((known & bit) && level == ((expected & bit) != 0)) continue;
+            ticks[bank] = gpioTick();
+            occupied[bank] = sample_parking_sensor(config, bank);
+            sampled |= bit;
+        }
+        pthread_mutex_lock(&watch->mutex);
+        if (!watch->enabled) break;
+        
+        for (uint8_t bank = 0; bank < banks; bank++) {
+            uint8_t bit = (uint8_t)(1u << bank);
+            // Uma borda aceita nesse meio-tempo é mais recente que a amostra
+            if (!(sampled & bit) || (watch->edge_banks & bit)) continue;
+            uint16_t spot = (uint16_t)((bank << config->num_address_bits) | address);
+            record_spot_locked(watch, spot, occupied[bank], ticks[bank]);
+        }
+        
+        deadline_after_us(&start, dwell_us, &until);
+        watch_wait_locked(watch, &until, true);
+    }
+    
+    int n = watch->count < max_events ? watch->count : max_events;
+    if (n > 0) {
+        watch->idle_steps = 0;
+    }
+    memcpy(events, watch->events, (size_t)n * sizeof(*events));
+    watch->count -= n;
+    memmove(watch->events, watch->events + n, (size_t)watch->count * sizeof(*events));
+    pthread_mutex_unlock(&watch->mutex);
+    
+    return n;
+}
+
+/**
+ * @brief Entrega as bordas de um pino de entrada ao callback
+ * @param pin Pino GPIO
+ * @param callback Função chamada a cada borda
+ * @param userdata Repassado ao callback
+ * @return 0 se sucesso, -1 se erro
+ */
+int gpio_input_watch_enable(uint8_t pin, gpio_edge_callback_t callback, void* userdata) {
+    if (!gpio_initialized || pin >= GPIO_MAX_PINS || !callback) {
+        LOG_ERROR("GPIO", "Parâmetros inválidos para input_watch_enable");
+        return -1;
+    }
+    
+    input_watch_t* watch = &input_watches[pin];
+    watch->callback = callback;
+    watch->userdata = userdata;
+    
+    if (gpioSetAlertFuncEx(pin, input_alert, watch) != 0) {
+        watch->callback = NULL;
+        LOG_ERROR("GPIO", "Falha ao registrar alerta no pino %d", pin);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Para de entregar as bordas de um pino
+ * @param pin Pino GPIO
+ */
+void gpio_input_watch_disable(uint8_t pin) {
+    if (!gpio_initialized || pin >= GPIO_MAX_PINS || !input_watches[pin].callback) return;
+    
+    // Ao retornar, o pigpio não chama mais input_alert para o pino
+    gpioSetAlertFuncEx(pin, NULL, NULL);
+    input_watches[pin].callback = NULL;
+    input_watches[pin].userdata = NULL;
 }
 
 /**
@@ -172,7 +613,7 @@ bool gpio_read_parking_sensor(const gpio_floor_config_t* config) {
  * @param pin Pino do sensor
  * @return true se sensor ativo, false se inativo
  */
-bool gpio_read_gate_sensor(int pin) {
+bool gpio_read_gate_sensor(uint8_t pin) {
     if (!gpio_initialized) {
         LOG_ERROR("GPIO", "GPIO não inicializado");
         return false;
@@ -216,7 +657,7 @@ bool gpio_read_pin(int pin) {
  * @param pin Pino do motor
  * @param activate true para ativar, false para desativar
  */
-void gpio_control_gate_motor(int pin, bool activate) {
+void gpio_set_gate_motor(uint8_t pin, bool activate) {
     if (!gpio_initialized) {
         LOG_ERROR("GPIO", "GPIO não inicializado");
         return;
@@ -243,14 +684,17 @@ void gpio_test_all_pins(void) {
     LOG_INFO("GPIO", "Iniciando teste de todos os pinos...");
     
     // Teste dos pinos de endereçamento
-    for (int floor = 0; floor < MAX_FLOORS; floor++) {
-        const gpio_floor_config_t* config = &GPIO_CONFIGS[floor];
+    for (int floor = 0; floor < site_floor_count(); floor++) {
+        const gpio_floor_config_t* config = &site_floor((floor_id_t)floor)->gpio;
         LOG_INFO("GPIO", "Testando andar %d...", floor);
         
-        for (uint8_t addr = 0; addr < 8; addr++) {
-            gpio_set_address(config, addr);
-            bool sensor = gpio_read_parking_sensor(config);
-            LOG_INFO("GPIO", "  Endereço %d: sensor %s", addr, sensor ? "OCUPADO" : "LIVRE");
+        for (uint16_t addr = 0; addr < config->num_addresses; addr++) {
+            gpio_set_address(config, (uint8_t)addr);
+            for (uint8_t bank = 0; bank < config->num_banks; bank++) {
+                bool sensor = gpio_read_parking_sensor(config, bank);
+                LOG_INFO("GPIO", "  Banco %d, endereço %d: sensor %s", bank, addr,
+                         sensor ? "OCUPADO" : "LIVRE");
+            }
             usleep(100000); // 100ms entre testes
         }
     }
@@ -268,14 +712,14 @@ void gpio_test_all_pins(void) {
     
     // Teste dos sensores de passagem
     LOG_INFO("GPIO", "Testando sensores de passagem...");
-    LOG_INFO("GPIO", "  1º andar - sensor 1: %s", 
-             gpio_read_gate_sensor(GPIO_ANDAR1_SENSOR_PASSAGEM_1) ? "ATIVO" : "INATIVO");
-    LOG_INFO("GPIO", "  1º andar - sensor 2: %s", 
-             gpio_read_gate_sensor(GPIO_ANDAR1_SENSOR_PASSAGEM_2) ? "ATIVO" : "INATIVO");
-    LOG_INFO("GPIO", "  2º andar - sensor 1: %s", 
-             gpio_read_gate_sensor(GPIO_ANDAR2_SENSOR_PASSAGEM_1) ? "ATIVO" : "INATIVO");
-    LOG_INFO("GPIO", "  2º andar - sensor 2: %s", 
-             gpio_read_gate_sensor(GPIO_ANDAR2_SENSOR_PASSAGEM_2) ? "ATIVO" : "INATIVO");
+    for (int floor = 0; floor < site_floor_count(); floor++) {
+        const site_floor_t* site = site_floor((floor_id_t)floor);
+        if (!site->has_passage) continue;
+        for (int i = 0; i < 2; i++) {
+            LOG_INFO("GPIO", "  %s - sensor %d: %s", site->name, i + 1,
+                     gpio_read_gate_sensor(site->passage_pins[i]) ? "ATIVO" : "INATIVO");
+        }
+    }
     
     LOG_INFO("GPIO", "Teste concluído");
 }
@@ -306,14 +750,18 @@ void gpio_monitor_sensors(int duration_seconds) {
         printf("\n=== STATUS DOS SENSORES ===\n");
         
         // Monitora vagas de estacionamento
-        for (int floor = 0; floor < MAX_FLOORS; floor++) {
-            const gpio_floor_config_t* config = &GPIO_CONFIGS[floor];
+        for (int floor = 0; floor < site_floor_count(); floor++) {
+            const gpio_floor_config_t* config = &site_floor((floor_id_t)floor)->gpio;
             printf("Andar %d:\n", floor);
             
-            for (uint8_t addr = 0; addr < 8; addr++) {
-                gpio_set_address(config, addr);
-                bool occupied = gpio_read_parking_sensor(config);
-                printf("  Vaga %d: %s\n", addr, occupied ? "OCUPADA" : "LIVRE");
+            for (uint16_t addr = 0; addr < config->num_addresses; addr++) {
+                gpio_set_address(config, (uint8_t)addr);
+                for (uint8_t bank = 0; bank < config->num_banks; bank++) {
+                    int spot = (bank << config->num_address_bits) | addr;
+                    if (spot >= config->num_spots) break;
+                    bool occupied = gpio_read_parking_sensor(config, bank);
+                    printf("  Vaga %d: %s\n", spot, occupied ? "OCUPADA" : "LIVRE");
+                }
             }
         }
         
@@ -330,14 +778,14 @@ void gpio_monitor_sensors(int duration_seconds) {
         
         // Monitora sensores de passagem
         printf("Passagem:\n");
-        printf("  1º Andar S1: %s\n", 
-               gpio_read_gate_sensor(GPIO_ANDAR1_SENSOR_PASSAGEM_1) ? "ATIVO" : "INATIVO");
-        printf("  1º Andar S2: %s\n", 
-               gpio_read_gate_sensor(GPIO_ANDAR1_SENSOR_PASSAGEM_2) ? "ATIVO" : "INATIVO");
-        printf("  2º Andar S1: %s\n", 
-               gpio_read_gate_sensor(GPIO_ANDAR2_SENSOR_PASSAGEM_1) ? "ATIVO" : "INATIVO");
-        printf("  2º Andar S2: %s\n", 
-               gpio_read_gate_sensor(GPIO_ANDAR2_SENSOR_PASSAGEM_2) ? "ATIVO" : "INATIVO");
+        for (int floor = 0; floor < site_floor_count(); floor++) {
+            const site_floor_t* site = site_floor((floor_id_t)floor);
+            if (!site->has_passage) continue;
+            for (int i = 0; i < 2; i++) {
+                printf("  %s S%d: %s\n", site->name, i + 1,
+                       gpio_read_gate_sensor(site->passage_pins[i]) ? "ATIVO" : "INATIVO");
+            }
+        }
         
         sleep(1); // Atualiza a cada segundo
     }
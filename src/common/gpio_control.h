@@ -20,19 +20,117 @@ int gpio_init(void);
 void gpio_cleanup(void);
 
 /**
- * @brief Configura o endereço para multiplexação (0-7)
+ * @brief Configura o endereço nas linhas de multiplexação do andar
+ *
+ * Todos os bancos do andar passam a apresentar o mesmo endereço.
+ *
  * @param config Configuração do andar
- * @param address Endereço da vaga (0-7)
+ * @param address Endereço (menor que config->num_addresses)
  * @return 0 se sucesso, -1 se erro
  */
 int gpio_set_address(const gpio_floor_config_t* config, uint8_t address);
 
 /**
- * @brief Lê o estado do sensor de vaga no endereço atual
+ * @brief Endereço na posição index da varredura em código Gray
+ *
+ * Posições consecutivas diferem em um único bit de endereço, então cada
+ * passo da varredura muda só um pino do multiplexador.
+ */
+static inline uint8_t gpio_gray_address(uint8_t index) {
+    return (uint8_t)(index ^ (index >> 1));
+}
+
+/**
+ * @brief Lê o estado do sensor de vaga de um banco no endereço atual
+ *
+ * Devolve a maioria de GPIO_SENSOR_SAMPLES leituras.
+ *
  * @param config Configuração do andar
+ * @param bank Banco de multiplexador (vaga = banco * 2^bits + endereço)
  * @return true se vaga ocupada, false se livre
  */
-bool gpio_read_parking_sensor(const gpio_floor_config_t* config);
+bool gpio_read_parking_sensor(const gpio_floor_config_t* config, uint8_t bank);
+
+// =============================================================================
+// SENSORES DE VAGA POR ALERTA (pigpio)
+// =============================================================================
+
+/**
+ * @brief Mudança de uma vaga observada na linha do multiplexador
+ */
+typedef struct {
+    uint16_t spot;          // Vaga: banco do sensor + endereço selecionado
+    bool occupied;          // Novo estado da vaga
+    uint64_t time_us;       // Instante da borda ou da leitura (CLOCK_REALTIME, us)
+} gpio_sensor_event_t;
+
+/**
+ * @brief Registra alerta do pigpio nos sensores de vagas do andar
+ *
+ * Um alerta por banco de multiplexador. A partir daqui o multiplexador do
+ * andar deve ser movido apenas por gpio_sensor_sweep.
+ *
+ * @param config Configuração do andar
+ * @return 0 se sucesso, -1 se alertas indisponíveis (usar varredura)
+ */
+int gpio_sensor_events_enable(const gpio_floor_config_t* config);
+
+/**
+ * @brief Remove os alertas dos sensores de vagas do andar
+ * @param config Configuração do andar
+ */
+void gpio_sensor_events_disable(const gpio_floor_config_t* config);
+
+/**
+ * @brief Percorre as vagas do andar e devolve as que mudaram
+ *
+ * Cada endereço fica selecionado por cycle_ms / num_addresses: após
+ * GPIO_MUX_SETTLE_US o pino de cada banco é lido uma vez, sem a trava do
+ * alerta, e só é amostrado por maioria se divergir do estado conhecido; enquanto
+ * selecionada, a vaga segue pelas bordas do alerta (com o tick da borda).
+ * Depois de GPIO_SENSOR_IDLE_SWEEPS voltas sem mudança a volta dura
+ * GPIO_SENSOR_IDLE_SLOWDOWN vezes cycle_ms. Retorna assim que houver
+ * mudança; a próxima chamada continua do endereço seguinte.
+ *
+ * @param config Configuração do andar (com alertas habilitados)
+ * @param events Saída: mudanças em ordem de ocorrência
+ * @param max_events Tamanho de events
+ * @param cycle_ms Duração de uma volta completa no multiplexador
+ * @return Número de eventos (0 = volta sem mudanças), -1 se erro
+ */
+int gpio_sensor_sweep(const gpio_floor_config_t* config, gpio_sensor_event_t* events,
+                      int max_events, int cycle_ms);
+
+// =============================================================================
+// BORDAS DE ENTRADAS DIGITAIS (pigpio)
+// =============================================================================
+
+/**
+ * @brief Callback de borda de uma entrada (chamado na thread do pigpio)
+ * @param pin Pino que mudou
+ * @param active true se o sensor ficou ativo (LOW), igual a gpio_read_gate_sensor
+ * @param time_us Instante da borda (CLOCK_REALTIME, us)
+ * @param userdata Valor passado em gpio_input_watch_enable
+ */
+typedef void (*gpio_edge_callback_t)(uint8_t pin, bool active, uint64_t time_us, void* userdata);
+
+/**
+ * @brief Passa a entregar as bordas de um pino de entrada ao callback
+ *
+ * O callback deve ser curto (apenas registrar e acordar quem processa).
+ *
+ * @param pin Pino GPIO de entrada
+ * @param callback Função chamada a cada borda
+ * @param userdata Repassado ao callback
+ * @return 0 se sucesso, -1 se alertas indisponíveis (ler o pino por varredura)
+ */
+int gpio_input_watch_enable(uint8_t pin, gpio_edge_callback_t callback, void* userdata);
+
+/**
+ * @brief Para de entregar as bordas de um pino
+ * @param pin Pino GPIO de entrada
+ */
+void gpio_input_watch_disable(uint8_t pin);
 
 /**
  * @brief Lê o estado de um sensor de cancela
@@ -53,4 +151,11 @@ void gpio_set_gate_motor(uint8_t pin, bool activate);
  */
 void gpio_test_all_pins(void);
 
+#ifdef MOCK_BUILD
+/**
+ * @brief Define o estado simulado de um sensor de vaga (apenas build mock)
+ */
+void gpio_mock_set_spot(uint8_t floor, uint16_t spot, bool occupied);
+#endif
+
 #endif // GPIO_CONTROL_H
\ No newline at end of file
@@ -1,12 +1,76 @@
 #include "gpio_control.h"
 #include "system_logger.h"
 #ifdef MOCK_BUILD
+#include <time.h>
 static bool initialized = false;
+
+// Simulação: vagas ocupadas por andar (gpio_mock_set_spot) e cancelas que
+// chegam ao fim de curso GPIO_MOCK_GATE_TRAVEL_MS ± GPIO_MOCK_GATE_JITTER_MS
+// após ligar o motor (sorteado a cada acionamento)
+#define GPIO_MOCK_GATE_TRAVEL_MS 50
+#define GPIO_MOCK_GATE_JITTER_MS 20
+static unsigned int mock_seed = 1;
+static pthread_mutex_t mock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static spot_mask_t mock_spots[MAX_FLOORS];
+static uint8_t mock_address[MAX_FLOORS];
+static struct { uint8_t motor, open, close; bool is_open, moving, opening; uint64_t start_ms, travel_ms; } mock_gates[] = {
+    { GPIO_TERREO_MOTOR_ENTRADA, GPIO_TERREO_SENSOR_ABERTURA_ENTRADA, GPIO_TERREO_SENSOR_FECHAMENTO_ENTRADA, false, false, false, 0, GPIO_MOCK_GATE_TRAVEL_MS },
+    { GPIO_TERREO_MOTOR_SAIDA, GPIO_TERREO_SENSOR_ABERTURA_SAIDA, GPIO_TERREO_SENSOR_FECHAMENTO_SAIDA, false, false, false, 0, GPIO_MOCK_GATE_TRAVEL_MS },
+};
+#define MOCK_GATE_COUNT (int)(sizeof(mock_gates)/sizeof(mock_gates[0]))
+static uint64_t mock_ms(void){struct timespec ts;clock_gettime(CLOCK_MONOTONIC,&ts);return (uint64_t)ts.tv_sec*1000u+(uint64_t)ts.tv_nsec/1000000u;}
+void gpio_mock_set_spot(uint8_t floor,uint16_t spot,bool occupied){
+    if(floor>=MAX_FLOORS||spot>=MAX_PARKING_SPOTS_PER_FLOOR)return;
+    pthread_mutex_lock(&mock_mutex);
+    if(occupied)spot_mask_set(&mock_spots[floor],spot);else spot_mask_clear(&mock_spots[floor],spot);
+    pthread_mutex_unlock(&mock_mutex);
+}
 int gpio_init(void){initialized=true;LOG_INFO("GPIO-MOCK","init");return 0;}
 void gpio_cleanup(void){initialized=false;LOG_INFO("GPIO-MOCK","cleanup");}
-int gpio_set_address(const gpio_floor_config_t* config, uint8_t address){(void)config;(void)address;return 0;}
-bool gpio_read_parking_sensor(const gpio_floor_config_t* config){(void)config;return false;}
-bool gpio_read_gate_sensor(uint8_t pin){(void)pin;return false;}
-void gpio_set_gate_motor(uint8_t pin,bool activate){LOG_DEBUG("GPIO-MOCK","motor pin %u -> %d",pin,activate);}
+int gpio_set_address(const gpio_floor_config_t* config, uint8_t address){if(config->floor<MAX_FLOORS)mock_address[config->floor]=address;return 0;}
+bool gpio_read_parking_sensor(const gpio_floor_config_t* config,uint8_t bank){
+    if(config->floor>=MAX_FLOORS)return false;
+    uint16_t spot=(uint16_t)((bank<<config->num_address_bits)|mock_address[config->floor]);
+    pthread_mutex_lock(&mock_mutex);
+    bool occupied=spot<MAX_PARKING_SPOTS_PER_FLOOR&&spot_mask_test(&mock_spots[config->floor],spot);
+    pthread_mutex_unlock(&mock_mutex);
+    return occupied;
+}
+int gpio_sensor_events_enable(const gpio_floor_config_t* config){(void)config;return -1;}
+void gpio_sensor_events_disable(const gpio_floor_config_t* config){(void)config;}
+int gpio_sensor_sweep(const gpio_floor_config_t* config,gpio_sensor_event_t* events,int max_events,int cycle_ms){(void)config;(void)events;(void)max_events;(void)cycle_ms;return -1;}
+int gpio_input_watch_enable(uint8_t pin,gpio_edge_callback_t callback,void* userdata){(void)pin;(void)callback;(void)userdata;return -1;}
+void gpio_input_watch_disable(uint8_t pin){(void)pin;}
+bool gpio_read_gate_sensor(uint8_t pin){
+    bool active=false;
+    pthread_mutex_lock(&mock_mutex);
+    for(int i=0;i<MOCK_GATE_COUNT;i++){
+        if(pin!=mock_gates[i].open&&pin!=mock_gates[i].close)continue;
+        bool is_open=mock_gates[i].is_open;
+        if(mock_gates[i].moving){
+            if(mock_ms()-mock_gates[i].start_ms<mock_gates[i].travel_ms)break; // Entre os fins de curso
+            is_open=mock_gates[i].opening;
+        }
+        active=(pin==mock_gates[i].open)?is_open:!is_open;
+        break;
+    }
+    pthread_mutex_unlock(&mock_mutex);
+    return active;
+}
+void gpio_set_gate_motor(uint8_t pin,bool activate){
+    LOG_DEBUG("GPIO-MOCK","motor pin %u -> %d",pin,activate);
+    pthread_mutex_lock(&mock_mutex);
+    for(int i=0;i<MOCK_GATE_COUNT;i++){
+        if(pin!=mock_gates[i].motor)continue;
+        // Motor ligado anda para o fim de curso oposto; desligado no meio, volta ao anterior
+        if(activate&&!mock_gates[i].moving){mock_gates[i].moving=true;mock_gates[i].opening=!mock_gates[i].is_open;mock_gates[i].start_ms=mock_ms();
+            mock_gates[i].travel_ms=GPIO_MOCK_GATE_TRAVEL_MS-GPIO_MOCK_GATE_JITTER_MS+(uint64_t)(rand_r(&mock_seed)%(2*GPIO_MOCK_GATE_JITTER_MS+1));}
+        else if(!activate&&mock_gates[i].moving){
+            mock_gates[i].moving=false;
+            if(mock_ms()-mock_gates[i].start_ms>=mock_gates[i].travel_ms)mock_gates[i].is_open=mock_gates[i].opening;
+        }
+    }
+    pthread_mutex_unlock(&mock_mutex);
+}
 void gpio_test_all_pins(void){LOG_INFO("GPIO-MOCK","test all pins");}
 #endif
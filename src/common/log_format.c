@@ -0,0 +1,313 @@
+/**
+ * @file log_format.c
+ * @brief Empacotamento e formatação dos argumentos do log binário
+ */
+
+#include "log_format.h"
+#include <stdio.h>
+#include <string.h>
+
+// =============================================================================
+// ESPECIFICADORES PRINTF
+// =============================================================================
+
+typedef enum {
+    ARG_NONE,       // %% ou especificador inválido
+    ARG_INT32,      // int (inclusive h, hh e %c)
+    ARG_INT64,      // l, ll, j, z, t (com sinal)
+    ARG_UINT64,     // l, ll, j, z, t (sem sinal)
+    ARG_DOUBLE,
+    ARG_LONG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER,
+    ARG_IGNORED     // %n: consome o argumento e não grava nada
+} arg_kind_t;
+
+typedef enum {
+    LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T, LEN_BIG_L
+} arg_length_t;
+
+typedef struct {
+    const char* start;      // Aponta para o '%'
+    const char* end;        // Após o caractere de conversão
+    int star_count;         // '*' na largura/precisão (cada um é um int)
+    arg_length_t length;
+    char conversion;
+    arg_kind_t kind;
+} format_spec_t;
+
+/**
+ * @brief Interpreta um especificador a partir do '%'
+ */
+static void parse_spec(const char* p, format_spec_t* spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->start = p++;
+    
+    while (*p && strchr("-+ #0", *p)) p++;
+    if (*p == '*') { spec->star_count++; p++; }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { spec->star_count++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    
+    switch (*p) {
+        case 'h': spec->length = (p[1] == 'h') ? LEN_HH : LEN_H; p += (p[1] == 'h') ? 2 : 1; break;
+        case 'l': spec->length = (p[1] == 'l') ? LEN_LL : LEN_L; p += (p[1] == 'l') ? 2 : 1; break;
+        case 'j': spec->length = LEN_J; p++; break;
+        case 'z': spec->length = LEN_Z; p++; break;
+        case 't': spec->length = LEN_T; p++; break;
+        case 'L': spec->length = LEN_BIG_L; p++; break;
+        default: break;
+    }
+    
+    spec->conversion = *p;
+    int wide = (spec->length >= LEN_L && spec->length <= LEN_T);
+    
+    switch (*p) {
+        case 'd': case 'i':
+            spec->kind = wide ? ARG_INT64 : ARG_INT32; break;
+        case 'u': case 'o': case 'x': case 'X':
+            spec->kind = wide ? ARG_UINT64 : ARG_INT32; break;
+        case 'c':
+            spec->kind = ARG_INT32; break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            spec->kind = (spec->length == LEN_BIG_L) ? ARG_LONG_DOUBLE : ARG_DOUBLE; break;
+        case 's':
+            spec->kind = ARG_STRING; break;
+        case 'p':
+            spec->kind = ARG_POINTER; break;
+        case 'n':
+            spec->kind = ARG_IGNORED; break;
+        default:
+            spec->kind = ARG_NONE; break;
+    }
+    
+    spec->end = *p ? p + 1 : p;
+}
+
+// =============================================================================
+// EMPACOTAMENTO (produtores)
+// =============================================================================
+
+uint8_t log_byte_order(void) {
+    const uint16_t probe = 1;
+    return (*(const uint8_t*)&probe == 1) ? LOG_BYTE_ORDER_LITTLE : LOG_BYTE_ORDER_BIG;
+}
+
+size_t log_pack_args(const char* format, va_list args, uint8_t* out, size_t size) {
+    size_t used = 0;
+    
+    // Cópia própria: a lista é consumida dentro do laço
+    va_list ap;
+    va_copy(ap, args);
+    
+    for (const char* p = format; *p; ) {
+        if (*p != '%') { p++; continue; }
+        
+        format_spec_t spec;
+        parse_spec(p, &spec);
+        p = spec.end;
+        
+        for (int i = 0; i < spec.star_count; i++) {
+            int32_t v = va_arg(ap, int);
+            if (used + sizeof(v) > size) goto full;
+            memcpy(out + used, &v, sizeof(v));
+            used += sizeof(v);
+        }
+        
+        switch (spec.kind) {
+            case ARG_INT32: {
+                int32_t v = va_arg(ap, int);
+                if (used + sizeof(v) > size) goto full;
+                memcpy(out + used, &v, sizeof(v));
+                used += sizeof(v);
+                break;
+            }
+            case ARG_INT64:
+            case ARG_UINT64: {
+                uint64_t v;
+                int is_signed = (spec.kind == ARG_INT64);
+                switch (spec.length) {
+                    case LEN_L:  v = is_signed ? (uint64_t)va_arg(ap, long) : (uint64_t)va_arg(ap, unsigned long); break;
+                    case LEN_J:  v = is_signed ? (uint64_t)va_arg(ap, intmax_t) : (uint64_t)va_arg(ap, uintmax_t); break;
+                    case LEN_Z:  v = is_signed ? (uint64_t)va_arg(ap, ptrdiff_t) : (uint64_t)va_arg(ap, size_t); break;
+                    case LEN_T:  v = (uint64_t)va_arg(ap, ptrdiff_t); break;
+                    default:     v = is_signed ? (uint64_t)va_arg(ap, long long) : (uint64_t)va_arg(ap, unsigned long long); break;
+                }
+                if (used + sizeof(v) > size) goto full;
+                memcpy(out + used, &v, sizeof(v));
+                used += sizeof(v);
+                break;
+            }
+            case ARG_DOUBLE:
+            case ARG_LONG_DOUBLE: {
+                double v = (spec.kind == ARG_LONG_DOUBLE) ? (double)va_arg(ap, long double)
+                                                          : va_arg(ap, double);
+                if (used + sizeof(v) > size) goto full;
+                memcpy(out + used, &v, sizeof(v));
+                used += sizeof(v);
+                break;
+            }
+            case ARG_STRING: {
+                const char* str = va_arg(ap, const char*);
+                if (!str) str = "(null)";
+                size_t len = strlen(str);
+                if (used + 1 > size) goto full;
+                if (len > 255) len = 255;
+                if (len > size - used - 1) len = size - used - 1; // Trunca a string
+                out[used++] = (uint8_t)len;
+                memcpy(out + used, str, len);
+                used += len;
+                break;
+            }
+            case ARG_POINTER: {
+                uint64_t v = (uint64_t)(uintptr_t)va_arg(ap, void*);
+                if (used + sizeof(v) > size) goto full;
+                memcpy(out + used, &v, sizeof(v));
+                used += sizeof(v);
+                break;
+            }
+            case ARG_IGNORED:
+                (void)va_arg(ap, void*);
+                break;
+            case ARG_NONE:
+                break;
+        }
+    }
+    
+full:
+    va_end(ap);
+    return used;
+}
+
+// =============================================================================
+// FORMATAÇÃO (thread escritora e log_decoder)
+// =============================================================================
+
+/**
+ * @brief Lê um valor empacotado
+ * @return 0 se havia bytes suficientes, -1 se os argumentos acabaram
+ */
+static int take(const uint8_t* args, size_t args_size, size_t* pos, void* value, size_t n) {
+    if (*pos + n > args_size) return -1;
+    memcpy(value, args + *pos, n);
+    *pos += n;
+    return 0;
+}
+
+/**
+ * @brief Formata um especificador com até dois '*' já lidos
+ */
+#define RENDER_SPEC(out, room, fmt, stars, w, value) \
+    ((stars) == 2 ? snprintf(out, room, fmt, (w)[0], (w)[1], value) : \
+     (stars) == 1 ? snprintf(out, room, fmt, (w)[0], value) : \
+                    snprintf(out, room, fmt, value))
+
+size_t log_render(const char* format, const uint8_t* args, size_t args_size,
+                  char* out, size_t size) {
+    size_t len = 0;
+    size_t pos = 0;
+    
+    if (size == 0) return 0;
+    out[0] = '\0';
+    
+    for (const char* p = format; *p && len < size - 1; ) {
+        if (*p != '%') {
+            out[len++] = *p++;
+            continue;
+        }
+        
+        format_spec_t spec;
+        parse_spec(p, &spec);
+        p = spec.end;
+        
+        if (spec.kind == ARG_NONE) {
+            // %% e especificadores desconhecidos saem como no printf
+            if (spec.conversion == '%') out[len++] = '%';
+            continue;
+        }
+        
+        if (spec.kind == ARG_IGNORED) {
+            continue;
+        }
+        
+        int32_t stars[2] = {0, 0};
+        int missing = 0;
+        for (int i = 0; i < spec.star_count; i++) {
+            missing |= take(args, args_size, &pos, &stars[i], sizeof(int32_t));
+        }
+        
+        // Especificador sem modificador de tamanho + o tamanho do valor empacotado
+        char fmt[32];
+        size_t flen = 0;
+        for (const char* q = spec.start; q < spec.end - 1 && flen < sizeof(fmt) - 4; q++) {
+            if (!strchr("hljztL", *q)) fmt[flen++] = *q;
+        }
+        if (spec.kind == ARG_INT64 || spec.kind == ARG_UINT64) {
+            fmt[flen++] = 'l';
+            fmt[flen++] = 'l';
+        }
+        fmt[flen++] = spec.conversion;
+        fmt[flen] = '\0';
+        
+        size_t room = size - len;
+        int n = 0;
+        
+        switch (spec.kind) {
+            case ARG_INT32: {
+                int32_t v;
+                if ((missing |= take(args, args_size, &pos, &v, sizeof(v)))) break;
+                n = RENDER_SPEC(out + len, room, fmt, spec.star_count, stars, (int)v);
+                break;
+            }
+            case ARG_INT64:
+            case ARG_UINT64: {
+                uint64_t v;
+                if ((missing |= take(args, args_size, &pos, &v, sizeof(v)))) break;
+                if (spec.kind == ARG_INT64) {
+                    n = RENDER_SPEC(out + len, room, fmt, spec.star_count, stars, (long long)v);
+                } else {
+                    n = RENDER_SPEC(out + len, room, fmt, spec.star_count, stars, (unsigned long long)v);
+                }
+                break;
+            }
+            case ARG_DOUBLE:
+            case ARG_LONG_DOUBLE: {
+                double v;
+                if ((missing |= take(args, args_size, &pos, &v, sizeof(v)))) break;
+                n = RENDER_SPEC(out + len, room, fmt, spec.star_count, stars, v);
+                break;
+            }
+            case ARG_STRING: {
+                uint8_t slen;
+                char str[256];
+                if ((missing |= take(args, args_size, &pos, &slen, 1))) break;
+                if ((missing |= take(args, args_size, &pos, str, slen))) break;
+                str[slen] = '\0';
+                n = RENDER_SPEC(out + len, room, fmt, spec.star_count, stars, str);
+                break;
+            }
+            case ARG_POINTER: {
+                uint64_t v;
+                if ((missing |= take(args, args_size, &pos, &v, sizeof(v)))) break;
+                n = RENDER_SPEC(out + len, room, fmt, spec.star_count, stars, (void*)(uintptr_t)v);
+                break;
+            }
+            default:
+                break;
+        }
+        
+        if (missing) {
+            n = snprintf(out + len, room, "?"); // Argumento truncado no empacotamento
+        }
+        
+        if (n > 0) {
+            len += ((size_t)n < room) ? (size_t)n : room - 1;
+        }
+    }
+    
+    out[len] = '\0';
+    return len;
+}
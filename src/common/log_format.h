@@ -0,0 +1,77 @@
+/**
+ * @file log_format.h
+ * @brief Formato binário do log de eventos (compartilhado com o log_decoder)
+ */
+
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// ARQUIVO BINÁRIO
+// =============================================================================
+//
+// Cabeçalho: [magic:4][versão:1][ordem dos bytes:1]
+// Registro:  [tipo:1][tamanho:2][corpo]
+//
+//   MODULE: [id:1][nome]
+//   FORMAT: [id:2][string de formato]
+//   EVENT:  [timestamp_us:8][nível:1][módulo:1][formato:2][argumentos]
+//   TEXT:   [timestamp_us:8][nível:1][módulo:1][mensagem já formatada]
+//
+// Inteiros na ordem de bytes da máquina que gravou (informada no cabeçalho).
+// Definições de módulo e formato são reemitidas em cada arquivo, então todo
+// arquivo rotacionado decodifica sozinho.
+
+#define LOG_BINARY_MAGIC        "PKLG"
+#define LOG_BINARY_VERSION      1
+#define LOG_BINARY_HEADER_SIZE  6
+#define LOG_RECORD_HEADER_SIZE  3
+#define LOG_EVENT_HEADER_SIZE   12
+
+#define LOG_BYTE_ORDER_LITTLE   1
+#define LOG_BYTE_ORDER_BIG      2
+
+typedef enum {
+    LOG_REC_MODULE = 1,
+    LOG_REC_FORMAT,
+    LOG_REC_EVENT,
+    LOG_REC_TEXT
+} log_record_type_t;
+
+/**
+ * @brief Ordem de bytes desta máquina (LOG_BYTE_ORDER_*)
+ */
+uint8_t log_byte_order(void);
+
+/**
+ * @brief Copia os argumentos de uma chamada printf em forma binária
+ *
+ * Percorre apenas os especificadores do formato (sem formatar nada):
+ * inteiros ocupam 4 ou 8 bytes, double 8, ponteiro 8 e %s vira
+ * [tamanho:1][bytes]. Argumentos que não cabem em size são descartados.
+ *
+ * @param format String de formato printf
+ * @param args Argumentos da chamada
+ * @param out Buffer de saída
+ * @param size Tamanho do buffer
+ * @return Bytes escritos em out
+ */
+size_t log_pack_args(const char* format, va_list args, uint8_t* out, size_t size);
+
+/**
+ * @brief Formata uma mensagem a partir de argumentos empacotados
+ * @param format String de formato usada no empacotamento
+ * @param args Argumentos de log_pack_args
+ * @param args_size Tamanho de args
+ * @param out Texto de saída (sempre terminado em '\0')
+ * @param size Tamanho de out
+ * @return Tamanho do texto (truncado em size - 1)
+ */
+size_t log_render(const char* format, const uint8_t* args, size_t args_size,
+                  char* out, size_t size);
+
+#endif // LOG_FORMAT_H
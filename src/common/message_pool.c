@@ -0,0 +1,313 @@
+/**
+ * @file message_pool.c
+ * @brief Pools fixos sem heap no caminho quente
+ *
+ * Mensagens, textos e resumos de métricas vivem em arrays estáticos; o slot livre é achado num
+ * bitmap com CAS, sem trava. Blocos de buffer são separados por classes de
+ * potência de 2: um bloco liberado volta para a lista da sua classe (até
+ * MESSAGE_BLOCK_CACHE_PER_CLASS) e é entregue de novo no próximo pedido.
+ */
+
+#include "message_pool.h"
+#include "system_logger.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#if MESSAGE_POOL_SIZE > 64 || MESSAGE_TEXT_SLOTS > 32 || MESSAGE_METRICS_SLOTS > 32
+#error "Bitmaps de message_pool limitados a 64 mensagens, 32 textos e 32 resumos"
+#endif
+
+// Texto e resumo ficam fora: a mensagem cabe em duas linhas de cache
+typedef char system_message_fits_128[(sizeof(system_message_t) <= 128) ? 1 : -1];
+
+// =============================================================================
+// ESTADO
+// =============================================================================
+
+static system_message_t messages[MESSAGE_POOL_SIZE];
+static uint64_t messages_used;
+
+static char texts[MESSAGE_TEXT_SLOTS][MESSAGE_TEXT_MAX];
+static uint32_t texts_used;
+
+static metrics_report_t reports[MESSAGE_METRICS_SLOTS];
+static uint32_t reports_used;
+
+static uint32_t exhausted_count;
+
+// Classes de 64 B a 16 KB; maiores vão direto ao malloc
+#define BLOCK_MIN_SHIFT   6
+#define BLOCK_CLASSES     9
+#define BLOCK_NO_CLASS    0xFFFFFFFFu
+
+// Cabeçalho de 16 bytes mantém o alinhamento do malloc para o chamador
+typedef struct {
+    uint32_t block_class;
+    uint32_t reserved[3];
+} block_header_t;
+
+typedef struct free_block {
+    struct free_block* next;
+} free_block_t;
+
+static struct {
+    pthread_mutex_t mutex;
+    free_block_t* free_list[BLOCK_CLASSES];
+    uint32_t free_count[BLOCK_CLASSES];
+    uint32_t cached;
+    uint64_t hits;
+    uint64_t misses;
+} blocks = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+/**
+ * @brief Marca o primeiro bit livre do bitmap
+ * @return Índice do bit ou -1 se todos ocupados
+ */
+static int bitmap_claim64(uint64_t* bitmap, int bits) {
+    uint64_t used = __atomic_load_n(bitmap, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        uint64_t free_bits = ~used & (bits == 64 ? ~0ull : ((1ull << bits) - 1));
+        if (free_bits == 0) return -1;
+    
+        int index = __builtin_ctzll(free_bits);
+        if (__atomic_compare_exchange_n(bitmap, &used, used | (1ull << index), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return index;
+        }
+    }
+}
+
+static int bitmap_claim32(uint32_t* bitmap, int bits) {
+    uint32_t used = __atomic_load_n(bitmap, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        uint32_t free_bits = ~used & (bits == 32 ? ~0u : ((1u << bits) - 1));
+        if (free_bits == 0) return -1;
+    
+        int index = __builtin_ctz(free_bits);
+        if (__atomic_compare_exchange_n(bitmap, &used, used | (1u << index), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return index;
+        }
+    }
+}
+
+static uint32_t block_class_for(size_t size) {
+    size_t total = size + sizeof(block_header_t);
+    
+    for (uint32_t cls = 0; cls < BLOCK_CLASSES; cls++) {
+        if (total <= ((size_t)1 << (BLOCK_MIN_SHIFT + cls))) return cls;
+    }
+    return BLOCK_NO_CLASS;
+}
+
+static size_t block_capacity(uint32_t cls) {
+    return ((size_t)1 << (BLOCK_MIN_SHIFT + cls)) - sizeof(block_header_t);
+}
+
+// =============================================================================
+// TEXTOS, RESUMOS E MENSAGENS
+// =============================================================================
+
+message_text_t message_text_put(const char* text, size_t len) {
+    if (!text) return MESSAGE_TEXT_NONE;
+    
+    int slot = bitmap_claim32(&texts_used, MESSAGE_TEXT_SLOTS);
+    if (slot < 0) {
+        __atomic_add_fetch(&exhausted_count, 1, __ATOMIC_RELAXED);
+        LOG_WARN("POOL", "Pool de textos esgotado (%d slots) - texto descartado", MESSAGE_TEXT_SLOTS);
+        return MESSAGE_TEXT_NONE;
+    }
+    
+    if (len > MESSAGE_TEXT_MAX - 1) len = MESSAGE_TEXT_MAX - 1;
+    memcpy(texts[slot], text, len);
+    texts[slot][len] = '\0';
+    return (message_text_t)(slot + 1);
+}
+
+const char* message_text_get(message_text_t id) {
+    if (id == MESSAGE_TEXT_NONE || id > MESSAGE_TEXT_SLOTS) return "";
+    return texts[id - 1];
+}
+
+void message_text_release(message_text_t id) {
+    if (id == MESSAGE_TEXT_NONE || id > MESSAGE_TEXT_SLOTS) return;
+    __atomic_and_fetch(&texts_used, ~(1u << (id - 1)), __ATOMIC_RELEASE);
+}
+
+message_metrics_t message_metrics_put(const metrics_report_t* report) {
+    if (!report) return MESSAGE_METRICS_NONE;
+    
+    int slot = bitmap_claim32(&reports_used, MESSAGE_METRICS_SLOTS);
+    if (slot < 0) {
+        __atomic_add_fetch(&exhausted_count, 1, __ATOMIC_RELAXED);
+        LOG_WARN("POOL", "Pool de métricas esgotado (%d slots) - resumo descartado", MESSAGE_METRICS_SLOTS);
+        return MESSAGE_METRICS_NONE;
+    }
+    
+    reports[slot] = *report;
+    return (message_metrics_t)(slot + 1);
+}
+
+const metrics_report_t* message_metrics_get(message_metrics_t id) {
+    if (id == MESSAGE_METRICS_NONE || id > MESSAGE_METRICS_SLOTS) return NULL;
+    return &reports[id - 1];
+}
+
+void message_metrics_release(message_metrics_t id) {
+    if (id == MESSAGE_METRICS_NONE || id > MESSAGE_METRICS_SLOTS) return;
+    __atomic_and_fetch(&reports_used, ~(1u << (id - 1)), __ATOMIC_RELEASE);
+}
+
+void system_message_release(system_message_t* msg) {
+    if (!msg) return;
+    
+    if (msg->type == MSG_TYPE_ERROR) {
+        message_text_release(msg->data.error_info.text);
+        msg->data.error_info.text = MESSAGE_TEXT_NONE;
+    } else if (msg->type == MSG_TYPE_METRICS) {
+        message_metrics_release(msg->data.metrics.report);
+        msg->data.metrics.report = MESSAGE_METRICS_NONE;
+    }
+}
+
+void system_message_copy_refs(system_message_t* copy) {
+    if (!copy) return;
+    
+    if (copy->type == MSG_TYPE_ERROR && copy->data.error_info.text != MESSAGE_TEXT_NONE) {
+        const char* text = message_text_get(copy->data.error_info.text);
+        copy->data.error_info.text = message_text_put(text, strlen(text));
+    } else if (copy->type == MSG_TYPE_METRICS && copy->data.metrics.report != MESSAGE_METRICS_NONE) {
+        copy->data.metrics.report = message_metrics_put(message_metrics_get(copy->data.metrics.report));
+    }
+}
+
+system_message_t* message_pool_get(void) {
+    int slot = bitmap_claim64(&messages_used, MESSAGE_POOL_SIZE);
+    if (slot < 0) {
+        __atomic_add_fetch(&exhausted_count, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    
+    memset(&messages[slot], 0, sizeof(messages[slot]));
+    return &messages[slot];
+}
+
+void message_pool_put(system_message_t* msg) {
+    if (!msg) return;
+    
+    ptrdiff_t slot = msg - messages;
+    if (slot < 0 || slot >= MESSAGE_POOL_SIZE) {
+        LOG_ERROR("POOL", "Mensagem devolvida não pertence ao pool");
+        return;
+    }
+    __atomic_and_fetch(&messages_used, ~(1ull << slot), __ATOMIC_RELEASE);
+}
+
+// =============================================================================
+// BLOCOS
+// =============================================================================
+
+void* message_block_alloc(size_t size) {
+    uint32_t cls = block_class_for(size);
+    block_header_t* header = NULL;
+    
+    if (cls != BLOCK_NO_CLASS) {
+        pthread_mutex_lock(&blocks.mutex);
+        free_block_t* block = blocks.free_list[cls];
+        if (block) {
+            blocks.free_list[cls] = block->next;
+            blocks.free_count[cls]--;
+            blocks.cached--;
+            blocks.hits++;
+        } else {
+            blocks.misses++;
+        }
+        pthread_mutex_unlock(&blocks.mutex);
+    
+        header = block ? (block_header_t*)block
+                       : malloc((size_t)1 << (BLOCK_MIN_SHIFT + cls));
+    } else {
+        header = malloc(sizeof(block_header_t) + size);
+    }
+    
+    if (!header) return NULL;
+    header->block_class = cls;
+    return header + 1;
+}
+
+void message_block_free(void* ptr) {
+    if (!ptr) return;
+    
+    block_header_t* header = (block_header_t*)ptr - 1;
+    uint32_t cls = header->block_class;
+    
+    if (cls != BLOCK_NO_CLASS) {
+        pthread_mutex_lock(&blocks.mutex);
+        if (blocks.free_count[cls] < MESSAGE_BLOCK_CACHE_PER_CLASS) {
+            free_block_t* block = (free_block_t*)header;
+            block->next = blocks.free_list[cls];
+            blocks.free_list[cls] = block;
+            blocks.free_count[cls]++;
+            blocks.cached++;
+            pthread_mutex_unlock(&blocks.mutex);
+            return;
+        }
+        pthread_mutex_unlock(&blocks.mutex);
+    }
+    free(header);
+}
+
+void* message_block_realloc(void* ptr, size_t size) {
+    if (!ptr) return message_block_alloc(size);
+    if (size == 0) {
+        message_block_free(ptr);
+        return NULL;
+    }
+    
+    block_header_t* header = (block_header_t*)ptr - 1;
+    if (header->block_class != BLOCK_NO_CLASS) {
+        size_t capacity = block_capacity(header->block_class);
+        if (size <= capacity) return ptr;
+    
+        void* grown = message_block_alloc(size);
+        if (!grown) return NULL;
+        memcpy(grown, ptr, capacity);
+        message_block_free(ptr);
+        return grown;
+    }
+    
+    // Bloco grande continua fora das classes, mas pode cair numa se encolher
+    if (block_class_for(size) == BLOCK_NO_CLASS) {
+        block_header_t* resized = realloc(header, sizeof(block_header_t) + size);
+        return resized ? resized + 1 : NULL;
+    }
+    
+    void* shrunk = message_block_alloc(size);
+    if (!shrunk) return NULL;
+    memcpy(shrunk, ptr, size);
+    free(header);
+    return shrunk;
+}
+
+void message_pool_get_stats(message_pool_stats_t* stats) {
+    if (!stats) return;
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->messages_in_use = (uint32_t)__builtin_popcountll(__atomic_load_n(&messages_used, __ATOMIC_RELAXED));
+    stats->texts_in_use = (uint32_t)__builtin_popcount(__atomic_load_n(&texts_used, __ATOMIC_RELAXED));
+    stats->reports_in_use = (uint32_t)__builtin_popcount(__atomic_load_n(&reports_used, __ATOMIC_RELAXED));
+    stats->exhausted = __atomic_load_n(&exhausted_count, __ATOMIC_RELAXED);
+    
+    pthread_mutex_lock(&blocks.mutex);
+    stats->block_hits = blocks.hits;
+    stats->block_misses = blocks.misses;
+    stats->blocks_cached = blocks.cached;
+    pthread_mutex_unlock(&blocks.mutex);
+}
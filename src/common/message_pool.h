@@ -0,0 +1,100 @@
+/**
+ * @file message_pool.h
+ * @brief Pools fixos de mensagens, textos e métricas fora da mensagem e blocos de buffer
+ */
+
+#ifndef MESSAGE_POOL_H
+#define MESSAGE_POOL_H
+
+#include "parking_system.h"
+
+/**
+ * @brief Guarda um texto num slot do pool (truncado em MESSAGE_TEXT_MAX - 1)
+ * @param text Texto
+ * @param len Comprimento (sem o terminador)
+ * @return Identificador do slot, ou MESSAGE_TEXT_NONE se o pool estiver cheio
+ */
+message_text_t message_text_put(const char* text, size_t len);
+
+/**
+ * @brief Texto de um slot
+ * @param id Identificador de message_text_put
+ * @return Texto terminado em '\0' ("" para MESSAGE_TEXT_NONE)
+ */
+const char* message_text_get(message_text_t id);
+
+/**
+ * @brief Devolve um slot de texto ao pool (MESSAGE_TEXT_NONE é ignorado)
+ */
+void message_text_release(message_text_t id);
+
+/**
+ * @brief Guarda um resumo de métricas num slot do pool
+ * @return Identificador do slot, ou MESSAGE_METRICS_NONE se o pool estiver cheio
+ */
+message_metrics_t message_metrics_put(const metrics_report_t* report);
+
+/**
+ * @brief Resumo de um slot (NULL para MESSAGE_METRICS_NONE)
+ */
+const metrics_report_t* message_metrics_get(message_metrics_t id);
+
+/**
+ * @brief Devolve um slot de resumo ao pool (MESSAGE_METRICS_NONE é ignorado)
+ */
+void message_metrics_release(message_metrics_t id);
+
+/**
+ * @brief Libera o que a mensagem referencia fora dela (texto de erro ou resumo)
+ *
+ * Deve ser chamada por quem obteve a mensagem de tcp_decode_message ou
+ * tcp_receive_message, ou montou uma com message_text_put ou
+ * metrics_build_message.
+ */
+void system_message_release(system_message_t* msg);
+
+/**
+ * @brief Dá a uma cópia por valor os próprios slots fora da mensagem
+ *
+ * Original e cópia passam a ser liberados cada um com system_message_release.
+ * Com o pool cheio a cópia segue sem o texto ou o resumo.
+ */
+void system_message_copy_refs(system_message_t* copy);
+
+/**
+ * @brief Reserva uma mensagem do pool fixo
+ * @return Mensagem zerada, ou NULL se o pool estiver esgotado
+ */
+system_message_t* message_pool_get(void);
+
+/**
+ * @brief Devolve uma mensagem ao pool (NULL é ignorado)
+ */
+void message_pool_put(system_message_t* msg);
+
+/**
+ * @brief Aloca um bloco reaproveitando os liberados de mesma classe de tamanho
+ *
+ * Para bibliotecas que aceitam alocador próprio (libevent): em regime, os
+ * buffers das conexões circulam pelo cache sem chegar ao malloc.
+ */
+void* message_block_alloc(size_t size);
+void* message_block_realloc(void* ptr, size_t size);
+void message_block_free(void* ptr);
+
+/**
+ * @brief Contadores dos pools
+ */
+typedef struct {
+    uint32_t messages_in_use;
+    uint32_t texts_in_use;
+    uint32_t reports_in_use;
+    uint32_t exhausted;             // Pedidos recusados por pool cheio
+    uint64_t block_hits;            // Blocos servidos pelo cache
+    uint64_t block_misses;          // Blocos que precisaram de malloc
+    uint32_t blocks_cached;
+} message_pool_stats_t;
+
+void message_pool_get_stats(message_pool_stats_t* stats);
+
+#endif // MESSAGE_POOL_H
@@ -0,0 +1,344 @@
+/**
+ * @file metrics.c
+ * @brief Histogramas HDR e medidores sem trava, formatação para coleta
+ *
+ * A faixa de um valor sai do bit mais significativo (expoente) e dos
+ * METRICS_HIST_SUB_BITS bits seguintes (mantissa): gravar custa três somas
+ * atômicas e, raramente, um CAS no máximo. Valores abaixo de
+ * METRICS_HIST_SUB_COUNT têm faixa própria e são exatos.
+ */
+
+#include "metrics.h"
+#include "system_logger.h"
+#include "message_pool.h"
+#include <stdarg.h>
+
+// O resumo enviado à central carrega todos os histogramas e medidores
+typedef char metrics_msg_hists_match[(METRIC_HIST_COUNT == METRICS_MSG_HISTS) ? 1 : -1];
+typedef char metrics_msg_gauges_match[(METRIC_GAUGE_COUNT == METRICS_MSG_GAUGES) ? 1 : -1];
+
+#define METRICS_PREFIX        "parking_"
+#define METRICS_FLOOR_PREFIX  "parking_floor_"
+
+// Séries do processo; entradas com o mesmo nome formam uma família (rótulos distintos)
+static const struct {
+    const char* name;
+    const char* labels;
+} hist_info[METRIC_HIST_COUNT] = {
+    [METRIC_SCAN_FLOOR_US]            = { "scan_floor_us", "" },
+    [METRIC_MODBUS_CAMERA_ENTRADA_US] = { "modbus_transaction_us", "slave=\"0x11\"" },
+    [METRIC_MODBUS_CAMERA_SAIDA_US]   = { "modbus_transaction_us", "slave=\"0x12\"" },
+    [METRIC_MODBUS_DISPLAY_US]        = { "modbus_transaction_us", "slave=\"0x20\"" },
+    [METRIC_LPR_ROUNDTRIP_US]         = { "lpr_roundtrip_us", "" },
+    [METRIC_GATE_OPEN_US]             = { "gate_open_us", "" },
+};
+
+static const char* const gauge_names[METRIC_GAUGE_COUNT] = {
+    [METRIC_TCP_SEND_QUEUE_BYTES] = "tcp_send_queue_bytes",
+    [METRIC_TCP_OFFLINE_QUEUE]    = "tcp_offline_queue_messages",
+    [METRIC_LOG_BACKLOG]          = "log_backlog_records",
+};
+
+static metrics_hist_t hists[METRIC_HIST_COUNT];
+static metrics_gauge_t gauges[METRIC_GAUGE_COUNT];
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+static inline unsigned bucket_index(uint32_t value) {
+    if (value < METRICS_HIST_SUB_COUNT) return value;
+    
+    unsigned shift = (unsigned)(31 - __builtin_clz(value)) - METRICS_HIST_SUB_BITS;
+    return ((shift + 1) << METRICS_HIST_SUB_BITS) |
+           ((value >> shift) & (METRICS_HIST_SUB_COUNT - 1));
+}
+
+/**
+ * @brief Maior valor que cai na faixa
+ */
+static uint32_t bucket_upper(unsigned index) {
+    if (index < METRICS_HIST_SUB_COUNT) return index;
+    
+    unsigned shift = (index >> METRICS_HIST_SUB_BITS) - 1;
+    uint64_t lower = (uint64_t)(METRICS_HIST_SUB_COUNT | (index & (METRICS_HIST_SUB_COUNT - 1))) << shift;
+    return (uint32_t)(lower + (1ull << shift) - 1);
+}
+
+static void atomic_max(uint32_t* target, uint32_t value) {
+    uint32_t current = __atomic_load_n(target, __ATOMIC_RELAXED);
+    while (value > current &&
+           !__atomic_compare_exchange_n(target, &current, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // current recarregado pelo CAS que falhou
+    }
+}
+
+/**
+ * @brief Acrescenta texto formatado ao buffer
+ * @return false se não coube (o buffer fica no estado anterior)
+ */
+static bool appendf(char* out, size_t size, size_t* len, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out + *len, size - *len, format, args);
+    va_end(args);
+    
+    if (n < 0 || (size_t)n >= size - *len) {
+        out[*len] = '\0';
+        return false;
+    }
+    *len += (size_t)n;
+    return true;
+}
+
+/**
+ * @brief Rótulos "{a,b}" a partir de duas listas (vazias são omitidas)
+ */
+static void join_labels(char* out, size_t size, const char* a, const char* b) {
+    bool has_a = a && a[0], has_b = b && b[0];
+    if (!has_a && !has_b) {
+        out[0] = '\0';
+    } else {
+        snprintf(out, size, "{%s%s%s}", has_a ? a : "", (has_a && has_b) ? "," : "",
+                 has_b ? b : "");
+    }
+}
+
+/**
+ * @brief Percentis, contagem e máximo de uma série (família nome + rótulos)
+ */
+static bool format_summary(char* out, size_t size, size_t* len, const char* family,
+                           const char* labels, const metrics_summary_t* summary,
+                           const uint64_t* sum) {
+    char with_p50[96], with_p99[96], plain[96];
+    join_labels(with_p50, sizeof(with_p50), labels, "quantile=\"0.5\"");
+    join_labels(with_p99, sizeof(with_p99), labels, "quantile=\"0.99\"");
+    join_labels(plain, sizeof(plain), labels, NULL);
+    
+    if (!appendf(out, size, len, "%s%s %u\n%s%s %u\n", family, with_p50, summary->p50,
+                 family, with_p99, summary->p99)) {
+        return false;
+    }
+    if (sum && !appendf(out, size, len, "%s_sum%s %llu\n", family, plain,
+                        (unsigned long long)*sum)) {
+        return false;
+    }
+    return appendf(out, size, len, "%s_count%s %u\n%s_max%s %u\n", family, plain,
+                   summary->count, family, plain, summary->max);
+}
+
+// =============================================================================
+// HISTOGRAMAS AVULSOS
+// =============================================================================
+
+void metrics_hist_record(metrics_hist_t* hist, uint32_t value) {
+    __atomic_add_fetch(&hist->buckets[bucket_index(value)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->sum, value, __ATOMIC_RELAXED);
+    atomic_max(&hist->max, value);
+}
+
+void metrics_hist_copy(const metrics_hist_t* hist, metrics_hist_t* out) {
+    for (unsigned i = 0; i < METRICS_HIST_BUCKETS; i++) {
+        out->buckets[i] = __atomic_load_n(&hist->buckets[i], __ATOMIC_RELAXED);
+    }
+    out->count = __atomic_load_n(&hist->count, __ATOMIC_RELAXED);
+    out->sum = __atomic_load_n(&hist->sum, __ATOMIC_RELAXED);
+    out->max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+}
+
+uint32_t metrics_hist_percentile(const metrics_hist_t* hist, double pct) {
+    // Total das faixas: a cópia pode ter count adiantado em relação a elas
+    uint64_t total = 0;
+    for (unsigned i = 0; i < METRICS_HIST_BUCKETS; i++) {
+        total += hist->buckets[i];
+    }
+    if (total == 0) return 0;
+    
+    uint64_t rank = (uint64_t)(pct / 100.0 * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+    
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < METRICS_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            return MIN(bucket_upper(i), hist->max);
+        }
+    }
+    return hist->max;
+}
+
+void metrics_hist_summary(const metrics_hist_t* hist, metrics_summary_t* out) {
+    out->count = (uint32_t)MIN(hist->count, UINT32_MAX);
+    out->p50 = metrics_hist_percentile(hist, 50.0);
+    out->p99 = metrics_hist_percentile(hist, 99.0);
+    out->max = hist->max;
+}
+
+// =============================================================================
+// REGISTROS DO PROCESSO
+// =============================================================================
+
+uint64_t metrics_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+void metrics_observe(metric_hist_id_t id, uint64_t value_us) {
+    if ((unsigned)id >= METRIC_HIST_COUNT) return;
+    metrics_hist_record(&hists[id], (uint32_t)MIN(value_us, UINT32_MAX));
+}
+
+void metrics_gauge_set(metric_gauge_id_t id, uint32_t value) {
+    if ((unsigned)id >= METRIC_GAUGE_COUNT) return;
+    __atomic_store_n(&gauges[id].value, value, __ATOMIC_RELAXED);
+    atomic_max(&gauges[id].max, value);
+}
+
+void metrics_get_hist(metric_hist_id_t id, metrics_hist_t* out) {
+    if ((unsigned)id >= METRIC_HIST_COUNT) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    metrics_hist_copy(&hists[id], out);
+}
+
+void metrics_get_gauge(metric_gauge_id_t id, metrics_gauge_t* out) {
+    if ((unsigned)id >= METRIC_GAUGE_COUNT) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    out->value = __atomic_load_n(&gauges[id].value, __ATOMIC_RELAXED);
+    out->max = __atomic_load_n(&gauges[id].max, __ATOMIC_RELAXED);
+}
+
+const char* metrics_hist_name(metric_hist_id_t id) {
+    return ((unsigned)id < METRIC_HIST_COUNT) ? hist_info[id].name : "?";
+}
+
+const char* metrics_hist_labels(metric_hist_id_t id) {
+    return ((unsigned)id < METRIC_HIST_COUNT) ? hist_info[id].labels : "";
+}
+
+const char* metrics_gauge_name(metric_gauge_id_t id) {
+    return ((unsigned)id < METRIC_GAUGE_COUNT) ? gauge_names[id] : "?";
+}
+
+void metrics_reset(void) {
+    for (int id = 0; id < METRIC_HIST_COUNT; id++) {
+        metrics_hist_t* hist = &hists[id];
+        for (unsigned i = 0; i < METRICS_HIST_BUCKETS; i++) {
+            __atomic_store_n(&hist->buckets[i], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&hist->count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&hist->sum, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&hist->max, 0, __ATOMIC_RELAXED);
+    }
+    for (int id = 0; id < METRIC_GAUGE_COUNT; id++) {
+        __atomic_store_n(&gauges[id].value, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&gauges[id].max, 0, __ATOMIC_RELAXED);
+    }
+}
+
+int metrics_format(char* out, size_t size) {
+    if (!out || size == 0) return -1;
+    
+    size_t len = 0;
+    out[0] = '\0';
+    char family[64];
+    
+    for (int id = 0; id < METRIC_HIST_COUNT; id++) {
+        snprintf(family, sizeof(family), METRICS_PREFIX "%s", hist_info[id].name);
+    
+        // Entradas consecutivas com o mesmo nome: um único TYPE para a família
+        if ((id == 0 || strcmp(hist_info[id].name, hist_info[id - 1].name) != 0) &&
+            !appendf(out, size, &len, "# TYPE %s summary\n", family)) {
+            return -1;
+        }
+    
+        metrics_hist_t copy;
+        metrics_summary_t summary;
+        metrics_hist_copy(&hists[id], &copy);
+        metrics_hist_summary(&copy, &summary);
+        if (!format_summary(out, size, &len, family, hist_info[id].labels, &summary, &copy.sum)) {
+            return -1;
+        }
+    }
+    
+    for (int id = 0; id < METRIC_GAUGE_COUNT; id++) {
+        metrics_gauge_t gauge;
+        metrics_get_gauge((metric_gauge_id_t)id, &gauge);
+        if (!appendf(out, size, &len, "# TYPE " METRICS_PREFIX "%s gauge\n"
+                     METRICS_PREFIX "%s %u\n" METRICS_PREFIX "%s_max %u\n",
+                     gauge_names[id], gauge_names[id], gauge.value, gauge_names[id], gauge.max)) {
+            return -1;
+        }
+    }
+    
+    return (int)len;
+}
+
+// =============================================================================
+// EXPORTAÇÃO PARA A CENTRAL
+// =============================================================================
+
+void metrics_build_message(floor_id_t floor, system_message_t* msg) {
+    memset(msg, 0, sizeof(*msg));
+    msg->type = MSG_TYPE_METRICS;
+    msg->timestamp = time(NULL);
+    msg->data.metrics.floor = floor;
+    
+    metrics_report_t report;
+    for (int id = 0; id < METRIC_HIST_COUNT; id++) {
+        metrics_hist_t copy;
+        metrics_hist_copy(&hists[id], &copy);
+        metrics_hist_summary(&copy, &report.hist[id]);
+    }
+    for (int id = 0; id < METRIC_GAUGE_COUNT; id++) {
+        metrics_get_gauge((metric_gauge_id_t)id, &report.gauge[id]);
+    }
+    msg->data.metrics.report = message_metrics_put(&report);
+}
+
+int metrics_format_floors(const metrics_report_t* const* reports, int count, char* out, size_t size) {
+    if (!reports || !out || size == 0) return -1;
+    
+    size_t len = 0;
+    out[0] = '\0';
+    char family[64];
+    char labels[64];
+    
+    // Sem TYPE: resumos sem soma, expostos como séries sem tipo
+    for (int id = 0; id < METRIC_HIST_COUNT; id++) {
+        snprintf(family, sizeof(family), METRICS_FLOOR_PREFIX "%s", hist_info[id].name);
+    
+        for (int i = 0; i < count; i++) {
+            if (!reports[i] || reports[i]->hist[id].count == 0) continue;
+    
+            snprintf(labels, sizeof(labels), "floor=\"%d\"%s%s", i,
+                     hist_info[id].labels[0] ? "," : "", hist_info[id].labels);
+            if (!format_summary(out, size, &len, family, labels, &reports[i]->hist[id], NULL)) {
+                return -1;
+            }
+        }
+    }
+    
+    for (int id = 0; id < METRIC_GAUGE_COUNT; id++) {
+        for (int i = 0; i < count; i++) {
+            if (!reports[i]) continue;
+    
+            const metrics_gauge_t* gauge = &reports[i]->gauge[id];
+            int floor = i;
+            if (!appendf(out, size, &len, METRICS_FLOOR_PREFIX "%s{floor=\"%d\"} %u\n"
+                         METRICS_FLOOR_PREFIX "%s_max{floor=\"%d\"} %u\n",
+                         gauge_names[id], floor, gauge->value, gauge_names[id], floor, gauge->max)) {
+                return -1;
+            }
+        }
+    }
+    
+    return (int)len;
+}
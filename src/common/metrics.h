@@ -0,0 +1,167 @@
+/**
+ * @file metrics.h
+ * @brief Métricas do caminho quente: histogramas de latência e medidores
+ *
+ * Registro sem trava: qualquer thread (inclusive callbacks do pigpio) grava
+ * com operações atômicas, sem alocar e sem bloquear. Os histogramas são
+ * log-lineares no estilo HDR: 2^METRICS_HIST_SUB_BITS faixas por potência
+ * de 2, erro relativo de até 1/2^METRICS_HIST_SUB_BITS em qualquer escala.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "parking_system.h"
+
+// Faixas por potência de 2 (3 = 8 faixas, até 12,5% de erro)
+#define METRICS_HIST_SUB_BITS   3
+#define METRICS_HIST_SUB_COUNT  (1u << METRICS_HIST_SUB_BITS)
+#define METRICS_HIST_BUCKETS    ((32 - METRICS_HIST_SUB_BITS + 1) * METRICS_HIST_SUB_COUNT)
+
+/**
+ * @brief Histograma de valores de 32 bits (microssegundos, em geral)
+ */
+typedef struct {
+    uint32_t buckets[METRICS_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint32_t max;
+} metrics_hist_t;
+
+/**
+ * @brief Histogramas do processo (ver metrics.c para nomes e rótulos)
+ */
+typedef enum {
+    METRIC_SCAN_FLOOR_US = 0,       // parking_scan_floor
+    METRIC_MODBUS_CAMERA_ENTRADA_US,// Transação MODBUS por escravo
+    METRIC_MODBUS_CAMERA_SAIDA_US,
+    METRIC_MODBUS_DISPLAY_US,
+    METRIC_LPR_ROUNDTRIP_US,        // Presença na cancela -> placa lida
+    METRIC_GATE_OPEN_US,            // Comando de abertura -> fim de curso
+    METRIC_HIST_COUNT               // = METRICS_MSG_HISTS
+} metric_hist_id_t;
+
+/**
+ * @brief Medidores do processo
+ */
+typedef enum {
+    METRIC_TCP_SEND_QUEUE_BYTES = 0,    // Aguardando envio na conexão que acabou de enfileirar
+    METRIC_TCP_OFFLINE_QUEUE,           // Mensagens na fila offline de um andar
+    METRIC_LOG_BACKLOG,                 // Registros na fila do logger
+    METRIC_GAUGE_COUNT                  // = METRICS_MSG_GAUGES
+} metric_gauge_id_t;
+
+// =============================================================================
+// HISTOGRAMAS AVULSOS
+// =============================================================================
+
+/**
+ * @brief Acrescenta um valor (sem trava)
+ */
+void metrics_hist_record(metrics_hist_t* hist, uint32_t value);
+
+/**
+ * @brief Copia um histograma que pode estar recebendo valores
+ *
+ * Cada contador é lido atomicamente; o conjunto pode misturar valores de
+ * gravações simultâneas, o que basta para percentis.
+ */
+void metrics_hist_copy(const metrics_hist_t* hist, metrics_hist_t* out);
+
+/**
+ * @brief Percentil de uma cópia (limite superior da faixa, até o máximo)
+ * @param pct Percentil (0-100)
+ * @return Valor, ou 0 se vazio
+ */
+uint32_t metrics_hist_percentile(const metrics_hist_t* hist, double pct);
+
+/**
+ * @brief Contagem, p50, p99 e máximo de uma cópia
+ */
+void metrics_hist_summary(const metrics_hist_t* hist, metrics_summary_t* out);
+
+// =============================================================================
+// REGISTROS DO PROCESSO
+// =============================================================================
+
+/**
+ * @brief Relógio monotônico em microssegundos (base das durações)
+ */
+uint64_t metrics_now_us(void);
+
+/**
+ * @brief Registra uma duração num histograma do processo
+ */
+void metrics_observe(metric_hist_id_t id, uint64_t value_us);
+
+/**
+ * @brief Registra a duração desde start_us (de metrics_now_us)
+ */
+static inline void metrics_observe_since(metric_hist_id_t id, uint64_t start_us) {
+    metrics_observe(id, metrics_now_us() - start_us);
+}
+
+/**
+ * @brief Atualiza um medidor (valor atual e máximo)
+ */
+void metrics_gauge_set(metric_gauge_id_t id, uint32_t value);
+
+/**
+ * @brief Cópia de um histograma do processo
+ */
+void metrics_get_hist(metric_hist_id_t id, metrics_hist_t* out);
+
+/**
+ * @brief Leitura de um medidor do processo
+ */
+void metrics_get_gauge(metric_gauge_id_t id, metrics_gauge_t* out);
+
+/**
+ * @brief Nome de um histograma do processo
+ */
+const char* metrics_hist_name(metric_hist_id_t id);
+
+/**
+ * @brief Rótulos de um histograma do processo ("" se nenhum)
+ */
+const char* metrics_hist_labels(metric_hist_id_t id);
+
+/**
+ * @brief Nome de um medidor do processo
+ */
+const char* metrics_gauge_name(metric_gauge_id_t id);
+
+/**
+ * @brief Zera histogramas e medidores (benchmark)
+ */
+void metrics_reset(void);
+
+/**
+ * @brief Formata as métricas do processo no formato texto do Prometheus
+ * @param out Buffer de saída
+ * @param size Tamanho do buffer
+ * @return Bytes escritos, ou -1 se não coube
+ */
+int metrics_format(char* out, size_t size);
+
+// =============================================================================
+// EXPORTAÇÃO PARA A CENTRAL
+// =============================================================================
+
+/**
+ * @brief Monta o resumo das métricas deste processo para a central
+ *
+ * O resumo fica num slot do pool (message_pool.h): liberar a mensagem com
+ * system_message_release depois de enviá-la.
+ */
+void metrics_build_message(floor_id_t floor, system_message_t* msg);
+
+/**
+ * @brief Formata os resumos recebidos dos andares (séries parking_floor_*)
+ * @param reports Último resumo de cada andar, indexado pelo andar (NULL = sem resumo)
+ * @param count Entradas em reports
+ * @return Bytes escritos, ou -1 se não coube
+ */
+int metrics_format_floors(const metrics_report_t* const* reports, int count, char* out, size_t size);
+
+#endif // METRICS_H
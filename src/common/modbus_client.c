@@ -5,6 +5,7 @@
 
 #include "modbus_client.h"
 #include "system_logger.h"
+#include "metrics.h"
 #include <modbus/modbus.h>
 #include <string.h>
 #include <unistd.h>
@@ -23,6 +24,83 @@ static int current_timeout_ms = MODBUS_TIMEOUT_MS;
 static int current_retries = MODBUS_MAX_RETRIES;
 static bool debug_enabled = false;
 
+// Placar: cópia do que ele exibe e último estado pedido (protegidos por modbus_mutex)
+static uint16_t display_shadow[DISPLAY_REG_COUNT];
+static uint16_t display_pending[DISPLAY_REG_COUNT];
+static uint16_t display_known = 0;      // Bit i: display_shadow[i] é confiável
+static uint16_t display_requested = 0;  // Bit i: display_pending[i] foi definido
+
+// =============================================================================
+// ESCALONADOR DO BARRAMENTO
+// =============================================================================
+//
+// Uma única thread executa as transações, uma por vez, escolhendo entre as
+// prontas a de maior prioridade. Uma captura é dividida em passos (disparo,
+// polls de status, leitura) e devolve o barramento entre eles. As chamadas
+// síncronas (disparo avulso, status, reset, leitura do placar, teste) entram
+// na mesma fila, atrás de capturas e placar, e o chamador espera o resultado.
+
+typedef enum {
+    BUS_PRIORITY_CAMERA_ENTRADA = 0,    // Carro parado na cancela de entrada
+    BUS_PRIORITY_CAMERA_SAIDA,
+    BUS_PRIORITY_DISPLAY,
+    BUS_PRIORITY_CALL                   // Chamadas síncronas da API
+} bus_priority_t;
+
+typedef enum {
+    BUS_JOB_CAMERA,     // Captura de placa
+    BUS_JOB_DISPLAY,    // Escrita dos registradores sujos do placar
+    BUS_JOB_CALL        // Função executada com o barramento (chamador aguarda)
+} bus_job_kind_t;
+
+// Executada na thread do barramento com modbus_mutex travado
+typedef int (*bus_call_fn_t)(void* arg);
+
+// Espera de uma chamada síncrona (na pilha do chamador, protegida por bus_mutex)
+typedef struct {
+    bool done;
+    int rc;
+} bus_call_wait_t;
+
+typedef enum {
+    CAMERA_STEP_TRIGGER,
+    CAMERA_STEP_POLL
+} camera_step_t;
+
+typedef struct {
+    bool in_use;
+    bus_job_kind_t kind;
+    bus_priority_t priority;
+    uint32_t order;                 // Desempate FIFO dentro da mesma prioridade
+    struct timespec ready_at;       // Próximo passo não antes disso
+    
+    // Captura
+    camera_type_t camera;
+    camera_step_t step;
+    struct timespec deadline;
+    int poll_interval_ms;
+    plate_reading_t result;
+    int status;
+    modbus_plate_callback_t callback;
+    void* user_data;
+    
+    // Chamada síncrona
+    bus_call_fn_t call;
+    void* call_arg;
+    bus_call_wait_t* wait;
+} bus_job_t;
+
+static bus_job_t bus_jobs[MODBUS_MAX_PENDING_JOBS];
+static uint32_t bus_job_order = 0;
+static bool display_job_queued = false;
+static struct timespec display_last_write;
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bus_cond;
+static pthread_cond_t bus_call_cond;   // Alguma chamada síncrona terminou
+static bool bus_cond_initialized = false;
+static pthread_t bus_thread;
+static bool bus_running = false;
+
 // =============================================================================
 // FUNÇÕES AUXILIARES
 // =============================================================================
@@ -79,6 +157,30 @@ static int add_matricula_to_message(uint8_t* buffer, int length) {
     return length;
 }
 
+/**
+ * @brief Soma milissegundos a um instante
+ */
+static struct timespec ts_add_ms(struct timespec t, long ms) {
+    t.tv_nsec += (ms % 1000) * 1000000L;
+    t.tv_sec += ms / 1000 + t.tv_nsec / 1000000000L;
+    t.tv_nsec %= 1000000000L;
+    return t;
+}
+
+/**
+ * @brief Compara dois instantes (a anterior a b)
+ */
+static bool ts_before(const struct timespec* a, const struct timespec* b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static const char* camera_name(camera_type_t camera) {
+    return (camera == CAMERA_ENTRADA) ? "ENTRADA" : "SAÍDA";
+}
+
+static int display_flush_locked(void);
+static void* bus_thread_main(void* arg);
+
 // =============================================================================
 // FUNÇÕES PÚBLICAS - INICIALIZAÇÃO
 // =============================================================================
@@ -122,6 +224,34 @@ int modbus_init(const char* device, int baudrate) {
     // Zerar estatísticas
     memset(&stats, 0, sizeof(stats));
     
+    // Conteúdo do placar desconhecido: o estado pedido é reenviado por inteiro
+    display_known = 0;
+    
+    // Thread dona do barramento
+    if (!bus_cond_initialized) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&bus_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        pthread_cond_init(&bus_call_cond, NULL);
+        bus_cond_initialized = true;
+    }
+    
+    memset(bus_jobs, 0, sizeof(bus_jobs));
+    memset(&display_last_write, 0, sizeof(display_last_write));
+    display_job_queued = false;
+    bus_running = true;
+    
+    if (pthread_create(&bus_thread, NULL, bus_thread_main, NULL) != 0) {
+        LOG_ERROR("MODBUS", "Erro ao criar thread do barramento");
+        bus_running = false;
+        modbus_close(ctx);
+        modbus_free(ctx);
+        ctx = NULL;
+        return -1;
+    }
+    
     initialized = true;
     LOG_INFO("MODBUS", "Cliente MODBUS inicializado com sucesso");
     
@@ -133,6 +263,13 @@ void modbus_cleanup(void) {
     
     LOG_INFO("MODBUS", "Finalizando cliente MODBUS...");
     
+    // Parar o barramento antes de fechar o contexto (capturas pendentes falham)
+    pthread_mutex_lock(&bus_mutex);
+    bus_running = false;
+    pthread_cond_signal(&bus_cond);
+    pthread_mutex_unlock(&bus_mutex);
+    pthread_join(bus_thread, NULL);
+    
     pthread_mutex_lock(&modbus_mutex);
     
     if (ctx) {
@@ -152,21 +289,28 @@ bool modbus_is_initialized(void) {
 }
 
 // =============================================================================
-// FUNÇÕES PÚBLICAS - CÂMERA LPR
+// FUNÇÕES AUXILIARES - CÂMERA LPR (chamar com modbus_mutex travado)
 // =============================================================================
 
-int modbus_camera_trigger(camera_type_t camera) {
-    if (!initialized || !ctx) {
-        LOG_ERROR("MODBUS", "Cliente não inicializado");
-        return -1;
+/**
+ * @brief Registra a duração de uma transação no histograma do escravo
+ */
+static void observe_transaction(uint8_t slave, uint64_t start_us) {
+    switch (slave) {
+        case MODBUS_ADDR_CAMERA_ENTRADA: metrics_observe_since(METRIC_MODBUS_CAMERA_ENTRADA_US, start_us); break;
+        case MODBUS_ADDR_CAMERA_SAIDA:   metrics_observe_since(METRIC_MODBUS_CAMERA_SAIDA_US, start_us); break;
+        case MODBUS_ADDR_DISPLAY:        metrics_observe_since(METRIC_MODBUS_DISPLAY_US, start_us); break;
+        default: break;
     }
-    
-    const char* camera_name = (camera == CAMERA_ENTRADA) ? "ENTRADA" : "SAÍDA";
-    LOG_DEBUG("MODBUS", "Disparando câmera %s (0x%02X)", camera_name, camera);
-    
-    pthread_mutex_lock(&modbus_mutex);
-    
+}
+
+/**
+ * @brief Envia o disparo (Write Single Register 0x06 com matrícula)
+ * @return 0 se sucesso, -1 se erro
+ */
+static int camera_trigger_locked(camera_type_t camera) {
     modbus_set_slave(ctx, camera);
+    uint64_t start_us = metrics_now_us();
     
     // Preparar mensagem Write Single Register (0x06)
     uint8_t req[256];
@@ -193,9 +337,9 @@ int modbus_camera_trigger(camera_type_t camera) {
     int rc = modbus_send_raw_request(ctx, req, req_length);
     if (rc == -1) {
         LOG_ERROR("MODBUS", "Erro ao disparar câmera %s: %s", 
-                  camera_name, modbus_strerror(errno));
+                  camera_name(camera), modbus_strerror(errno));
         stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
+        observe_transaction(camera, start_us);
         return -1;
     }
     
@@ -204,97 +348,72 @@ int modbus_camera_trigger(camera_type_t camera) {
     rc = modbus_receive_confirmation(ctx, rsp);
     if (rc == -1) {
         LOG_ERROR("MODBUS", "Erro ao receber confirmação da câmera %s: %s",
-                  camera_name, modbus_strerror(errno));
+                  camera_name(camera), modbus_strerror(errno));
         stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
+        observe_transaction(camera, start_us);
         return -1;
     }
     
     stats.responses_received++;
-    pthread_mutex_unlock(&modbus_mutex);
-    
-    LOG_INFO("MODBUS", "Câmera %s disparada com sucesso", camera_name);
+    observe_transaction(camera, start_us);
     return 0;
 }
 
-int modbus_camera_read_plate(camera_type_t camera, plate_reading_t* result, int timeout_ms) {
-    if (!initialized || !ctx || !result) {
-        LOG_ERROR("MODBUS", "Parâmetros inválidos");
-        return -1;
-    }
-    
-    memset(result, 0, sizeof(plate_reading_t));
-    result->timestamp = time(NULL);
-    
-    if (timeout_ms <= 0) {
-        timeout_ms = 2000; // Default 2 segundos
-    }
-    
-    const char* camera_name = (camera == CAMERA_ENTRADA) ? "ENTRADA" : "SAÍDA";
-    LOG_DEBUG("MODBUS", "Lendo placa da câmera %s (timeout: %dms)", 
-              camera_name, timeout_ms);
-    
-    pthread_mutex_lock(&modbus_mutex);
+/**
+ * @brief Lê o registrador de status da câmera
+ * @return Status (0-3) ou -1 se erro
+ */
+static int camera_read_status_locked(camera_type_t camera) {
     modbus_set_slave(ctx, camera);
+    uint64_t start_us = metrics_now_us();
     
-    // Polling do status até OK ou ERROR
-    int elapsed = 0;
-    const int poll_interval = 100; // 100ms
-    int status = -1;
-    
-    while (elapsed < timeout_ms) {
-        uint16_t status_reg;
-        stats.requests_sent++;
-        
-        if (modbus_read_registers(ctx, LPR_REG_STATUS, 1, &status_reg) != 1) {
-            LOG_DEBUG("MODBUS", "Erro ao ler status da câmera %s", camera_name);
-            stats.errors++;
-        } else {
-            stats.responses_received++;
-            status = (int)status_reg;
-            
-            if (status == LPR_STATUS_OK) {
-                LOG_DEBUG("MODBUS", "Câmera %s: captura OK", camera_name);
-                break;
-            } else if (status == LPR_STATUS_ERROR) {
-                LOG_ERROR("MODBUS", "Câmera %s retornou erro", camera_name);
-                pthread_mutex_unlock(&modbus_mutex);
-                return -1;
-            }
-            // Status PROCESSING ou READY - continua polling
-        }
-        
-        pthread_mutex_unlock(&modbus_mutex);
-        usleep(poll_interval * 1000);
-        pthread_mutex_lock(&modbus_mutex);
-        elapsed += poll_interval;
-    }
+    uint16_t status_reg;
+    stats.requests_sent++;
     
-    if (status != LPR_STATUS_OK) {
-        LOG_ERROR("MODBUS", "Timeout aguardando câmera %s", camera_name);
-        stats.timeouts++;
-        pthread_mutex_unlock(&modbus_mutex);
+    if (modbus_read_registers(ctx, LPR_REG_STATUS, 1, &status_reg) != 1) {
+        LOG_DEBUG("MODBUS", "Erro ao ler status da câmera %s", camera_name(camera));
+        stats.errors++;
+        observe_transaction(camera, start_us);
         return -1;
     }
     
-    // Ler placa (4 registros = 8 bytes)
-    uint16_t plate_regs[4];
+    stats.responses_received++;
+    observe_transaction(camera, start_us);
+    return (int)status_reg;
+}
+
+/**
+ * @brief Lê o bloco de registradores 0-7 da câmera numa única transação
+ * @param regs Saída com LPR_REG_COUNT registradores (status, placa, confiança, erro)
+ * @return 0 se sucesso, -1 se erro
+ */
+static int camera_read_block_locked(camera_type_t camera, uint16_t regs[LPR_REG_COUNT]) {
+    modbus_set_slave(ctx, camera);
+    uint64_t start_us = metrics_now_us();
+    
     stats.requests_sent++;
     
-    if (modbus_read_registers(ctx, LPR_REG_PLATE, 4, plate_regs) != 4) {
-        LOG_ERROR("MODBUS", "Erro ao ler placa da câmera %s: %s", 
-                  camera_name, modbus_strerror(errno));
+    if (modbus_read_registers(ctx, LPR_REG_STATUS, LPR_REG_COUNT, regs) != LPR_REG_COUNT) {
+        LOG_DEBUG("MODBUS", "Erro ao ler registradores da câmera %s: %s", 
+                  camera_name(camera), modbus_strerror(errno));
         stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
+        observe_transaction(camera, start_us);
         return -1;
     }
     
     stats.responses_received++;
-    
-    // Converter registros para string
+    observe_transaction(camera, start_us);
+    return 0;
+}
+
+/**
+ * @brief Extrai placa e confiança de um bloco lido com status OK
+ */
+static void camera_parse_result(const uint16_t regs[LPR_REG_COUNT], plate_reading_t* result) {
+    // Converter registros da placa (4 registros = 8 bytes) para string
     for (int i = 0; i < 4; i++) {
-        result->plate[i*2] = (plate_regs[i] >> 8) & 0xFF;
-        result->plate[i*2 + 1] = plate_regs[i] & 0xFF;
+        result->plate[i*2] = (regs[LPR_REG_PLATE + i] >> 8) & 0xFF;
+        result->plate[i*2 + 1] = regs[LPR_REG_PLATE + i] & 0xFF;
     }
     result->plate[8] = '\0';
     
@@ -312,137 +431,602 @@ int modbus_camera_read_plate(camera_type_t camera, plate_reading_t* result, int
         result->plate[--len] = '\0';
     }
     
-    // Ler confiança
-    uint16_t confidence_reg;
-    stats.requests_sent++;
-    
-    if (modbus_read_registers(ctx, LPR_REG_CONFIDENCE, 1, &confidence_reg) != 1) {
-        LOG_WARN("MODBUS", "Erro ao ler confiança da câmera %s", camera_name);
-        result->confidence = 0;
-        stats.errors++;
-    } else {
-        result->confidence = confidence_reg;
-        stats.responses_received++;
-    }
-    
-    pthread_mutex_unlock(&modbus_mutex);
+    result->confidence = regs[LPR_REG_CONFIDENCE];
     
     // Determinar sucesso baseado na confiança e tamanho da placa
     result->success = (result->confidence >= MIN_PLATE_CONFIDENCE && 
                        strlen(result->plate) >= 7);
-    
+}
+
+/**
+ * @brief Próximo intervalo de poll: começa curto e dobra até o máximo
+ */
+static int next_poll_interval(int interval_ms) {
+    interval_ms *= 2;
+    return (interval_ms > MODBUS_CAMERA_POLL_MAX_MS) ? MODBUS_CAMERA_POLL_MAX_MS : interval_ms;
+}
+
+/**
+ * @brief Registra no log o resultado de uma leitura de placa
+ */
+static void log_plate_result(camera_type_t camera, const plate_reading_t* result) {
     const char* status_str = result->success ? "[OK]" : 
                              (result->confidence < LOW_PLATE_CONFIDENCE) ? 
                              "[CONFIANÇA MUITO BAIXA]" : "[BAIXA CONFIANÇA]";
     
     LOG_INFO("MODBUS", "Placa lida da câmera %s: '%s' (confiança: %d%%) %s", 
-             camera_name, result->plate, result->confidence, status_str);
+             camera_name(camera), result->plate, result->confidence, status_str);
+}
+
+// =============================================================================
+// ESCALONADOR DO BARRAMENTO - IMPLEMENTAÇÃO
+// =============================================================================
+
+/**
+ * @brief Reserva um slot da fila (chamar com bus_mutex travado)
+ * @return Transação com ready_at = agora, ou NULL se a fila estiver cheia
+ */
+static bus_job_t* bus_job_alloc(bus_job_kind_t kind, bus_priority_t priority) {
+    for (int i = 0; i < MODBUS_MAX_PENDING_JOBS; i++) {
+        bus_job_t* job = &bus_jobs[i];
+        if (!job->in_use) {
+            memset(job, 0, sizeof(*job));
+            job->in_use = true;
+            job->kind = kind;
+            job->priority = priority;
+            job->order = bus_job_order++;
+            clock_gettime(CLOCK_MONOTONIC, &job->ready_at);
+            return job;
+        }
+    }
+    
+    LOG_WARN("MODBUS", "Fila do barramento cheia");
+    return NULL;
+}
+
+/**
+ * @brief Agenda a escrita do placar (uma transação pendente por vez)
+ * @param immediate true para ignorar MODBUS_DISPLAY_MIN_INTERVAL_MS
+ * @return 0 se agendado, -1 se erro
+ */
+static int schedule_display_job(bool immediate) {
+    pthread_mutex_lock(&bus_mutex);
     
+    if (!bus_running) {
+        pthread_mutex_unlock(&bus_mutex);
+        return -1;
+    }
+    
+    bus_job_t* job = NULL;
+    if (display_job_queued) {
+        // Já agendada: o estado novo será enviado por ela (colapso)
+        for (int i = 0; i < MODBUS_MAX_PENDING_JOBS && immediate; i++) {
+            if (bus_jobs[i].in_use && bus_jobs[i].kind == BUS_JOB_DISPLAY) {
+                job = &bus_jobs[i];
+                clock_gettime(CLOCK_MONOTONIC, &job->ready_at);
+            }
+        }
+    } else {
+        job = bus_job_alloc(BUS_JOB_DISPLAY, BUS_PRIORITY_DISPLAY);
+        if (!job) {
+            pthread_mutex_unlock(&bus_mutex);
+            return -1;
+        }
+        
+        if (!immediate && display_last_write.tv_sec != 0) {
+            struct timespec earliest = ts_add_ms(display_last_write, MODBUS_DISPLAY_MIN_INTERVAL_MS);
+            if (ts_before(&job->ready_at, &earliest)) {
+                job->ready_at = earliest;
+            }
+        }
+        display_job_queued = true;
+    }
+    
+    if (job) {
+        pthread_cond_signal(&bus_cond);
+    }
+    
+    pthread_mutex_unlock(&bus_mutex);
     return 0;
 }
 
-int modbus_camera_capture_and_read(camera_type_t camera, plate_reading_t* result) {
-    if (!result) return -1;
+/**
+ * @brief Executa um passo (uma transação) de uma captura
+ * @return true se a captura terminou (job->status preenchido)
+ */
+static bool camera_job_step(bus_job_t* job, const struct timespec* now) {
+    bool done = false;
+    
+    pthread_mutex_lock(&modbus_mutex);
+    
+    switch (job->step) {
+        case CAMERA_STEP_TRIGGER:
+            if (camera_trigger_locked(job->camera) != 0) {
+                job->status = -1;
+                done = true;
+                break;
+            }
+            LOG_DEBUG("MODBUS", "Câmera %s disparada", camera_name(job->camera));
+            job->step = CAMERA_STEP_POLL;
+            job->deadline = ts_add_ms(*now, MODBUS_CAMERA_TIMEOUT_MS);
+            job->poll_interval_ms = MODBUS_CAMERA_POLL_MIN_MS;
+            job->ready_at = ts_add_ms(*now, job->poll_interval_ms);
+            break;
+            
+        case CAMERA_STEP_POLL: {
+            // Status, placa e confiança no mesmo quadro
+            uint16_t regs[LPR_REG_COUNT];
+            int status = (camera_read_block_locked(job->camera, regs) == 0) ?
+                         (int)regs[LPR_REG_STATUS] : -1;
+            
+            if (status == LPR_STATUS_OK) {
+                camera_parse_result(regs, &job->result);
+                job->status = 0;
+                done = true;
+            } else if (status == LPR_STATUS_ERROR) {
+                LOG_ERROR("MODBUS", "Câmera %s retornou erro (código %u)", 
+                          camera_name(job->camera), regs[LPR_REG_ERROR]);
+                job->status = -1;
+                done = true;
+            } else if (!ts_before(now, &job->deadline)) {
+                LOG_ERROR("MODBUS", "Timeout aguardando câmera %s", camera_name(job->camera));
+                stats.timeouts++;
+                job->status = -1;
+                done = true;
+            } else {
+                // PROCESSING/READY ou falha de leitura: novo poll mais tarde
+                job->poll_interval_ms = next_poll_interval(job->poll_interval_ms);
+                job->ready_at = ts_add_ms(*now, job->poll_interval_ms);
+            }
+            break;
+        }
+    }
+    
+    pthread_mutex_unlock(&modbus_mutex);
+    return done;
+}
+
+/**
+ * @brief Entrega o resultado de uma captura (sem travas)
+ */
+static void finish_camera_job(const bus_job_t* job) {
+    if (job->status == 0) {
+        log_plate_result(job->camera, &job->result);
+    }
+    
+    if (job->callback) {
+        job->callback(job->camera, &job->result, job->status, job->user_data);
+    }
+}
+
+/**
+ * @brief Thread dona do barramento: executa a transação pronta mais prioritária
+ */
+static void* bus_thread_main(void* arg) {
+    (void)arg;
+    
+    LOG_INFO("MODBUS", "Thread do barramento iniciada");
+    
+    pthread_mutex_lock(&bus_mutex);
+    
+    while (bus_running) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        
+        bus_job_t* job = NULL;
+        bus_job_t* next = NULL;
+        for (int i = 0; i < MODBUS_MAX_PENDING_JOBS; i++) {
+            bus_job_t* j = &bus_jobs[i];
+            if (!j->in_use) continue;
+            
+            if (!ts_before(&now, &j->ready_at)) {
+                if (!job || j->priority < job->priority ||
+                    (j->priority == job->priority && j->order < job->order)) {
+                    job = j;
+                }
+            } else if (!next || ts_before(&j->ready_at, &next->ready_at)) {
+                next = j;
+            }
+        }
+        
+        if (!job) {
+            if (next) {
+                pthread_cond_timedwait(&bus_cond, &bus_mutex, &next->ready_at);
+            } else {
+                pthread_cond_wait(&bus_cond, &bus_mutex);
+            }
+            continue;
+        }
+        
+        if (job->kind == BUS_JOB_DISPLAY) {
+            // Atualizações chegando a partir daqui agendam uma nova escrita
+            display_job_queued = false;
+            display_last_write = now;
+            pthread_mutex_unlock(&bus_mutex);
+            
+            pthread_mutex_lock(&modbus_mutex);
+            int rc = display_flush_locked();
+            pthread_mutex_unlock(&modbus_mutex);
+            
+            pthread_mutex_lock(&bus_mutex);
+            if (rc != 0 && !display_job_queued) {
+                // Faixas que falharam seguem sujas: nova tentativa após o intervalo
+                job->ready_at = ts_add_ms(now, MODBUS_DISPLAY_MIN_INTERVAL_MS);
+                job->order = bus_job_order++;
+                display_job_queued = true;
+            } else {
+                job->in_use = false;
+            }
+            continue;
+        }
+        
+        if (job->kind == BUS_JOB_CALL) {
+            pthread_mutex_unlock(&bus_mutex);
+            
+            pthread_mutex_lock(&modbus_mutex);
+            int rc = job->call(job->call_arg);
+            pthread_mutex_unlock(&modbus_mutex);
+            
+            pthread_mutex_lock(&bus_mutex);
+            job->wait->rc = rc;
+            job->wait->done = true;
+            job->in_use = false;
+            pthread_cond_broadcast(&bus_call_cond);
+            continue;
+        }
+        
+        pthread_mutex_unlock(&bus_mutex);
+        bool done = camera_job_step(job, &now);
+        pthread_mutex_lock(&bus_mutex);
+        
+        if (done) {
+            bus_job_t finished = *job;
+            job->in_use = false;
+            
+            pthread_mutex_unlock(&bus_mutex);
+            finish_camera_job(&finished);
+            pthread_mutex_lock(&bus_mutex);
+        }
+    }
+    
+    // Capturas ainda pendentes falham: quem espera precisa ser liberado
+    for (int i = 0; i < MODBUS_MAX_PENDING_JOBS; i++) {
+        if (bus_jobs[i].in_use && bus_jobs[i].kind == BUS_JOB_CAMERA) {
+            bus_job_t finished = bus_jobs[i];
+            finished.status = -1;
+            bus_jobs[i].in_use = false;
+            
+            pthread_mutex_unlock(&bus_mutex);
+            finish_camera_job(&finished);
+            pthread_mutex_lock(&bus_mutex);
+        } else if (bus_jobs[i].in_use && bus_jobs[i].kind == BUS_JOB_CALL) {
+            bus_jobs[i].wait->rc = -1;
+            bus_jobs[i].wait->done = true;
+            pthread_cond_broadcast(&bus_call_cond);
+        }
+        bus_jobs[i].in_use = false;
+    }
+    
+    pthread_mutex_unlock(&bus_mutex);
+    
+    LOG_INFO("MODBUS", "Thread do barramento finalizada");
+    return NULL;
+}
+
+/**
+ * @brief Executa fn com o barramento, pela fila, e aguarda o resultado
+ *
+ * Na própria thread do barramento (callback de captura) executa direto:
+ * esperar a fila ali travaria a thread.
+ *
+ * @return Retorno de fn, ou -1 se a fila estiver cheia ou o barramento parado
+ */
+static int bus_call(bus_call_fn_t fn, void* arg) {
+    pthread_mutex_lock(&bus_mutex);
+    
+    if (bus_running && pthread_equal(pthread_self(), bus_thread)) {
+        pthread_mutex_unlock(&bus_mutex);
+        pthread_mutex_lock(&modbus_mutex);
+        int rc = fn(arg);
+        pthread_mutex_unlock(&modbus_mutex);
+        return rc;
+    }
     
-    // Disparar captura
-    if (modbus_camera_trigger(camera) != 0) {
+    bus_job_t* job = bus_running ? bus_job_alloc(BUS_JOB_CALL, BUS_PRIORITY_CALL) : NULL;
+    if (!job) {
+        pthread_mutex_unlock(&bus_mutex);
         return -1;
     }
     
-    // Aguardar e ler resultado
-    return modbus_camera_read_plate(camera, result, 2000);
+    bus_call_wait_t wait = { false, -1 };
+    job->call = fn;
+    job->call_arg = arg;
+    job->wait = &wait;
+    pthread_cond_signal(&bus_cond);
+    
+    while (!wait.done) {
+        pthread_cond_wait(&bus_call_cond, &bus_mutex);
+    }
+    
+    pthread_mutex_unlock(&bus_mutex);
+    return wait.rc;
 }
 
-int modbus_camera_get_status(camera_type_t camera) {
+typedef struct {
+    camera_type_t camera;
+    uint16_t regs[LPR_REG_COUNT];
+} camera_call_t;
+
+static int camera_trigger_call(void* arg) {
+    return camera_trigger_locked(((camera_call_t*)arg)->camera);
+}
+
+static int camera_read_block_call(void* arg) {
+    camera_call_t* call = (camera_call_t*)arg;
+    return camera_read_block_locked(call->camera, call->regs);
+}
+
+static int camera_read_status_call(void* arg) {
+    return camera_read_status_locked(((camera_call_t*)arg)->camera);
+}
+
+static int camera_reset_call(void* arg) {
+    modbus_set_slave(ctx, ((camera_call_t*)arg)->camera);
+    
+    // Escrever 0 no trigger para resetar
+    return (modbus_write_register(ctx, LPR_REG_TRIGGER, 0) == 1) ? 0 : -1;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS - CÂMERA LPR
+// =============================================================================
+
+int modbus_camera_trigger(camera_type_t camera) {
     if (!initialized || !ctx) {
+        LOG_ERROR("MODBUS", "Cliente não inicializado");
         return -1;
     }
     
-    pthread_mutex_lock(&modbus_mutex);
-    modbus_set_slave(ctx, camera);
+    LOG_DEBUG("MODBUS", "Disparando câmera %s (0x%02X)", camera_name(camera), camera);
     
-    uint16_t status_reg;
-    if (modbus_read_registers(ctx, LPR_REG_STATUS, 1, &status_reg) != 1) {
-        pthread_mutex_unlock(&modbus_mutex);
+    camera_call_t call = { .camera = camera };
+    if (bus_call(camera_trigger_call, &call) != 0) {
         return -1;
     }
     
+    LOG_INFO("MODBUS", "Câmera %s disparada com sucesso", camera_name(camera));
+    return 0;
+}
+
+int modbus_camera_read_plate(camera_type_t camera, plate_reading_t* result, int timeout_ms) {
+    if (!initialized || !ctx || !result) {
+        LOG_ERROR("MODBUS", "Parâmetros inválidos");
+        return -1;
+    }
+    
+    memset(result, 0, sizeof(plate_reading_t));
+    result->timestamp = time(NULL);
+    
+    if (timeout_ms <= 0) {
+        timeout_ms = MODBUS_CAMERA_TIMEOUT_MS;
+    }
+    
+    LOG_DEBUG("MODBUS", "Lendo placa da câmera %s (timeout: %dms)", 
+              camera_name(camera), timeout_ms);
+    
+    // Polling do bloco de registradores até OK ou ERROR (barramento livre entre polls)
+    int elapsed = 0;
+    int interval = MODBUS_CAMERA_POLL_MIN_MS;
+    camera_call_t call = { .camera = camera };
+    const uint16_t* regs = call.regs;
+    
+    while (elapsed < timeout_ms) {
+        int status = (bus_call(camera_read_block_call, &call) == 0) ?
+                     (int)regs[LPR_REG_STATUS] : -1;
+        
+        if (status == LPR_STATUS_OK) {
+            camera_parse_result(regs, result);
+            log_plate_result(camera, result);
+            return 0;
+        }
+        
+        if (status == LPR_STATUS_ERROR) {
+            LOG_ERROR("MODBUS", "Câmera %s retornou erro (código %u)", 
+                      camera_name(camera), regs[LPR_REG_ERROR]);
+            return -1;
+        }
+        
+        // Status PROCESSING ou READY - continua polling
+        usleep(interval * 1000);
+        elapsed += interval;
+        interval = next_poll_interval(interval);
+    }
+    
+    LOG_ERROR("MODBUS", "Timeout aguardando câmera %s", camera_name(camera));
+    pthread_mutex_lock(&modbus_mutex);
+    stats.timeouts++;
     pthread_mutex_unlock(&modbus_mutex);
-    return (int)status_reg;
+    return -1;
 }
 
-int modbus_camera_reset(camera_type_t camera) {
+/**
+ * @brief Enfileira uma captura (chamar com bus_mutex travado)
+ */
+static int submit_capture_locked(camera_type_t camera, modbus_plate_callback_t callback,
+                                 void* user_data) {
+    bus_job_t* job = bus_job_alloc(BUS_JOB_CAMERA,
+                                   (camera == CAMERA_ENTRADA) ? BUS_PRIORITY_CAMERA_ENTRADA
+                                                              : BUS_PRIORITY_CAMERA_SAIDA);
+    if (!job) {
+        return -1;
+    }
+    
+    job->camera = camera;
+    job->step = CAMERA_STEP_TRIGGER;
+    job->result.timestamp = time(NULL);
+    job->callback = callback;
+    job->user_data = user_data;
+    return 0;
+}
+
+/**
+ * @brief Conta slots livres na fila (chamar com bus_mutex travado)
+ */
+static int free_job_slots_locked(void) {
+    int count = 0;
+    for (int i = 0; i < MODBUS_MAX_PENDING_JOBS; i++) {
+        if (!bus_jobs[i].in_use) count++;
+    }
+    return count;
+}
+
+int modbus_camera_capture_async(camera_type_t camera, modbus_plate_callback_t callback,
+                                void* user_data) {
     if (!initialized || !ctx) {
+        LOG_ERROR("MODBUS", "Cliente não inicializado");
         return -1;
     }
     
-    pthread_mutex_lock(&modbus_mutex);
-    modbus_set_slave(ctx, camera);
+    pthread_mutex_lock(&bus_mutex);
     
-    // Escrever 0 no trigger para resetar
-    if (modbus_write_register(ctx, LPR_REG_TRIGGER, 0) != 1) {
-        pthread_mutex_unlock(&modbus_mutex);
+    if (!bus_running || submit_capture_locked(camera, callback, user_data) != 0) {
+        pthread_mutex_unlock(&bus_mutex);
         return -1;
     }
     
-    pthread_mutex_unlock(&modbus_mutex);
+    pthread_cond_signal(&bus_cond);
+    pthread_mutex_unlock(&bus_mutex);
     
-    LOG_INFO("MODBUS", "Câmera 0x%02X resetada", camera);
+    LOG_DEBUG("MODBUS", "Captura agendada na câmera %s", camera_name(camera));
     return 0;
 }
 
-// =============================================================================
-// FUNÇÕES PÚBLICAS - DISPLAY
-// =============================================================================
-
-int modbus_display_update(const display_info_t* info) {
-    if (!initialized || !ctx || !info) {
-        LOG_ERROR("MODBUS", "Parâmetros inválidos");
+int modbus_camera_capture_both(modbus_plate_callback_t callback, void* user_data) {
+    if (!initialized || !ctx) {
+        LOG_ERROR("MODBUS", "Cliente não inicializado");
         return -1;
     }
     
-    LOG_DEBUG("MODBUS", "Atualizando placar");
+    pthread_mutex_lock(&bus_mutex);
     
-    pthread_mutex_lock(&modbus_mutex);
-    modbus_set_slave(ctx, MODBUS_ADDR_DISPLAY);
+    // Tudo ou nada: com uma só captura agendada o chamador esperaria a outra
+    if (!bus_running || free_job_slots_locked() < 2) {
+        pthread_mutex_unlock(&bus_mutex);
+        LOG_WARN("MODBUS", "Fila do barramento sem espaço para captura dupla");
+        return -1;
+    }
     
-    // Preparar dados (13 registros)
-    uint16_t data[13];
-    data[0] = info->terreo_pne;
-    data[1] = info->terreo_idoso;
-    data[2] = info->terreo_comum;
-    data[3] = info->andar1_pne;
-    data[4] = info->andar1_idoso;
-    data[5] = info->andar1_comum;
-    data[6] = info->andar2_pne;
-    data[7] = info->andar2_idoso;
-    data[8] = info->andar2_comum;
-    data[9] = info->total_pne;
-    data[10] = info->total_idoso;
-    data[11] = info->total_comum;
+    submit_capture_locked(CAMERA_ENTRADA, callback, user_data);
+    submit_capture_locked(CAMERA_SAIDA, callback, user_data);
     
-    // Flags
-    data[12] = 0;
-    if (info->lotado_geral) data[12] |= DISPLAY_FLAG_LOTADO_GERAL;
-    if (info->bloqueado_andar1) data[12] |= DISPLAY_FLAG_BLOQ_ANDAR1;
-    if (info->bloqueado_andar2) data[12] |= DISPLAY_FLAG_BLOQ_ANDAR2;
+    pthread_cond_signal(&bus_cond);
+    pthread_mutex_unlock(&bus_mutex);
+    
+    LOG_DEBUG("MODBUS", "Captura agendada nas câmeras ENTRADA e SAÍDA");
+    return 0;
+}
+
+/**
+ * @brief Espera de uma captura síncrona sobre a API assíncrona
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool done;
+    int status;
+    plate_reading_t result;
+} capture_wait_t;
+
+static void capture_wait_callback(camera_type_t camera, const plate_reading_t* result,
+                                  int status, void* user_data) {
+    (void)camera;
+    capture_wait_t* wait = (capture_wait_t*)user_data;
+    
+    pthread_mutex_lock(&wait->mutex);
+    wait->result = *result;
+    wait->status = status;
+    wait->done = true;
+    pthread_cond_signal(&wait->cond);
+    pthread_mutex_unlock(&wait->mutex);
+}
+
+int modbus_camera_capture_and_read(camera_type_t camera, plate_reading_t* result) {
+    if (!result) return -1;
+    
+    capture_wait_t wait;
+    memset(&wait, 0, sizeof(wait));
+    pthread_mutex_init(&wait.mutex, NULL);
+    pthread_cond_init(&wait.cond, NULL);
+    
+    int rc = -1;
+    if (modbus_camera_capture_async(camera, capture_wait_callback, &wait) == 0) {
+        pthread_mutex_lock(&wait.mutex);
+        while (!wait.done) {
+            pthread_cond_wait(&wait.cond, &wait.mutex);
+        }
+        pthread_mutex_unlock(&wait.mutex);
+        
+        *result = wait.result;
+        rc = wait.status;
+    }
+    
+    pthread_cond_destroy(&wait.cond);
+    pthread_mutex_destroy(&wait.mutex);
+    return rc;
+}
+
+int modbus_camera_get_status(camera_type_t camera) {
+    if (!initialized || !ctx) {
+        return -1;
+    }
+    
+    camera_call_t call = { .camera = camera };
+    return bus_call(camera_read_status_call, &call);
+}
+
+int modbus_camera_reset(camera_type_t camera) {
+    if (!initialized || !ctx) {
+        return -1;
+    }
+    
+    camera_call_t call = { .camera = camera };
+    if (bus_call(camera_reset_call, &call) != 0) {
+        return -1;
+    }
+    
+    LOG_INFO("MODBUS", "Câmera 0x%02X resetada", camera);
+    return 0;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS - DISPLAY
+// =============================================================================
+
+/**
+ * @brief Escreve um intervalo de registradores do placar num único quadro 0x10
+ * @note Chamar com modbus_mutex travado
+ * @return 0 se sucesso, -1 se erro
+ */
+static int display_write_range(int start, int count, const uint16_t* values) {
+    modbus_set_slave(ctx, MODBUS_ADDR_DISPLAY);
+    uint64_t start_us = metrics_now_us();
     
     // Preparar mensagem Write Multiple Registers (0x10)
     uint8_t req[256];
     int req_length = 0;
     
-    req[req_length++] = MODBUS_ADDR_DISPLAY;  // Slave
-    req[req_length++] = 0x10;                 // Function code
-    req[req_length++] = 0x00;                 // Start address HIGH
-    req[req_length++] = 0x00;                 // Start address LOW
-    req[req_length++] = 0x00;                 // Quantity HIGH (13)
-    req[req_length++] = 0x0D;                 // Quantity LOW
-    req[req_length++] = 0x1A;                 // Byte count (13*2 = 26)
+    req[req_length++] = MODBUS_ADDR_DISPLAY;      // Slave
+    req[req_length++] = 0x10;                     // Function code
+    req[req_length++] = (start >> 8) & 0xFF;      // Start address HIGH
+    req[req_length++] = start & 0xFF;             // Start address LOW
+    req[req_length++] = (count >> 8) & 0xFF;      // Quantity HIGH
+    req[req_length++] = count & 0xFF;             // Quantity LOW
+    req[req_length++] = (uint8_t)(count * 2);     // Byte count
     
     // Dados dos registros
-    for (int i = 0; i < 13; i++) {
-        req[req_length++] = (data[i] >> 8) & 0xFF;
-        req[req_length++] = data[i] & 0xFF;
+    for (int i = 0; i < count; i++) {
+        req[req_length++] = (values[i] >> 8) & 0xFF;
+        req[req_length++] = values[i] & 0xFF;
     }
     
     // Adicionar matrícula antes do CRC
@@ -461,7 +1045,7 @@ int modbus_display_update(const display_info_t* info) {
         LOG_ERROR("MODBUS", "Erro ao enviar atualização do placar: %s", 
                   modbus_strerror(errno));
         stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
+        observe_transaction(MODBUS_ADDR_DISPLAY, start_us);
         return -1;
     }
     
@@ -472,18 +1056,117 @@ int modbus_display_update(const display_info_t* info) {
         LOG_ERROR("MODBUS", "Erro ao receber confirmação do placar: %s",
                   modbus_strerror(errno));
         stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
+        observe_transaction(MODBUS_ADDR_DISPLAY, start_us);
         return -1;
     }
     
     stats.responses_received++;
+    observe_transaction(MODBUS_ADDR_DISPLAY, start_us);
+    return 0;
+}
+
+/**
+ * @brief Escreve no placar os registradores que diferem da cópia local
+ *
+ * Os registradores alterados saem num único quadro, do primeiro ao último
+ * sujo: registradores limpos no meio custam menos que um quadro a mais no
+ * barramento. Só um registrador nunca lido nem definido (antes da primeira
+ * atualização completa) divide o quadro.
+ *
+ * @note Executado pela thread do barramento, com modbus_mutex travado
+ * @return 0 se sucesso ou nada a enviar, -1 se erro
+ */
+static int display_flush_locked(void) {
+    uint16_t dirty = 0;
+    for (int i = 0; i < DISPLAY_REG_COUNT; i++) {
+        uint16_t bit = (uint16_t)(1u << i);
+        if ((display_requested & bit) &&
+            (!(display_known & bit) || display_pending[i] != display_shadow[i])) {
+            dirty |= bit;
+        }
+    }
+    
+    if (dirty == 0) {
+        return 0; // Placar já exibe o estado pedido
+    }
+    
+    int rc = 0;
+    int i = 0;
+    while (i < DISPLAY_REG_COUNT) {
+        if (!(dirty & (1u << i))) {
+            i++;
+            continue;
+        }
+        
+        // Estender até o último sujo sem atravessar registrador de valor desconhecido
+        int first = i, last = i;
+        for (int j = i + 1; j < DISPLAY_REG_COUNT; j++) {
+            uint16_t bit = (uint16_t)(1u << j);
+            if (!(display_known & bit) && !(display_requested & bit)) break;
+            if (dirty & bit) last = j;
+        }
+        
+        uint16_t values[DISPLAY_REG_COUNT];
+        int count = last - first + 1;
+        for (int k = first; k <= last; k++) {
+            values[k - first] = (display_requested & (1u << k)) ? display_pending[k]
+                                                                 : display_shadow[k];
+        }
+        
+        if (display_write_range(first, count, values) == 0) {
+            memcpy(&display_shadow[first], values, count * sizeof(uint16_t));
+            display_known |= (uint16_t)(((1u << count) - 1) << first);
+            LOG_DEBUG("MODBUS", "Placar: registradores %d-%d escritos", first, last);
+        } else {
+            rc = -1; // Cópia local inalterada: a faixa segue suja e a thread reagenda
+        }
+        
+        i = last + 1;
+    }
+    
+    return rc;
+}
+
+int modbus_display_update(const display_info_t* info) {
+    if (!initialized || !ctx || !info) {
+        LOG_ERROR("MODBUS", "Parâmetros inválidos");
+        return -1;
+    }
+    
+    pthread_mutex_lock(&modbus_mutex);
+    
+    display_pending[DISPLAY_REG_TERREO_PNE] = info->terreo_pne;
+    display_pending[DISPLAY_REG_TERREO_IDOSO] = info->terreo_idoso;
+    display_pending[DISPLAY_REG_TERREO_COMUM] = info->terreo_comum;
+    display_pending[DISPLAY_REG_ANDAR1_PNE] = info->andar1_pne;
+    display_pending[DISPLAY_REG_ANDAR1_IDOSO] = info->andar1_idoso;
+    display_pending[DISPLAY_REG_ANDAR1_COMUM] = info->andar1_comum;
+    display_pending[DISPLAY_REG_ANDAR2_PNE] = info->andar2_pne;
+    display_pending[DISPLAY_REG_ANDAR2_IDOSO] = info->andar2_idoso;
+    display_pending[DISPLAY_REG_ANDAR2_COMUM] = info->andar2_comum;
+    display_pending[DISPLAY_REG_TOTAL_PNE] = info->total_pne;
+    display_pending[DISPLAY_REG_TOTAL_IDOSO] = info->total_idoso;
+    display_pending[DISPLAY_REG_TOTAL_COMUM] = info->total_comum;
+    
+    // Flags
+    uint16_t flags = 0;
+    if (info->lotado_geral) flags |= DISPLAY_FLAG_LOTADO_GERAL;
+    if (info->bloqueado_andar1) flags |= DISPLAY_FLAG_BLOQ_ANDAR1;
+    if (info->bloqueado_andar2) flags |= DISPLAY_FLAG_BLOQ_ANDAR2;
+    display_pending[DISPLAY_REG_FLAGS] = flags;
+    display_requested = (uint16_t)((1u << DISPLAY_REG_COUNT) - 1);
+    
     pthread_mutex_unlock(&modbus_mutex);
     
-    LOG_INFO("MODBUS", "Placar atualizado: T=%d/%d/%d A1=%d/%d/%d A2=%d/%d/%d", 
-             data[0], data[1], data[2], data[3], data[4], data[5],
-             data[6], data[7], data[8]);
+    // Atualizações dentro do intervalo mínimo colapsam na mesma escrita
+    int rc = schedule_display_job(false);
     
-    return 0;
+    LOG_DEBUG("MODBUS", "Placar: T=%d/%d/%d A1=%d/%d/%d A2=%d/%d/%d", 
+              info->terreo_pne, info->terreo_idoso, info->terreo_comum,
+              info->andar1_pne, info->andar1_idoso, info->andar1_comum,
+              info->andar2_pne, info->andar2_idoso, info->andar2_comum);
+    
+    return rc;
 }
 
 int modbus_display_update_floor(int floor, uint8_t pne, uint8_t idoso, uint8_t comum) {
@@ -492,24 +1175,17 @@ int modbus_display_update_floor(int floor, uint8_t pne, uint8_t idoso, uint8_t c
     }
     
     pthread_mutex_lock(&modbus_mutex);
-    modbus_set_slave(ctx, MODBUS_ADDR_DISPLAY);
     
     // Calcular offset baseado no andar
     int offset = floor * 3; // 0, 3 ou 6
+    display_pending[offset] = pne;
+    display_pending[offset + 1] = idoso;
+    display_pending[offset + 2] = comum;
+    display_requested |= (uint16_t)(0x7u << offset);
     
-    uint16_t data[3] = {pne, idoso, comum};
-    
-    if (modbus_write_registers(ctx, offset, 3, data) != 3) {
-        stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
-        return -1;
-    }
-    
-    stats.requests_sent++;
-    stats.responses_received++;
     pthread_mutex_unlock(&modbus_mutex);
     
-    return 0;
+    return schedule_display_job(false);
 }
 
 int modbus_display_update_flags(bool lotado, bool bloq_andar1, bool bloq_andar2) {
@@ -518,23 +1194,42 @@ int modbus_display_update_flags(bool lotado, bool bloq_andar1, bool bloq_andar2)
     }
     
     pthread_mutex_lock(&modbus_mutex);
-    modbus_set_slave(ctx, MODBUS_ADDR_DISPLAY);
     
     uint16_t flags = 0;
     if (lotado) flags |= DISPLAY_FLAG_LOTADO_GERAL;
     if (bloq_andar1) flags |= DISPLAY_FLAG_BLOQ_ANDAR1;
     if (bloq_andar2) flags |= DISPLAY_FLAG_BLOQ_ANDAR2;
+    display_pending[DISPLAY_REG_FLAGS] = flags;
+    display_requested |= (uint16_t)(1u << DISPLAY_REG_FLAGS);
+    
+    pthread_mutex_unlock(&modbus_mutex);
+    
+    return schedule_display_job(false);
+}
+
+int modbus_display_flush(void) {
+    if (!initialized || !ctx) {
+        return -1;
+    }
+    
+    return schedule_display_job(true);
+}
+
+static int display_read_call(void* arg) {
+    uint16_t* regs = (uint16_t*)arg;
     
-    if (modbus_write_register(ctx, DISPLAY_REG_FLAGS, flags) != 1) {
+    modbus_set_slave(ctx, MODBUS_ADDR_DISPLAY);
+    if (modbus_read_registers(ctx, 0, DISPLAY_REG_COUNT, regs) != DISPLAY_REG_COUNT) {
         stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
         return -1;
     }
     
     stats.requests_sent++;
     stats.responses_received++;
-    pthread_mutex_unlock(&modbus_mutex);
     
+    // O placar pode ter reiniciado: a leitura passa a ser a referência do diff
+    memcpy(display_shadow, regs, sizeof(display_shadow));
+    display_known = (uint16_t)((1u << DISPLAY_REG_COUNT) - 1);
     return 0;
 }
 
@@ -543,19 +1238,11 @@ int modbus_display_read(display_info_t* info) {
         return -1;
     }
     
-    pthread_mutex_lock(&modbus_mutex);
-    modbus_set_slave(ctx, MODBUS_ADDR_DISPLAY);
-    
-    uint16_t regs[13];
-    if (modbus_read_registers(ctx, 0, 13, regs) != 13) {
-        stats.errors++;
-        pthread_mutex_unlock(&modbus_mutex);
+    uint16_t regs[DISPLAY_REG_COUNT];
+    if (bus_call(display_read_call, regs) != 0) {
         return -1;
     }
     
-    stats.requests_sent++;
-    stats.responses_received++;
-    
     info->terreo_pne = regs[0];
     info->terreo_idoso = regs[1];
     info->terreo_comum = regs[2];
@@ -573,8 +1260,6 @@ int modbus_display_read(display_info_t* info) {
     info->bloqueado_andar1 = (regs[12] & DISPLAY_FLAG_BLOQ_ANDAR1) != 0;
     info->bloqueado_andar2 = (regs[12] & DISPLAY_FLAG_BLOQ_ANDAR2) != 0;
     
-    pthread_mutex_unlock(&modbus_mutex);
-    
     return 0;
 }
 
@@ -582,6 +1267,13 @@ int modbus_display_read(display_info_t* info) {
 // FUNÇÕES PÚBLICAS - DIAGNÓSTICO
 // =============================================================================
 
+static int test_device_call(void* arg) {
+    modbus_set_slave(ctx, *(uint8_t*)arg);
+    
+    uint16_t reg;
+    return (modbus_read_registers(ctx, 0, 1, &reg) == 1) ? 0 : -1;
+}
+
 int modbus_test_device(uint8_t address) {
     if (!initialized || !ctx) {
         return -1;
@@ -589,15 +1281,7 @@ int modbus_test_device(uint8_t address) {
     
     LOG_INFO("MODBUS", "Testando dispositivo 0x%02X...", address);
     
-    pthread_mutex_lock(&modbus_mutex);
-    modbus_set_slave(ctx, address);
-    
-    uint16_t reg;
-    int rc = modbus_read_registers(ctx, 0, 1, &reg);
-    
-    pthread_mutex_unlock(&modbus_mutex);
-    
-    if (rc == 1) {
+    if (bus_call(test_device_call, &address) == 0) {
         LOG_INFO("MODBUS", "  ✓ Dispositivo 0x%02X responde", address);
         return 0;
     } else {
@@ -19,6 +19,11 @@
 #define MODBUS_TIMEOUT_USEC 500000  // 500ms
 #define MODBUS_MAX_RETRIES 3
 #define MODBUS_RETRY_DELAY_MS 100
+#define MODBUS_DISPLAY_MIN_INTERVAL_MS 250  // Intervalo mínimo entre escritas no placar
+#define MODBUS_CAMERA_POLL_MIN_MS 20        // Primeiro poll de status após o disparo
+#define MODBUS_CAMERA_POLL_MAX_MS 100       // Intervalo máximo (dobra a cada poll)
+#define MODBUS_CAMERA_TIMEOUT_MS 2000       // Tempo máximo de uma captura
+#define MODBUS_MAX_PENDING_JOBS 8           // Transações na fila do barramento
 
 // Endereços dos dispositivos
 #define MODBUS_ADDR_CAMERA_ENTRADA 0x11
@@ -31,6 +36,7 @@
 #define LPR_REG_PLATE       2   
 #define LPR_REG_CONFIDENCE  6
 #define LPR_REG_ERROR       7
+#define LPR_REG_COUNT       8   // Bloco 0-7 lido de uma vez nos polls
 
 // Valores de status da câmera
 #define LPR_STATUS_READY       0
@@ -52,6 +58,7 @@
 #define DISPLAY_REG_TOTAL_IDOSO     10
 #define DISPLAY_REG_TOTAL_COMUM     11
 #define DISPLAY_REG_FLAGS           12
+#define DISPLAY_REG_COUNT           13
 
  
 #define DISPLAY_FLAG_LOTADO_GERAL   (1 << 0)
@@ -84,6 +91,10 @@ typedef struct {
 
 /**
  * @brief Informações do display
+ *
+ * Espelha o mapa de registradores do placar, fixo no equipamento: três
+ * linhas de andar, totais e flags. Andares do site.conf além do terceiro
+ * não têm linha no placar.
  */
 typedef struct {
     // Vagas por andar e tipo
@@ -110,6 +121,16 @@ typedef struct {
     bool bloqueado_andar2;
 } display_info_t;
 
+/**
+ * @brief Callback de conclusão de uma captura assíncrona
+ * @param camera Câmera que capturou
+ * @param result Leitura (válida se status == 0)
+ * @param status 0 se a placa foi lida, -1 se erro ou timeout
+ * @param user_data Contexto passado em modbus_camera_capture_async
+ */
+typedef void (*modbus_plate_callback_t)(camera_type_t camera, const plate_reading_t* result,
+                                        int status, void* user_data);
+
 /**
  * @brief Estatísticas do cliente MODBUS
  */
@@ -164,13 +185,41 @@ int modbus_camera_trigger(camera_type_t camera);
 int modbus_camera_read_plate(camera_type_t camera, plate_reading_t* result, int timeout_ms);
 
 /**
- * @brief  o
+ * @brief Dispara a câmera e aguarda a placa (bloqueante, via thread do barramento)
  * @param camera  
  * @param result  
  * @return 0 se sucesso, -1 se erro
  */
 int modbus_camera_capture_and_read(camera_type_t camera, plate_reading_t* result);
 
+/**
+ * @brief Agenda disparo + leitura de placa na thread do barramento
+ *
+ * Câmeras têm prioridade sobre o placar (entrada antes de saída) e a espera
+ * entre polls libera o barramento para outras transações. O callback roda
+ * na thread do barramento e deve ser curto.
+ *
+ * @param camera Câmera a disparar
+ * @param callback Chamado ao fim da captura (sucesso, erro ou timeout)
+ * @param user_data Contexto repassado ao callback
+ * @return 0 se agendado, -1 se não inicializado ou fila cheia
+ */
+int modbus_camera_capture_async(camera_type_t camera, modbus_plate_callback_t callback,
+                                void* user_data);
+
+/**
+ * @brief Agenda capturas nas câmeras de entrada e saída ao mesmo tempo
+ *
+ * Os dois disparos saem em sequência e os polls de status se intercalam no
+ * barramento; cada resultado é entregue ao callback assim que fica pronto,
+ * sem esperar a outra câmera.
+ *
+ * @param callback Chamado uma vez por câmera
+ * @param user_data Contexto repassado ao callback
+ * @return 0 se as duas foram agendadas, -1 se erro (nenhuma é agendada)
+ */
+int modbus_camera_capture_both(modbus_plate_callback_t callback, void* user_data);
+
 /**
  * @brief  
  * @param camera  
@@ -190,7 +239,7 @@ int modbus_camera_reset(camera_type_t camera);
 /**
  * @brief  
  * @param info  
- * @return 0 se sucesso, -1 se erro
+ * @return 0 se agendado, -1 se erro
  */
 int modbus_display_update(const display_info_t* info);
 
@@ -200,7 +249,7 @@ int modbus_display_update(const display_info_t* info);
  * @param pne Vagas PNE
  * @param idoso Vagas Idoso+
  * @param comum Vagas comuns
- * @return 0 se sucesso, -1 se erro
+ * @return 0 se agendado, -1 se erro
  */
 int modbus_display_update_floor(int floor, uint8_t pne, uint8_t idoso, uint8_t comum);
 
@@ -209,10 +258,21 @@ int modbus_display_update_floor(int floor, uint8_t pne, uint8_t idoso, uint8_t c
  * @param lotado Sistema lotado
  * @param bloq_andar1 Andar 1 bloqueado
  * @param bloq_andar2 Andar 2 bloqueado
- * @return 0 se sucesso, -1 se erro
+ * @return 0 se agendado, -1 se erro
  */
 int modbus_display_update_flags(bool lotado, bool bloq_andar1, bool bloq_andar2);
 
+/**
+ * @brief Agenda o envio imediato das alterações pendentes do placar
+ *
+ * As funções de atualização só gravam a cópia local e agendam a escrita na
+ * thread do barramento, respeitando MODBUS_DISPLAY_MIN_INTERVAL_MS; esta
+ * função ignora o limite de taxa.
+ *
+ * @return 0 se agendado, -1 se não inicializado
+ */
+int modbus_display_flush(void);
+
 /**
  * @brief Lê informações atuais do display
  * @param info Estrutura para armazenar informações lidas
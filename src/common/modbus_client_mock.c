@@ -1,9 +1,76 @@
 #include "modbus_client.h"
 #include "system_logger.h"
+#include "metrics.h"
 #ifdef MOCK_BUILD
-int modbus_init(const char* device,int baud){LOG_INFO("MODBUS-MOCK","init %s %d",device,baud);return 0;}
+#include <time.h>
+#include <unistd.h>
+
+// Simulação: cada transação ocupa o barramento pelo tempo dos quadros RTU
+// (11 bits por byte, 3,5 caracteres de silêncio) mais a resposta do escravo;
+// a câmera leva MODBUS_MOCK_CAMERA_MS ± jitter entre o disparo e a placa
+#define MODBUS_MOCK_TURNAROUND_US   800     // Atraso de resposta do escravo
+#define MODBUS_MOCK_JITTER_US       400
+#define MODBUS_MOCK_CAMERA_MS       40      // Processamento LPR
+#define MODBUS_MOCK_CAMERA_JITTER_MS 25
+#define MODBUS_MOCK_LPR_REGS        8       // Bloco lido com a placa
+#define MODBUS_MOCK_DISPLAY_REGS    13      // Registradores do placar
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int mock_baud = MODBUS_BAUDRATE;
+static unsigned int mock_seed = 1;
+static uint32_t mock_jitter(uint32_t range){pthread_mutex_lock(&bus_mutex);uint32_t r=range?(uint32_t)rand_r(&mock_seed)%(2*range+1):0;pthread_mutex_unlock(&bus_mutex);return r;}
+static uint32_t mock_frame_us(int bytes){return (uint32_t)(((double)bytes+3.5)*11.0*1e6/mock_baud);}
+/**
+ * @brief Ocupa o barramento por uma transação e registra no histograma do escravo
+ */
+static void mock_transaction(uint8_t slave,int req_bytes,int resp_bytes){
+    uint32_t wait_us=mock_frame_us(req_bytes)+MODBUS_MOCK_TURNAROUND_US-MODBUS_MOCK_JITTER_US+mock_jitter(MODBUS_MOCK_JITTER_US)+mock_frame_us(resp_bytes);
+    uint64_t start_us=metrics_now_us();
+    pthread_mutex_lock(&bus_mutex);
+    usleep(wait_us);
+    pthread_mutex_unlock(&bus_mutex);
+    switch(slave){
+        case MODBUS_ADDR_CAMERA_ENTRADA: metrics_observe_since(METRIC_MODBUS_CAMERA_ENTRADA_US,start_us); break;
+        case MODBUS_ADDR_CAMERA_SAIDA:   metrics_observe_since(METRIC_MODBUS_CAMERA_SAIDA_US,start_us); break;
+        case MODBUS_ADDR_DISPLAY:        metrics_observe_since(METRIC_MODBUS_DISPLAY_US,start_us); break;
+        default: break;
+    }
+}
+int modbus_init(const char* device,int baud){if(baud>0)mock_baud=baud;LOG_INFO("MODBUS-MOCK","init %s %d",device,baud);return 0;}
 void modbus_cleanup(void){LOG_INFO("MODBUS-MOCK","cleanup");}
-int modbus_trigger_camera(uint8_t addr){LOG_INFO("MODBUS-MOCK","trigger cam %u",addr);return 0;}
-int modbus_read_plate(uint8_t addr,char* plate,int* conf){(void)addr;if(plate){snprintf(plate,9,"AAA1234");}if(conf)*conf=99;return 0;}
-int modbus_update_display(uint8_t a,uint8_t b,uint8_t c,uint8_t d,uint16_t f){LOG_INFO("MODBUS-MOCK","display %u %u %u %u flags=%u",a,b,c,d,f);return 0;}
+int modbus_trigger_camera(uint8_t addr){mock_transaction(addr,8,8);LOG_INFO("MODBUS-MOCK","trigger cam %u",addr);return 0;}
+int modbus_read_plate(uint8_t addr,char* plate,int* conf){mock_transaction(addr,8,5+2*MODBUS_MOCK_LPR_REGS);if(plate){snprintf(plate,9,"AAA1234");}if(conf)*conf=99;return 0;}
+int modbus_camera_capture_async(camera_type_t camera,modbus_plate_callback_t callback,void* user_data){
+    // Disparo (0x06), processamento da câmera, status e bloco da placa (0x03)
+    mock_transaction((uint8_t)camera,8,8);
+    usleep((MODBUS_MOCK_CAMERA_MS-MODBUS_MOCK_CAMERA_JITTER_MS+mock_jitter(MODBUS_MOCK_CAMERA_JITTER_MS))*1000u);
+    mock_transaction((uint8_t)camera,8,7);
+    mock_transaction((uint8_t)camera,8,5+2*MODBUS_MOCK_LPR_REGS);
+    plate_reading_t r;memset(&r,0,sizeof r);snprintf(r.plate,9,"AAA1234");r.confidence=99;r.success=true;r.timestamp=time(NULL);
+    LOG_INFO("MODBUS-MOCK","capture cam %d",camera);
+    if(callback)callback(camera,&r,0,user_data);
+    return 0;
+}
+int modbus_camera_capture_both(modbus_plate_callback_t callback,void* user_data){
+    // Disparos em sequência, processamento das duas câmeras em paralelo, polls intercalados
+    mock_transaction(MODBUS_ADDR_CAMERA_ENTRADA,8,8);
+    mock_transaction(MODBUS_ADDR_CAMERA_SAIDA,8,8);
+    usleep((MODBUS_MOCK_CAMERA_MS-MODBUS_MOCK_CAMERA_JITTER_MS+mock_jitter(MODBUS_MOCK_CAMERA_JITTER_MS))*1000u);
+    camera_type_t cams[2]={CAMERA_ENTRADA,CAMERA_SAIDA};
+    for(int i=0;i<2;i++){
+        mock_transaction((uint8_t)cams[i],8,7);
+        mock_transaction((uint8_t)cams[i],8,5+2*MODBUS_MOCK_LPR_REGS);
+        plate_reading_t r;memset(&r,0,sizeof r);snprintf(r.plate,9,"AAA1234");r.confidence=99;r.success=true;r.timestamp=time(NULL);
+        LOG_INFO("MODBUS-MOCK","capture cam %d",cams[i]);
+        if(callback)callback(cams[i],&r,0,user_data);
+    }
+    return 0;
+}
+int modbus_display_update(const display_info_t* info){
+    if(!info)return -1;
+    // Write Multiple Registers (0x10) com o placar inteiro
+    mock_transaction(MODBUS_ADDR_DISPLAY,9+2*MODBUS_MOCK_DISPLAY_REGS,8);
+    LOG_DEBUG("MODBUS-MOCK","display total %u/%u/%u lotado=%d",info->total_pne,info->total_idoso,info->total_comum,info->lotado_geral);
+    return 0;
+}
+int modbus_update_display(uint8_t a,uint8_t b,uint8_t c,uint8_t d,uint16_t f){mock_transaction(MODBUS_ADDR_DISPLAY,9+2*MODBUS_MOCK_DISPLAY_REGS,8);LOG_INFO("MODBUS-MOCK","display %u %u %u %u flags=%u",a,b,c,d,f);return 0;}
 #endif
@@ -6,91 +6,290 @@
 #include "parking_logic.h"
 #include "system_logger.h"
 #include "gpio_control.h"
+#include "tariff.h"
+#include "site_config.h"
+#include "metrics.h"
 #include <string.h>
+#include <sched.h>
+#include <stddef.h>
+
+#if MAX_PARKING_SPOTS_PER_FLOOR > SPOT_DELTA_INDEX_MASK + 1 || MAX_FLOORS > 255
+#error "Índices de vaga/andar do protocolo limitados a 32768 vagas e 255 andares"
+#endif
+
+// Filtro por vaga: a amostra só vira estado depois de estável pela janela
+typedef struct {
+    bool sample;                // Último estado amostrado
+    uint64_t since_us;          // Borda em que a amostra passou a valer
+} spot_filter_t;
+
+static spot_filter_t spot_filters[MAX_FLOORS][MAX_PARKING_SPOTS_PER_FLOOR];
+
+#if (PLATE_INDEX_SIZE & (PLATE_INDEX_SIZE - 1)) != 0 || PLATE_INDEX_SIZE < 2 * MAX_PARKING_SPOTS
+#error "PLATE_INDEX_SIZE deve ser potência de 2 e >= 2x MAX_PARKING_SPOTS"
+#endif
+
+static void publish_snapshot(const parking_status_t* status);
 
-static const spot_type_t TERREO_SPOT_TYPES[SPOTS_TERREO] = {
-    SPOT_TYPE_PNE,      
-    SPOT_TYPE_IDOSO,    
-    SPOT_TYPE_COMUM,    
-    SPOT_TYPE_COMUM     
-};
-static const spot_type_t ANDAR1_SPOT_TYPES[SPOTS_ANDAR1] = {
-    SPOT_TYPE_PNE,      
-    SPOT_TYPE_PNE,      
-    SPOT_TYPE_IDOSO,    
-    SPOT_TYPE_COMUM,    
-    SPOT_TYPE_COMUM,    
-    SPOT_TYPE_COMUM,    
-    SPOT_TYPE_COMUM     
-}; 
-static const spot_type_t ANDAR2_SPOT_TYPES[SPOTS_ANDAR2] = {
-    SPOT_TYPE_PNE,       
-    SPOT_TYPE_PNE,       
-    SPOT_TYPE_IDOSO,     
-    SPOT_TYPE_IDOSO,     
-    SPOT_TYPE_COMUM,     
-    SPOT_TYPE_COMUM,     
-    SPOT_TYPE_COMUM,     
-    SPOT_TYPE_COMUM      
-};
- 
 /**
- * @brief Obtém o tipo de uma vaga baseado no andar e índice
+ * @brief Recalcula do zero contadores e mapas de vagas livres de um andar
  */
-static spot_type_t get_spot_type(floor_id_t floor_id, uint8_t spot_index) {
-    switch(floor_id) {
-        case FLOOR_TERREO:
-            if (spot_index < SPOTS_TERREO) {
-                return TERREO_SPOT_TYPES[spot_index];
-            }
+static void update_floor_counters(floor_status_t* floor) {
+    if (!floor) return;
+    
+    floor->free_pne = parking_free_count(floor, SPOT_TYPE_PNE);
+    floor->free_idoso = parking_free_count(floor, SPOT_TYPE_IDOSO);
+    floor->free_comum = parking_free_count(floor, SPOT_TYPE_COMUM);
+    floor->cars_count = spot_mask_count(&floor->occupied_mask, floor->spot_words);
+    
+    floor->total_free = floor->free_pne + floor->free_idoso + floor->free_comum;
+}
+
+/**
+ * @brief Bits da palavra w da máscara que correspondem a vagas existentes
+ */
+static uint64_t floor_word_mask(const floor_status_t* floor, uint8_t w) {
+    uint32_t used = (uint32_t)floor->num_spots - (uint32_t)w * 64u;
+    return used >= 64 ? UINT64_MAX : (1ull << used) - 1;
+}
+
+/**
+ * @brief Recalcula do zero os totais a partir dos contadores dos andares
+ */
+static void update_total_counters(parking_status_t* status) {
+    status->total_free_pne = 0;
+    status->total_free_idoso = 0;
+    status->total_free_comum = 0;
+    status->total_free_spots = 0;
+    status->total_cars = 0;
+    
+    for (int floor = 0; floor < status->num_floors; floor++) {
+        status->total_free_pne += status->floors[floor].free_pne;
+        status->total_free_idoso += status->floors[floor].free_idoso;
+        status->total_free_comum += status->floors[floor].free_comum;
+        status->total_free_spots += status->floors[floor].total_free;
+        status->total_cars += status->floors[floor].cars_count;
+    }
+    
+    status->system_full = (status->total_free_spots == 0);
+}
+
+/**
+ * @brief Muda o estado de uma vaga, ajustando contadores e mapas em O(1)
+ *
+ * Única escrita de occupied_mask: atualiza o andar e os totais do
+ * parking_status_t dono do andar.
+ */
+static void set_spot_occupied(floor_status_t* floor, uint16_t spot, bool occupied) {
+    if (parking_spot_occupied(floor, spot) == occupied) return;
+    
+    int delta = occupied ? -1 : 1;
+    
+    if (occupied) {
+        spot_mask_set(&floor->occupied_mask, spot);
+    } else {
+        spot_mask_clear(&floor->occupied_mask, spot);
+    }
+    
+    parking_status_t* owner = floor->owner;
+    
+    switch(parking_spot_type(floor, spot)) {
+        case SPOT_TYPE_PNE:
+            floor->free_pne += delta;
+            if (owner) owner->total_free_pne += delta;
             break;
-        case FLOOR_ANDAR1:
-            if (spot_index < SPOTS_ANDAR1) {
-                return ANDAR1_SPOT_TYPES[spot_index];
-            }
+        case SPOT_TYPE_IDOSO:
+            floor->free_idoso += delta;
+            if (owner) owner->total_free_idoso += delta;
             break;
-        case FLOOR_ANDAR2:
-            if (spot_index < SPOTS_ANDAR2) {
-                return ANDAR2_SPOT_TYPES[spot_index];
-            }
+        case SPOT_TYPE_COMUM:
+            floor->free_comum += delta;
+            if (owner) owner->total_free_comum += delta;
             break;
     }
-    return SPOT_TYPE_COMUM;  
+    
+    floor->total_free += delta;
+    floor->cars_count -= delta;
+    
+    if (owner) {
+        owner->total_free_spots += delta;
+        owner->total_cars -= delta;
+        owner->system_full = (owner->total_free_spots == 0);
+    }
+}
+
+// =============================================================================
+// ÍNDICE DE PLACAS
+// =============================================================================
+//
+// Sondagem linear sobre plate_index, com remoção por deslocamento (sem
+// lápides): com no máximo plate_index_size / 2 tickets abertos a tabela fica
+// abaixo de 50% e a busca custa O(1) esperado, independente do número de
+// vagas. Só as primeiras plate_index_size posições são usadas (dimensionadas
+// pela topologia). Os registros ficam contíguos em vehicles: fechar um ticket
+// traz o último para o lugar dele.
+
+static uint32_t plate_home_slot(const parking_status_t* status, uint64_t key) {
+    uint64_t h = key * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(h >> 32) & (status->plate_index_size - 1);
 }
 
 /**
- * @brief Atualiza contadores de vagas livres por tipo em um andar
+ * @brief Posição da placa no índice, ou -1 se ausente
  */
-static void update_floor_counters(floor_status_t* floor) {
-    if (!floor) return;
+static int plate_index_find(const parking_status_t* status, uint64_t key) {
+    uint32_t slot = plate_home_slot(status, key);
     
-    floor->free_pne = 0;
-    floor->free_idoso = 0;
-    floor->free_comum = 0;
-    floor->cars_count = 0;
+    while (status->plate_index[slot].key != 0) {
+        if (status->plate_index[slot].key == key) {
+            return (int)slot;
+        }
+        slot = (slot + 1) & (status->plate_index_size - 1);
+    }
+    return -1;
+}
+
+static void plate_index_insert(parking_status_t* status, uint64_t key, uint16_t record) {
+    uint32_t slot = plate_home_slot(status, key);
     
-    for (int i = 0; i < floor->num_spots; i++) {
-        parking_spot_t* spot = &floor->spots[i];
+    while (status->plate_index[slot].key != 0) {
+        slot = (slot + 1) & (status->plate_index_size - 1);
+    }
+    status->plate_index[slot].key = key;
+    status->plate_index[slot].record = record;
+    status->indexed_plates++;
+}
+
+/**
+ * @brief Remove a entrada em slot, puxando para trás as que sondaram por ela
+ */
+static void plate_index_remove_slot(parking_status_t* status, uint32_t slot) {
+    uint32_t mask = status->plate_index_size - 1;
+    uint32_t hole = slot;
+    uint32_t next = (hole + 1) & mask;
+    
+    while (status->plate_index[next].key != 0) {
+        uint32_t home = plate_home_slot(status, status->plate_index[next].key);
         
-        if (spot->occupied) {
-            floor->cars_count++;
-        } else {
-             switch(spot->type) {
-                case SPOT_TYPE_PNE:
-                    floor->free_pne++;
-                    break;
-                case SPOT_TYPE_IDOSO:
-                    floor->free_idoso++;
-                    break;
-                case SPOT_TYPE_COMUM:
-                    floor->free_comum++;
-                    break;
+        // A entrada só pode ocupar o buraco se sua posição natural não
+        // estiver no trecho circular (hole, next]
+        bool stays = (hole <= next) ? (home > hole && home <= next)
+                                    : (home > hole || home <= next);
+        if (!stays) {
+            status->plate_index[hole] = status->plate_index[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    
+    status->plate_index[hole].key = 0;
+    status->indexed_plates--;
+}
+
+/**
+ * @brief Abre um ticket para uma placa que ainda não tem um
+ * @return Registro do ticket, ou NULL se a tabela está cheia
+ */
+static vehicle_record_t* open_ticket(parking_status_t* status, uint64_t key,
+                                     const char* plate, time_t entry_time) {
+    if (status->indexed_plates >= status->plate_index_size / 2) {
+        return NULL;
+    }
+    
+    uint16_t index = status->indexed_plates;
+    plate_index_insert(status, key, index);
+    
+    vehicle_record_t* record = &status->vehicles[index];
+    memset(record, 0, sizeof(*record));
+    strcpy(record->plate, plate);
+    record->entry_time = entry_time;
+    record->floor = FLOOR_TERREO;
+    record->spot = PARKING_SPOT_NONE;
+    record->ticket_id = ++status->next_ticket_id;
+    return record;
+}
+
+/**
+ * @brief Fecha o ticket da posição slot do índice
+ */
+static void close_ticket(parking_status_t* status, uint32_t slot) {
+    uint16_t index = status->plate_index[slot].record;
+    plate_index_remove_slot(status, slot);
+    
+    // Manter os registros contíguos: o último ocupa o lugar do removido
+    uint16_t last = status->indexed_plates;
+    if (index != last) {
+        status->vehicles[index] = status->vehicles[last];
+        int moved = plate_index_find(status, plate_key(status->vehicles[index].plate));
+        if (moved >= 0) {
+            status->plate_index[moved].record = index;
+        }
+    }
+}
+
+/**
+ * @brief Apaga a placa de uma vaga; o ticket, se houver, segue aberto sem vaga
+ */
+static void clear_spot_plate(floor_status_t* floor, uint16_t spot) {
+    char* plate = floor->plates[spot];
+    parking_status_t* owner = floor->owner;
+    
+    if (plate[0] != '\0' && owner) {
+        int slot = plate_index_find(owner, plate_key(plate));
+        if (slot >= 0) {
+            vehicle_record_t* record = &owner->vehicles[owner->plate_index[slot].record];
+            if (record->spot == spot && &owner->floors[record->floor] == floor) {
+                record->spot = PARKING_SPOT_NONE;
             }
         }
     }
+    plate[0] = '\0';
+}
+
+#if PARKING_VERIFY_COUNTERS
+/**
+ * @brief Confere os contadores incrementais com uma recontagem (modo debug)
+ */
+static void verify_counters(parking_status_t* status) {
+    bool mismatch = false;
+    
+    uint16_t free_spots = 0, cars = 0;
+    uint16_t free_by_type[SPOT_TYPE_COUNT] = {0};
+    
+    for (int floor = 0; floor < status->num_floors; floor++) {
+        floor_status_t* f = &status->floors[floor];
+        floor_status_t expected = *f;
+        update_floor_counters(&expected);
+        
+        if (expected.free_pne != f->free_pne || expected.free_idoso != f->free_idoso ||
+            expected.free_comum != f->free_comum || expected.total_free != f->total_free ||
+            expected.cars_count != f->cars_count) {
+            LOG_ERROR("PARKING", "Contadores do andar %d divergem da recontagem "
+                      "(livres %u != %u, carros %u != %u)", floor,
+                      f->total_free, expected.total_free, f->cars_count, expected.cars_count);
+            update_floor_counters(f);
+            mismatch = true;
+        }
+        
+        free_by_type[SPOT_TYPE_PNE] += f->free_pne;
+        free_by_type[SPOT_TYPE_IDOSO] += f->free_idoso;
+        free_by_type[SPOT_TYPE_COMUM] += f->free_comum;
+        free_spots += f->total_free;
+        cars += f->cars_count;
+    }
     
-    floor->total_free = floor->free_pne + floor->free_idoso + floor->free_comum;
+    if (mismatch || free_spots != status->total_free_spots || cars != status->total_cars ||
+        free_by_type[SPOT_TYPE_PNE] != status->total_free_pne ||
+        free_by_type[SPOT_TYPE_IDOSO] != status->total_free_idoso ||
+        free_by_type[SPOT_TYPE_COMUM] != status->total_free_comum) {
+        if (!mismatch) {
+            LOG_ERROR("PARKING", "Totais divergem da recontagem (livres %u != %u)",
+                      status->total_free_spots, free_spots);
+        }
+        update_total_counters(status);
+    }
 }
+#endif
  
 void parking_init(parking_status_t* status) {
     if (!status) return;
@@ -98,104 +297,324 @@ void parking_init(parking_status_t* status) {
     LOG_INFO("PARKING", "Inicializando sistema de estacionamento...");
     
     memset(status, 0, sizeof(parking_status_t));
+    memset(spot_filters, 0, sizeof(spot_filters));
     
-     
-    const uint8_t spots_per_floor[MAX_FLOORS] = {SPOTS_TERREO, SPOTS_ANDAR1, SPOTS_ANDAR2};
+    // Tamanhos fixados aqui pela topologia; daí em diante só são lidos
+    status->num_floors = site_floor_count();
+    status->plate_index_size = 16;
+    while (status->plate_index_size < 2u * site_total_spots()) {
+        status->plate_index_size <<= 1;
+    }
     
-    for (int floor = 0; floor < MAX_FLOORS; floor++) {
+    for (int floor = 0; floor < status->num_floors; floor++) {
+        const site_floor_t* site = site_floor((floor_id_t)floor);
         floor_status_t* f = &status->floors[floor];
-        f->num_spots = spots_per_floor[floor];
+        f->num_spots = site->num_spots;
+        f->spot_words = site->spot_words;
+        memcpy(f->type_mask, site->type_mask, sizeof(f->type_mask));
         f->blocked = false;
+        f->owner = status;
         
+        uint64_t now_us = (uint64_t)time(NULL) * 1000000u;
         for (int spot = 0; spot < f->num_spots; spot++) {
-            f->spots[spot].occupied = false;
-            f->spots[spot].type = get_spot_type((floor_id_t)floor, spot);
-            f->spots[spot].timestamp = time(NULL);
-            f->spots[spot].confidence = 0;
-            strcpy(f->spots[spot].plate, "");
+            f->changed_us[spot] = now_us;
         }
         
         update_floor_counters(f);
         
-        LOG_INFO("PARKING", "Andar %d: %d vagas (%d PNE, %d Idoso+, %d Comuns)", 
-                 floor, f->num_spots, f->free_pne, f->free_idoso, f->free_comum);
+        LOG_INFO("PARKING", "Andar %d (%s): %d vagas (%d PNE, %d Idoso+, %d Comuns)", 
+                 floor, site->name, f->num_spots, f->free_pne, f->free_idoso, f->free_comum);
     }
     
-    parking_update_total_stats(status);
+    update_total_counters(status);
     
     LOG_INFO("PARKING", "Sistema inicializado - Total: %d vagas (%d PNE, %d Idoso+, %d Comuns)", 
-             TOTAL_PARKING_SPOTS,
+             site_total_spots(),
              status->total_free_pne,
              status->total_free_idoso,
              status->total_free_comum);
 }
  
+static uint64_t realtime_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+/**
+ * @brief Aplica a leitura de uma vaga; retorna true se o estado mudou
+ */
+static bool apply_spot_reading(floor_id_t floor_id, floor_status_t* floor_status,
+                               uint16_t spot, bool currently_occupied, uint64_t edge_us) {
+    bool was_occupied = parking_spot_occupied(floor_status, spot);
+    if (currently_occupied == was_occupied) {
+        return false;
+    }
+    
+    spot_mask_set(&floor_status->changed_mask, spot);
+    
+    time_t now = (time_t)(edge_us / 1000000u);
+    set_spot_occupied(floor_status, spot, currently_occupied);
+    floor_status->changed_us[spot] = edge_us;
+    
+    char time_str[32];
+    time_to_string(now, time_str, sizeof(time_str));
+    
+    const char* type_str = spot_type_to_string(parking_spot_type(floor_status, spot));
+    
+    LOG_INFO("PARKING", "Andar %d, Vaga %d (%s): %s -> %s [%s]",
+             floor_id, spot, type_str,
+             was_occupied ? "OCUPADA" : "LIVRE",
+             currently_occupied ? "OCUPADA" : "LIVRE",
+             time_str);
+             
+    if (currently_occupied && !was_occupied) {
+        clear_spot_plate(floor_status, spot);
+        floor_status->confidence[spot] = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Passa uma amostra pelo filtro da vaga; retorna true se o estado mudou
+ *
+ * Uma amostra diferente da anterior reinicia a janela a partir de edge_us;
+ * o estado da vaga só muda quando a amostra se mantém por
+ * SPOT_DEBOUNCE_OCCUPY_MS (ocupar) ou SPOT_DEBOUNCE_FREE_MS (liberar).
+ */
+static bool filter_spot_sample(floor_id_t floor_id, floor_status_t* floor_status,
+                               uint16_t spot, bool sample, uint64_t edge_us, uint64_t now_us) {
+    spot_filter_t* filter = &spot_filters[floor_id][spot];
+    bool occupied = parking_spot_occupied(floor_status, spot);
+    
+    if (sample != filter->sample) {
+        if (filter->sample != occupied) {
+            LOG_DEBUG("PARKING", "Andar %d, Vaga %d: oscilação descartada", floor_id, spot);
+        }
+        filter->sample = sample;
+        filter->since_us = edge_us;
+    }
+    
+    if (filter->sample == occupied) {
+        return false;
+    }
+    
+    uint64_t window_us = (uint64_t)(filter->sample ? SPOT_DEBOUNCE_OCCUPY_MS
+                                                   : SPOT_DEBOUNCE_FREE_MS) * 1000u;
+    if (now_us < filter->since_us) {
+        filter->since_us = now_us;  // Relógio ajustado para trás: recomeça a janela
+    }
+    if (now_us - filter->since_us < window_us) {
+        return false;
+    }
+    
+    return apply_spot_reading(floor_id, floor_status, spot, filter->sample, filter->since_us);
+}
+
+/**
+ * @brief Recalcula os contadores após mudanças em uma varredura
+ */
+static void finish_floor_changes(floor_id_t floor_id, floor_status_t* floor_status) {
+    LOG_INFO("PARKING", "Andar %d: PNE=%d, Idoso+=%d, Comuns=%d, Total=%d livres (%d carros)", 
+             floor_id,
+             floor_status->free_pne,
+             floor_status->free_idoso,
+             floor_status->free_comum,
+             floor_status->total_free,
+             floor_status->cars_count);
+}
+ 
 int parking_scan_floor(floor_id_t floor_id, const gpio_floor_config_t* config,
                        floor_status_t* floor_status) {
     if (!config || !floor_status || floor_id >= MAX_FLOORS) {
         return -1;
     }
     
-    uint8_t changes_detected = 0;
+    uint64_t start_us = metrics_now_us();
+    int changes_detected = 0;
+    memset(&floor_status->changed_mask, 0, sizeof(floor_status->changed_mask));
     
     LOG_DEBUG("PARKING", "Iniciando varredura do andar %d (%d vagas)", 
               floor_id, floor_status->num_spots);
     
-     
-    for (uint8_t spot = 0; spot < floor_status->num_spots; spot++) {
+    // Ordem Gray: um único bit de endereço muda entre posições consecutivas;
+    // em cada endereço são lidos os sensores de todos os bancos
+    uint16_t positions = (uint16_t)(1u << config->num_address_bits);
+    for (uint16_t i = 0; i < positions; i++) {
+        uint8_t address = gpio_gray_address((uint8_t)i);
+        if (address >= config->num_addresses) continue;
          
-        if (gpio_set_address(config, spot) != 0) {
-            LOG_ERROR("PARKING", "Erro ao configurar endereço %d no andar %d", spot, floor_id);
+        if (gpio_set_address(config, address) != 0) {
+            LOG_ERROR("PARKING", "Erro ao configurar endereço %d no andar %d", address, floor_id);
             continue;
         }
         
-         
-        bool currently_occupied = gpio_read_parking_sensor(config);
-        bool was_occupied = floor_status->spots[spot].occupied;
-        
-         
-        if (currently_occupied != was_occupied) {
-            changes_detected++;
+        for (uint8_t bank = 0; bank < config->num_banks; bank++) {
+            uint16_t spot = (uint16_t)((bank << config->num_address_bits) | address);
+            if (spot >= floor_status->num_spots) break;
             
-            time_t now = time(NULL);
-            floor_status->spots[spot].occupied = currently_occupied;
-            floor_status->spots[spot].timestamp = now;
-            
-            char time_str[32];
-            time_to_string(now, time_str, sizeof(time_str));
-            
-            const char* type_str = spot_type_to_string(floor_status->spots[spot].type);
-            
-            LOG_INFO("PARKING", "Andar %d, Vaga %d (%s): %s -> %s [%s]",
-                     floor_id, spot, type_str,
-                     was_occupied ? "OCUPADA" : "LIVRE",
-                     currently_occupied ? "OCUPADA" : "LIVRE",
-                     time_str);
-                     
-             if (currently_occupied && !was_occupied) {
-                strcpy(floor_status->spots[spot].plate, "");
-                floor_status->spots[spot].confidence = 0;
+            bool sample = gpio_read_parking_sensor(config, bank);
+            uint64_t now_us = realtime_us();
+            if (filter_spot_sample(floor_id, floor_status, spot, sample, now_us, now_us)) {
+                changes_detected++;
             }
         }
     }
     
      if (changes_detected > 0) {
-        update_floor_counters(floor_status);
-        
-        LOG_INFO("PARKING", "Andar %d: PNE=%d, Idoso+=%d, Comuns=%d, Total=%d livres (%d carros)", 
-                 floor_id,
-                 floor_status->free_pne,
-                 floor_status->free_idoso,
-                 floor_status->free_comum,
-                 floor_status->total_free,
-                 floor_status->cars_count);
+        finish_floor_changes(floor_id, floor_status);
     }
     
+    metrics_observe_since(METRIC_SCAN_FLOOR_US, start_us);
     LOG_DEBUG("PARKING", "Varredura andar %d concluída - %d mudanças detectadas", 
               floor_id, changes_detected);
     
     return changes_detected;
 }
+
+int parking_apply_sensor_events(floor_id_t floor_id, floor_status_t* floor_status,
+                                const gpio_sensor_event_t* events, int count) {
+    if (!floor_status || !events || floor_id >= MAX_FLOORS) {
+        return -1;
+    }
+    
+    int changes_detected = 0;
+    memset(&floor_status->changed_mask, 0, sizeof(floor_status->changed_mask));
+    uint64_t now_us = realtime_us();
+    
+    for (int i = 0; i < count; i++) {
+        if (events[i].spot >= floor_status->num_spots) continue;
+        if (filter_spot_sample(floor_id, floor_status, events[i].spot, events[i].occupied,
+                               events[i].time_us, now_us)) {
+            changes_detected++;
+        }
+    }
+    
+    // Sem borda a amostra continua valendo: vagas pendentes podem vencer a janela
+    for (uint16_t spot = 0; spot < floor_status->num_spots; spot++) {
+        const spot_filter_t* filter = &spot_filters[floor_id][spot];
+        if (spot_mask_test(&floor_status->changed_mask, spot) ||
+            filter->sample == parking_spot_occupied(floor_status, spot)) {
+            continue;
+        }
+        if (filter_spot_sample(floor_id, floor_status, spot, filter->sample,
+                               filter->since_us, now_us)) {
+            changes_detected++;
+        }
+    }
+    
+    if (changes_detected > 0) {
+        finish_floor_changes(floor_id, floor_status);
+    }
+    
+    return changes_detected;
+}
+
+void parking_get_spot(const floor_status_t* floor_status, uint16_t spot, parking_spot_t* out) {
+    if (!floor_status || !out) return;
+    
+    memset(out, 0, sizeof(*out));
+    if (spot >= floor_status->num_spots) return;
+    
+    out->occupied = parking_spot_occupied(floor_status, spot);
+    out->type = parking_spot_type(floor_status, spot);
+    strcpy(out->plate, floor_status->plates[spot]);
+    out->timestamp_us = floor_status->changed_us[spot];
+    out->timestamp = (time_t)(out->timestamp_us / 1000000u);
+    out->confidence = floor_status->confidence[spot];
+}
+
+int parking_build_spot_delta(floor_id_t floor_id, const floor_status_t* floor_status,
+                             const spot_mask_t* changed, uint32_t seq, system_message_t* msg) {
+    if (!floor_status || !msg || floor_id >= MAX_FLOORS) {
+        return -1;
+    }
+    
+    memset(msg, 0, sizeof(system_message_t));
+    msg->type = MSG_TYPE_SPOT_DELTA;
+    msg->timestamp = time(NULL);
+    msg->data.spot_delta.floor = floor_id;
+    msg->data.spot_delta.seq = seq;
+    
+    for (uint8_t w = 0; changed && w < floor_status->spot_words; w++) {
+        uint64_t pending = changed->words[w] & floor_word_mask(floor_status, w);
+        while (pending) {
+            if (msg->data.spot_delta.count == SPOT_DELTA_MAX_ENTRIES) {
+                return -1;
+            }
+            uint16_t spot = (uint16_t)(w * 64 + __builtin_ctzll(pending));
+            pending &= pending - 1;
+            msg->data.spot_delta.spots[msg->data.spot_delta.count++] =
+                spot | (parking_spot_occupied(floor_status, spot) ? SPOT_DELTA_OCCUPIED : 0);
+        }
+    }
+    
+    return msg->data.spot_delta.count;
+}
+
+void parking_build_floor_status(floor_id_t floor_id, const floor_status_t* floor_status,
+                                uint32_t seq, system_message_t* msg) {
+    if (!floor_status || !msg) return;
+    
+    memset(msg, 0, sizeof(system_message_t));
+    msg->type = MSG_TYPE_PARKING_STATUS;
+    msg->timestamp = time(NULL);
+    msg->data.parking_status.floor = floor_id;
+    msg->data.parking_status.free_pne = floor_status->free_pne;
+    msg->data.parking_status.free_idoso = floor_status->free_idoso;
+    msg->data.parking_status.free_comum = floor_status->free_comum;
+    msg->data.parking_status.cars = floor_status->cars_count;
+    msg->data.parking_status.lotado = floor_status->total_free == 0;
+    msg->data.parking_status.seq = seq;
+    msg->data.parking_status.num_spots = floor_status->num_spots;
+    memcpy(msg->data.parking_status.occupied.words, floor_status->occupied_mask.words,
+           floor_status->spot_words * sizeof(uint64_t));
+}
+
+void parking_apply_occupied_mask(floor_status_t* floor_status, const spot_mask_t* occupied,
+                                 time_t timestamp) {
+    if (!floor_status || !occupied) return;
+    
+    for (uint8_t w = 0; w < floor_status->spot_words; w++) {
+        uint64_t diff = (occupied->words[w] ^ floor_status->occupied_mask.words[w]) &
+                        floor_word_mask(floor_status, w);
+        while (diff) {
+            uint16_t spot = (uint16_t)(w * 64 + __builtin_ctzll(diff));
+            diff &= diff - 1;
+            set_spot_occupied(floor_status, spot, spot_mask_test(occupied, spot));
+            floor_status->changed_us[spot] = (uint64_t)timestamp * 1000000u;
+        }
+    }
+}
+
+int parking_apply_spot_delta(floor_status_t* floor_status, const system_message_t* msg) {
+    if (!floor_status || !msg || msg->type != MSG_TYPE_SPOT_DELTA ||
+        msg->data.spot_delta.count > SPOT_DELTA_MAX_ENTRIES) {
+        return -1;
+    }
+    
+    // Validar antes de aplicar: um delta inválido não deve ser aplicado pela metade
+    for (uint16_t i = 0; i < msg->data.spot_delta.count; i++) {
+        if ((msg->data.spot_delta.spots[i] & SPOT_DELTA_INDEX_MASK) >= floor_status->num_spots) {
+            return -1;
+        }
+    }
+    
+    int applied = 0;
+    for (uint16_t i = 0; i < msg->data.spot_delta.count; i++) {
+        uint16_t entry = msg->data.spot_delta.spots[i];
+        uint16_t index = entry & SPOT_DELTA_INDEX_MASK;
+        bool occupied = (entry & SPOT_DELTA_OCCUPIED) != 0;
+        
+        if (parking_spot_occupied(floor_status, index) != occupied) {
+            set_spot_occupied(floor_status, index, occupied);
+            floor_status->changed_us[index] = (uint64_t)msg->timestamp * 1000000u;
+            applied++;
+        }
+    }
+    
+    return applied;
+}
  
 bool parking_allocate_spot(parking_status_t* status, const char* plate, 
                            spot_type_t preferred_type, floor_id_t preferred_floor) {
@@ -211,6 +630,12 @@ bool parking_allocate_spot(parking_status_t* status, const char* plate,
         return false;
     }
     
+    uint64_t key = plate_key(plate);
+    if (plate_index_find(status, key) >= 0) {
+        LOG_WARN("PARKING", "Placa %s já consta como estacionada - entrada recusada", plate);
+        return false;
+    }
+    
     spot_type_t types_to_try[3];
     int num_types = 0;
     
@@ -226,36 +651,45 @@ bool parking_allocate_spot(parking_status_t* status, const char* plate,
         types_to_try[num_types++] = SPOT_TYPE_PNE;
     }
     
-    for (int floor_offset = 0; floor_offset < MAX_FLOORS; floor_offset++) {
-        int floor = (preferred_floor + floor_offset) % MAX_FLOORS;
+    for (int floor_offset = 0; floor_offset < status->num_floors; floor_offset++) {
+        int floor = (preferred_floor + floor_offset) % status->num_floors;
         
-        if (status->floors[floor].blocked) {
+        floor_status_t* f = &status->floors[floor];
+        if (f->blocked) {
             continue;
         }
         
         for (int t = 0; t < num_types; t++) {
             spot_type_t try_type = types_to_try[t];
+            // Menor índice livre do tipo
+            int free_spot = parking_first_free(f, try_type);
+            if (free_spot < 0) {
+                continue;
+            }
             
-            for (int spot = 0; spot < status->floors[floor].num_spots; spot++) {
-                parking_spot_t* s = &status->floors[floor].spots[spot];
-                
-                if (!s->occupied && s->type == try_type) {
-                    
-                    s->occupied = true;
-                    s->timestamp = time(NULL);
-                    strcpy(s->plate, plate);
-                    s->confidence = 0; // Será atualizado depois
-                    
-                    // Atualiza contadores
-                    update_floor_counters(&status->floors[floor]);
-                    parking_update_total_stats(status);
-                    
-                    LOG_INFO("PARKING", "Vaga alocada: Andar %d, Spot %d (%s) para placa %s", 
-                             floor, spot, spot_type_to_string(try_type), plate);
-                    
-                    return true;
-                }
+            uint16_t spot = (uint16_t)free_spot;
+            time_t now = time(NULL);
+            
+            vehicle_record_t* record = open_ticket(status, key, plate, now);
+            if (!record) {
+                LOG_WARN("PARKING", "Tabela de tickets cheia - recusando entrada da placa %s", plate);
+                return false;
             }
+            record->floor = (floor_id_t)floor;
+            record->spot = spot;
+            
+            set_spot_occupied(f, spot, true);
+            f->changed_us[spot] = (uint64_t)now * 1000000u;
+            clear_spot_plate(f, spot);
+            strcpy(f->plates[spot], plate);
+            f->confidence[spot] = 0; // Será atualizado depois
+            
+            parking_update_total_stats(status);
+            
+            LOG_INFO("PARKING", "Vaga alocada: Andar %d, Spot %d (%s) para placa %s", 
+                     floor, spot, spot_type_to_string(try_type), plate);
+            
+            return true;
         }
     }
     
@@ -263,39 +697,131 @@ bool parking_allocate_spot(parking_status_t* status, const char* plate,
     return false;
 }
 
-bool parking_free_spot(parking_status_t* status, const char* plate) {
+const vehicle_record_t* parking_open_ticket(parking_status_t* status, const char* plate) {
+    if (!status || !plate || !is_valid_plate(plate)) {
+        return NULL;
+    }
+    
+    uint64_t key = plate_key(plate);
+    if (plate_index_find(status, key) >= 0) {
+        LOG_WARN("PARKING", "Placa %s já tem ticket em aberto - entrada recusada", plate);
+        return NULL;
+    }
+    
+    const vehicle_record_t* record = open_ticket(status, key, plate, time(NULL));
+    if (!record) {
+        LOG_WARN("PARKING", "Tabela de tickets cheia - recusando entrada da placa %s", plate);
+        return NULL;
+    }
+    
+    publish_snapshot(status);
+    
+    LOG_INFO("PARKING", "Ticket %u aberto para placa %s", record->ticket_id, plate);
+    return record;
+}
+
+const vehicle_record_t* parking_find_vehicle(const parking_status_t* status, const char* plate) {
+    if (!status || !plate || !is_valid_plate(plate)) {
+        return NULL;
+    }
+    
+    int slot = plate_index_find(status, plate_key(plate));
+    if (slot < 0) {
+        return NULL;
+    }
+    
+    return &status->vehicles[status->plate_index[slot].record];
+}
+
+bool parking_checkout_vehicle(parking_status_t* status, const char* plate,
+                              vehicle_record_t* record) {
     if (!status || !plate || !is_valid_plate(plate)) {
         return false;
     }
     
     LOG_INFO("PARKING", "Tentando liberar vaga da placa %s", plate);
     
-    // Procura a vaga da placa em todos os andares
-    for (int floor = 0; floor < MAX_FLOORS; floor++) {
-        for (int spot = 0; spot < status->floors[floor].num_spots; spot++) {
-            parking_spot_t* current_spot = &status->floors[floor].spots[spot];
-            
-            if (current_spot->occupied && strcmp(current_spot->plate, plate) == 0) {
-                // Libera a vaga
-                current_spot->occupied = false;
-                current_spot->timestamp = time(NULL);
-                strcpy(current_spot->plate, "");
-                current_spot->confidence = 0;
-                
-                // Atualiza contadores
-                update_floor_counters(&status->floors[floor]);
-                parking_update_total_stats(status);
-                
-                LOG_INFO("PARKING", "Vaga liberada: Andar %d, Spot %d (%s) da placa %s", 
-                         floor, spot, spot_type_to_string(current_spot->type), plate);
-                
-                return true;
-            }
-        }
+    int slot = plate_index_find(status, plate_key(plate));
+    if (slot < 0) {
+        LOG_WARN("PARKING", "Placa %s não encontrada para liberação", plate);
+        return false;
     }
     
-    LOG_WARN("PARKING", "Placa %s não encontrada para liberação", plate);
-    return false;
+    vehicle_record_t active = status->vehicles[status->plate_index[slot].record];
+    active.exit_time = time(NULL);
+    if (record) {
+        *record = active;
+    }
+    close_ticket(status, (uint32_t)slot);
+    
+    // Vaga atribuída por parking_allocate_spot: liberar também
+    uint16_t spot = active.spot;
+    floor_status_t* f = (spot != PARKING_SPOT_NONE) ? &status->floors[active.floor] : NULL;
+    if (f && strcmp(f->plates[spot], plate) == 0) {
+        set_spot_occupied(f, spot, false);
+        f->changed_us[spot] = (uint64_t)active.exit_time * 1000000u;
+        f->plates[spot][0] = '\0';
+        f->confidence[spot] = 0;
+        
+        LOG_INFO("PARKING", "Vaga liberada: Andar %d, Spot %d (%s) da placa %s",
+                 active.floor, spot, spot_type_to_string(parking_spot_type(f, spot)), plate);
+    } else {
+        LOG_INFO("PARKING", "Ticket %u da placa %s encerrado", active.ticket_id, plate);
+    }
+    
+    parking_update_total_stats(status);
+    
+    return true;
+}
+
+bool parking_restore_vehicle(parking_status_t* status, const vehicle_record_t* record,
+                             bool parked) {
+    if (!status || !record || !is_valid_plate(record->plate) ||
+        (unsigned)record->floor >= status->num_floors) {
+        return false;
+    }
+    
+    // Só o ticket: a ocupação das vagas vem do checkpoint e dos andares
+    int slot = plate_index_find(status, plate_key(record->plate));
+    if (slot >= 0) {
+        close_ticket(status, (uint32_t)slot);
+    }
+    
+    if (record->ticket_id > status->next_ticket_id) {
+        status->next_ticket_id = record->ticket_id;
+    }
+    
+    if (!parked) return true;
+    
+    uint32_t next_ticket = status->next_ticket_id;
+    vehicle_record_t* restored = open_ticket(status, plate_key(record->plate), record->plate,
+                                             record->entry_time);
+    status->next_ticket_id = next_ticket;
+    if (!restored) return false;
+    
+    *restored = *record;
+    return true;
+}
+
+void parking_restore_status(parking_status_t* status, const parking_status_t* saved) {
+    if (!status || !saved) return;
+    
+    parking_snapshot_t* snapshot = status->snapshot;
+    memcpy(status, saved, sizeof(*status));
+    
+    // Ponteiros gravados são de outro processo; contadores são refeitos
+    status->snapshot = snapshot;
+    for (int floor = 0; floor < status->num_floors; floor++) {
+        status->floors[floor].owner = status;
+        update_floor_counters(&status->floors[floor]);
+    }
+    update_total_counters(status);
+    
+    parking_update_total_stats(status);
+}
+
+bool parking_free_spot(parking_status_t* status, const char* plate) {
+    return parking_checkout_vehicle(status, plate, NULL);
 }
 
 uint32_t parking_calculate_fee(time_t entry_time, time_t exit_time) {
@@ -304,47 +830,134 @@ uint32_t parking_calculate_fee(time_t entry_time, time_t exit_time) {
         return 0;
     }
     
-    double diff_seconds = difftime(exit_time, entry_time);
-    
-    uint32_t minutes = (uint32_t)((diff_seconds + 59) / 60);
+    uint32_t fee_cents = tariff_fee(tariff_default(), entry_time, exit_time);
     
-    uint32_t fee_cents = minutes * PRICE_PER_MINUTE_CENTS;
+    // Lotes (fechamento, relatórios) usam tariff_fee_batch, sem log por ticket
+    LOG_DEBUG("PARKING", "Tarifa: %ld segundos = %u centavos",
+              (long)(exit_time - entry_time), fee_cents);
     
-    char money_str[32];
-    format_money(fee_cents, money_str, sizeof(money_str));
+    return fee_cents;
+}
+
+/**
+ * @brief Copia a parte do estado que a topologia usa
+ *
+ * Andares, posições do índice e registros além da topologia nunca são
+ * lidos: o custo da cópia acompanha o site, não os limites de compilação.
+ */
+static void copy_used_status(parking_status_t* dst, const parking_status_t* src) {
+    size_t floors = src->num_floors;
     
-    LOG_INFO("PARKING", "Cálculo de tarifa: %.0f segundos = %u minutos = %s", 
-             diff_seconds, minutes, money_str);
+    memcpy(dst, src, offsetof(parking_status_t, floors) + floors * sizeof(src->floors[0]));
+    memcpy(dst->plate_index, src->plate_index, src->plate_index_size * sizeof(src->plate_index[0]));
+    memcpy(dst->vehicles, src->vehicles, src->indexed_plates * sizeof(src->vehicles[0]));
+}
+
+/**
+ * @brief Copia o estado para o snapshot associado (escritor único)
+ *
+ * Chamado com o estado protegido pela trava dos escritores; leitores que
+ * pegarem seq ímpar ou alterado durante a cópia tentam de novo.
+ */
+static void publish_snapshot(const parking_status_t* status) {
+    parking_snapshot_t* snapshot = status->snapshot;
+    if (!snapshot) return;
     
-    return fee_cents;
+    uint32_t seq = snapshot->seq;
+    __atomic_store_n(&snapshot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    copy_used_status(&snapshot->status, status);
+    __atomic_store_n(&snapshot->seq, seq + 2, __ATOMIC_RELEASE);
 }
 
-void parking_update_total_stats(parking_status_t* status) {
+/**
+ * @brief Início de uma leitura do snapshot: aguarda seq par
+ */
+static uint32_t snapshot_read_begin(const parking_snapshot_t* snapshot) {
+    for (;;) {
+        uint32_t begin = __atomic_load_n(&snapshot->seq, __ATOMIC_ACQUIRE);
+        if (!(begin & 1u)) return begin;
+        sched_yield();
+    }
+}
+
+/**
+ * @brief true se o escritor publicou durante a leitura (repetir a cópia)
+ */
+static bool snapshot_read_retry(const parking_snapshot_t* snapshot, uint32_t begin) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&snapshot->seq, __ATOMIC_RELAXED) != begin;
+}
+
+void parking_snapshot_attach(parking_status_t* status, parking_snapshot_t* snapshot) {
     if (!status) return;
     
-    status->total_free_pne = 0;
-    status->total_free_idoso = 0;
-    status->total_free_comum = 0;
-    status->total_free_spots = 0;
-    status->total_cars = 0;
+    status->snapshot = snapshot;
+    if (snapshot) {
+        snapshot->seq = 0;
+        publish_snapshot(status);
+    }
+}
+
+/**
+ * @return Versão do snapshot copiado (compare com parking_snapshot_version)
+ */
+uint32_t parking_snapshot_read(const parking_snapshot_t* snapshot, parking_status_t* out) {
+    if (!snapshot || !out) return 0;
     
-    for (int floor = 0; floor < MAX_FLOORS; floor++) {
-        status->total_free_pne += status->floors[floor].free_pne;
-        status->total_free_idoso += status->floors[floor].free_idoso;
-        status->total_free_comum += status->floors[floor].free_comum;
-        status->total_free_spots += status->floors[floor].total_free;
-        status->total_cars += status->floors[floor].cars_count;
+    uint32_t begin;
+    do {
+        begin = snapshot_read_begin(snapshot);
+        copy_used_status(out, &snapshot->status);
+    } while (snapshot_read_retry(snapshot, begin));
+    
+    // A cópia é do leitor: não deve apontar para o estado vivo
+    out->snapshot = NULL;
+    for (int floor = 0; floor < out->num_floors; floor++) {
+        out->floors[floor].owner = out;
     }
+    return begin;
+}
+
+/**
+ * @brief Versão publicada agora (muda a cada publicação)
+ *
+ * Com a trava dos escritores, versão igual à de uma cópia garante que o
+ * estado não mudou desde ela.
+ */
+uint32_t parking_snapshot_version(const parking_snapshot_t* snapshot) {
+    return snapshot ? __atomic_load_n(&snapshot->seq, __ATOMIC_ACQUIRE) : 0;
+}
+
+void parking_snapshot_read_floor(const parking_snapshot_t* snapshot, floor_id_t floor_id,
+                                 floor_status_t* out) {
+    if (!snapshot || !out || floor_id >= MAX_FLOORS) return;
     
-    status->system_full = (status->total_free_spots == 0);
+    uint32_t begin;
+    do {
+        begin = snapshot_read_begin(snapshot);
+        memcpy(out, &snapshot->status.floors[floor_id], sizeof(*out));
+    } while (snapshot_read_retry(snapshot, begin));
+    out->owner = NULL;
+}
+
+void parking_update_total_stats(parking_status_t* status) {
+    if (!status) return;
+    
+    // Totais já acompanham cada mudança de vaga (set_spot_occupied)
+#if PARKING_VERIFY_COUNTERS
+    verify_counters(status);
+#endif
     
     if (status->system_full) {
         LOG_WARN("PARKING", "ESTACIONAMENTO LOTADO!");
     }
+    
+    publish_snapshot(status);
 }
 
 void parking_set_floor_blocked(parking_status_t* status, floor_id_t floor_id, bool blocked) {
-    if (!status || floor_id >= MAX_FLOORS) return;
+    if (!status || (unsigned)floor_id >= status->num_floors) return;
     
     status->floors[floor_id].blocked = blocked;
     
@@ -363,8 +976,12 @@ void parking_set_emergency_mode(parking_status_t* status, bool emergency) {
     } else {
         LOG_INFO("PARKING", "Modo de emergência desativado");
     }
+    
+    publish_snapshot(status);
 }
 
+#define PRINT_MAP_ROW 14     // Vagas por linha do mapa (3 colunas cada)
+
 void parking_print_status(const parking_status_t* status) {
     if (!status) return;
     
@@ -383,35 +1000,39 @@ void parking_print_status(const parking_status_t* status) {
     printf("║   Emergência:    %-45s ║\n",
            status->emergency_mode ? "ATIVO" : "Normal");
     
-    const char* floor_names[] = {"TÉRREO", "1º ANDAR", "2º ANDAR"};
-    
-    for (int floor = 0; floor < MAX_FLOORS; floor++) {
+    for (int floor = 0; floor < status->num_floors; floor++) {
         const floor_status_t* f = &status->floors[floor];
         
         printf("╠────────────────────────────────────────────────────────────────╣\n");
-        printf("║ %-62s ║\n", floor_names[floor]);
+        printf("║ %-62s ║\n", site_floor_name((floor_id_t)floor));
         printf("║   Vagas Livres:  %2d PNE | %2d Idoso+ | %2d Comuns = %2d total  ║\n",
                f->free_pne, f->free_idoso, f->free_comum, f->total_free);
         printf("║   Carros:        %2d                                            ║\n",
                f->cars_count);
         printf("║   Bloqueado:     %-45s ║\n", f->blocked ? "SIM" : "NÃO");
         
+        // Andares grandes continuam em linhas de PRINT_MAP_ROW vagas
         printf("║   Mapa:          ");
         for (int spot = 0; spot < f->num_spots; spot++) {
-            if (f->spots[spot].occupied) {
+            if (spot > 0 && spot % PRINT_MAP_ROW == 0) {
+                printf("    ║\n║                  ");
+            }
+            if (parking_spot_occupied(f, spot)) {
                 printf("[X]");
             } else {
-                switch(f->spots[spot].type) {
+                switch(parking_spot_type(f, spot)) {
                     case SPOT_TYPE_PNE: printf("[P]"); break;
                     case SPOT_TYPE_IDOSO: printf("[I]"); break;
                     case SPOT_TYPE_COMUM: printf("[ ]"); break;
                 }
             }
         }
-        for (int i = f->num_spots; i < MAX_PARKING_SPOTS_PER_FLOOR; i++) {
+        int last_row = f->num_spots % PRINT_MAP_ROW;
+        for (int i = (last_row == 0 && f->num_spots > 0) ? PRINT_MAP_ROW : last_row;
+             i < PRINT_MAP_ROW; i++) {
             printf("   ");
         }
-        printf("        ║\n");
+        printf("    ║\n");
     }
     
     printf("╚════════════════════════════════════════════════════════════════╝\n");
@@ -419,12 +1040,11 @@ void parking_print_status(const parking_status_t* status) {
 }
 
 void parking_print_floor_details(const parking_status_t* status, floor_id_t floor_id) {
-    if (!status || floor_id >= MAX_FLOORS) return;
+    if (!status || (unsigned)floor_id >= status->num_floors) return;
     
     const floor_status_t* f = &status->floors[floor_id];
-    const char* floor_names[] = {"TÉRREO", "1º ANDAR", "2º ANDAR"};
     
-    printf("\n=== DETALHES DO %s ===\n", floor_names[floor_id]);
+    printf("\n=== DETALHES DO %s ===\n", site_floor_name(floor_id));
     printf("Total de vagas: %d\n", f->num_spots);
     printf("Vagas livres: %d PNE, %d Idoso+, %d Comuns\n",
            f->free_pne, f->free_idoso, f->free_comum);
@@ -436,15 +1056,16 @@ void parking_print_floor_details(const parking_status_t* status, floor_id_t floo
     printf("----------------------------------------------------------------\n");
     
     for (int i = 0; i < f->num_spots; i++) {
-        const parking_spot_t* spot = &f->spots[i];
+        parking_spot_t spot;
+        parking_get_spot(f, (uint16_t)i, &spot);
         char time_str[32];
-        time_to_string(spot->timestamp, time_str, sizeof(time_str));
+        time_to_string(spot.timestamp, time_str, sizeof(time_str));
         
         printf("%-5d %-10s %-10s %-10s %s\n",
                i,
-               spot_type_to_string(spot->type),
-               spot->occupied ? "OCUPADA" : "LIVRE",
-               spot->occupied ? spot->plate : "-",
+               spot_type_to_string(spot.type),
+               spot.occupied ? "OCUPADA" : "LIVRE",
+               spot.occupied ? spot.plate : "-",
                time_str);
     }
     printf("\n");
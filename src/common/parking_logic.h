@@ -2,17 +2,86 @@
 #define PARKING_LOGIC_H
 
 #include "parking_system.h"
+#include "gpio_control.h"
 
 void parking_init(parking_status_t* status);
 
 int parking_scan_floor(floor_id_t floor_id, const gpio_floor_config_t* config,
                        floor_status_t* floor_status);
 
+int parking_apply_sensor_events(floor_id_t floor_id, floor_status_t* floor_status,
+                                const gpio_sensor_event_t* events, int count);
+
+static inline bool parking_spot_occupied(const floor_status_t* floor_status, uint16_t spot) {
+    return spot_mask_test(&floor_status->occupied_mask, spot);
+}
+
+static inline spot_type_t parking_spot_type(const floor_status_t* floor_status, uint16_t spot) {
+    for (int type = 0; type < SPOT_TYPE_COUNT; type++) {
+        if (spot_mask_test(&floor_status->type_mask[type], spot)) return (spot_type_t)type;
+    }
+    return SPOT_TYPE_COMUM;
+}
+
+static inline uint16_t parking_free_count(const floor_status_t* floor_status, spot_type_t type) {
+    uint16_t count = 0;
+    for (uint8_t w = 0; w < floor_status->spot_words; w++) {
+        count += (uint16_t)__builtin_popcountll(floor_status->type_mask[type].words[w] &
+                                                ~floor_status->occupied_mask.words[w]);
+    }
+    return count;
+}
+
+/**
+ * @brief Menor vaga livre do tipo no andar, ou -1 se não houver
+ */
+static inline int parking_first_free(const floor_status_t* floor_status, spot_type_t type) {
+    for (uint8_t w = 0; w < floor_status->spot_words; w++) {
+        uint64_t free_bits = floor_status->type_mask[type].words[w] &
+                             ~floor_status->occupied_mask.words[w];
+        if (free_bits) return w * 64 + __builtin_ctzll(free_bits);
+    }
+    return -1;
+}
+
+void parking_get_spot(const floor_status_t* floor_status, uint16_t spot, parking_spot_t* out);
+
+/**
+ * @brief Monta um delta com as vagas de changed (NULL = delta vazio)
+ * @return Vagas no delta, ou -1 se são mais que SPOT_DELTA_MAX_ENTRIES
+ *         (enviar snapshot) ou parâmetros inválidos
+ */
+int parking_build_spot_delta(floor_id_t floor_id, const floor_status_t* floor_status,
+                             const spot_mask_t* changed, uint32_t seq, system_message_t* msg);
+
+/**
+ * @brief Monta o snapshot do andar: contadores e ocupação de todas as vagas
+ */
+void parking_build_floor_status(floor_id_t floor_id, const floor_status_t* floor_status,
+                                uint32_t seq, system_message_t* msg);
+
+void parking_apply_occupied_mask(floor_status_t* floor_status, const spot_mask_t* occupied,
+                                 time_t timestamp);
+
+int parking_apply_spot_delta(floor_status_t* floor_status, const system_message_t* msg);
+
 bool parking_allocate_spot(parking_status_t* status, const char* plate,
                            spot_type_t preferred_type, floor_id_t preferred_floor);
 
 bool parking_free_spot(parking_status_t* status, const char* plate);
 
+const vehicle_record_t* parking_open_ticket(parking_status_t* status, const char* plate);
+
+const vehicle_record_t* parking_find_vehicle(const parking_status_t* status, const char* plate);
+
+bool parking_checkout_vehicle(parking_status_t* status, const char* plate,
+                              vehicle_record_t* record);
+
+bool parking_restore_vehicle(parking_status_t* status, const vehicle_record_t* record,
+                             bool parked);
+
+void parking_restore_status(parking_status_t* status, const parking_status_t* saved);
+
 uint32_t parking_calculate_fee(time_t entry_time, time_t exit_time);
 
 void parking_update_total_stats(parking_status_t* status);
@@ -21,6 +90,15 @@ void parking_set_floor_blocked(parking_status_t* status, floor_id_t floor_id, bo
 
 void parking_set_emergency_mode(parking_status_t* status, bool emergency);
 
+void parking_snapshot_attach(parking_status_t* status, parking_snapshot_t* snapshot);
+
+uint32_t parking_snapshot_read(const parking_snapshot_t* snapshot, parking_status_t* out);
+
+uint32_t parking_snapshot_version(const parking_snapshot_t* snapshot);
+
+void parking_snapshot_read_floor(const parking_snapshot_t* snapshot, floor_id_t floor_id,
+                                 floor_status_t* out);
+
 void parking_print_status(const parking_status_t* status);
 
 void parking_print_floor_details(const parking_status_t* status, floor_id_t floor_id);
@@ -16,42 +16,63 @@
 
 #include "system_config.h"
 
+// Conjunto de vagas de um andar: vaga i no bit i % 64 da palavra i / 64. As
+// operações percorrem só as palavras em uso pelo andar.
+#define SPOT_MASK_WORDS ((MAX_PARKING_SPOTS_PER_FLOOR + 63) / 64)
+
+typedef struct {
+    uint64_t words[SPOT_MASK_WORDS];
+} spot_mask_t;
+
+// words = palavras em uso pelo andar (floor_status_t.spot_words)
+static inline bool spot_mask_test(const spot_mask_t* mask, uint16_t spot) {
+    return (mask->words[spot / 64] >> (spot % 64)) & 1u;
+}
+
+static inline void spot_mask_set(spot_mask_t* mask, uint16_t spot) {
+    mask->words[spot / 64] |= 1ull << (spot % 64);
+}
+
+static inline void spot_mask_clear(spot_mask_t* mask, uint16_t spot) {
+    mask->words[spot / 64] &= ~(1ull << (spot % 64));
+}
+
+static inline bool spot_mask_any(const spot_mask_t* mask, uint8_t words) {
+    for (uint8_t w = 0; w < words; w++) {
+        if (mask->words[w]) return true;
+    }
+    return false;
+}
+
+static inline uint16_t spot_mask_count(const spot_mask_t* mask, uint8_t words) {
+    uint16_t count = 0;
+    for (uint8_t w = 0; w < words; w++) {
+        count += (uint16_t)__builtin_popcountll(mask->words[w]);
+    }
+    return count;
+}
+
+// Visão de uma vaga montada por parking_get_spot (floor_status_t guarda os
+// campos em arrays separados)
 typedef struct {
     bool occupied;
     spot_type_t type;
     char plate[9];
     time_t timestamp;
+    uint64_t timestamp_us;      // Borda que originou o estado (CLOCK_REALTIME, us)
     int confidence;
 } parking_spot_t;
 
-typedef struct {
-    parking_spot_t spots[MAX_PARKING_SPOTS_PER_FLOOR];
-    uint8_t num_spots;
-    uint8_t free_pne;
-    uint8_t free_idoso;
-    uint8_t free_comum;
-    uint8_t total_free;
-    uint8_t cars_count;
-    bool blocked;
-} floor_status_t;
-
-typedef struct {
-    floor_status_t floors[MAX_FLOORS];
-    uint8_t total_free_pne;
-    uint8_t total_free_idoso;
-    uint8_t total_free_comum;
-    uint8_t total_free_spots;
-    uint8_t total_cars;
-    bool system_full;
-    bool emergency_mode;
-} parking_status_t;
+// vehicle_record_t.spot de um ticket sem vaga conhecida (a central só sabe
+// da entrada; onde o carro para é dado dos sensores do andar)
+#define PARKING_SPOT_NONE 0xFFFF
 
 typedef struct {
     char plate[9];
     time_t entry_time;
     time_t exit_time;
     floor_id_t floor;
-    uint8_t spot;
+    uint16_t spot;              // PARKING_SPOT_NONE se não atribuída
     int confidence;
     bool is_anonymous;
     uint32_t ticket_id;
@@ -59,6 +80,71 @@ typedef struct {
     uint32_t amount_cents;
 } vehicle_record_t;
 
+// Entrada do índice de placas: chave plate_key() (0 = vazia) -> ticket
+typedef struct {
+    uint64_t key;
+    uint16_t record;            // Posição em parking_status_t.vehicles
+} plate_index_entry_t;
+
+struct parking_status;
+struct parking_snapshot;
+
+// Vagas em estrutura de arrays: ocupação e tipo em bitsets (bit i = vaga i) no
+// início, placas e horários em arrays à parte. Bitsets e contadores são mantidos
+// por parking_logic (ler com parking_spot_* / parking_get_spot)
+typedef struct {
+    spot_mask_t occupied_mask;              // Vagas ocupadas
+    spot_mask_t type_mask[SPOT_TYPE_COUNT]; // Vagas de cada tipo (disjuntos)
+    uint16_t num_spots;
+    uint8_t spot_words;         // Palavras das máscaras em uso (num_spots / 64, arred.)
+    uint16_t free_pne;
+    uint16_t free_idoso;
+    uint16_t free_comum;
+    uint16_t total_free;
+    uint16_t cars_count;
+    bool blocked;
+    spot_mask_t changed_mask;   // Vagas alteradas na última varredura
+    struct parking_status* owner;           // Totais atualizados junto (parking_init)
+    
+    // Dados por vaga, só tocados por quem precisa deles
+    char plates[MAX_PARKING_SPOTS_PER_FLOOR][9];
+    uint64_t changed_us[MAX_PARKING_SPOTS_PER_FLOOR];   // Última mudança (CLOCK_REALTIME, us)
+    uint8_t confidence[MAX_PARKING_SPOTS_PER_FLOOR];
+} floor_status_t;
+
+// Dimensionado pelos limites de compilação; parking_init ajusta num_floors e
+// plate_index_size à topologia e só essa parte é percorrida ou copiada
+typedef struct parking_status {
+    uint8_t num_floors;
+    uint16_t total_free_pne;
+    uint16_t total_free_idoso;
+    uint16_t total_free_comum;
+    uint16_t total_free_spots;
+    uint16_t total_cars;
+    bool system_full;
+    bool emergency_mode;
+    uint16_t indexed_plates;    // Tickets em aberto (vehicles[0 .. indexed_plates))
+    uint32_t plate_index_size;  // Potência de 2, >= 2x as vagas da topologia
+    uint32_t next_ticket_id;
+    
+    struct parking_snapshot* snapshot;  // Republicado a cada atualização (parking_snapshot_attach)
+    
+    floor_status_t floors[MAX_FLOORS];
+    
+    // Tickets em aberto, por placa: índice por endereçamento aberto sobre
+    // registros contíguos. Independem da ocupação das vagas, que só os
+    // sensores alteram (parking_open_ticket / parking_checkout_vehicle)
+    plate_index_entry_t plate_index[PLATE_INDEX_SIZE];
+    vehicle_record_t vehicles[MAX_PARKING_SPOTS];
+} parking_status_t;
+
+// Cópia do estado para leitores sem trava (seqlock): o escritor publica com
+// seq ímpar durante a cópia; o leitor repete até ler seq par e inalterado
+typedef struct parking_snapshot {
+    uint32_t seq;
+    parking_status_t status;
+} parking_snapshot_t;
+
 typedef enum {
     MSG_TYPE_ENTRY_OK = 1,
     MSG_TYPE_EXIT_OK,
@@ -67,9 +153,51 @@ typedef enum {
     MSG_TYPE_GATE_COMMAND,
     MSG_TYPE_SYSTEM_STATUS,
     MSG_TYPE_PASSAGE_DETECTED,
-    MSG_TYPE_ERROR
+    MSG_TYPE_ERROR,
+    MSG_TYPE_SPOT_DELTA,
+    MSG_TYPE_LOG_LEVEL,
+    MSG_TYPE_METRICS
 } message_type_t;
 
+// Texto de erro guardado fora da mensagem (message_pool.h); 0 = sem texto
+typedef uint8_t message_text_t;
+#define MESSAGE_TEXT_NONE 0
+
+// Entrada de spot_delta: índice da vaga nos bits 0-14, bit 15 = vaga ocupada
+#define SPOT_DELTA_OCCUPIED     0x8000
+#define SPOT_DELTA_INDEX_MASK   0x7FFF
+
+// Vagas por delta; mais mudanças de uma vez seguem como snapshot. Limitado
+// para a linha do protocolo texto ("255+" por vaga) caber no payload TCP.
+#define SPOT_DELTA_MAX_ENTRIES  48
+
+// Resumo de um histograma de metrics.h e leitura de um medidor
+typedef struct {
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+} metrics_summary_t;
+
+typedef struct {
+    uint32_t value;         // Atual
+    uint32_t max;           // Desde o início do processo
+} metrics_gauge_t;
+
+// Histogramas e medidores de metrics.h no resumo enviado à central
+#define METRICS_MSG_HISTS   6
+#define METRICS_MSG_GAUGES  3
+
+// Resumo das métricas de um processo, guardado fora da mensagem como o texto
+// de erro (message_pool.h); 0 = sem resumo
+typedef struct {
+    metrics_summary_t hist[METRICS_MSG_HISTS];      // metric_hist_id_t
+    metrics_gauge_t gauge[METRICS_MSG_GAUGES];      // metric_gauge_id_t
+} metrics_report_t;
+
+typedef uint8_t message_metrics_t;
+#define MESSAGE_METRICS_NONE 0
+
 typedef struct {
     message_type_t type;
     time_t timestamp;
@@ -78,18 +206,30 @@ typedef struct {
             char plate[9];
             int confidence;
             floor_id_t floor;
+            bool is_exit;           // VEHICLE_DETECTED: pedido de saída (senão entrada)
+            bool accepted;          // ENTRY_OK/EXIT_OK: resposta da central ao pedido;
+                                    // VEHICLE_DETECTED de saída: checkout adiado (já saiu)
+            uint32_t ticket_id;
+            uint32_t amount_cents;  // EXIT_OK: tarifa da permanência
         } vehicle_event;
         
         struct {
-            uint8_t terreo_pne, terreo_idoso, terreo_comum;
-            uint8_t andar1_pne, andar1_idoso, andar1_comum;
-            uint8_t andar2_pne, andar2_idoso, andar2_comum;
-            uint8_t cars_terreo, cars_andar1, cars_andar2;
-            bool lotado_geral;
-            bool lotado_andar1;
-            bool lotado_andar2;
+            floor_id_t floor;       // Andar que originou a atualização
+            uint16_t free_pne, free_idoso, free_comum;
+            uint16_t cars;
+            bool lotado;            // Andar sem vagas livres
+            uint32_t seq;           // Último delta incluído neste snapshot
+            uint16_t num_spots;     // Vagas do andar em occupied
+            spot_mask_t occupied;
         } parking_status;
         
+        struct {
+            floor_id_t floor;
+            uint32_t seq;           // Snapshot/delta anterior + 1 (igual se vazio)
+            uint16_t count;
+            uint16_t spots[SPOT_DELTA_MAX_ENTRIES]; // Ver SPOT_DELTA_OCCUPIED
+        } spot_delta;
+        
         struct {
             floor_id_t from_floor;
             floor_id_t to_floor;
@@ -103,15 +243,25 @@ typedef struct {
         
         struct {
             int error_code;
-            char description[256];
+            message_text_t text;    // Descrição (system_message_release libera)
         } error_info;
+        
+        struct {
+            char module[LOG_MODULE_MAX];    // "*" = nível global
+            int8_t level;                   // log_level_t ou -1 (remove o nível do módulo)
+        } log_level;
+        
+        struct {
+            floor_id_t floor;
+            message_metrics_t report;   // Resumo (system_message_release libera)
+        } metrics;
     } data;
 } system_message_t;
 
 int gpio_init(void);
 void gpio_cleanup(void);
 int gpio_set_address(const gpio_floor_config_t* config, uint8_t address);
-bool gpio_read_parking_sensor(const gpio_floor_config_t* config);
+bool gpio_read_parking_sensor(const gpio_floor_config_t* config, uint8_t bank);
 bool gpio_read_gate_sensor(uint8_t pin);
 void gpio_set_gate_motor(uint8_t pin, bool activate);
 
@@ -125,11 +275,22 @@ int logger_init(const char* log_dir);
 void logger_cleanup(void);
 void logger_log(log_level_t level, const char* module, const char* format, ...);
 
-#define LOG_DEBUG(module, ...) logger_log(LOG_LEVEL_DEBUG, module, __VA_ARGS__)
-#define LOG_INFO(module, ...)  logger_log(LOG_LEVEL_INFO, module, __VA_ARGS__)
-#define LOG_WARN(module, ...)  logger_log(LOG_LEVEL_WARNING, module, __VA_ARGS__)
-#define LOG_ERROR(module, ...) logger_log(LOG_LEVEL_ERROR, module, __VA_ARGS__)
-#define LOG_FATAL(module, ...) logger_log(LOG_LEVEL_FATAL, module, __VA_ARGS__)
+// Menor nível aceito por algum módulo: filtra antes de avaliar os argumentos
+extern int logger_min_level;
+
+#define LOG_AT(level, module, ...) \
+    do { \
+        if ((level) >= LOG_COMPILE_LEVEL && \
+            (int)(level) >= __atomic_load_n(&logger_min_level, __ATOMIC_RELAXED)) { \
+            logger_log(level, module, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(module, ...) LOG_AT(LOG_LEVEL_DEBUG, module, __VA_ARGS__)
+#define LOG_INFO(module, ...)  LOG_AT(LOG_LEVEL_INFO, module, __VA_ARGS__)
+#define LOG_WARN(module, ...)  LOG_AT(LOG_LEVEL_WARNING, module, __VA_ARGS__)
+#define LOG_ERROR(module, ...) LOG_AT(LOG_LEVEL_ERROR, module, __VA_ARGS__)
+#define LOG_FATAL(module, ...) LOG_AT(LOG_LEVEL_FATAL, module, __VA_ARGS__)
 
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -144,6 +305,20 @@ static inline bool is_valid_plate(const char* plate) {
     return strlen(plate) >= 7 && strlen(plate) <= 8;
 }
 
+/**
+ * @brief Empacota uma placa (até 8 caracteres) em um inteiro de 64 bits
+ *
+ * Caractere i ocupa o byte i; placas diferentes geram chaves diferentes e
+ * nenhuma placa válida gera 0.
+ */
+static inline uint64_t plate_key(const char* plate) {
+    uint64_t key = 0;
+    for (int i = 0; i < 8 && plate[i]; i++) {
+        key |= (uint64_t)(uint8_t)plate[i] << (8 * i);
+    }
+    return key;
+}
+
 static inline const char* spot_type_to_string(spot_type_t type) {
     switch(type) {
         case SPOT_TYPE_PNE: return "PNE";
@@ -0,0 +1,331 @@
+/**
+ * @file passage_detector.c
+ * @brief Detector de passagem dirigido por bordas e tabela de transições
+ *
+ * Cada par de sensores é uma máquina de estados cuja transição é uma única
+ * consulta em TRANSITIONS[estado][s1][s2]; o sentido de entrada faz parte do
+ * estado, então não há variáveis auxiliares. As bordas chegam com o
+ * timestamp do pigpio e são aplicadas na ordem em que ocorreram: um carro
+ * rápido não passa entre duas amostras. O prazo de PASSAGE_TIMEOUT_MS é
+ * conferido pelo timestamp da borda seguinte, sem relógio próprio.
+ * Cada par enfileira as suas passagens separadamente.
+ */
+
+#include "passage_detector.h"
+#include "system_logger.h"
+#include "gpio_control.h"
+#include <pthread.h>
+#include <errno.h>
+
+#if (PASSAGE_EVENT_QUEUE & (PASSAGE_EVENT_QUEUE - 1)) != 0
+#error "PASSAGE_EVENT_QUEUE deve ser potência de 2"
+#endif
+
+// =============================================================================
+// TABELA DE TRANSIÇÕES
+// =============================================================================
+
+typedef enum {
+    PS_IDLE = 0,        // Nenhum sensor ativo
+    PS_ENTER_S1,        // Só S1 ativo, veículo chegou por S1
+    PS_ENTER_S2,        // Só S2 ativo, veículo chegou por S2
+    PS_BOTH_S1,         // Ambos ativos, chegou por S1
+    PS_BOTH_S2,         // Ambos ativos, chegou por S2
+    PS_CLEARING,        // Passagem contada (ou sentido indefinido): aguardar 0/0
+    PS_COUNT
+} passage_state_t;
+
+// Entrada: próximo estado nos bits 0-3, evento nos bits 4-5
+#define EV_NONE         0x00
+#define EV_FORWARD      0x10
+#define EV_BACKWARD     0x20
+#define STATE_MASK      0x0F
+
+// [estado][s1][s2]
+static const uint8_t TRANSITIONS[PS_COUNT][2][2] = {
+    //                 s1=0: s2=0          s2=1                          s1=1: s2=0                      s2=1
+    [PS_IDLE]     = { { PS_IDLE,           PS_ENTER_S2 },               { PS_ENTER_S1,                   PS_CLEARING } },
+    // Saiu de S1 direto para S2: a sobreposição caiu entre duas leituras
+    [PS_ENTER_S1] = { { PS_IDLE,           PS_CLEARING | EV_FORWARD },  { PS_ENTER_S1,                   PS_BOTH_S1 } },
+    [PS_ENTER_S2] = { { PS_IDLE,           PS_ENTER_S2 },               { PS_CLEARING | EV_BACKWARD,     PS_BOTH_S2 } },
+    [PS_BOTH_S1]  = { { PS_IDLE,           PS_CLEARING | EV_FORWARD },  { PS_ENTER_S1,                   PS_BOTH_S1 } },
+    [PS_BOTH_S2]  = { { PS_IDLE,           PS_ENTER_S2 },               { PS_CLEARING | EV_BACKWARD,     PS_BOTH_S2 } },
+    [PS_CLEARING] = { { PS_IDLE,           PS_CLEARING },               { PS_CLEARING,                   PS_CLEARING } },
+};
+
+// =============================================================================
+// ESTADO
+// =============================================================================
+
+typedef struct {
+    uint8_t pin_s1;
+    uint8_t pin_s2;
+    bool s1;
+    bool s2;
+    bool watched;               // Bordas entregues por alerta
+    uint8_t state;
+    uint64_t last_edge_us;
+    passage_event_t queue[PASSAGE_EVENT_QUEUE];
+    uint32_t head;
+    uint32_t tail;
+} passage_pair_t;
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        // CLOCK_MONOTONIC; broadcast: um aguardante por par
+    passage_pair_t pairs[PASSAGE_MAX_PAIRS];
+    int pair_count;
+    uint32_t dropped;
+} detector;
+
+static bool detector_initialized = false;
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+static uint64_t realtime_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+static void deadline_after_ms(int ms, struct timespec* out) {
+    clock_gettime(CLOCK_MONOTONIC, out);
+    out->tv_sec += ms / 1000;
+    out->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (out->tv_nsec >= 1000000000L) {
+        out->tv_sec++;
+        out->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Aplica um novo nível dos sensores de um par (com detector.mutex)
+ * @return true se uma passagem foi enfileirada
+ */
+static bool pair_update(int index, bool s1, bool s2, uint64_t time_us) {
+    passage_pair_t* pair = &detector.pairs[index];
+    
+    if (s1 == pair->s1 && s2 == pair->s2) return false;
+    
+    // Veículo parado além do prazo (ou sensor preso): recomeçar do repouso
+    if (pair->state != PS_IDLE && time_us > pair->last_edge_us &&
+        time_us - pair->last_edge_us > (uint64_t)PASSAGE_TIMEOUT_MS * 1000u) {
+        LOG_DEBUG("PASSAGE", "Par %d: prazo de %d ms esgotado - reiniciando", index, PASSAGE_TIMEOUT_MS);
+        pair->state = PS_IDLE;
+    }
+    
+    uint8_t next = TRANSITIONS[pair->state][s1][s2];
+    pair->state = next & STATE_MASK;
+    pair->s1 = s1;
+    pair->s2 = s2;
+    pair->last_edge_us = time_us;
+    
+    if ((next & ~STATE_MASK) == EV_NONE) return false;
+    
+    if (pair->tail - pair->head == PASSAGE_EVENT_QUEUE) {
+        detector.dropped++;
+        LOG_WARN("PASSAGE", "Fila de passagens cheia - evento do par %d descartado", index);
+        return false;
+    }
+    
+    passage_event_t* event = &pair->queue[pair->tail & (PASSAGE_EVENT_QUEUE - 1)];
+    event->pair = index;
+    event->direction = (next & EV_FORWARD) ? PASSAGE_FORWARD : PASSAGE_BACKWARD;
+    event->time_us = time_us;
+    pair->tail++;
+    return true;
+}
+
+/**
+ * @brief Indica se há passagens na fila do par (ou de qualquer par)
+ */
+static bool pending_events(int pair) {
+    if (pair != PASSAGE_ANY_PAIR) {
+        return detector.pairs[pair].head != detector.pairs[pair].tail;
+    }
+    
+    for (int i = 0; i < detector.pair_count; i++) {
+        if (detector.pairs[i].head != detector.pairs[i].tail) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Callback de borda (thread do pigpio)
+ */
+static void passage_edge(uint8_t pin, bool active, uint64_t time_us, void* userdata) {
+    int index = (int)(intptr_t)userdata;
+    
+    pthread_mutex_lock(&detector.mutex);
+    passage_pair_t* pair = &detector.pairs[index];
+    bool s1 = (pin == pair->pin_s1) ? active : pair->s1;
+    bool s2 = (pin == pair->pin_s2) ? active : pair->s2;
+    if (pair_update(index, s1, s2, time_us)) {
+        pthread_cond_broadcast(&detector.cond);
+    }
+    pthread_mutex_unlock(&detector.mutex);
+}
+
+/**
+ * @brief Lê os pares sem alerta (com detector.mutex)
+ *
+ * Quem lê pode achar passagens de pares alheios: os outros aguardantes são
+ * acordados.
+ *
+ * @return true se algum par observado por leitura existe
+ */
+static bool poll_unwatched_pairs(void) {
+    bool polling = false;
+    bool queued = false;
+    
+    for (int i = 0; i < detector.pair_count; i++) {
+        passage_pair_t* pair = &detector.pairs[i];
+        if (pair->watched) continue;
+    
+        polling = true;
+        bool s1 = gpio_read_gate_sensor(pair->pin_s1);
+        bool s2 = gpio_read_gate_sensor(pair->pin_s2);
+        queued |= pair_update(i, s1, s2, realtime_us());
+    }
+    
+    if (queued) {
+        pthread_cond_broadcast(&detector.cond);
+    }
+    return polling;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS
+// =============================================================================
+
+int passage_detector_init(void) {
+    if (detector_initialized) {
+        LOG_WARN("PASSAGE", "Detector de passagem já inicializado");
+        return 0;
+    }
+    
+    memset(&detector, 0, sizeof(detector));
+    
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (pthread_mutex_init(&detector.mutex, NULL) != 0 ||
+        pthread_cond_init(&detector.cond, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
+        LOG_ERROR("PASSAGE", "Erro ao inicializar sincronização do detector");
+        return -1;
+    }
+    pthread_condattr_destroy(&attr);
+    
+    detector_initialized = true;
+    return 0;
+}
+
+void passage_detector_cleanup(void) {
+    if (!detector_initialized) return;
+    
+    // Alertas primeiro: nenhuma borda chega depois daqui
+    for (int i = 0; i < detector.pair_count; i++) {
+        gpio_input_watch_disable(detector.pairs[i].pin_s1);
+        gpio_input_watch_disable(detector.pairs[i].pin_s2);
+    }
+    
+    if (detector.dropped > 0) {
+        LOG_WARN("PASSAGE", "%u passagens descartadas por fila cheia", detector.dropped);
+    }
+    
+    pthread_cond_destroy(&detector.cond);
+    pthread_mutex_destroy(&detector.mutex);
+    detector_initialized = false;
+}
+
+int passage_detector_add_pair(uint8_t pin_s1, uint8_t pin_s2) {
+    if (!detector_initialized) return -1;
+    
+    pthread_mutex_lock(&detector.mutex);
+    if (detector.pair_count >= PASSAGE_MAX_PAIRS) {
+        pthread_mutex_unlock(&detector.mutex);
+        LOG_ERROR("PASSAGE", "Limite de %d pares de sensores atingido", PASSAGE_MAX_PAIRS);
+        return -1;
+    }
+    
+    int index = detector.pair_count;
+    passage_pair_t* pair = &detector.pairs[index];
+    memset(pair, 0, sizeof(*pair));
+    pair->pin_s1 = pin_s1;
+    pair->pin_s2 = pin_s2;
+    pair->s1 = gpio_read_gate_sensor(pin_s1);
+    pair->s2 = gpio_read_gate_sensor(pin_s2);
+    pair->state = TRANSITIONS[PS_IDLE][pair->s1][pair->s2] & STATE_MASK;
+    pair->last_edge_us = realtime_us();
+    detector.pair_count++;
+    pthread_mutex_unlock(&detector.mutex);
+    
+    // Fora da trava: o alerta pode disparar antes de enable retornar
+    void* userdata = (void*)(intptr_t)index;
+    if (gpio_input_watch_enable(pin_s1, passage_edge, userdata) == 0 &&
+        gpio_input_watch_enable(pin_s2, passage_edge, userdata) == 0) {
+        pthread_mutex_lock(&detector.mutex);
+        pair->watched = true;
+        // Bordas entre a leitura inicial e o alerta não foram vistas
+        pair_update(index, gpio_read_gate_sensor(pin_s1), gpio_read_gate_sensor(pin_s2),
+                    realtime_us());
+        pthread_mutex_unlock(&detector.mutex);
+        LOG_INFO("PASSAGE", "Par %d (GPIO %u/%u) por alerta de borda", index, pin_s1, pin_s2);
+    } else {
+        gpio_input_watch_disable(pin_s1);
+        LOG_INFO("PASSAGE", "Par %d (GPIO %u/%u) por varredura a cada %d ms",
+                 index, pin_s1, pin_s2, PASSAGE_POLL_INTERVAL_MS);
+    }
+    
+    return index;
+}
+
+int passage_detector_wait(int pair, passage_event_t* events, int max_events, int timeout_ms) {
+    if (!detector_initialized || !events || max_events <= 0) return -1;
+    
+    struct timespec deadline;
+    deadline_after_ms(timeout_ms, &deadline);
+    
+    pthread_mutex_lock(&detector.mutex);
+    if (pair != PASSAGE_ANY_PAIR && (pair < 0 || pair >= detector.pair_count)) {
+        pthread_mutex_unlock(&detector.mutex);
+        return -1;
+    }
+    
+    while (!pending_events(pair)) {
+        struct timespec wake = deadline;
+        if (poll_unwatched_pairs()) {
+            if (pending_events(pair)) break;
+    
+            // Acordar para a próxima leitura, sem passar do prazo
+            struct timespec next;
+            deadline_after_ms(PASSAGE_POLL_INTERVAL_MS, &next);
+            if (next.tv_sec < wake.tv_sec ||
+                (next.tv_sec == wake.tv_sec && next.tv_nsec < wake.tv_nsec)) {
+                wake = next;
+            }
+        }
+    
+        if (pthread_cond_timedwait(&detector.cond, &detector.mutex, &wake) == ETIMEDOUT &&
+            wake.tv_sec == deadline.tv_sec && wake.tv_nsec == deadline.tv_nsec) {
+            break;
+        }
+    }
+    
+    int count = 0;
+    int first = (pair == PASSAGE_ANY_PAIR) ? 0 : pair;
+    int last = (pair == PASSAGE_ANY_PAIR) ? detector.pair_count - 1 : pair;
+    for (int i = first; i <= last; i++) {
+        passage_pair_t* p = &detector.pairs[i];
+        while (count < max_events && p->head != p->tail) {
+            events[count++] = p->queue[p->head & (PASSAGE_EVENT_QUEUE - 1)];
+            p->head++;
+        }
+    }
+    pthread_mutex_unlock(&detector.mutex);
+    
+    return count;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file passage_detector.h
+ * @brief Detector de passagem por pares de sensores (rampas entre andares)
+ */
+
+#ifndef PASSAGE_DETECTOR_H
+#define PASSAGE_DETECTOR_H
+
+#include "parking_system.h"
+
+/**
+ * @brief Sentido de uma passagem pelo par de sensores
+ */
+typedef enum {
+    PASSAGE_FORWARD = 1,        // Entrou por S1 e saiu por S2
+    PASSAGE_BACKWARD = -1       // Entrou por S2 e saiu por S1
+} passage_direction_t;
+
+/**
+ * @brief Passagem detectada
+ */
+typedef struct {
+    int pair;                   // Identificador de passage_detector_add_pair
+    passage_direction_t direction;
+    uint64_t time_us;           // Borda que completou a passagem (CLOCK_REALTIME)
+} passage_event_t;
+
+/**
+ * @brief Inicializa o detector (requer gpio_init)
+ * @return 0 se sucesso, -1 se erro
+ */
+int passage_detector_init(void);
+
+/**
+ * @brief Finaliza o detector e para de observar os pinos
+ */
+void passage_detector_cleanup(void);
+
+/**
+ * @brief Passa a observar um par de sensores
+ *
+ * As bordas chegam por alerta do pigpio; sem alertas, os pinos são lidos a
+ * cada PASSAGE_POLL_INTERVAL_MS dentro de passage_detector_wait.
+ *
+ * @param pin_s1 Sensor do lado de origem do sentido PASSAGE_FORWARD
+ * @param pin_s2 Sensor do lado de destino
+ * @return Identificador do par (>= 0) ou -1 se erro
+ */
+int passage_detector_add_pair(uint8_t pin_s1, uint8_t pin_s2);
+
+// Qualquer par em passage_detector_wait
+#define PASSAGE_ANY_PAIR (-1)
+
+/**
+ * @brief Aguarda passagens de um par por até timeout_ms
+ *
+ * Cada par tem a sua fila: servidores no mesmo processo aguardam os próprios
+ * pares sem consumir as passagens dos outros.
+ *
+ * @param pair Identificador de passage_detector_add_pair ou PASSAGE_ANY_PAIR
+ * @param events Array de saída
+ * @param max_events Tamanho do array
+ * @param timeout_ms Espera máxima em milissegundos
+ * @return Número de passagens (0 se expirou) ou -1 se não inicializado
+ */
+int passage_detector_wait(int pair, passage_event_t* events, int max_events, int timeout_ms);
+
+#endif // PASSAGE_DETECTOR_H
@@ -0,0 +1,227 @@
+/**
+ * @file server_module.c
+ * @brief Ciclo de vida dos servidores: recursos do processo, módulos e sinais
+ *
+ * SIGINT/SIGTERM ficam bloqueados em todas as threads e são recebidos pela
+ * thread principal com sigwait: nenhum manipulador roda no meio de uma
+ * thread de módulo, e o menu pode pedir o término com o mesmo sinal.
+ */
+
+#include "server_module.h"
+#include "system_logger.h"
+#include "gpio_control.h"
+#include "gate_control.h"
+#include "modbus_client.h"
+#include "passage_detector.h"
+#include "site_config.h"
+#include "parking_logic.h"
+#include <signal.h>
+
+// Estado do estacionamento compartilhado pelos módulos (server_store)
+static parking_status_t store_status;
+static parking_snapshot_t store_snapshot;
+static pthread_mutex_t store_mutex = PTHREAD_MUTEX_INITIALIZER;
+static const server_store_t store = { &store_status, &store_snapshot, &store_mutex };
+
+static bool process_ready = false;
+static sigset_t process_signals;
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+/**
+ * @brief Confere que cada andar dos módulos existe e tem um só dono
+ *
+ * Sem isto, um site.conf com menos andares que os módulos derrubaria o
+ * processo na primeira varredura, e um andar sem servidor ficaria sem
+ * leitura de vagas sem nenhum aviso.
+ *
+ * @return 0 se válido, -1 se não (já registrado)
+ */
+static int check_floor_owners(const server_module_t* const* modules, int count) {
+    const char* owner[MAX_FLOORS] = {0};
+    int floors = site_floor_count();
+    int ret = 0;
+    
+    for (int i = 0; i < count; i++) {
+        int floor = modules[i]->floor;
+        if (floor == SERVER_NO_FLOOR) continue;
+    
+        if (!site_floor((floor_id_t)floor)) {
+            LOG_FATAL("MAIN", "Servidor %s atende o andar %d, mas o site.conf declara %d andar(es)",
+                      modules[i]->name, floor, floors);
+            ret = -1;
+        } else if (owner[floor]) {
+            LOG_FATAL("MAIN", "Andar %d (%s) atendido por %s e %s",
+                      floor, site_floor_name((floor_id_t)floor), owner[floor], modules[i]->name);
+            ret = -1;
+        } else {
+            owner[floor] = modules[i]->name;
+        }
+    }
+    
+#ifdef PARKING_SINGLE_PROCESS
+    // Cada andar tem seu processo fora do processo único: só aqui dá para
+    // ver a topologia inteira
+    for (int floor = 0; floor < floors; floor++) {
+        if (!owner[floor]) {
+            LOG_FATAL("MAIN", "Andar %d (%s) do site.conf sem servidor",
+                      floor, site_floor_name((floor_id_t)floor));
+            ret = -1;
+        }
+    }
+#endif
+    
+    return ret;
+}
+
+/**
+ * @brief Inicializa o que os módulos usam em comum
+ * @return 0 se sucesso, -1 se um recurso obrigatório falhou
+ */
+static int process_init(unsigned uses) {
+    if (gpio_init() != 0) {
+        LOG_ERROR("MAIN", "Falha ao inicializar GPIO");
+#ifndef MOCK_BUILD
+        if (uses & SERVER_USES_GPIO) return -1;
+#else
+        LOG_WARN("MAIN", "Continuando em modo MOCK");
+#endif
+    }
+
+    if ((uses & SERVER_USES_GATES) && gate_system_init() != 0) {
+        LOG_ERROR("MAIN", "Falha ao inicializar sistema de cancelas");
+    }
+
+    // Câmeras LPR e placar
+    if ((uses & SERVER_USES_MODBUS) &&
+        modbus_init(MODBUS_DEFAULT_DEVICE, MODBUS_DEFAULT_BAUDRATE) != 0) {
+        LOG_ERROR("MAIN", "Falha ao inicializar MODBUS - entradas seguem sem leitura de placa");
+    }
+
+    if ((uses & SERVER_USES_PASSAGE) && passage_detector_init() != 0) {
+        LOG_ERROR("MAIN", "Falha ao inicializar detector de passagem");
+    }
+
+    return 0;
+}
+
+static void process_cleanup(unsigned uses) {
+    if (uses & SERVER_USES_PASSAGE) passage_detector_cleanup();
+    if (uses & SERVER_USES_GATES) gate_system_cleanup();
+    if (uses & SERVER_USES_MODBUS) modbus_cleanup();
+    gpio_cleanup();
+}
+
+/**
+ * @brief Thread do menu: ao sair pelo menu, pede o término do processo
+ */
+static void* console_thread(void* arg) {
+    const server_module_t* module = (const server_module_t*)arg;
+
+    if (module->console(module->context) == 0) {
+        kill(getpid(), SIGTERM);
+    } else {
+        LOG_INFO("MAIN", "Entrada padrão encerrada - menu de %s desativado", module->name);
+    }
+    return NULL;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS
+// =============================================================================
+
+int server_init(void) {
+    if (process_ready) return 0;
+
+    // Antes de qualquer thread (inclusive a do logger): a máscara é herdada
+    sigemptyset(&process_signals);
+    sigaddset(&process_signals, SIGINT);
+    sigaddset(&process_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &process_signals, NULL);
+
+    if (logger_init(LOG_DIR) != 0) {
+        fprintf(stderr, "Falha ao iniciar logger\n");
+        return -1;
+    }
+    logger_set_level(DEFAULT_LOG_LEVEL);
+
+    // Topologia antes de qualquer módulo: GPIO, vagas e diário dependem dela
+    if (site_config_load(NULL) != 0) {
+        LOG_FATAL("MAIN", "Topologia do estacionamento inválida");
+        logger_cleanup();
+        return -1;
+    }
+
+    parking_init(store.status);
+    parking_snapshot_attach(store.status, store.snapshot);
+
+    process_ready = true;
+    return 0;
+}
+
+int server_run(const server_module_t* const* modules, int count) {
+    if (server_init() != 0) {
+        return 1;
+    }
+
+    if (check_floor_owners(modules, count) != 0) {
+        logger_cleanup();
+        return 1;
+    }
+
+    unsigned uses = 0;
+    for (int i = 0; i < count; i++) {
+        uses |= modules[i]->uses;
+    }
+
+    if (process_init(uses) != 0) {
+        logger_cleanup();
+        return 1;
+    }
+
+    int started = 0;
+    int exit_code = 0;
+    for (; started < count; started++) {
+        if (modules[started]->start(modules[started]->context) != 0) {
+            LOG_ERROR("MAIN", "Falha ao iniciar %s", modules[started]->name);
+            exit_code = 1;
+            break;
+        }
+    }
+
+    if (started == count) {
+        if (count > 1) {
+            LOG_INFO("MAIN", "%d servidores em execução no mesmo processo", count);
+        }
+
+        // O menu fica solto: pode estar bloqueado lendo a entrada no término
+        for (int i = 0; i < count; i++) {
+            pthread_t thread;
+            if (modules[i]->console &&
+                pthread_create(&thread, NULL, console_thread, (void*)modules[i]) == 0) {
+                pthread_detach(thread);
+            }
+        }
+
+        int sig = 0;
+        sigwait(&process_signals, &sig);
+        LOG_WARN("MAIN", "Sinal de término recebido (%d)", sig);
+    }
+
+    LOG_INFO("MAIN", "Iniciando shutdown...");
+    while (started > 0) {
+        started--;
+        modules[started]->stop(modules[started]->context);
+    }
+
+    process_cleanup(uses);
+    logger_cleanup();
+
+    return exit_code;
+}
+
+const server_store_t* server_store(void) {
+    return &store;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file server_module.h
+ * @brief Servidores como módulos: em processo próprio ou todos num só
+ */
+
+#ifndef SERVER_MODULE_H
+#define SERVER_MODULE_H
+
+#include "parking_system.h"
+
+// Recursos do processo usados por um módulo (server_module_t.uses)
+#define SERVER_USES_GPIO     0x01   // Sem GPIO o módulo não funciona (fora do MOCK)
+#define SERVER_USES_GATES    0x02
+#define SERVER_USES_MODBUS   0x04
+#define SERVER_USES_PASSAGE  0x08
+
+// server_module_t.floor de um módulo que não varre vagas
+#define SERVER_NO_FLOOR      (-1)
+
+/**
+ * @brief Um servidor (central ou andar) visto pelo processo que o executa
+ *
+ * Logger, GPIO, cancelas, MODBUS e detector de passagem são do processo:
+ * server_run inicializa uma vez o que algum módulo usa e libera no fim.
+ * Cada andar da topologia é varrido por exatamente um módulo (floor).
+ */
+typedef struct {
+    const char* name;
+    unsigned uses;              // SERVER_USES_*
+    int floor;                  // Andar cujas vagas o módulo varre (SERVER_NO_FLOOR = nenhum)
+    void* context;              // Passado a start, stop e console (instância do módulo)
+    int (*start)(void* context);    // Cria as threads do servidor; 0 se sucesso
+    void (*stop)(void* context);    // Sinaliza término, aguarda as threads e libera o que start criou
+    int (*console)(void* context);  // Menu interativo (NULL se não houver); 0 = pedido de saída,
+                                    // -1 = entrada padrão encerrada (segue sem menu)
+} server_module_t;
+
+/**
+ * @brief Estado do estacionamento do processo
+ *
+ * server_run inicia o estado com a topologia antes do primeiro módulo. No
+ * processo único a central e os andares usam o mesmo: cada andar varre só o
+ * seu floors[] com a mesma trava e envia a partir do snapshot, sem cópia
+ * própria.
+ */
+typedef struct {
+    parking_status_t* status;
+    parking_snapshot_t* snapshot;   // Republicado a cada atualização (sem trava)
+    pthread_mutex_t* mutex;         // Escritores de status
+} server_store_t;
+
+// Módulos de cada servidor (src/servidor_*/main.c)
+extern const server_module_t servidor_central_module;
+extern const server_module_t servidor_terreo_module;
+
+/**
+ * @brief Módulo do servidor de um andar acima do térreo (src/servidor_andar)
+ * @param floor Andar da topologia (1 .. site_floor_count() - 1)
+ * @return Módulo, ou NULL se o andar está fora da topologia
+ */
+const server_module_t* servidor_andar_module(floor_id_t floor);
+
+/**
+ * @brief Inicializa sinais, logger e topologia do processo
+ *
+ * Chamada por server_run se o main não a chamou antes: quem monta a lista de
+ * módulos a partir do site.conf precisa da topologia já carregada.
+ *
+ * @return 0 se sucesso, -1 se o logger ou o site.conf falhou (já registrado)
+ */
+int server_init(void);
+
+/**
+ * @brief Executa módulos até SIGINT/SIGTERM (ou saída pelo menu)
+ *
+ * Os módulos sobem na ordem do array e param na ordem inversa. O menu, se
+ * houver, roda numa thread própria. Antes de subir qualquer módulo, recusa
+ * um andar fora da topologia ou atendido por dois módulos; no processo
+ * único, também um andar do site.conf sem módulo.
+ *
+ * @param modules Módulos
+ * @param count Quantidade
+ * @return Código de saída do processo
+ */
+int server_run(const server_module_t* const* modules, int count);
+
+/**
+ * @brief Estado do estacionamento do processo (válido a partir de start)
+ */
+const server_store_t* server_store(void);
+
+#endif // SERVER_MODULE_H
@@ -0,0 +1,365 @@
+/**
+ * @file site_config.c
+ * @brief Leitura e validação da topologia do estacionamento
+ *
+ * Formato do arquivo (linhas key = value, '#' inicia comentário):
+ *
+ *   [andar]                 # Um bloco por andar, na ordem dos índices
+ *   nome = TÉRREO
+ *   vagas = 1P 1I 2C        # Tipos na ordem das vagas: P=PNE, I=Idoso+, C=Comum
+ *   endereco = 17 18        # Pinos das linhas de endereço, bit 0 primeiro
+ *   sensores = 8            # Pino do sensor de cada banco de multiplexador
+ *   passagem = 22 11        # Opcional: sensores S1 S2 da rampa do andar
+ *
+ * A vaga i fica no banco i / 2^bits, endereço i % 2^bits.
+ */
+
+#include "site_config.h"
+#include "system_logger.h"
+#include <ctype.h>
+
+#define SITE_LINE_MAX 512
+#define SITE_GPIO_PINS 32       // Escrita de endereço em bloco (registradores 0-31)
+
+typedef struct {
+    uint8_t num_floors;
+    uint16_t total_spots;
+    site_floor_t floors[MAX_FLOORS];
+} site_topology_t;
+
+static site_topology_t site;
+static bool site_ready = false;
+
+// =============================================================================
+// TOPOLOGIA EMBUTIDA
+// =============================================================================
+
+typedef struct {
+    const char* name;
+    const char* spots;
+    uint8_t address_pins[3];
+    uint8_t num_address_bits;
+    uint8_t sensor_pin;
+    uint8_t passage_pins[2];    // {0, 0} = sem rampa
+} default_floor_t;
+
+static const default_floor_t DEFAULT_FLOORS[] = {
+    {"TÉRREO", "1P 1I 2C",
+     {GPIO_TERREO_ENDERECO_01, GPIO_TERREO_ENDERECO_02, 0}, 2, GPIO_TERREO_SENSOR_VAGA, {0, 0}},
+    {"1º ANDAR", "2P 1I 4C 1P",
+     {GPIO_ANDAR1_ENDERECO_01, GPIO_ANDAR1_ENDERECO_02, GPIO_ANDAR1_ENDERECO_03}, 3, GPIO_ANDAR1_SENSOR_VAGA,
+     {GPIO_ANDAR1_SENSOR_PASSAGEM_1, GPIO_ANDAR1_SENSOR_PASSAGEM_2}},
+    {"2º ANDAR", "2P 2I 4C",
+     {GPIO_ANDAR2_ENDERECO_01, GPIO_ANDAR2_ENDERECO_02, GPIO_ANDAR2_ENDERECO_03}, 3, GPIO_ANDAR2_SENSOR_VAGA,
+     {GPIO_ANDAR2_SENSOR_PASSAGEM_1, GPIO_ANDAR2_SENSOR_PASSAGEM_2}},
+};
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+static char* trim(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    
+    char* end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+/**
+ * @brief Lê a sequência de tipos das vagas ("2P 1I 5C" ou "PPICCCCC")
+ * @return 0 se sucesso, -1 se inválida ou acima de MAX_PARKING_SPOTS_PER_FLOOR
+ */
+static int parse_spots(const char* text, site_floor_t* floor) {
+    memset(floor->type_mask, 0, sizeof(floor->type_mask));
+    memset(floor->type_count, 0, sizeof(floor->type_count));
+    floor->num_spots = 0;
+    
+    const char* p = text;
+    while (*p) {
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+    
+        unsigned long count = 1;
+        if (isdigit((unsigned char)*p)) {
+            char* end;
+            count = strtoul(p, &end, 10);
+            p = end;
+        }
+    
+        spot_type_t type;
+        switch (toupper((unsigned char)*p)) {
+            case 'P': type = SPOT_TYPE_PNE; break;
+            case 'I': type = SPOT_TYPE_IDOSO; break;
+            case 'C': type = SPOT_TYPE_COMUM; break;
+            default: return -1;
+        }
+        p++;
+    
+        if (count == 0 || floor->num_spots + count > MAX_PARKING_SPOTS_PER_FLOOR) {
+            return -1;
+        }
+        for (unsigned long i = 0; i < count; i++) {
+            uint16_t spot = floor->num_spots++;
+            floor->type_mask[type].words[spot / 64] |= 1ull << (spot % 64);
+        }
+        floor->type_count[type] += (uint16_t)count;
+    }
+    
+    return floor->num_spots > 0 ? 0 : -1;
+}
+
+/**
+ * @brief Lê uma lista de pinos separados por espaço ou vírgula
+ * @return Quantidade lida, ou -1 se inválida ou com mais de max pinos
+ */
+static int parse_pins(const char* text, uint8_t* pins, int max) {
+    int count = 0;
+    const char* p = text;
+    
+    while (*p) {
+        if (isspace((unsigned char)*p) || *p == ',') {
+            p++;
+            continue;
+        }
+    
+        char* end;
+        unsigned long pin = strtoul(p, &end, 10);
+        if (end == p || pin >= SITE_GPIO_PINS || count >= max) return -1;
+        pins[count++] = (uint8_t)pin;
+        p = end;
+    }
+    return count;
+}
+
+/**
+ * @brief Confere um andar lido e calcula os campos derivados
+ * @return 0 se sucesso, -1 se inválido (já registrado no log)
+ */
+static int finish_floor(site_floor_t* floor, int index, const char* path) {
+    gpio_floor_config_t* gpio = &floor->gpio;
+    
+    if (floor->num_spots == 0 || gpio->num_banks == 0) {
+        LOG_ERROR("SITE", "%s: andar %d sem vagas ou sem sensores", path, index);
+        return -1;
+    }
+    
+    uint32_t capacity = (uint32_t)gpio->num_banks << gpio->num_address_bits;
+    if (floor->num_spots > capacity) {
+        LOG_ERROR("SITE", "%s: andar %d tem %u vagas mas %u banco(s) de %u endereços",
+                  path, index, floor->num_spots, gpio->num_banks, 1u << gpio->num_address_bits);
+        return -1;
+    }
+    
+    if (floor->name[0] == '\0') {
+        snprintf(floor->name, sizeof(floor->name), "ANDAR %d", index);
+    }
+    
+    floor->spot_words = (uint8_t)((floor->num_spots + 63) / 64);
+    gpio->floor = (uint8_t)index;
+    gpio->num_spots = floor->num_spots;
+    gpio->num_addresses = (uint16_t)MIN(1u << gpio->num_address_bits, floor->num_spots);
+    return 0;
+}
+
+static void finish_topology(site_topology_t* topology) {
+    topology->total_spots = 0;
+    for (int i = 0; i < topology->num_floors; i++) {
+        topology->total_spots += topology->floors[i].num_spots;
+    }
+}
+
+static void load_default(void) {
+    memset(&site, 0, sizeof(site));
+    
+    for (size_t i = 0; i < ARRAY_SIZE(DEFAULT_FLOORS); i++) {
+        const default_floor_t* def = &DEFAULT_FLOORS[i];
+        site_floor_t* floor = &site.floors[i];
+    
+        strncpy(floor->name, def->name, sizeof(floor->name) - 1);
+        parse_spots(def->spots, floor);
+        memcpy(floor->gpio.address_pins, def->address_pins, sizeof(def->address_pins));
+        floor->gpio.num_address_bits = def->num_address_bits;
+        floor->gpio.sensor_pins[0] = def->sensor_pin;
+        floor->gpio.num_banks = 1;
+        memcpy(floor->passage_pins, def->passage_pins, sizeof(def->passage_pins));
+        floor->has_passage = def->passage_pins[0] != def->passage_pins[1];
+        finish_floor(floor, (int)i, "embutida");
+    }
+    
+    site.num_floors = (uint8_t)ARRAY_SIZE(DEFAULT_FLOORS);
+    finish_topology(&site);
+    site_ready = true;
+}
+
+static uint32_t fnv_mix(uint32_t hash, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        hash = (hash ^ (uint8_t)(value >> (8 * i))) * 16777619u;
+    }
+    return hash;
+}
+
+static void ensure_loaded(void) {
+    if (!site_ready) load_default();
+}
+
+/**
+ * @brief Interpreta o arquivo numa topologia à parte
+ * @return 0 se sucesso, -1 se inválido (já registrado no log)
+ */
+static int parse_file(FILE* file, const char* path, site_topology_t* topology) {
+    char line[SITE_LINE_MAX];
+    int line_no = 0;
+    site_floor_t* floor = NULL;
+    
+    memset(topology, 0, sizeof(*topology));
+    
+    while (fgets(line, sizeof(line), file)) {
+        line_no++;
+    
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        char* text = trim(line);
+        if (*text == '\0') continue;
+    
+        if (strcmp(text, "[andar]") == 0) {
+            if (floor && finish_floor(floor, topology->num_floors - 1, path) != 0) return -1;
+            if (topology->num_floors >= MAX_FLOORS) {
+                LOG_ERROR("SITE", "%s:%d: mais de %d andares (MAX_FLOORS)", path, line_no, MAX_FLOORS);
+                return -1;
+            }
+            floor = &topology->floors[topology->num_floors++];
+            continue;
+        }
+    
+        char* eq = strchr(text, '=');
+        if (!floor || !eq) {
+            LOG_ERROR("SITE", "%s:%d: esperado [andar] ou chave = valor", path, line_no);
+            return -1;
+        }
+        *eq = '\0';
+        char* key = trim(text);
+        char* value = trim(eq + 1);
+    
+        int ok;
+        if (strcmp(key, "nome") == 0) {
+            strncpy(floor->name, value, sizeof(floor->name) - 1);
+            ok = 1;
+        } else if (strcmp(key, "vagas") == 0) {
+            ok = parse_spots(value, floor) == 0;
+        } else if (strcmp(key, "endereco") == 0) {
+            int bits = parse_pins(value, floor->gpio.address_pins, GPIO_MAX_ADDRESS_BITS);
+            floor->gpio.num_address_bits = (uint8_t)(bits > 0 ? bits : 0);
+            ok = bits >= 0;
+        } else if (strcmp(key, "sensores") == 0) {
+            int banks = parse_pins(value, floor->gpio.sensor_pins, GPIO_MAX_MUX_BANKS);
+            floor->gpio.num_banks = (uint8_t)(banks > 0 ? banks : 0);
+            ok = banks > 0;
+        } else if (strcmp(key, "passagem") == 0) {
+            int pins = parse_pins(value, floor->passage_pins, 2);
+            floor->has_passage = (pins == 2);
+            ok = pins == 2 && floor->passage_pins[0] != floor->passage_pins[1];
+        } else {
+            LOG_ERROR("SITE", "%s:%d: chave desconhecida '%s'", path, line_no, key);
+            return -1;
+        }
+    
+        if (!ok) {
+            LOG_ERROR("SITE", "%s:%d: valor inválido para '%s' (limites: %d vagas, "
+                      "%d bits de endereço, %d bancos, 2 pinos de passagem, pinos < %d)", path, line_no, key,
+                      MAX_PARKING_SPOTS_PER_FLOOR, GPIO_MAX_ADDRESS_BITS, GPIO_MAX_MUX_BANKS,
+                      SITE_GPIO_PINS);
+            return -1;
+        }
+    }
+    
+    if (!floor) {
+        LOG_ERROR("SITE", "%s: nenhum [andar] definido", path);
+        return -1;
+    }
+    if (finish_floor(floor, topology->num_floors - 1, path) != 0) return -1;
+    
+    finish_topology(topology);
+    return 0;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS
+// =============================================================================
+
+int site_config_load(const char* path) {
+    if (!path) path = getenv(SITE_CONFIG_ENV);
+    if (!path || path[0] == '\0') path = SITE_CONFIG_PATH;
+    
+    ensure_loaded();
+    
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        if (errno != ENOENT) {
+            LOG_ERROR("SITE", "Não foi possível abrir %s: %s", path, strerror(errno));
+            return -1;
+        }
+        LOG_INFO("SITE", "%s ausente - usando a topologia embutida (%u andares, %u vagas)",
+                 path, site.num_floors, site.total_spots);
+        return 0;
+    }
+    
+    // Estática: a topologia inteira não cabe com folga na pilha
+    static site_topology_t loaded;
+    int ret = parse_file(file, path, &loaded);
+    fclose(file);
+    
+    if (ret != 0) {
+        return -1;
+    }
+    
+    site = loaded;
+    LOG_INFO("SITE", "Topologia de %s: %u andares, %u vagas", path, site.num_floors, site.total_spots);
+    for (int i = 0; i < site.num_floors; i++) {
+        const site_floor_t* floor = &site.floors[i];
+        LOG_DEBUG("SITE", "Andar %d (%s): %u vagas em %u banco(s) x %u bits",
+                  i, floor->name, floor->num_spots, floor->gpio.num_banks,
+                  floor->gpio.num_address_bits);
+    }
+    return 0;
+}
+
+uint8_t site_floor_count(void) {
+    ensure_loaded();
+    return site.num_floors;
+}
+
+uint16_t site_total_spots(void) {
+    ensure_loaded();
+    return site.total_spots;
+}
+
+const site_floor_t* site_floor(floor_id_t floor) {
+    ensure_loaded();
+    return ((unsigned)floor < site.num_floors) ? &site.floors[floor] : NULL;
+}
+
+const char* site_floor_name(floor_id_t floor) {
+    const site_floor_t* f = site_floor(floor);
+    return f ? f->name : "?";
+}
+
+uint32_t site_config_fingerprint(void) {
+    ensure_loaded();
+    
+    // FNV-1a sobre o que define o estado por vaga
+    uint32_t hash = fnv_mix(2166136261u, site.num_floors);
+    for (int i = 0; i < site.num_floors; i++) {
+        const site_floor_t* floor = &site.floors[i];
+        hash = fnv_mix(hash, floor->num_spots);
+        for (int type = 0; type < SPOT_TYPE_COUNT; type++) {
+            for (int w = 0; w < floor->spot_words; w++) {
+                hash = fnv_mix(hash, floor->type_mask[type].words[w]);
+            }
+        }
+    }
+    return hash;
+}
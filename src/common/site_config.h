@@ -0,0 +1,73 @@
+/**
+ * @file site_config.h
+ * @brief Topologia do estacionamento (andares, vagas e multiplexadores)
+ *
+ * Carregada uma vez na inicialização do processo, antes das threads; depois
+ * disso é só leitura. As tabelas já saem no formato do caminho quente:
+ * máscaras de tipo por andar e configuração de GPIO pronta para a varredura.
+ */
+
+#ifndef SITE_CONFIG_H
+#define SITE_CONFIG_H
+
+#include "parking_system.h"
+
+#define SITE_FLOOR_NAME_MAX 24
+
+/**
+ * @brief Um andar da topologia
+ */
+typedef struct {
+    char name[SITE_FLOOR_NAME_MAX];
+    uint16_t num_spots;
+    uint8_t spot_words;                     // Palavras de spot_mask_t em uso
+    spot_mask_t type_mask[SPOT_TYPE_COUNT]; // Vagas de cada tipo (disjuntos)
+    uint16_t type_count[SPOT_TYPE_COUNT];
+    gpio_floor_config_t gpio;
+    bool has_passage;                       // Par de sensores da rampa deste andar
+    uint8_t passage_pins[2];                // S1, S2 (S1 -> S2 = PASSAGE_FORWARD)
+} site_floor_t;
+
+/**
+ * @brief Carrega a topologia de um arquivo
+ *
+ * Sem path, usa a variável SITE_CONFIG_ENV ou SITE_CONFIG_PATH. Arquivo
+ * ausente mantém a topologia embutida (3 andares); arquivo inválido ou acima
+ * dos limites de compilação é recusado sem alterar a topologia atual.
+ *
+ * @param path Caminho do arquivo ou NULL
+ * @return 0 se sucesso, -1 se o arquivo é inválido
+ */
+int site_config_load(const char* path);
+
+/**
+ * @brief Número de andares da topologia
+ */
+uint8_t site_floor_count(void);
+
+/**
+ * @brief Total de vagas de todos os andares
+ */
+uint16_t site_total_spots(void);
+
+/**
+ * @brief Andar da topologia
+ * @param floor Índice do andar
+ * @return Andar, ou NULL se fora da topologia
+ */
+const site_floor_t* site_floor(floor_id_t floor);
+
+/**
+ * @brief Nome do andar para menus e logs ("?" se fora da topologia)
+ */
+const char* site_floor_name(floor_id_t floor);
+
+/**
+ * @brief Resumo da topologia (andares, vagas e tipos)
+ *
+ * Estado gravado com outra topologia (diário da central) não deve ser
+ * restaurado sobre esta.
+ */
+uint32_t site_config_fingerprint(void);
+
+#endif // SITE_CONFIG_H
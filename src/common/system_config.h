@@ -4,14 +4,25 @@
 #include <stdint.h>
 
 #define SYSTEM_VERSION "1.0"
-#define MAX_FLOORS 3
 
-#define SPOTS_TERREO 4
-#define SPOTS_ANDAR1 8
-#define SPOTS_ANDAR2 8
-#define MAX_PARKING_SPOTS_PER_FLOOR 8
+// Topologia do estacionamento (andares, vagas, tipos e pinos) lida do arquivo
+// em execução (site_config.c); sem o arquivo vale a topologia embutida de 3
+// andares. Os limites abaixo só dimensionam as estruturas fixas.
+#define SITE_CONFIG_PATH "./config/site.conf"
+#define SITE_CONFIG_ENV "PARKING_SITE_CONFIG"   // Caminho alternativo
 
-#define TOTAL_PARKING_SPOTS (SPOTS_TERREO + SPOTS_ANDAR1 + SPOTS_ANDAR2)
+#ifndef MAX_FLOORS
+#define MAX_FLOORS 16
+#endif
+#ifndef MAX_PARKING_SPOTS_PER_FLOOR
+#define MAX_PARKING_SPOTS_PER_FLOOR 256
+#endif
+
+#define MAX_PARKING_SPOTS (MAX_FLOORS * MAX_PARKING_SPOTS_PER_FLOOR)
+
+// Índice placa -> vaga: capacidade (potência de 2, >= 2x MAX_PARKING_SPOTS);
+// a parte usada é dimensionada pela topologia em parking_init
+#define PLATE_INDEX_SIZE 8192
 
 typedef enum {
     SPOT_TYPE_PNE = 0,
@@ -19,7 +30,23 @@ typedef enum {
     SPOT_TYPE_COMUM = 2
 } spot_type_t;
 
+#define SPOT_TYPE_COUNT 3
+
+// 1 = confere os contadores incrementais com recontagem completa (make DEBUG=1)
+#ifndef PARKING_VERIFY_COUNTERS
+#define PARKING_VERIFY_COUNTERS 0
+#endif
+
 #define PRICE_PER_MINUTE_CENTS 15
+
+// Tarifação (tariff.c): faixas em centavos/minuto, minutos do dia em hora local
+#define TARIFF_NIGHT_START_MIN (22 * 60)
+#define TARIFF_NIGHT_END_MIN (6 * 60)
+#define TARIFF_NIGHT_CENTS PRICE_PER_MINUTE_CENTS
+#define TARIFF_WEEKEND_CENTS PRICE_PER_MINUTE_CENTS
+#define TARIFF_GRACE_MINUTES 0          // Permanência até este tempo não é cobrada
+#define TARIFF_DAILY_CAP_CENTS 0        // Teto por dia do calendário (0 = sem teto)
+#define TARIFF_STAY_CAP_CENTS 0         // Teto da permanência (0 = sem teto)
 #define MIN_PLATE_CONFIDENCE 70
 #define LOW_PLATE_CONFIDENCE 60
 
@@ -34,6 +61,41 @@ typedef enum {
 
 #define TCP_CONNECT_TIMEOUT 5
 #define TCP_RECEIVE_TIMEOUT 10
+#define TCP_HEARTBEAT_INTERVAL_MS 2000   // Só enviado se a conexão ficou ociosa por este tempo
+
+// Reconexão dos andares: espera sorteada entre metade e o total de um teto
+// que dobra a cada falha (MIN..MAX); a fila offline guarda deltas e
+// passagens até a central voltar (potência de 2)
+#define TCP_RECONNECT_MIN_MS 500
+#define TCP_RECONNECT_MAX_MS 10000
+#define TCP_RECONNECT_POLL_MS 250       // Espera máxima por chamada (término responsivo)
+#define TCP_OFFLINE_QUEUE_SIZE 32
+
+// Agrupamento de envios dos andares: mensagens geradas dentro da janela saem
+// numa única escrita (0 = desabilita). Emergências nunca esperam a janela.
+#define TCP_BATCH_WINDOW_MS 10
+#define TCP_BATCH_MAX_BYTES 1024
+
+// 1 = linhas key=value em vez de quadros binários (apenas para depuração)
+#define TCP_TEXT_PROTOCOL 0
+
+// Enlaces em memória (andares no processo da central): fila única dos
+// andares para o loop e fila de cada enlace no sentido contrário (potências de 2)
+#define TCP_LOCAL_QUEUE_SIZE 16
+#define TCP_LOCAL_INBOX_SIZE 8
+
+// Pools fixos (message_pool.c): mensagens em fila, textos de erro, resumos de
+// métricas e blocos de buffer reaproveitados por classe de tamanho (libevent)
+#define MESSAGE_POOL_SIZE 64            // Difusão + enlaces em memória; máx. 64
+#define MESSAGE_TEXT_SLOTS 16
+#define MESSAGE_TEXT_MAX 252            // Cabe no payload junto do código de erro
+#define MESSAGE_METRICS_SLOTS 16        // Resumos de métricas em trânsito
+#define MESSAGE_BLOCK_CACHE_PER_CLASS 8
+
+// Métricas (metrics.c): resumo enviado pelos andares à central e buffer do
+// texto servido em "GET /metrics" na porta da central
+#define METRICS_EXPORT_INTERVAL_MS 10000
+#define METRICS_SCRAPE_BUFFER_SIZE 32768
 
 #define MODBUS_DEVICE "/dev/ttyUSB0"
 #define MODBUS_BAUDRATE 115200
@@ -84,6 +146,8 @@ typedef enum {
 #define GPIO_TERREO_SENSOR_ABERTURA_SAIDA 12
 #define GPIO_TERREO_SENSOR_FECHAMENTO_SAIDA 25
 #define GPIO_TERREO_MOTOR_SAIDA 24
+#define GPIO_TERREO_SENSOR_PRESENCA_ENTRADA 4
+#define GPIO_TERREO_SENSOR_PRESENCA_SAIDA 9
 
 #define GPIO_ANDAR1_ENDERECO_01 16
 #define GPIO_ANDAR1_ENDERECO_02 20
@@ -99,15 +163,78 @@ typedef enum {
 #define GPIO_ANDAR2_SENSOR_PASSAGEM_1 19
 #define GPIO_ANDAR2_SENSOR_PASSAGEM_2 26
 
+// Multiplexadores de vagas: os bancos de um andar dividem as linhas de
+// endereço e cada um tem seu pino de sensor (vaga = banco * 2^bits + endereço)
+#define GPIO_MAX_ADDRESS_BITS 8
+#define GPIO_MAX_MUX_BANKS 8
+
 #define GPIO_SCAN_INTERVAL_MS 100
+
+// Vagas por alerta do pigpio: a thread dorme até uma borda em vez de ler cada
+// endereço com espera fixa (0 = varredura periódica com gpioRead)
+#define GPIO_EVENT_DRIVEN 1
+
+// Estabilização do multiplexador + sensor após trocar o endereço (us)
+#ifndef GPIO_MUX_SETTLE_US
+#define GPIO_MUX_SETTLE_US 100
+#endif
+
+// Filtro dos sensores de vaga: cada amostra é a maioria de N leituras, e uma
+// mudança só vale após ficar estável pela janela do sentido (histerese)
+#define GPIO_SENSOR_SAMPLES 3
+#define GPIO_SENSOR_SAMPLE_GAP_US 20
+
+// Varredura por alerta sem mudanças por N voltas: volta fica M vezes mais longa
+#define GPIO_SENSOR_IDLE_SWEEPS 10
+#define GPIO_SENSOR_IDLE_SLOWDOWN 4
+#define SPOT_DEBOUNCE_OCCUPY_MS 200     // Livre -> ocupada
+#define SPOT_DEBOUNCE_FREE_MS 500       // Ocupada -> livre
+
 #define GATE_TIMEOUT_MS 5000
+
+// Reator das cancelas: prazos numa roda de temporizadores (slots potência de
+// 2 x tick); sem alertas do pigpio os sensores são lidos só durante o movimento
+#define GATE_WHEEL_SLOTS 64
+#define GATE_WHEEL_TICK_MS 10
+#define GATE_POLL_INTERVAL_MS 10
+
+// Fluxo de entrada/saída do térreo: a cancela abre antes da resposta da central
+// quando a leitura da placa tem confiança >= VEHICLE_PREOPEN_CONFIDENCE
+#define VEHICLE_ACK_TIMEOUT_MS 1500
+#define VEHICLE_GATE_HOLD_MS 2000       // Cancela aberta após o veículo sair do sensor
+#define VEHICLE_FLOW_POLL_MS 20         // Varredura de presença sem alertas do pigpio
+#define VEHICLE_FLOW_SAMPLES 256        // Latências guardadas para os percentis
+#define VEHICLE_PREOPEN_CONFIDENCE 90
+
+// Detector de passagem das rampas: transições por borda; sem alertas, os pares
+// são lidos a cada PASSAGE_POLL_INTERVAL_MS enquanto o chamador aguarda
+#define PASSAGE_TIMEOUT_MS 5000
+#define PASSAGE_POLL_INTERVAL_MS 10
+#define PASSAGE_MAX_PAIRS 4
+#define PASSAGE_EVENT_QUEUE 16          // Potência de 2
+
 #define MODBUS_POLL_INTERVAL_MS 100
 #define STATUS_UPDATE_INTERVAL_MS 1000
 
+// Diário persistente dos veículos na central (arquivo mapeado): checkpoint do
+// estado a cada VEHICLE_JOURNAL_CHECKPOINT_S ou quando o diário enche
+#define VEHICLE_JOURNAL_PATH "./data/vehicle_journal.bin"
+#define VEHICLE_JOURNAL_CAPACITY 1024
+#define VEHICLE_JOURNAL_CHECKPOINT_S 30
+#define VEHICLE_JOURNAL_SYNC 0          // 1 = msync síncrono a cada gravação
+
 #define LOG_DIR "./logs"
 #define LOG_FILE_MAX_SIZE_MB 10
 #define LOG_FILE_MAX_COUNT 5
 
+// Fila do logger assíncrono (registros pré-formatados; tamanho potência de 2)
+#define LOG_RING_SIZE 512
+#define LOG_MESSAGE_MAX 480
+#define LOG_MODULE_MAX 16
+
+// 1 = arquivo de log binário (decodificar com build/log_decoder); console segue em texto
+#define LOG_BINARY_FILE 0
+
 typedef enum {
     LOG_LEVEL_DEBUG = 0,
     LOG_LEVEL_INFO,
@@ -118,6 +245,14 @@ typedef enum {
 
 #define DEFAULT_LOG_LEVEL LOG_LEVEL_INFO
 
+// Nível mínimo compilado: chamadas LOG_* abaixo dele saem do binário
+// (make LOG_LEVEL=INFO). Acima dele valem os níveis definidos em execução.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_MODULE_FILTER_MAX 16    // Módulos com nível próprio
+
 typedef enum {
     FLOOR_TERREO = 0,
     FLOOR_ANDAR1 = 1,
@@ -132,32 +267,15 @@ typedef enum {
     GATE_STATE_ERROR
 } gate_state_t;
 
+// Vagas de um andar no GPIO; preenchido por site_config a partir da topologia
 typedef struct {
-    uint8_t address_pins[3];
+    uint8_t floor;                                  // Índice do andar na topologia
+    uint8_t address_pins[GPIO_MAX_ADDRESS_BITS];
     uint8_t num_address_bits;
-    uint8_t sensor_pin;
-    uint8_t num_spots;
+    uint8_t sensor_pins[GPIO_MAX_MUX_BANKS];        // Um por banco de multiplexador
+    uint8_t num_banks;
+    uint16_t num_spots;
+    uint16_t num_addresses;     // Endereços com alguma vaga: min(2^bits, num_spots)
 } gpio_floor_config_t;
 
-static const gpio_floor_config_t GPIO_CONFIGS[MAX_FLOORS] = {
-    {
-        .address_pins = {GPIO_TERREO_ENDERECO_01, GPIO_TERREO_ENDERECO_02, 0},
-        .num_address_bits = 2,
-        .sensor_pin = GPIO_TERREO_SENSOR_VAGA,
-        .num_spots = SPOTS_TERREO
-    },
-    {
-        .address_pins = {GPIO_ANDAR1_ENDERECO_01, GPIO_ANDAR1_ENDERECO_02, GPIO_ANDAR1_ENDERECO_03},
-        .num_address_bits = 3,
-        .sensor_pin = GPIO_ANDAR1_SENSOR_VAGA,
-        .num_spots = SPOTS_ANDAR1
-    },
-    {
-        .address_pins = {GPIO_ANDAR2_ENDERECO_01, GPIO_ANDAR2_ENDERECO_02, GPIO_ANDAR2_ENDERECO_03},
-        .num_address_bits = 3,
-        .sensor_pin = GPIO_ANDAR2_SENSOR_VAGA,
-        .num_spots = SPOTS_ANDAR2
-    }
-};
-
 #endif
\ No newline at end of file
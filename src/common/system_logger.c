@@ -1,22 +1,122 @@
 /**
  * @file system_logger.c
  * @brief Sistema de logging para debug e monitoramento
+ *
+ * Produtores formatam a mensagem direto num slot de uma fila circular
+ * MPSC sem travas (fila limitada de Vyukov); uma thread escritora formata o
+ * timestamp e grava os registros em lote com write(). Nenhuma chamada de
+ * logger_log toca em disco ou no terminal.
+ *
+ * No modo binário (LOG_FILE_BINARY) o produtor nem formata: copia os
+ * argumentos crus (log_pack_args) e o arquivo recebe registros compactos com
+ * ids de módulo e de formato (ver log_format.h).
  */
 
 #include "system_logger.h"
+#include "log_format.h"
+#include "metrics.h"
 #include <stdarg.h>
+#include <strings.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#if (LOG_RING_SIZE & (LOG_RING_SIZE - 1)) != 0
+#error "LOG_RING_SIZE deve ser potência de 2"
+#endif
+
+#if LOG_FILE_MAX_COUNT < 1
+#error "LOG_FILE_MAX_COUNT deve ser pelo menos 1"
+#endif
+
+// =============================================================================
+// TIPOS INTERNOS
+// =============================================================================
+
+typedef struct {
+    size_t seq;                         // Posição esperada (protocolo da fila)
+    struct timeval tv;
+    log_level_t level;
+    char module[LOG_MODULE_MAX];
+    const char* format;                 // Não NULL: message guarda argumentos empacotados
+    uint16_t args_size;
+    char message[LOG_MESSAGE_MAX];
+} log_record_t;
+
+// Ids do arquivo binário (reemitidos a cada arquivo novo)
+typedef struct {
+    const char* format;
+    uint16_t id;
+    bool defined;                       // Definição já gravada no arquivo atual
+} format_entry_t;
+
+typedef struct {
+    char name[LOG_MODULE_MAX];
+    bool defined;
+} module_entry_t;
+
+#define LOG_FORMAT_TABLE_SIZE 1024      // Potência de 2 (endereçamento aberto)
+#define LOG_MODULE_TABLE_SIZE 64
+#define LOG_MODULE_UNKNOWN 0xFF
+
+// Tamanho dos buffers de escrita da thread escritora
+#define LOG_WRITE_BUFFER_SIZE 16384
+
+// Espera máxima da escritora sem ser acordada (rede de segurança)
+#define LOG_WRITER_IDLE_MS 100
+
 // =============================================================================
 // VARIÁVEIS GLOBAIS
 // =============================================================================
 
-static FILE* log_file = NULL;
-static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int log_fd = -1;
+static off_t log_file_size = 0;
 static char log_directory[256] = {0};
 static log_level_t current_log_level = DEFAULT_LOG_LEVEL;
 
+// Níveis por módulo: produtores leem sem trava; entradas nunca são removidas
+// (LOG_LEVEL_INHERIT volta ao nível global)
+typedef struct {
+    char name[LOG_MODULE_MAX];
+    int level;
+} module_filter_t;
+
+static module_filter_t module_filters[LOG_MODULE_FILTER_MAX];
+static int module_filter_count = 0;
+static pthread_mutex_t filter_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int logger_min_level = DEFAULT_LOG_LEVEL;
+static log_overflow_policy_t overflow_policy = LOG_OVERFLOW_DROP;
+static log_file_format_t file_format = LOG_BINARY_FILE ? LOG_FILE_BINARY : LOG_FILE_TEXT;
+static bool console_enabled = true;
+
+// Tabelas do arquivo binário (apenas a escritora; no cleanup, após o join)
+static format_entry_t format_table[LOG_FORMAT_TABLE_SIZE];
+static uint16_t format_count = 0;
+static module_entry_t module_table[LOG_MODULE_TABLE_SIZE];
+static int module_count = 0;
+
+// Fila circular
+static log_record_t ring[LOG_RING_SIZE];
+static size_t enqueue_pos = 0;          // Disputado pelos produtores (CAS)
+static size_t dequeue_pos = 0;          // Apenas a escritora altera (produtores leem o atraso)
+static uint64_t dropped_count = 0;
+
+// Thread escritora
+static pthread_t writer_thread;
+static bool writer_running = false;
+static bool writer_idle = false;
+static size_t written_pos = 0;          // Registros já gravados (para logger_flush)
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t flush_cond = PTHREAD_COND_INITIALIZER;
+
+static char writer_file_buf[LOG_WRITE_BUFFER_SIZE];
+static char writer_console_buf[LOG_WRITE_BUFFER_SIZE];
+
+// Escrita direta no console quando a escritora não está rodando (antes do init/após cleanup)
+static pthread_mutex_t direct_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 // Nomes dos níveis de log
 static const char* level_names[] = {
     "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
@@ -35,6 +135,38 @@ static const char* level_colors[] = {
 // FUNÇÕES INTERNAS
 // =============================================================================
 
+/**
+ * @brief Nível mínimo aceito para um módulo
+ */
+static int module_threshold(const char* module) {
+    int count = __atomic_load_n(&module_filter_count, __ATOMIC_ACQUIRE);
+    
+    for (int i = 0; i < count && module; i++) {
+        if (strcmp(module_filters[i].name, module) == 0) {
+            int level = __atomic_load_n(&module_filters[i].level, __ATOMIC_RELAXED);
+            if (level != LOG_LEVEL_INHERIT) return level;
+            break;
+        }
+    }
+    
+    return (int)__atomic_load_n(&current_log_level, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Recalcula logger_min_level (chamar com filter_mutex travado)
+ */
+static void update_min_level(void) {
+    int min = (int)current_log_level;
+    
+    for (int i = 0; i < module_filter_count; i++) {
+        if (module_filters[i].level != LOG_LEVEL_INHERIT && module_filters[i].level < min) {
+            min = module_filters[i].level;
+        }
+    }
+    
+    __atomic_store_n(&logger_min_level, min, __ATOMIC_RELAXED);
+}
+
 /**
  * @brief Cria o diretório de log se não existir
  */
@@ -53,130 +185,735 @@ static int create_log_directory(const char* dir) {
 }
 
 /**
- * @brief Obtém timestamp formatado
+ * @brief Formata o timestamp de um registro
  */
-static void get_timestamp(char* buffer, size_t size) {
-    struct timeval tv;
-    struct tm* tm_info;
+static void format_timestamp(const struct timeval* tv, char* buffer, size_t size) {
+    struct tm tm_info;
     
-    gettimeofday(&tv, NULL);
-    tm_info = localtime(&tv.tv_sec);
+    localtime_r(&tv->tv_sec, &tm_info);
     
     snprintf(buffer, size, "%04d-%02d-%02d %02d:%02d:%02d.%03ld",
-             tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday,
-             tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec,
-             tv.tv_usec / 1000);
+             tm_info.tm_year + 1900, tm_info.tm_mon + 1, tm_info.tm_mday,
+             tm_info.tm_hour, tm_info.tm_min, tm_info.tm_sec,
+             (long)(tv->tv_usec / 1000));
+}
+
+/**
+ * @brief write() completo (repete em escritas parciais)
+ */
+static int write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Caminho do arquivo de log (index 0 = atual, N = rotacionado .N)
+ */
+static void log_file_path(char* buffer, size_t size, int index) {
+    const char* name = (file_format == LOG_FILE_BINARY) ? "parking_system.binlog"
+                                                        : "parking_system.log";
+    if (index == 0) {
+        snprintf(buffer, size, "%s/%s", log_directory, name);
+    } else {
+        snprintf(buffer, size, "%s/%s.%d", log_directory, name, index);
+    }
 }
 
 /**
- * @brief Rotaciona arquivo de log se necessário
+ * @brief Abre o arquivo de log atual (O_APPEND)
+ */
+static int open_log_file(void) {
+    char log_path[512];
+    log_file_path(log_path, sizeof(log_path), 0);
+    
+    log_fd = open(log_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd < 0) {
+        fprintf(stderr, "Erro ao abrir arquivo de log %s: %s\n", 
+                log_path, strerror(errno));
+        return -1;
+    }
+    
+    struct stat st;
+    log_file_size = (fstat(log_fd, &st) == 0) ? st.st_size : 0;
+    
+    if (file_format == LOG_FILE_BINARY) {
+        // Arquivo novo: cabeçalho. Em qualquer caso, ids são redefinidos antes do uso
+        if (log_file_size == 0) {
+            uint8_t header[LOG_BINARY_HEADER_SIZE];
+            memcpy(header, LOG_BINARY_MAGIC, 4);
+            header[4] = LOG_BINARY_VERSION;
+            header[5] = log_byte_order();
+            if (write_all(log_fd, (const char*)header, sizeof(header)) == 0) {
+                log_file_size += sizeof(header);
+            }
+        }
+        
+        for (int i = 0; i < LOG_FORMAT_TABLE_SIZE; i++) format_table[i].defined = false;
+        for (int i = 0; i < module_count; i++) module_table[i].defined = false;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Rotaciona arquivo de log se necessário (apenas a escritora chama)
+ *
+ * Mantém LOG_FILE_MAX_COUNT arquivos: o atual e .1 (mais novo) até
+ * .(LOG_FILE_MAX_COUNT - 1); o mais antigo é apagado.
  */
 static void rotate_log_file_if_needed(void) {
-    if (!log_file) return;
+    if (log_fd < 0) return;
     
-    long file_size = ftell(log_file);
-    if (file_size > (LOG_FILE_MAX_SIZE_MB * 1024 * 1024)) {
-        fclose(log_file);
+    if (log_file_size > (off_t)LOG_FILE_MAX_SIZE_MB * 1024 * 1024) {
+        close(log_fd);
+        log_fd = -1;
         
-        // Renomeia arquivo atual
         char old_path[512], new_path[512];
-        snprintf(old_path, sizeof(old_path), "%s/parking_system.log", log_directory);
-        snprintf(new_path, sizeof(new_path), "%s/parking_system.log.1", log_directory);
-        rename(old_path, new_path);
+        log_file_path(old_path, sizeof(old_path), LOG_FILE_MAX_COUNT - 1);
+        unlink(old_path);
+        
+        // Renomeia .N-2 -> .N-1, ..., atual -> .1
+        for (int i = LOG_FILE_MAX_COUNT - 2; i >= 0; i--) {
+            log_file_path(old_path, sizeof(old_path), i);
+            log_file_path(new_path, sizeof(new_path), i + 1);
+            rename(old_path, new_path);
+        }
         
         // Reabre arquivo
-        log_file = fopen(old_path, "a");
-        if (!log_file) {
+        if (open_log_file() != 0) {
             fprintf(stderr, "Erro ao reabrir arquivo de log\n");
         }
     }
 }
 
+/**
+ * @brief Acrescenta um registro binário [tipo][tamanho][corpo] ao buffer
+ */
+static void append_binary(char* buf, size_t* len, log_record_type_t type,
+                          const void* head, size_t head_size,
+                          const void* body, size_t body_size) {
+    uint16_t size = (uint16_t)(head_size + body_size);
+    buf[(*len)++] = (char)type;
+    memcpy(buf + *len, &size, sizeof(size));
+    *len += sizeof(size);
+    memcpy(buf + *len, head, head_size);
+    *len += head_size;
+    memcpy(buf + *len, body, body_size);
+    *len += body_size;
+}
+
+/**
+ * @brief Procura (ou cadastra) o id de um módulo
+ * @return Índice na tabela ou LOG_MODULE_UNKNOWN se a tabela estiver cheia
+ */
+static uint8_t module_id(const char* module) {
+    for (int i = 0; i < module_count; i++) {
+        if (strcmp(module_table[i].name, module) == 0) return (uint8_t)i;
+    }
+    
+    if (module_count == LOG_MODULE_TABLE_SIZE) return LOG_MODULE_UNKNOWN;
+    
+    strcpy(module_table[module_count].name, module);
+    module_table[module_count].defined = false;
+    return (uint8_t)module_count++;
+}
+
+/**
+ * @brief Procura (ou cadastra) o id de uma string de formato pelo endereço
+ * @return Entrada ou NULL se a tabela estiver cheia
+ */
+static format_entry_t* format_entry(const char* format) {
+    size_t slot = ((uintptr_t)format >> 3) & (LOG_FORMAT_TABLE_SIZE - 1);
+    
+    for (int probe = 0; probe < LOG_FORMAT_TABLE_SIZE; probe++) {
+        format_entry_t* entry = &format_table[slot];
+        if (entry->format == format) return entry;
+        if (!entry->format) {
+            if (format_count >= LOG_FORMAT_TABLE_SIZE / 2) return NULL; // Mantém sondagens curtas
+            entry->format = format;
+            entry->id = format_count++;
+            entry->defined = false;
+            return entry;
+        }
+        slot = (slot + 1) & (LOG_FORMAT_TABLE_SIZE - 1);
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Acrescenta um registro ao buffer do arquivo binário
+ * @param text Mensagem já formatada (usada se não houver id de formato)
+ * @return true se coube no buffer
+ */
+static bool append_binary_record(const log_record_t* rec, const char* text,
+                                 char* file_buf, size_t* file_len) {
+    uint8_t mod = module_id(rec->module);
+    format_entry_t* fmt = rec->format ? format_entry(rec->format) : NULL;
+    
+    size_t mod_len = strlen(rec->module);
+    size_t fmt_len = fmt ? strlen(rec->format) : 0;
+    size_t text_len = strlen(text);
+    if (fmt_len > UINT16_MAX - 2) fmt = NULL;
+    
+    // Espaço total antes de marcar qualquer definição como gravada
+    size_t need = LOG_RECORD_HEADER_SIZE + LOG_EVENT_HEADER_SIZE;
+    need += fmt ? rec->args_size : text_len;
+    if (mod != LOG_MODULE_UNKNOWN && !module_table[mod].defined) {
+        need += LOG_RECORD_HEADER_SIZE + 1 + mod_len;
+    }
+    if (fmt && !fmt->defined) {
+        need += LOG_RECORD_HEADER_SIZE + 2 + fmt_len;
+    }
+    if (need > LOG_WRITE_BUFFER_SIZE - *file_len) {
+        return false;
+    }
+    
+    if (mod != LOG_MODULE_UNKNOWN && !module_table[mod].defined) {
+        append_binary(file_buf, file_len, LOG_REC_MODULE, &mod, 1, rec->module, mod_len);
+        module_table[mod].defined = true;
+    }
+    if (fmt && !fmt->defined) {
+        append_binary(file_buf, file_len, LOG_REC_FORMAT, &fmt->id, 2, rec->format, fmt_len);
+        fmt->defined = true;
+    }
+    
+    uint8_t head[LOG_EVENT_HEADER_SIZE];
+    uint64_t ts_us = (uint64_t)rec->tv.tv_sec * 1000000ULL + (uint64_t)rec->tv.tv_usec;
+    memcpy(head, &ts_us, 8);
+    head[8] = (uint8_t)rec->level;
+    head[9] = mod;
+    
+    if (fmt) {
+        memcpy(head + 10, &fmt->id, 2);
+        append_binary(file_buf, file_len, LOG_REC_EVENT, head, LOG_EVENT_HEADER_SIZE,
+                      rec->message, rec->args_size);
+    } else {
+        // Sem id de formato: mensagem pronta (o campo de formato fica sem uso)
+        head[10] = head[11] = 0;
+        append_binary(file_buf, file_len, LOG_REC_TEXT, head, LOG_EVENT_HEADER_SIZE,
+                      text, text_len);
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Acrescenta as linhas de arquivo e de console de um registro
+ * @return true se coube nos dois buffers
+ */
+static bool format_record(const log_record_t* rec,
+                          char* file_buf, size_t* file_len,
+                          char* console_buf, size_t* console_len) {
+    char timestamp[64];
+    format_timestamp(&rec->tv, timestamp, sizeof(timestamp));
+    
+    char rendered[LOG_MESSAGE_MAX];
+    const char* text = rec->message;
+    if (rec->format) {
+        log_render(rec->format, (const uint8_t*)rec->message, rec->args_size,
+                   rendered, sizeof(rendered));
+        text = rendered;
+    }
+    
+    size_t console_room = LOG_WRITE_BUFFER_SIZE - *console_len;
+    int c = snprintf(console_buf + *console_len, console_room, "%s[%s] %s [%s] %s\x1b[0m\n",
+                     level_colors[rec->level], timestamp, level_names[rec->level],
+                     rec->module, text);
+    if (c < 0 || (size_t)c >= console_room) {
+        return false;
+    }
+    
+    if (file_format == LOG_FILE_BINARY) {
+        if (!append_binary_record(rec, text, file_buf, file_len)) {
+            return false;
+        }
+    } else {
+        size_t file_room = LOG_WRITE_BUFFER_SIZE - *file_len;
+        int f = snprintf(file_buf + *file_len, file_room, "[%s] %s [%s] %s\n",
+                         timestamp, level_names[rec->level], rec->module, text);
+        if (f < 0 || (size_t)f >= file_room) {
+            return false;
+        }
+        *file_len += (size_t)f;
+    }
+    
+    *console_len += (size_t)c;
+    return true;
+}
+
+/**
+ * @brief Grava os buffers acumulados (arquivo + console)
+ */
+static void write_buffers(const char* file_buf, size_t* file_len,
+                          const char* console_buf, size_t* console_len) {
+    if (*file_len > 0 && log_fd >= 0) {
+        if (write_all(log_fd, file_buf, *file_len) == 0) {
+            log_file_size += (off_t)*file_len;
+        }
+        rotate_log_file_if_needed();
+    }
+    
+    // Console independente do arquivo
+    if (*console_len > 0 && __atomic_load_n(&console_enabled, __ATOMIC_RELAXED)) {
+        write_all(STDOUT_FILENO, console_buf, *console_len);
+    }
+    
+    *file_len = 0;
+    *console_len = 0;
+}
+
+/**
+ * @brief Preenche um registro com a mensagem formatada
+ */
+static void fill_record(log_record_t* rec, log_level_t level, const char* module,
+                        const char* format, va_list args, bool pack) {
+    gettimeofday(&rec->tv, NULL);
+    rec->level = level;
+    
+    size_t i = 0;
+    for (; module && module[i] && i < LOG_MODULE_MAX - 1; i++) {
+        rec->module[i] = module[i];
+    }
+    rec->module[i] = '\0';
+    
+    if (pack) {
+        rec->format = format;
+        rec->args_size = (uint16_t)log_pack_args(format, args, (uint8_t*)rec->message,
+                                                 sizeof(rec->message));
+    } else {
+        rec->format = NULL;
+        rec->args_size = 0;
+        vsnprintf(rec->message, sizeof(rec->message), format, args);
+    }
+}
+
+/**
+ * @brief Reserva um slot livre da fila
+ * @return Slot reservado (publicar com seq = pos + 1) ou NULL se cheia
+ */
+static log_record_t* ring_claim(size_t* out_pos) {
+    size_t pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        log_record_t* rec = &ring[pos & (LOG_RING_SIZE - 1)];
+        size_t seq = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *out_pos = pos;
+                return rec;
+            }
+            // pos recarregado pelo CAS que falhou
+        } else if (diff < 0) {
+            return NULL; // Slot ainda não consumido: fila cheia
+        } else {
+            pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Acorda a escritora se ela estiver dormindo
+ */
+static void wake_writer(void) {
+    if (__atomic_load_n(&writer_idle, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&writer_mutex);
+        pthread_cond_signal(&writer_cond);
+        pthread_mutex_unlock(&writer_mutex);
+    }
+}
+
+/**
+ * @brief Grava um registro de texto na hora, só no console (sem escritora ativa)
+ */
+static void write_direct(const log_record_t* rec) {
+    char timestamp[64];
+    char line[LOG_MESSAGE_MAX + 128];
+    
+    format_timestamp(&rec->tv, timestamp, sizeof(timestamp));
+    int n = snprintf(line, sizeof(line), "%s[%s] %s [%s] %s\x1b[0m\n",
+                     level_colors[rec->level], timestamp, level_names[rec->level],
+                     rec->module, rec->message);
+    if (n <= 0 || !__atomic_load_n(&console_enabled, __ATOMIC_RELAXED)) return;
+    if ((size_t)n >= sizeof(line)) n = sizeof(line) - 1;
+    
+    pthread_mutex_lock(&direct_mutex);
+    write_all(STDOUT_FILENO, line, (size_t)n);
+    pthread_mutex_unlock(&direct_mutex);
+}
+
+/**
+ * @brief Consome os registros publicados e grava em lote
+ * @return Número de registros consumidos
+ */
+static size_t drain_ring(char* file_buf, char* console_buf) {
+    size_t file_len = 0, console_len = 0;
+    size_t count = 0;
+    
+    for (;;) {
+        log_record_t* rec = &ring[dequeue_pos & (LOG_RING_SIZE - 1)];
+        size_t seq = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        
+        if (seq != dequeue_pos + 1) {
+            break; // Vazia (ou produtor ainda formatando este slot)
+        }
+        
+        if (!format_record(rec, file_buf, &file_len, console_buf, &console_len)) {
+            write_buffers(file_buf, &file_len, console_buf, &console_len);
+            format_record(rec, file_buf, &file_len, console_buf, &console_len);
+        }
+        
+        // Libera o slot para a próxima volta da fila
+        __atomic_store_n(&rec->seq, dequeue_pos + LOG_RING_SIZE, __ATOMIC_RELEASE);
+        __atomic_store_n(&dequeue_pos, dequeue_pos + 1, __ATOMIC_RELAXED);
+        count++;
+    }
+    
+    write_buffers(file_buf, &file_len, console_buf, &console_len);
+    return count;
+}
+
+/**
+ * @brief Thread escritora: grava em lote e avisa descartes
+ */
+static void* writer_thread_main(void* arg) {
+    (void)arg;
+    
+    uint64_t reported_drops = __atomic_load_n(&dropped_count, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        size_t count = drain_ring(writer_file_buf, writer_console_buf);
+        
+        uint64_t drops = __atomic_load_n(&dropped_count, __ATOMIC_RELAXED);
+        if (drops != reported_drops) {
+            log_record_t notice;
+            memset(&notice, 0, sizeof(notice));
+            gettimeofday(&notice.tv, NULL);
+            notice.level = LOG_LEVEL_WARNING;
+            strcpy(notice.module, "LOGGER");
+            snprintf(notice.message, sizeof(notice.message),
+                     "%llu mensagens de log descartadas (fila cheia)",
+                     (unsigned long long)(drops - reported_drops));
+            
+            size_t file_len = 0, console_len = 0;
+            format_record(&notice, writer_file_buf, &file_len, writer_console_buf, &console_len);
+            write_buffers(writer_file_buf, &file_len, writer_console_buf, &console_len);
+            reported_drops = drops;
+        }
+        
+        pthread_mutex_lock(&writer_mutex);
+        if (count > 0) {
+            written_pos = dequeue_pos;
+            pthread_cond_broadcast(&flush_cond);
+        }
+        
+        if (count == 0) {
+            if (!writer_running) {
+                pthread_mutex_unlock(&writer_mutex);
+                break;
+            }
+            
+            // Dekker com os produtores: marcar ocioso antes de reconferir a fila
+            __atomic_store_n(&writer_idle, true, __ATOMIC_SEQ_CST);
+            size_t seq = __atomic_load_n(&ring[dequeue_pos & (LOG_RING_SIZE - 1)].seq,
+                                         __ATOMIC_SEQ_CST);
+            if (seq != dequeue_pos + 1) {
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_nsec += LOG_WRITER_IDLE_MS * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+                pthread_cond_timedwait(&writer_cond, &writer_mutex, &deadline);
+            }
+            __atomic_store_n(&writer_idle, false, __ATOMIC_SEQ_CST);
+        }
+        pthread_mutex_unlock(&writer_mutex);
+    }
+    
+    return NULL;
+}
+
 // =============================================================================
 // FUNÇÕES PÚBLICAS
 // =============================================================================
 
 int logger_init(const char* log_dir) {
-    pthread_mutex_lock(&log_mutex);
+    pthread_mutex_lock(&writer_mutex);
+    
+    if (writer_running) {
+        pthread_mutex_unlock(&writer_mutex);
+        return 0;
+    }
     
     // Cria diretório se necessário
     if (create_log_directory(log_dir) != 0) {
-        pthread_mutex_unlock(&log_mutex);
+        pthread_mutex_unlock(&writer_mutex);
         return -1;
     }
     
     strncpy(log_directory, log_dir, sizeof(log_directory) - 1);
     
     // Abre arquivo de log
-    char log_path[512];
-    snprintf(log_path, sizeof(log_path), "%s/parking_system.log", log_dir);
+    if (open_log_file() != 0) {
+        pthread_mutex_unlock(&writer_mutex);
+        return -1;
+    }
     
-    log_file = fopen(log_path, "a");
-    if (!log_file) {
-        fprintf(stderr, "Erro ao abrir arquivo de log %s: %s\n", 
-                log_path, strerror(errno));
-        pthread_mutex_unlock(&log_mutex);
+    // Fila vazia: slot i espera a posição i
+    for (size_t i = 0; i < LOG_RING_SIZE; i++) {
+        __atomic_store_n(&ring[i].seq, i, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&enqueue_pos, 0, __ATOMIC_RELAXED);
+    dequeue_pos = 0;
+    written_pos = 0;
+    
+    __atomic_store_n(&writer_running, true, __ATOMIC_RELEASE);
+    if (pthread_create(&writer_thread, NULL, writer_thread_main, NULL) != 0) {
+        fprintf(stderr, "Erro ao criar thread do logger\n");
+        __atomic_store_n(&writer_running, false, __ATOMIC_RELEASE);
+        close(log_fd);
+        log_fd = -1;
+        pthread_mutex_unlock(&writer_mutex);
         return -1;
     }
     
-    pthread_mutex_unlock(&log_mutex);
+    pthread_mutex_unlock(&writer_mutex);
     
     // Log inicial
+    char log_path[512];
+    log_file_path(log_path, sizeof(log_path), 0);
     logger_log(LOG_LEVEL_INFO, "LOGGER", "Sistema de logging inicializado - arquivo: %s", log_path);
     
     return 0;
 }
 
 void logger_cleanup(void) {
-    pthread_mutex_lock(&log_mutex);
+    pthread_mutex_lock(&writer_mutex);
+    bool running = writer_running;
+    pthread_mutex_unlock(&writer_mutex);
     
-    if (log_file) {
-        logger_log(LOG_LEVEL_INFO, "LOGGER", "Finalizando sistema de logging");
-        fclose(log_file);
-        log_file = NULL;
-    }
+    if (!running) return;
+    
+    logger_log(LOG_LEVEL_INFO, "LOGGER", "Finalizando sistema de logging");
+    
+    // A escritora só sai depois de esvaziar a fila
+    pthread_mutex_lock(&writer_mutex);
+    __atomic_store_n(&writer_running, false, __ATOMIC_RELEASE);
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_mutex);
     
-    pthread_mutex_unlock(&log_mutex);
+    pthread_join(writer_thread, NULL);
+    
+    // Registros publicados enquanto a escritora saía
+    drain_ring(writer_file_buf, writer_console_buf);
+    
+    if (log_fd >= 0) {
+        close(log_fd);
+        log_fd = -1;
+    }
 }
 
 void logger_log(log_level_t level, const char* module, const char* format, ...) {
-    if (level < current_log_level) {
-        return; // Nível muito baixo, ignora
+    if ((int)level < module_threshold(module)) {
+        return; // Nível muito baixo para este módulo, ignora
     }
     
-    pthread_mutex_lock(&log_mutex);
-    
-    char timestamp[32];
-    get_timestamp(timestamp, sizeof(timestamp));
-    
-    // Formata mensagem
-    char message[1024];
     va_list args;
     va_start(args, format);
-    vsnprintf(message, sizeof(message), format, args);
+    
+    if (!__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE)) {
+        // Antes do init ou após o cleanup: escrita direta no console
+        log_record_t rec;
+        fill_record(&rec, level, module, format, args, false);
+        va_end(args);
+        write_direct(&rec);
+        return;
+    }
+    
+    size_t pos;
+    log_record_t* rec;
+    
+    while ((rec = ring_claim(&pos)) == NULL) {
+        if (overflow_policy == LOG_OVERFLOW_DROP && level < LOG_LEVEL_FATAL) {
+            __atomic_add_fetch(&dropped_count, 1, __ATOMIC_RELAXED);
+            va_end(args);
+            wake_writer();
+            return;
+        }
+        
+        // LOG_OVERFLOW_BLOCK (e FATAL): espera a escritora liberar espaço
+        wake_writer();
+        usleep(1000);
+    }
+    
+    fill_record(rec, level, module, format, args, file_format == LOG_FILE_BINARY);
     va_end(args);
     
-    // Log para arquivo
-    if (log_file) {
-        fprintf(log_file, "[%s] %s [%s] %s\n", 
-                timestamp, level_names[level], module, message);
-        fflush(log_file);
-        rotate_log_file_if_needed();
+    // Publica o registro para a escritora
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_SEQ_CST);
+    metrics_gauge_set(METRIC_LOG_BACKLOG,
+                      (uint32_t)(pos + 1 - __atomic_load_n(&dequeue_pos, __ATOMIC_RELAXED)));
+    wake_writer();
+    
+    if (level == LOG_LEVEL_FATAL) {
+        logger_flush(); // Processo provavelmente vai terminar
     }
+}
+
+void logger_flush(void) {
+    size_t target = __atomic_load_n(&enqueue_pos, __ATOMIC_ACQUIRE);
+    
+    pthread_mutex_lock(&writer_mutex);
     
-    // Log para console (sempre, independente do arquivo)
-    printf("%s[%s] %s [%s] %s\x1b[0m\n", 
-           level_colors[level], timestamp, level_names[level], module, message);
-    fflush(stdout);
+    while (writer_running && (intptr_t)(written_pos - target) < 0) {
+        pthread_cond_signal(&writer_cond);
+        
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        if (pthread_cond_timedwait(&flush_cond, &writer_mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
     
-    pthread_mutex_unlock(&log_mutex);
+    pthread_mutex_unlock(&writer_mutex);
 }
 
 void logger_set_level(log_level_t level) {
-    current_log_level = level;
+    pthread_mutex_lock(&filter_mutex);
+    __atomic_store_n(&current_log_level, level, __ATOMIC_RELAXED);
+    update_min_level();
+    pthread_mutex_unlock(&filter_mutex);
+    
     logger_log(LOG_LEVEL_INFO, "LOGGER", "Nível de log alterado para: %s", level_names[level]);
 }
 
 log_level_t logger_get_level(void) {
     return current_log_level;
+}
+
+int logger_set_module_level(const char* module, int level) {
+    if (level != LOG_LEVEL_INHERIT && (level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_FATAL)) {
+        return -1;
+    }
+    
+    if (!module || strcmp(module, "*") == 0) {
+        if (level == LOG_LEVEL_INHERIT) return -1;
+        logger_set_level((log_level_t)level);
+        return 0;
+    }
+    
+    pthread_mutex_lock(&filter_mutex);
+    
+    module_filter_t* filter = NULL;
+    for (int i = 0; i < module_filter_count; i++) {
+        if (strcmp(module_filters[i].name, module) == 0) {
+            filter = &module_filters[i];
+            break;
+        }
+    }
+    
+    if (!filter) {
+        if (level == LOG_LEVEL_INHERIT) {
+            pthread_mutex_unlock(&filter_mutex);
+            return 0; // Já segue o nível global
+        }
+        if (module_filter_count == LOG_MODULE_FILTER_MAX) {
+            pthread_mutex_unlock(&filter_mutex);
+            return -1;
+        }
+        
+        // Preencher antes de publicar a entrada para os produtores
+        filter = &module_filters[module_filter_count];
+        strncpy(filter->name, module, LOG_MODULE_MAX - 1);
+        filter->name[LOG_MODULE_MAX - 1] = '\0';
+        filter->level = level;
+        __atomic_store_n(&module_filter_count, module_filter_count + 1, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&filter->level, level, __ATOMIC_RELAXED);
+    }
+    
+    update_min_level();
+    pthread_mutex_unlock(&filter_mutex);
+    
+    if (level == LOG_LEVEL_INHERIT) {
+        logger_log(LOG_LEVEL_INFO, "LOGGER", "Módulo %s volta ao nível global", module);
+    } else {
+        logger_log(LOG_LEVEL_INFO, "LOGGER", "Nível do módulo %s alterado para: %s",
+                   module, level_names[level]);
+    }
+    return 0;
+}
+
+int logger_get_module_level(const char* module) {
+    return module_threshold(module);
+}
+
+void logger_reset_module_levels(void) {
+    pthread_mutex_lock(&filter_mutex);
+    for (int i = 0; i < module_filter_count; i++) {
+        __atomic_store_n(&module_filters[i].level, LOG_LEVEL_INHERIT, __ATOMIC_RELAXED);
+    }
+    update_min_level();
+    pthread_mutex_unlock(&filter_mutex);
+}
+
+int logger_parse_level(const char* name, int* level) {
+    static const struct {
+        const char* name;
+        int level;
+    } names[] = {
+        {"DEBUG", LOG_LEVEL_DEBUG}, {"INFO", LOG_LEVEL_INFO},
+        {"WARN", LOG_LEVEL_WARNING}, {"WARNING", LOG_LEVEL_WARNING},
+        {"ERROR", LOG_LEVEL_ERROR}, {"FATAL", LOG_LEVEL_FATAL},
+        {"DEFAULT", LOG_LEVEL_INHERIT}
+    };
+    
+    for (size_t i = 0; name && i < ARRAY_SIZE(names); i++) {
+        if (strcasecmp(name, names[i].name) == 0) {
+            *level = names[i].level;
+            return 0;
+        }
+    }
+    
+    return -1;
+}
+
+const char* logger_level_name(int level) {
+    if (level == LOG_LEVEL_INHERIT) return "DEFAULT";
+    if (level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_FATAL) return "?";
+    return level_names[level];
+}
+
+void logger_set_overflow_policy(log_overflow_policy_t policy) {
+    overflow_policy = policy;
+}
+
+void logger_set_console(bool enabled) {
+    __atomic_store_n(&console_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+uint64_t logger_get_dropped_count(void) {
+    return __atomic_load_n(&dropped_count, __ATOMIC_RELAXED);
+}
+
+void logger_set_file_format(log_file_format_t format) {
+    pthread_mutex_lock(&writer_mutex);
+    if (!writer_running) {
+        file_format = format;
+    }
+    pthread_mutex_unlock(&writer_mutex);
 }
\ No newline at end of file
@@ -8,6 +8,25 @@
 
 #include "parking_system.h"
 
+// Nível de módulo que segue o nível global (logger_set_module_level)
+#define LOG_LEVEL_INHERIT (-1)
+
+/**
+ * @brief Comportamento de logger_log com a fila cheia
+ */
+typedef enum {
+    LOG_OVERFLOW_DROP = 0,  // Descarta e conta (padrão); FATAL nunca é descartado
+    LOG_OVERFLOW_BLOCK      // Espera a escritora liberar espaço
+} log_overflow_policy_t;
+
+/**
+ * @brief Formato do arquivo de log
+ */
+typedef enum {
+    LOG_FILE_TEXT = 0,      // parking_system.log, uma linha por mensagem
+    LOG_FILE_BINARY         // parking_system.binlog (ver log_format.h e log_decoder)
+} log_file_format_t;
+
 /**
  * @brief Inicializa o sistema de logging
  * @param log_dir Diretório onde salvar os logs
@@ -22,6 +41,10 @@ void logger_cleanup(void);
 
 /**
  * @brief Registra uma mensagem de log
+ *
+ * Apenas formata a mensagem na fila; a gravação em arquivo e console é feita
+ * pela thread do logger. Mensagens FATAL esperam a gravação (logger_flush).
+ *
  * @param level Nível do log
  * @param module Nome do módulo (ex: "GPIO", "MODBUS")
  * @param format String de formato (como printf)
@@ -30,7 +53,7 @@ void logger_cleanup(void);
 void logger_log(log_level_t level, const char* module, const char* format, ...);
 
 /**
- * @brief Define o nível mínimo de log
+ * @brief Define o nível mínimo de log (global)
  * @param level Nível mínimo
  */
 void logger_set_level(log_level_t level);
@@ -41,4 +64,68 @@ void logger_set_level(log_level_t level);
  */
 log_level_t logger_get_level(void);
 
+/**
+ * @brief Define o nível mínimo de um módulo (ex.: MODBUS=DEBUG, PARKING=WARN)
+ *
+ * Não reativa chamadas abaixo de LOG_COMPILE_LEVEL, que não existem no binário.
+ *
+ * @param module Nome do módulo; "*" ou NULL altera o nível global
+ * @param level log_level_t ou LOG_LEVEL_INHERIT para voltar ao global
+ * @return 0 se sucesso, -1 se nível inválido ou limite de módulos atingido
+ */
+int logger_set_module_level(const char* module, int level);
+
+/**
+ * @brief Obtém o nível efetivo de um módulo
+ * @param module Nome do módulo
+ * @return Nível do módulo, ou o global se ele não tiver nível próprio
+ */
+int logger_get_module_level(const char* module);
+
+/**
+ * @brief Faz todos os módulos voltarem ao nível global
+ */
+void logger_reset_module_levels(void);
+
+/**
+ * @brief Converte o nome de um nível (DEBUG, INFO, WARN, ERROR, FATAL, DEFAULT)
+ * @param name Nome (maiúsculas ou minúsculas)
+ * @param level Saída: log_level_t ou LOG_LEVEL_INHERIT (DEFAULT)
+ * @return 0 se sucesso, -1 se nome desconhecido
+ */
+int logger_parse_level(const char* name, int* level);
+
+/**
+ * @brief Nome de um nível (inverso de logger_parse_level)
+ */
+const char* logger_level_name(int level);
+
+/**
+ * @brief Aguarda a gravação de tudo que foi registrado até agora
+ */
+void logger_flush(void);
+
+/**
+ * @brief Define a política para fila cheia
+ * @param policy LOG_OVERFLOW_DROP ou LOG_OVERFLOW_BLOCK
+ */
+void logger_set_overflow_policy(log_overflow_policy_t policy);
+
+/**
+ * @brief Liga ou desliga a cópia no console (o arquivo não muda)
+ */
+void logger_set_console(bool enabled);
+
+/**
+ * @brief Obtém o número de mensagens descartadas por fila cheia
+ * @return Total desde o início do processo
+ */
+uint64_t logger_get_dropped_count(void);
+
+/**
+ * @brief Define o formato do arquivo (chamar antes de logger_init)
+ * @param format LOG_FILE_TEXT ou LOG_FILE_BINARY (padrão: LOG_BINARY_FILE)
+ */
+void logger_set_file_format(log_file_format_t format);
+
 #endif // SYSTEM_LOGGER_H
\ No newline at end of file
@@ -0,0 +1,195 @@
+/**
+ * @file tariff.c
+ * @brief Tabela de tarifas pré-calculada e cobrança em lote
+ *
+ * Para cada tipo de dia guarda a soma acumulada do preço minuto a minuto;
+ * o custo de um trecho dentro de um dia é a diferença de duas posições.
+ * Uma permanência percorre no máximo um trecho por dia (semanas inteiras
+ * custam uma soma só), com o dia da semana tirado da aritmética sobre o
+ * fuso guardado na tabela, sem localtime por ticket.
+ */
+
+#include "tariff.h"
+#include "system_logger.h"
+#include <pthread.h>
+
+// 01/01/1970 foi uma quinta-feira
+#define EPOCH_WEEKDAY 4
+#define MINUTES_PER_WEEK (7 * TARIFF_MINUTES_PER_DAY)
+
+// =============================================================================
+// TABELA PADRÃO
+// =============================================================================
+
+static const tariff_band_t default_bands[] = {
+    { TARIFF_DAYS_WEEKEND, 0, TARIFF_MINUTES_PER_DAY, TARIFF_WEEKEND_CENTS },
+    { TARIFF_DAYS_ALL, TARIFF_NIGHT_START_MIN, TARIFF_NIGHT_END_MIN, TARIFF_NIGHT_CENTS },
+};
+
+static const tariff_config_t default_config = {
+    .base_cents_per_minute = PRICE_PER_MINUTE_CENTS,
+    .bands = default_bands,
+    .num_bands = (int)(sizeof(default_bands) / sizeof(default_bands[0])),
+    .grace_minutes = TARIFF_GRACE_MINUTES,
+    .daily_cap_cents = TARIFF_DAILY_CAP_CENTS,
+    .stay_cap_cents = TARIFF_STAY_CAP_CENTS,
+};
+
+static tariff_table_t default_table;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static void build_default_table(void) {
+    if (tariff_build(&default_table, &default_config) != 0) {
+        LOG_ERROR("TARIFF", "Tabela padrão inválida - usando preço único");
+        tariff_config_t flat = { .base_cents_per_minute = PRICE_PER_MINUTE_CENTS };
+        tariff_build(&default_table, &flat);
+    }
+}
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+static uint32_t day_cost(const tariff_table_t* table, int day_type, uint32_t from, uint32_t to) {
+    const uint32_t* prefix = table->prefix[day_type];
+    uint32_t cost = prefix[to] - prefix[from];
+    
+    if (table->daily_cap_cents && cost > table->daily_cap_cents) {
+        cost = table->daily_cap_cents;
+    }
+    return cost;
+}
+
+static int32_t local_utc_offset(void) {
+    time_t now = time(NULL);
+    struct tm tm_local;
+    
+    if (!localtime_r(&now, &tm_local)) return 0;
+    return (int32_t)tm_local.tm_gmtoff;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS
+// =============================================================================
+
+int tariff_build(tariff_table_t* table, const tariff_config_t* config) {
+    if (!table || !config || (config->num_bands > 0 && !config->bands)) return -1;
+    
+    uint16_t rates[TARIFF_DAY_TYPE_COUNT][TARIFF_MINUTES_PER_DAY];
+    for (int type = 0; type < TARIFF_DAY_TYPE_COUNT; type++) {
+        for (int m = 0; m < TARIFF_MINUTES_PER_DAY; m++) {
+            rates[type][m] = config->base_cents_per_minute;
+        }
+    }
+    
+    for (int i = 0; i < config->num_bands; i++) {
+        const tariff_band_t* band = &config->bands[i];
+        if (band->start_min >= TARIFF_MINUTES_PER_DAY || band->end_min > TARIFF_MINUTES_PER_DAY ||
+            band->start_min == band->end_min) {
+            LOG_ERROR("TARIFF", "Faixa %d inválida (%u-%u)", i, band->start_min, band->end_min);
+            return -1;
+        }
+    
+        for (int type = 0; type < TARIFF_DAY_TYPE_COUNT; type++) {
+            if (!(band->day_mask & (1u << type))) continue;
+    
+            // Faixa noturna (fim < início): vale nas duas pontas do mesmo dia
+            for (int m = 0; m < TARIFF_MINUTES_PER_DAY; m++) {
+                bool inside = band->start_min < band->end_min
+                    ? (m >= band->start_min && m < band->end_min)
+                    : (m >= band->start_min || m < band->end_min);
+                if (inside) rates[type][m] = band->cents_per_minute;
+            }
+        }
+    }
+    
+    memset(table, 0, sizeof(*table));
+    for (int type = 0; type < TARIFF_DAY_TYPE_COUNT; type++) {
+        for (int m = 0; m < TARIFF_MINUTES_PER_DAY; m++) {
+            table->prefix[type][m + 1] = table->prefix[type][m] + rates[type][m];
+        }
+    }
+    
+    table->day_type[0] = TARIFF_DAY_SUNDAY;
+    for (int wd = 1; wd <= 5; wd++) table->day_type[wd] = TARIFF_DAY_WEEKDAY;
+    table->day_type[6] = TARIFF_DAY_SATURDAY;
+    
+    table->grace_minutes = config->grace_minutes;
+    table->daily_cap_cents = config->daily_cap_cents;
+    table->stay_cap_cents = config->stay_cap_cents;
+    table->utc_offset_s = local_utc_offset();
+    
+    for (int wd = 0; wd < 7; wd++) {
+        table->week_cents += day_cost(table, table->day_type[wd], 0, TARIFF_MINUTES_PER_DAY);
+    }
+    
+    LOG_DEBUG("TARIFF", "Tabela montada: %d faixas, carência %u min, semana %u centavos",
+              config->num_bands, table->grace_minutes, table->week_cents);
+    return 0;
+}
+
+const tariff_table_t* tariff_default(void) {
+    pthread_once(&default_once, build_default_table);
+    return &default_table;
+}
+
+uint32_t tariff_fee(const tariff_table_t* table, time_t entry_time, time_t exit_time) {
+    if (exit_time <= entry_time) return 0;
+    
+    uint64_t minutes = ((uint64_t)(exit_time - entry_time) + 59) / 60;
+    if (minutes <= table->grace_minutes) return 0;
+    
+    int64_t local_min = ((int64_t)entry_time + table->utc_offset_s) / 60;
+    int64_t day = local_min / TARIFF_MINUTES_PER_DAY;
+    uint32_t minute = (uint32_t)(local_min % TARIFF_MINUTES_PER_DAY);
+    uint64_t fee = 0;
+    
+    while (minutes > 0) {
+        if (minute == 0 && minutes >= MINUTES_PER_WEEK) {
+            uint64_t weeks = minutes / MINUTES_PER_WEEK;
+            fee += weeks * table->week_cents;
+            minutes -= weeks * MINUTES_PER_WEEK;
+            day += (int64_t)weeks * 7;
+            continue;
+        }
+    
+        uint32_t span = TARIFF_MINUTES_PER_DAY - minute;
+        if (span > minutes) span = (uint32_t)minutes;
+    
+        int type = table->day_type[(day + EPOCH_WEEKDAY) % 7];
+        fee += day_cost(table, type, minute, minute + span);
+        minutes -= span;
+        minute = 0;
+        day++;
+    }
+    
+    if (table->stay_cap_cents && fee > table->stay_cap_cents) {
+        fee = table->stay_cap_cents;
+    }
+    return fee > UINT32_MAX ? UINT32_MAX : (uint32_t)fee;
+}
+
+uint64_t tariff_fee_batch(const tariff_table_t* table, vehicle_record_t* records, size_t count,
+                          time_t now, tariff_summary_t* summary) {
+    if (!table || !records) return 0;
+    
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        vehicle_record_t* rec = &records[i];
+        time_t exit_time = rec->exit_time ? rec->exit_time : now;
+        uint32_t fee = tariff_fee(table, rec->entry_time, exit_time);
+    
+        rec->amount_cents = fee;
+        total += fee;
+    
+        if (summary) {
+            summary->tickets++;
+            if (fee == 0) summary->free_tickets++;
+            if (fee > summary->max_cents) summary->max_cents = fee;
+            if ((unsigned)rec->floor < MAX_FLOORS) summary->floor_cents[rec->floor] += fee;
+        }
+    }
+    
+    if (summary) summary->total_cents += total;
+    return total;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file tariff.h
+ * @brief Tarifação por faixas de horário e tipo de dia, com tetos e carência
+ */
+
+#ifndef TARIFF_H
+#define TARIFF_H
+
+#include "parking_system.h"
+
+#define TARIFF_MINUTES_PER_DAY 1440
+
+/**
+ * @brief Tipo de dia (feriados não são distinguidos)
+ */
+typedef enum {
+    TARIFF_DAY_WEEKDAY = 0,         // Segunda a sexta
+    TARIFF_DAY_SATURDAY,
+    TARIFF_DAY_SUNDAY,
+    TARIFF_DAY_TYPE_COUNT
+} tariff_day_type_t;
+
+#define TARIFF_DAYS_WEEKDAY  (1u << TARIFF_DAY_WEEKDAY)
+#define TARIFF_DAYS_WEEKEND  ((1u << TARIFF_DAY_SATURDAY) | (1u << TARIFF_DAY_SUNDAY))
+#define TARIFF_DAYS_ALL      ((1u << TARIFF_DAY_TYPE_COUNT) - 1)
+
+/**
+ * @brief Faixa de preço; faixas posteriores sobrescrevem as anteriores
+ */
+typedef struct {
+    uint8_t day_mask;               // Bits de tariff_day_type_t
+    uint16_t start_min;             // Minuto do dia (hora local) em que começa
+    uint16_t end_min;               // Minuto em que termina; < start_min atravessa a meia-noite
+    uint16_t cents_per_minute;
+} tariff_band_t;
+
+/**
+ * @brief Regras de uma tabela de tarifas
+ */
+typedef struct {
+    uint16_t base_cents_per_minute; // Preço fora de qualquer faixa
+    const tariff_band_t* bands;
+    int num_bands;
+    uint16_t grace_minutes;         // Permanência até este tempo não é cobrada
+    uint32_t daily_cap_cents;       // Teto por dia do calendário (0 = sem teto)
+    uint32_t stay_cap_cents;        // Teto da permanência inteira (0 = sem teto)
+} tariff_config_t;
+
+/**
+ * @brief Tabela pré-calculada: custo de um intervalo = duas consultas
+ */
+typedef struct {
+    // prefix[tipo][m] = custo acumulado dos minutos [0, m) do dia
+    uint32_t prefix[TARIFF_DAY_TYPE_COUNT][TARIFF_MINUTES_PER_DAY + 1];
+    uint8_t day_type[7];            // Dia da semana (0 = domingo) -> tipo
+    uint32_t week_cents;            // Semana completa, já com os tetos diários
+    int32_t utc_offset_s;           // Fuso local na montagem da tabela
+    uint16_t grace_minutes;
+    uint32_t daily_cap_cents;
+    uint32_t stay_cap_cents;
+} tariff_table_t;
+
+/**
+ * @brief Resumo acumulado de um lote (pode somar vários lotes)
+ */
+typedef struct {
+    uint32_t tickets;
+    uint32_t free_tickets;          // Dentro da carência
+    uint64_t total_cents;
+    uint32_t max_cents;
+    uint64_t floor_cents[MAX_FLOORS];
+} tariff_summary_t;
+
+/**
+ * @brief Monta uma tabela a partir das regras
+ * @param table Tabela de saída
+ * @param config Regras
+ * @return 0 se sucesso, -1 se alguma faixa for inválida
+ */
+int tariff_build(tariff_table_t* table, const tariff_config_t* config);
+
+/**
+ * @brief Tabela padrão do system_config.h (montada no primeiro uso)
+ */
+const tariff_table_t* tariff_default(void);
+
+/**
+ * @brief Tarifa de uma permanência, por minuto iniciado
+ * @param table Tabela
+ * @param entry_time Entrada
+ * @param exit_time Saída
+ * @return Valor em centavos (0 se exit_time <= entry_time)
+ */
+uint32_t tariff_fee(const tariff_table_t* table, time_t entry_time, time_t exit_time);
+
+/**
+ * @brief Calcula a tarifa de um lote de registros, sem log por registro
+ *
+ * Preenche amount_cents de cada registro; registros sem saída (exit_time 0)
+ * são cobrados até now. Serve para fechamento do dia e relatórios.
+ *
+ * @param table Tabela
+ * @param records Registros
+ * @param count Quantidade
+ * @param now Saída assumida para tickets em aberto
+ * @param summary Acumulador (pode ser NULL); não é zerado aqui
+ * @return Soma do lote em centavos
+ */
+uint64_t tariff_fee_batch(const tariff_table_t* table, vehicle_record_t* records, size_t count,
+                          time_t now, tariff_summary_t* summary);
+
+#endif // TARIFF_H
@@ -11,16 +11,21 @@
 
 #include "tcp_communication.h"
 #include "system_logger.h"
+#include "message_pool.h"
+#include "metrics.h"
 #include <event2/event.h>
 #include <event2/bufferevent.h>
 #include <event2/buffer.h>
 #include <event2/listener.h>
 #include <event2/util.h>
+#include <event2/thread.h>
 #include <arpa/inet.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
 #include <stdio.h>
+#include <poll.h>
+#include <fcntl.h>
 
 // =============================================================================
 // DEFINIÇÕES GLOBAIS
@@ -32,8 +37,16 @@ static struct event_base *base = NULL;
 // Listener para conexões de entrada
 static struct evconnlistener *listener = NULL;
 
-// Array de conexões ativas
-static tcp_connection_t active_connections[MAX_CONNECTIONS];
+#if MAX_CONNECTIONS > 0xFFFF
+#error "MAX_CONNECTIONS não cabe nos 16 bits de slot do tcp_connection_id_t"
+#endif
+
+// Pool de conexões: os slots nunca se movem, então o ponteiro guardado como
+// contexto do bufferevent continua válido até a conexão ser removida
+static tcp_connection_t connection_pool[MAX_CONNECTIONS];
+static uint16_t slot_generation[MAX_CONNECTIONS];
+static int free_slots[MAX_CONNECTIONS];
+static int free_count = 0;
 static int connection_count = 0;
 
 // Estado de inicialização
@@ -42,29 +55,109 @@ static bool tcp_initialized = false;
 // Callbacks do usuário
 static tcp_message_callback_t message_callback = NULL;
 static tcp_connection_callback_t connection_callback = NULL;
+static tcp_scrape_callback_t scrape_callback = NULL;
 
 // Mutex para thread safety
 static pthread_mutex_t tcp_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Mensagens para todas as conexões, enfileiradas por outras threads e
+// enviadas pelo loop (bufferevents não são thread-safe); cada uma ocupa um
+// slot de message_pool até ser enviada
+#define TCP_BROADCAST_QUEUE_SIZE 8
+
+static system_message_t *broadcast_queue[TCP_BROADCAST_QUEUE_SIZE];
+static int broadcast_count = 0;
+static struct event *broadcast_event = NULL;
+
+static void broadcast_callback(evutil_socket_t fd, short events, void *arg);
+
+// Enlaces em memória com andares do mesmo processo (ver ENLACES EM MEMÓRIA)
+#define TCP_LOCAL_SOCKET_BASE 0x40000000
+
+#if (TCP_LOCAL_QUEUE_SIZE & (TCP_LOCAL_QUEUE_SIZE - 1)) != 0 || \
+    (TCP_LOCAL_INBOX_SIZE & (TCP_LOCAL_INBOX_SIZE - 1)) != 0
+#error "TCP_LOCAL_QUEUE_SIZE e TCP_LOCAL_INBOX_SIZE devem ser potências de 2"
+#endif
+
+// A mensagem vai inteira em tcp_message_t.data
+typedef char tcp_local_message_fits[(sizeof(system_message_t) <= TCP_MAX_PAYLOAD_SIZE) ? 1 : -1];
+
+typedef struct {
+    bool in_use;
+    bool open_requested;                // Aguardando a thread do loop abrir a conexão
+    bool close_requested;               // Andar fechou; a thread do loop libera o enlace
+    bool closed;                        // Nada mais é entregue (central desconectou)
+    tcp_connection_t *conn;             // Lado da central (só muda na thread do loop)
+    system_message_t *inbox[TCP_LOCAL_INBOX_SIZE];  // Central -> andar
+    uint32_t head;
+    uint32_t tail;
+    struct timespec last_send;          // Último envio do andar (tcp_idle_ms)
+    pthread_cond_t cond;                // CLOCK_MONOTONIC
+} tcp_local_link_t;
+
+typedef struct {
+    int link;
+    system_message_t *msg;
+} tcp_local_entry_t;
+
+static tcp_local_link_t local_links[MAX_CLIENTS];
+static tcp_local_entry_t local_outbox[TCP_LOCAL_QUEUE_SIZE];  // Andares -> loop
+static uint32_t outbox_head = 0;
+static uint32_t outbox_tail = 0;
+static int local_listen_port = 0;       // Porta do listener deste processo (0 = nenhum)
+static struct event *local_event = NULL;
+static bool local_links_initialized = false;
+static pthread_mutex_t local_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void local_callback(evutil_socket_t fd, short events, void *arg);
+
+// Formato usado pelos clientes de socket (tcp_send_message)
+static tcp_wire_format_t client_wire_format = TCP_TEXT_PROTOCOL ? TCP_WIRE_TEXT : TCP_WIRE_BINARY;
+
+// Lote de envio de um socket cliente
+typedef struct {
+    int socket;                         // -1 = slot livre
+    uint8_t buffers[2][TCP_BATCH_MAX_BYTES];
+    uint8_t *data;                      // Lote pendente (recebe as mensagens)
+    uint8_t *out;                       // Lote em envio, escrito fora da trava
+    size_t length;
+    bool sending;                       // Um escritor está enviando out
+    bool flush_requested;               // Pendente deve sair assim que out terminar
+    struct timespec deadline;           // Quando o lote atual deve sair
+    struct timespec last_send;          // Último envio aceito (tcp_idle_ms)
+    bool failed;                        // Falha adiada, reportada no próximo envio
+} tcp_batch_t;
+
+static tcp_batch_t batches[MAX_CLIENTS];
+static bool batches_initialized = false;
+static int batch_count = 0;
+static pthread_mutex_t batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t batch_cond;
+static pthread_cond_t batch_idle_cond;  // Algum lote terminou de enviar
+static pthread_t batch_thread;
+static bool batch_thread_running = false;
+static bool batch_thread_stopping = false;  // Encerrada, aguardando pthread_join
+static pthread_cond_t batch_joined_cond;    // batch_thread_stopping voltou a false
+
+// Qualquer mensagem serializada cabe num lote vazio
+typedef char tcp_batch_fits_message[(TCP_MAX_LINE_SIZE <= TCP_BATCH_MAX_BYTES &&
+                                     TCP_MAX_FRAME_SIZE <= TCP_BATCH_MAX_BYTES) ? 1 : -1];
+
 // =============================================================================
 // FUNÇÕES PRIVADAS
 // =============================================================================
 
 /**
- * @brief Encontra uma conexão pelo bufferevent
- * @param bev BufferEvent
- * @return Ponteiro para conexão ou NULL se não encontrada
+ * @brief Recoloca todos os slots do pool na lista livre
  */
-static tcp_connection_t* find_connection_by_bev(struct bufferevent *bev) {
-    pthread_mutex_lock(&tcp_mutex);
-    for (int i = 0; i < connection_count; i++) {
-        if (active_connections[i].bev == bev) {
-            pthread_mutex_unlock(&tcp_mutex);
-            return &active_connections[i];
-        }
+static void reset_connection_pool(void) {
+    memset(connection_pool, 0, sizeof(connection_pool));
+    free_count = 0;
+    // Empilhados em ordem inversa para que o slot 0 seja usado primeiro
+    for (int i = MAX_CONNECTIONS - 1; i >= 0; i--) {
+        free_slots[free_count++] = i;
     }
-    pthread_mutex_unlock(&tcp_mutex);
-    return NULL;
+    connection_count = 0;
 }
 
 /**
@@ -73,28 +166,37 @@ static tcp_connection_t* find_connection_by_bev(struct bufferevent *bev) {
  * @param address Endereço IP
  * @param port Porta
  * @param is_outgoing true se conexão sainte, false se entrada
- * @return Ponteiro para conexão ou NULL se erro
+ * @return Ponteiro estável para a conexão ou NULL se o pool estiver cheio
  */
 static tcp_connection_t* add_connection(struct bufferevent *bev, const char *address, 
                                       int port, bool is_outgoing) {
     pthread_mutex_lock(&tcp_mutex);
     
-    if (connection_count >= MAX_CONNECTIONS) {
+    if (free_count == 0) {
         LOG_ERROR("TCP", "Máximo de conexões atingido");
         pthread_mutex_unlock(&tcp_mutex);
         return NULL;
     }
     
-    tcp_connection_t *conn = &active_connections[connection_count++];
+    int slot = free_slots[--free_count];
+    // Geração 0 é evitada para que nenhum id válido seja igual a TCP_CONNECTION_ID_INVALID
+    if (++slot_generation[slot] == 0) {
+        slot_generation[slot] = 1;
+    }
+    
+    tcp_connection_t *conn = &connection_pool[slot];
+    memset(conn, 0, sizeof(*conn));
     conn->bev = bev;
+    conn->id = ((tcp_connection_id_t)slot_generation[slot] << 16) | (tcp_connection_id_t)slot;
+    conn->in_use = true;
     strncpy(conn->address, address, sizeof(conn->address) - 1);
     conn->address[sizeof(conn->address) - 1] = '\0';
     conn->port = port;
     conn->is_outgoing = is_outgoing;
+    conn->wire_format = TCP_WIRE_UNKNOWN;
     conn->connected_time = time(NULL);
     conn->last_activity = conn->connected_time;
-    conn->bytes_sent = 0;
-    conn->bytes_received = 0;
+    connection_count++;
     
     pthread_mutex_unlock(&tcp_mutex);
     
@@ -108,478 +210,2739 @@ static tcp_connection_t* add_connection(struct bufferevent *bev, const char *add
 }
 
 /**
- * @brief Remove uma conexão
- * @param bev BufferEvent
+ * @brief Remove uma conexão e devolve seu slot ao pool
+ * @param conn Conexão (contexto do bufferevent)
  */
-static void remove_connection(struct bufferevent *bev) {
+static void remove_connection(tcp_connection_t *conn) {
     pthread_mutex_lock(&tcp_mutex);
     
-    for (int i = 0; i < connection_count; i++) {
-        if (active_connections[i].bev == bev) {
-            tcp_connection_t *conn = &active_connections[i];
-            
-            if (connection_callback) {
-                connection_callback(conn, TCP_EVENT_DISCONNECTED);
-            }
-            
-            LOG_INFO("TCP", "Conexão removida: %s:%d", conn->address, conn->port);
-            
-            // Move última conexão para posição removida
-            if (i < connection_count - 1) {
-                active_connections[i] = active_connections[connection_count - 1];
-            }
-            connection_count--;
-            break;
-        }
+    if (!conn->in_use) {
+        pthread_mutex_unlock(&tcp_mutex);
+        return;
+    }
+    
+    if (connection_callback) {
+        connection_callback(conn, TCP_EVENT_DISCONNECTED);
     }
     
+    LOG_INFO("TCP", "Conexão removida: %s:%d", conn->address, conn->port);
+    
+    conn->in_use = false;
+    conn->bev = NULL;
+    free_slots[free_count++] = (int)(conn - connection_pool);
+    connection_count--;
+    
     pthread_mutex_unlock(&tcp_mutex);
 }
 
 /**
- * @brief Processa uma mensagem simples recebida (formato key=value)
- * @param conn Conexão
- * @param message_str String da mensagem
+ * @brief Converte tipo de mensagem TCP para string do protocolo
  */
-static void process_simple_message(tcp_connection_t *conn, const char *message_str) {
-    // Parsear mensagem simples no formato: type=parking_status,data=terreo:5,andar1:3
+static const char* tcp_type_to_string(tcp_message_type_t type) {
+    switch (type) {
+        case TCP_MSG_PARKING_STATUS: return "parking_status";
+        case TCP_MSG_VEHICLE_ENTRY: return "vehicle_entry";
+        case TCP_MSG_VEHICLE_EXIT: return "vehicle_exit";
+        case TCP_MSG_SYSTEM_STATUS: return "system_status";
+        case TCP_MSG_EMERGENCY: return "emergency";
+        case TCP_MSG_PASSAGE: return "passage";
+        case TCP_MSG_SPOT_DELTA: return "spot_delta";
+        case TCP_MSG_LOG_LEVEL: return "log_level";
+        case TCP_MSG_METRICS: return "metrics";
+        case TCP_MSG_VEHICLE_DETECTED: return "vehicle_detected";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Converte string do protocolo para tipo de mensagem TCP
+ * @return 0 se sucesso, -1 se tipo desconhecido
+ */
+static int tcp_type_from_string(const char *type_str, tcp_message_type_t *type) {
+    if (strcmp(type_str, "parking_status") == 0) {
+        *type = TCP_MSG_PARKING_STATUS;
+    } else if (strcmp(type_str, "vehicle_entry") == 0) {
+        *type = TCP_MSG_VEHICLE_ENTRY;
+    } else if (strcmp(type_str, "vehicle_exit") == 0) {
+        *type = TCP_MSG_VEHICLE_EXIT;
+    } else if (strcmp(type_str, "system_status") == 0) {
+        *type = TCP_MSG_SYSTEM_STATUS;
+    } else if (strcmp(type_str, "emergency") == 0) {
+        *type = TCP_MSG_EMERGENCY;
+    } else if (strcmp(type_str, "passage") == 0) {
+        *type = TCP_MSG_PASSAGE;
+    } else if (strcmp(type_str, "spot_delta") == 0) {
+        *type = TCP_MSG_SPOT_DELTA;
+    } else if (strcmp(type_str, "log_level") == 0) {
+        *type = TCP_MSG_LOG_LEVEL;
+    } else if (strcmp(type_str, "metrics") == 0) {
+        *type = TCP_MSG_METRICS;
+    } else if (strcmp(type_str, "vehicle_detected") == 0) {
+        *type = TCP_MSG_VEHICLE_DETECTED;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Parseia uma linha no formato type=xxx,timestamp=zzz,source=www,data=yyy
+ * @param message_str Linha recebida (sem '\n')
+ * @param message Estrutura de saída
+ * @return 0 se sucesso, -1 se tipo desconhecido
+ */
+static int parse_simple_message(const char *message_str, tcp_message_t *message) {
     char type_str[64] = {0};
-    char data_str[256] = {0};
     
     // Extrair tipo
     const char *type_start = strstr(message_str, "type=");
     if (type_start) {
         type_start += 5; // pula "type="
         const char *type_end = strchr(type_start, ',');
-        int type_len = type_end ? (type_end - type_start) : strlen(type_start);
+        size_t type_len = type_end ? (size_t)(type_end - type_start) : strlen(type_start);
         if (type_len < sizeof(type_str)) {
             strncpy(type_str, type_start, type_len);
         }
     }
     
-    // Extrair dados
+    if (tcp_type_from_string(type_str, &message->type) != 0) {
+        LOG_WARN("TCP", "Tipo de mensagem desconhecido: %s", type_str);
+        return -1;
+    }
+    message->format = TCP_WIRE_TEXT;
+    message->msg_type = 0;
+    
+    // Timestamp do emissor (usa horário local se ausente)
+    const char *ts_start = strstr(message_str, "timestamp=");
+    message->timestamp = ts_start ? (time_t)strtol(ts_start + 10, NULL, 10) : time(NULL);
+    message->source[0] = '\0';
+    
+    // Extrair dados (sempre o último campo da linha)
+    message->data[0] = '\0';
     const char *data_start = strstr(message_str, "data=");
     if (data_start) {
         data_start += 5; // pula "data="
-        strncpy(data_str, data_start, sizeof(data_str) - 1);
+        strncpy(message->data, data_start, sizeof(message->data) - 1);
+        message->data[sizeof(message->data) - 1] = '\0';
     }
+    message->data_size = strlen(message->data);
     
-    // Determinar tipo de mensagem
-    tcp_message_type_t msg_type;
-    if (strcmp(type_str, "parking_status") == 0) {
-        msg_type = TCP_MSG_PARKING_STATUS;
-    } else if (strcmp(type_str, "vehicle_entry") == 0) {
-        msg_type = TCP_MSG_VEHICLE_ENTRY;
-    } else if (strcmp(type_str, "vehicle_exit") == 0) {
-        msg_type = TCP_MSG_VEHICLE_EXIT;
-    } else if (strcmp(type_str, "system_status") == 0) {
-        msg_type = TCP_MSG_SYSTEM_STATUS;
-    } else if (strcmp(type_str, "emergency") == 0) {
-        msg_type = TCP_MSG_EMERGENCY;
-    } else {
-        LOG_WARN("TCP", "Tipo de mensagem desconhecido: %s", type_str);
+    return 0;
+}
+
+/**
+ * @brief Processa uma mensagem simples recebida (formato key=value)
+ * @param conn Conexão
+ * @param message_str String da mensagem
+ */
+static void process_simple_message(tcp_connection_t *conn, const char *message_str) {
+    tcp_message_t message;
+    if (parse_simple_message(message_str, &message) != 0) {
         return;
     }
     
-    // Criar estrutura de mensagem
-    tcp_message_t message;
-    message.type = msg_type;
-    message.timestamp = time(NULL);
     strncpy(message.source, conn->address, sizeof(message.source) - 1);
     message.source[sizeof(message.source) - 1] = '\0';
     
-    // Copiar dados
-    strncpy(message.data, data_str, sizeof(message.data) - 1);
-    message.data[sizeof(message.data) - 1] = '\0';
-    message.data_size = strlen(message.data);
-    
     // Chamar callback do usuário se definido
     if (message_callback) {
         message_callback(&message, conn);
     }
 }
 
+// =============================================================================
+// PROTOCOLO BINÁRIO
+// =============================================================================
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (v >> 8) & 0xFF;
+    p[1] = v & 0xFF;
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (v >> 24) & 0xFF;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
 /**
- * @brief Callback chamado quando dados são recebidos
- * @param bev BufferEvent
- * @param user_data Dados do usuário (não usado)
+ * @brief Copia uma placa para campo fixo de 8 bytes (preenchido com zeros)
  */
-static void read_callback(struct bufferevent *bev, void *user_data) {
-    (void)user_data; // Suprimir warning de parâmetro não usado
-    
-    tcp_connection_t *conn = find_connection_by_bev(bev);
-    if (!conn) {
-        LOG_ERROR("TCP", "Conexão não encontrada para bufferevent");
-        return;
-    }
-    
-    struct evbuffer *input = bufferevent_get_input(bev);
-    size_t len = evbuffer_get_length(input);
-    
-    if (len == 0) return;
-    
-    // Ler dados
-    char *data = malloc(len + 1);
-    if (!data) {
-        LOG_ERROR("TCP", "Erro ao alocar memória para dados recebidos");
-        return;
-    }
-    
-    evbuffer_copyout(input, data, len);
-    data[len] = '\0';
-    
-    // Atualizar estatísticas da conexão
-    conn->last_activity = time(NULL);
-    conn->bytes_received += len;
-    
-    // Processar mensagens (assumindo uma mensagem por linha)
-    char *line_start = data;
-    char *line_end;
-    
-    while ((line_end = strchr(line_start, '\n')) != NULL) {
-        *line_end = '\0';
+static void put_plate(uint8_t *p, const char *plate) {
+    size_t len = strnlen(plate, 8);
+    memcpy(p, plate, len);
+    memset(p + len, 0, 8 - len);
+}
+
+static void get_plate(char *plate, const uint8_t *p) {
+    memcpy(plate, p, 8);
+    plate[8] = '\0';
+}
+
+/**
+ * @brief Serializa os campos de uma mensagem do sistema em payload binário
+ * @param msg Mensagem do sistema
+ * @param out Buffer de pelo menos TCP_MAX_PAYLOAD_SIZE bytes
+ * @return Tamanho do payload ou -1 se tipo não suportado
+ */
+static int encode_binary_payload(const system_message_t *msg, uint8_t *out) {
+    switch (msg->type) {
+        case MSG_TYPE_PARKING_STATUS: {
+            // Bitmap de ocupação: vaga i no bit (i % 8) do byte i / 8
+            uint16_t num_spots = MIN(msg->data.parking_status.num_spots, MAX_PARKING_SPOTS_PER_FLOOR);
+            size_t mask_bytes = (num_spots + 7u) / 8u;
+            out[0] = (uint8_t)msg->data.parking_status.floor;
+            put_u16(out + 1, msg->data.parking_status.free_pne);
+            put_u16(out + 3, msg->data.parking_status.free_idoso);
+            put_u16(out + 5, msg->data.parking_status.free_comum);
+            put_u16(out + 7, msg->data.parking_status.cars);
+            out[9] = msg->data.parking_status.lotado ? 0x01 : 0;
+            put_u32(out + 10, msg->data.parking_status.seq);
+            put_u16(out + 14, num_spots);
+            for (size_t i = 0; i < mask_bytes; i++) {
+                out[16 + i] = (uint8_t)(msg->data.parking_status.occupied.words[i / 8] >> (8 * (i % 8)));
+            }
+            return (int)(16 + mask_bytes);
+        }
+        
+        case MSG_TYPE_SPOT_DELTA: {
+            uint16_t count = MIN(msg->data.spot_delta.count, SPOT_DELTA_MAX_ENTRIES);
+            out[0] = (uint8_t)msg->data.spot_delta.floor;
+            put_u32(out + 1, msg->data.spot_delta.seq);
+            put_u16(out + 5, count);
+            for (uint16_t i = 0; i < count; i++) {
+                put_u16(out + 7 + 2 * i, msg->data.spot_delta.spots[i]);
+            }
+            return 7 + 2 * count;
+        }
+        
+        case MSG_TYPE_ENTRY_OK:
+        case MSG_TYPE_EXIT_OK:
+        case MSG_TYPE_VEHICLE_DETECTED:
+            put_plate(out, msg->data.vehicle_event.plate);
+            out[8] = (uint8_t)msg->data.vehicle_event.confidence;
+            out[9] = (uint8_t)msg->data.vehicle_event.floor;
+            out[10] = (msg->data.vehicle_event.is_exit ? 0x01 : 0) |
+                      (msg->data.vehicle_event.accepted ? 0x02 : 0);
+            put_u32(out + 11, msg->data.vehicle_event.ticket_id);
+            put_u32(out + 15, msg->data.vehicle_event.amount_cents);
+            return 19;
+            
+        case MSG_TYPE_PASSAGE_DETECTED:
+            out[0] = (uint8_t)msg->data.passage.from_floor;
+            out[1] = (uint8_t)msg->data.passage.to_floor;
+            put_plate(out + 2, msg->data.passage.plate);
+            return 10;
+            
+        case MSG_TYPE_GATE_COMMAND:
+            out[0] = msg->data.gate_command.open_gate;
+            out[1] = msg->data.gate_command.is_entry;
+            return 2;
+            
+        case MSG_TYPE_SYSTEM_STATUS:
+            return 0;
+            
+        case MSG_TYPE_ERROR: {
+            const char *text = message_text_get(msg->data.error_info.text);
+            size_t desc_len = strnlen(text, TCP_MAX_PAYLOAD_SIZE - 4);
+            put_u32(out, (uint32_t)msg->data.error_info.error_code);
+            memcpy(out + 4, text, desc_len);
+            return (int)(4 + desc_len);
+        }
         
-        if (strlen(line_start) > 0) {
-            LOG_DEBUG("TCP", "Mensagem recebida de %s:%d: %s", conn->address, conn->port, line_start);
-            process_simple_message(conn, line_start);
+        case MSG_TYPE_LOG_LEVEL: {
+            size_t module_len = strnlen(msg->data.log_level.module, LOG_MODULE_MAX - 1);
+            out[0] = (uint8_t)msg->data.log_level.level;
+            memcpy(out + 1, msg->data.log_level.module, module_len);
+            return (int)(1 + module_len);
         }
         
-        line_start = line_end + 1;
+        case MSG_TYPE_METRICS: {
+            // Histogramas (contagem, p50, p99, máx.) e depois medidores (valor, máx.)
+            const metrics_report_t *report = message_metrics_get(msg->data.metrics.report);
+            if (!report) return -1;
+            uint8_t *p = out + 1;
+            out[0] = (uint8_t)msg->data.metrics.floor;
+            for (int i = 0; i < METRICS_MSG_HISTS; i++, p += 16) {
+                const metrics_summary_t *h = &report->hist[i];
+                put_u32(p, h->count);
+                put_u32(p + 4, h->p50);
+                put_u32(p + 8, h->p99);
+                put_u32(p + 12, h->max);
+            }
+            for (int i = 0; i < METRICS_MSG_GAUGES; i++, p += 8) {
+                put_u32(p, report->gauge[i].value);
+                put_u32(p + 4, report->gauge[i].max);
+            }
+            return (int)(p - out);
+        }
     }
     
-    // Remover dados processados
-    evbuffer_drain(input, len);
-    free(data);
+    return -1;
 }
 
 /**
- * @brief Callback chamado quando ocorre um evento na conexão
- * @param bev BufferEvent
- * @param events Eventos
- * @param user_data Dados do usuário (não usado)
+ * @brief Reconstrói uma mensagem do sistema a partir do payload binário
+ * @return 0 se sucesso, -1 se tipo desconhecido ou payload curto
  */
-static void event_callback(struct bufferevent *bev, short events, void *user_data) {
-    (void)user_data; // Suprimir warning
-    
-    tcp_connection_t *conn = find_connection_by_bev(bev);
-    
-    if (events & BEV_EVENT_CONNECTED) {
-        LOG_INFO("TCP", "Conexão estabelecida");
-        return;
-    }
+static int decode_binary_payload(message_type_t type, const uint8_t *p, size_t len,
+                                 system_message_t *msg) {
+    msg->type = type;
     
-    if (events & (BEV_EVENT_ERROR | BEV_EVENT_EOF)) {
-        if (events & BEV_EVENT_ERROR) {
-            int err = EVUTIL_SOCKET_ERROR();
-            LOG_ERROR("TCP", "Erro na conexão: %s", evutil_socket_error_to_string(err));
-        } else {
-            LOG_INFO("TCP", "Conexão fechada pelo peer");
+    switch (type) {
+        case MSG_TYPE_PARKING_STATUS: {
+            if (len < 16 || p[0] >= MAX_FLOORS) return -1;
+            uint16_t num_spots = get_u16(p + 14);
+            size_t mask_bytes = (num_spots + 7u) / 8u;
+            if (num_spots > MAX_PARKING_SPOTS_PER_FLOOR || len < 16 + mask_bytes) return -1;
+            
+            msg->data.parking_status.floor = (floor_id_t)p[0];
+            msg->data.parking_status.free_pne = get_u16(p + 1);
+            msg->data.parking_status.free_idoso = get_u16(p + 3);
+            msg->data.parking_status.free_comum = get_u16(p + 5);
+            msg->data.parking_status.cars = get_u16(p + 7);
+            msg->data.parking_status.lotado = (p[9] & 0x01) != 0;
+            msg->data.parking_status.seq = get_u32(p + 10);
+            msg->data.parking_status.num_spots = num_spots;
+            for (size_t i = 0; i < mask_bytes; i++) {
+                msg->data.parking_status.occupied.words[i / 8] |= (uint64_t)p[16 + i] << (8 * (i % 8));
+            }
+            return 0;
         }
         
-        remove_connection(bev);
-        bufferevent_free(bev);
+        case MSG_TYPE_SPOT_DELTA: {
+            if (len < 7 || p[0] >= MAX_FLOORS) return -1;
+            uint16_t count = get_u16(p + 5);
+            if (count > SPOT_DELTA_MAX_ENTRIES || len < 7 + 2 * (size_t)count) return -1;
+            
+            msg->data.spot_delta.floor = (floor_id_t)p[0];
+            msg->data.spot_delta.seq = get_u32(p + 1);
+            msg->data.spot_delta.count = count;
+            for (uint16_t i = 0; i < count; i++) {
+                msg->data.spot_delta.spots[i] = get_u16(p + 7 + 2 * i);
+            }
+            return 0;
+        }
+        
+        case MSG_TYPE_ENTRY_OK:
+        case MSG_TYPE_EXIT_OK:
+        case MSG_TYPE_VEHICLE_DETECTED:
+            if (len < 19) return -1;
+            get_plate(msg->data.vehicle_event.plate, p);
+            msg->data.vehicle_event.confidence = p[8];
+            msg->data.vehicle_event.floor = (floor_id_t)p[9];
+            msg->data.vehicle_event.is_exit = (p[10] & 0x01) != 0;
+            msg->data.vehicle_event.accepted = (p[10] & 0x02) != 0;
+            msg->data.vehicle_event.ticket_id = get_u32(p + 11);
+            msg->data.vehicle_event.amount_cents = get_u32(p + 15);
+            return 0;
+            
+        case MSG_TYPE_PASSAGE_DETECTED:
+            if (len < 10) return -1;
+            msg->data.passage.from_floor = (floor_id_t)p[0];
+            msg->data.passage.to_floor = (floor_id_t)p[1];
+            get_plate(msg->data.passage.plate, p + 2);
+            return 0;
+            
+        case MSG_TYPE_GATE_COMMAND:
+            if (len < 2) return -1;
+            msg->data.gate_command.open_gate = p[0] != 0;
+            msg->data.gate_command.is_entry = p[1] != 0;
+            return 0;
+            
+        case MSG_TYPE_SYSTEM_STATUS:
+            return 0;
+            
+        case MSG_TYPE_ERROR: {
+            if (len < 4) return -1;
+            msg->data.error_info.error_code = (int)get_u32(p);
+            msg->data.error_info.text = (len > 4) ? message_text_put((const char*)p + 4, len - 4)
+                                                  : MESSAGE_TEXT_NONE;
+            return 0;
+        }
+        
+        case MSG_TYPE_LOG_LEVEL: {
+            if (len < 2) return -1;
+            size_t module_len = MIN(len - 1, (size_t)LOG_MODULE_MAX - 1);
+            msg->data.log_level.level = (int8_t)p[0];
+            memcpy(msg->data.log_level.module, p + 1, module_len);
+            msg->data.log_level.module[module_len] = '\0';
+            return 0;
+        }
+        
+        case MSG_TYPE_METRICS: {
+            if (len < 1 + 16 * METRICS_MSG_HISTS + 8 * METRICS_MSG_GAUGES || p[0] >= MAX_FLOORS) return -1;
+            metrics_report_t report;
+            msg->data.metrics.floor = (floor_id_t)p[0];
+            p++;
+            for (int i = 0; i < METRICS_MSG_HISTS; i++, p += 16) {
+                metrics_summary_t *h = &report.hist[i];
+                h->count = get_u32(p);
+                h->p50 = get_u32(p + 4);
+                h->p99 = get_u32(p + 8);
+                h->max = get_u32(p + 12);
+            }
+            for (int i = 0; i < METRICS_MSG_GAUGES; i++, p += 8) {
+                report.gauge[i].value = get_u32(p);
+                report.gauge[i].max = get_u32(p + 4);
+            }
+            msg->data.metrics.report = message_metrics_put(&report);
+            return 0;
+        }
     }
+    
+    return -1;
 }
 
 /**
- * @brief Callback chamado quando nova conexão é aceita
- * @param listener Listener
- * @param fd File descriptor da nova conexão
- * @param address Endereço do cliente
- * @param socklen Tamanho do endereço
- * @param user_data Dados do usuário (não usado)
+ * @brief Mapeia o tipo nativo para o tipo TCP equivalente
+ * @return 0 se sucesso, -1 se tipo sem equivalente
  */
-static void accept_callback(struct evconnlistener *listener, evutil_socket_t fd,
-                          struct sockaddr *address, int socklen, void *user_data) {
-    (void)listener;    // Suprimir warning
-    (void)socklen;     // Suprimir warning
-    (void)user_data;   // Suprimir warning
-    
-    struct sockaddr_in *sin = (struct sockaddr_in*)address;
-    char addr_str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &sin->sin_addr, addr_str, INET_ADDRSTRLEN);
-    int port = ntohs(sin->sin_port);
-    
-    LOG_INFO("TCP", "Nova conexão aceita de %s:%d", addr_str, port);
-    
-    // Criar bufferevent para nova conexão
-    struct bufferevent *bev = bufferevent_socket_new(base, fd, BEV_OPT_CLOSE_ON_FREE);
-    if (!bev) {
-        LOG_ERROR("TCP", "Erro ao criar bufferevent");
-        close(fd);
-        return;
+static int tcp_type_from_system(message_type_t type, tcp_message_type_t *tcp_type) {
+    switch (type) {
+        case MSG_TYPE_PARKING_STATUS: *tcp_type = TCP_MSG_PARKING_STATUS; return 0;
+        case MSG_TYPE_ENTRY_OK: *tcp_type = TCP_MSG_VEHICLE_ENTRY; return 0;
+        case MSG_TYPE_VEHICLE_DETECTED: *tcp_type = TCP_MSG_VEHICLE_DETECTED; return 0;
+        case MSG_TYPE_EXIT_OK: *tcp_type = TCP_MSG_VEHICLE_EXIT; return 0;
+        case MSG_TYPE_PASSAGE_DETECTED: *tcp_type = TCP_MSG_PASSAGE; return 0;
+        case MSG_TYPE_SYSTEM_STATUS:
+        case MSG_TYPE_GATE_COMMAND: *tcp_type = TCP_MSG_SYSTEM_STATUS; return 0;
+        case MSG_TYPE_ERROR: *tcp_type = TCP_MSG_EMERGENCY; return 0;
+        case MSG_TYPE_SPOT_DELTA: *tcp_type = TCP_MSG_SPOT_DELTA; return 0;
+        case MSG_TYPE_LOG_LEVEL: *tcp_type = TCP_MSG_LOG_LEVEL; return 0;
+        case MSG_TYPE_METRICS: *tcp_type = TCP_MSG_METRICS; return 0;
     }
-    
-    // Configurar callbacks
-    bufferevent_setcb(bev, read_callback, NULL, event_callback, NULL);
-    bufferevent_enable(bev, EV_READ | EV_WRITE);
-    
-    // Adicionar à lista de conexões
-    add_connection(bev, addr_str, port, false);
+    return -1;
 }
 
 /**
- * @brief Callback chamado quando ocorre erro no listener
- * @param listener Listener
- * @param user_data Dados do usuário (não usado)
+ * @brief Monta cabeçalho de quadro binário
  */
-static void accept_error_callback(struct evconnlistener *listener, void *user_data) {
-    (void)user_data; // Suprimir warning
-    
-    struct event_base *base = evconnlistener_get_base(listener);
-    int err = EVUTIL_SOCKET_ERROR();
-    LOG_ERROR("TCP", "Erro no listener: %s", evutil_socket_error_to_string(err));
-    event_base_loopexit(base, NULL);
+static void build_frame_header(uint8_t *frame, message_type_t type, uint16_t payload_len,
+                               time_t timestamp) {
+    frame[0] = TCP_FRAME_MAGIC;
+    frame[1] = TCP_PROTOCOL_VERSION;
+    frame[2] = (uint8_t)type;
+    frame[3] = 0;
+    put_u16(frame + 4, payload_len);
+    put_u32(frame + 6, (uint32_t)timestamp);
 }
 
-// =============================================================================
-// FUNÇÕES PÚBLICAS
-// =============================================================================
-
 /**
- * @brief Inicializa o sistema de comunicação TCP
- * @param port Porta para escutar conexões (0 = não escutar)
- * @return 0 se sucesso, -1 se erro
+ * @brief Converte um quadro binário completo em tcp_message_t
+ * @param frame Início do quadro (cabeçalho + payload)
+ * @param message Estrutura de saída
+ * @return 0 se sucesso, -1 se versão ou tipo inválidos
  */
-int tcp_init(int listen_port) {
-    if (tcp_initialized) {
-        LOG_WARN("TCP", "TCP já inicializado");
-        return 0;
-    }
-    
-    LOG_INFO("TCP", "Inicializando sistema TCP...");
-    
-    // Criar base de eventos
-    base = event_base_new();
-    if (!base) {
-        LOG_ERROR("TCP", "Erro ao criar base de eventos");
+static int parse_binary_frame(const uint8_t *frame, tcp_message_t *message) {
+    if (frame[1] != TCP_PROTOCOL_VERSION) {
+        LOG_WARN("TCP", "Versão de protocolo não suportada: %u", frame[1]);
         return -1;
     }
     
-    // Criar listener se porta especificada
-    if (listen_port > 0) {
-        struct sockaddr_in sin;
-        memset(&sin, 0, sizeof(sin));
-        sin.sin_family = AF_INET;
-        sin.sin_addr.s_addr = INADDR_ANY;
-        sin.sin_port = htons(listen_port);
-        
-        listener = evconnlistener_new_bind(base, accept_callback, NULL,
-                                         LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE,
-                                         -1, (struct sockaddr*)&sin, sizeof(sin));
-        
-        if (!listener) {
-            LOG_ERROR("TCP", "Erro ao criar listener na porta %d: %s", 
-                     listen_port, strerror(errno));
-            event_base_free(base);
-            base = NULL;
-            return -1;
-        }
-        
-        evconnlistener_set_error_cb(listener, accept_error_callback);
-        LOG_INFO("TCP", "Escutando na porta %d", listen_port);
+    message->msg_type = (message_type_t)frame[2];
+    if (tcp_type_from_system(message->msg_type, &message->type) != 0) {
+        LOG_WARN("TCP", "Tipo de quadro desconhecido: %u", frame[2]);
+        return -1;
     }
     
-    // Zerar contadores
-    connection_count = 0;
-    memset(active_connections, 0, sizeof(active_connections));
+    message->format = TCP_WIRE_BINARY;
+    message->data_size = get_u16(frame + 4);
+    message->timestamp = (time_t)get_u32(frame + 6);
+    message->source[0] = '\0';
+    memcpy(message->data, frame + TCP_FRAME_HEADER_SIZE, message->data_size);
     
-    tcp_initialized = true;
-    LOG_INFO("TCP", "Sistema TCP inicializado com sucesso");
     return 0;
 }
 
 /**
- * @brief Finaliza o sistema TCP
+ * @brief Processa um quadro binário recebido
+ * @param conn Conexão
+ * @param frame Quadro completo (tamanho já validado)
+ */
+static void process_binary_frame(tcp_connection_t *conn, const uint8_t *frame) {
+    tcp_message_t message;
+    if (parse_binary_frame(frame, &message) != 0) {
+        return;
+    }
+    
+    strncpy(message.source, conn->address, sizeof(message.source) - 1);
+    message.source[sizeof(message.source) - 1] = '\0';
+    
+    if (message_callback) {
+        message_callback(&message, conn);
+    }
+}
+
+/**
+ * @brief Codifica uma mensagem do sistema no formato key=value
+ * @param msg Mensagem do sistema
+ * @param type Tipo TCP correspondente (saída)
+ * @param data Buffer para o campo data
+ * @param size Tamanho do buffer
+ * @return 0 se sucesso, -1 se tipo não suportado
+ */
+static int encode_system_message(const system_message_t *msg, tcp_message_type_t *type,
+                                 char *data, size_t size) {
+    switch (msg->type) {
+        case MSG_TYPE_PARKING_STATUS: {
+            // mask=<palavra 0>:<palavra 1>... em hexa, vaga 0 no bit 0 da primeira
+            const system_message_t *m = msg;
+            uint16_t num_spots = m->data.parking_status.num_spots;
+            if (m->data.parking_status.floor >= MAX_FLOORS ||
+                num_spots > MAX_PARKING_SPOTS_PER_FLOOR) {
+                return -1;
+            }
+            
+            *type = TCP_MSG_PARKING_STATUS;
+            int len = snprintf(data, size, "floor=%d,pne=%u,idoso=%u,comum=%u,cars=%u,seq=%u,spots=%u,mask=",
+                               m->data.parking_status.floor, m->data.parking_status.free_pne,
+                               m->data.parking_status.free_idoso, m->data.parking_status.free_comum,
+                               m->data.parking_status.cars, (unsigned int)m->data.parking_status.seq,
+                               num_spots);
+            int words = (num_spots + 63) / 64;
+            for (int w = 0; w < words && len >= 0 && (size_t)len < size; w++) {
+                len += snprintf(data + len, size - (size_t)len, "%s%llx", w > 0 ? ":" : "",
+                                (unsigned long long)m->data.parking_status.occupied.words[w]);
+            }
+            return (len >= 0 && (size_t)len < size) ? 0 : -1;
+        }
+        
+        case MSG_TYPE_SPOT_DELTA: {
+            // spots=<vaga><+|->... ('+' = ocupada), ex.: spots=2+5-
+            *type = TCP_MSG_SPOT_DELTA;
+            int len = snprintf(data, size, "floor=%d,seq=%u,spots=",
+                               msg->data.spot_delta.floor, (unsigned int)msg->data.spot_delta.seq);
+            for (uint16_t i = 0; i < msg->data.spot_delta.count && len >= 0 && (size_t)len < size; i++) {
+                uint16_t entry = msg->data.spot_delta.spots[i];
+                len += snprintf(data + len, size - (size_t)len, "%u%c",
+                                entry & SPOT_DELTA_INDEX_MASK,
+                                (entry & SPOT_DELTA_OCCUPIED) ? '+' : '-');
+            }
+            return (len >= 0 && (size_t)len < size) ? 0 : -1;
+        }
+        
+        case MSG_TYPE_ENTRY_OK:
+        case MSG_TYPE_VEHICLE_DETECTED:
+        case MSG_TYPE_EXIT_OK:
+            tcp_type_from_system(msg->type, type);
+            snprintf(data, size, "floor=%d,confidence=%d,exit=%d,accepted=%d,ticket=%u,amount=%u,plate=%s",
+                     msg->data.vehicle_event.floor, msg->data.vehicle_event.confidence,
+                     msg->data.vehicle_event.is_exit ? 1 : 0,
+                     msg->data.vehicle_event.accepted ? 1 : 0,
+                     (unsigned int)msg->data.vehicle_event.ticket_id,
+                     (unsigned int)msg->data.vehicle_event.amount_cents,
+                     msg->data.vehicle_event.plate);
+            return 0;
+            
+        case MSG_TYPE_PASSAGE_DETECTED:
+            *type = TCP_MSG_PASSAGE;
+            snprintf(data, size, "from=%d,to=%d,plate=%s",
+                     msg->data.passage.from_floor, msg->data.passage.to_floor,
+                     msg->data.passage.plate);
+            return 0;
+            
+        case MSG_TYPE_SYSTEM_STATUS:
+            *type = TCP_MSG_SYSTEM_STATUS;
+            data[0] = '\0';
+            return 0;
+            
+        case MSG_TYPE_ERROR: {
+            // text=<descrição> por último: pode ter vírgulas; quebras viram espaço
+            *type = TCP_MSG_EMERGENCY;
+            int len = snprintf(data, size, "code=%d,text=", msg->data.error_info.error_code);
+            if (len < 0 || (size_t)len >= size) return -1;
+            
+            const char *text = message_text_get(msg->data.error_info.text);
+            size_t i = 0;
+            for (; text[i] && (size_t)len + i < size - 1; i++) {
+                data[len + i] = (text[i] == '\n' || text[i] == '\r') ? ' ' : text[i];
+            }
+            data[len + i] = '\0';
+            return 0;
+        }
+            
+        case MSG_TYPE_LOG_LEVEL:
+            *type = TCP_MSG_LOG_LEVEL;
+            snprintf(data, size, "level=%d,module=%s",
+                     msg->data.log_level.level, msg->data.log_level.module);
+            return 0;
+            
+        case MSG_TYPE_METRICS: {
+            // hists=<id>:<contagem>:<p50>:<p99>:<máx.>;... só os não vazios,
+            // até onde couber na linha (os medidores vão sempre)
+            const metrics_report_t *report = message_metrics_get(msg->data.metrics.report);
+            if (!report) return -1;
+            const metrics_gauge_t *g = report->gauge;
+            *type = TCP_MSG_METRICS;
+            int len = snprintf(data, size, "floor=%d,gauges=%u:%u;%u:%u;%u:%u,hists=",
+                               msg->data.metrics.floor, g[0].value, g[0].max,
+                               g[1].value, g[1].max, g[2].value, g[2].max);
+            if (len < 0 || (size_t)len >= size) return -1;
+            
+            for (int i = 0; i < METRICS_MSG_HISTS; i++) {
+                const metrics_summary_t *h = &report->hist[i];
+                if (h->count == 0) continue;
+                
+                int n = snprintf(data + len, size - (size_t)len, "%d:%u:%u:%u:%u;",
+                                 i, h->count, h->p50, h->p99, h->max);
+                if (n < 0 || (size_t)n >= size - (size_t)len) {
+                    data[len] = '\0';
+                    break;
+                }
+                len += n;
+            }
+            return 0;
+        }
+            
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Serializa uma mensagem do sistema no formato de fio indicado
+ * @param msg Mensagem do sistema
+ * @param format TCP_WIRE_BINARY ou TCP_WIRE_TEXT
+ * @param out Buffer de saída
+ * @param size Tamanho do buffer (ao menos TCP_MAX_LINE_SIZE)
+ * @return Bytes gravados ou -1 se tipo não suportado
+ */
+static int serialize_system_message(const system_message_t *msg, tcp_wire_format_t format,
+                                    uint8_t *out, size_t size) {
+    if (format == TCP_WIRE_BINARY) {
+        int payload_len = encode_binary_payload(msg, out + TCP_FRAME_HEADER_SIZE);
+        if (payload_len < 0) return -1;
+        
+        build_frame_header(out, msg->type, (uint16_t)payload_len, msg->timestamp);
+        return TCP_FRAME_HEADER_SIZE + payload_len;
+    }
+    
+    tcp_message_type_t type;
+    char data[TCP_MAX_PAYLOAD_SIZE];
+    if (encode_system_message(msg, &type, data, sizeof(data)) != 0) {
+        return -1;
+    }
+    
+    int len = snprintf((char*)out, size, "type=%s,timestamp=%ld,source=,data=%s\n",
+                       tcp_type_to_string(type), (long)msg->timestamp, data);
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+    
+    return len;
+}
+
+/**
+ * @brief Remove uma conexão e libera seu bufferevent
+ * @param conn Conexão
+ */
+static void drop_connection(tcp_connection_t *conn) {
+    struct bufferevent *bev = conn->bev;
+    remove_connection(conn);
+    bufferevent_free(bev);
+}
+
+static void event_callback(struct bufferevent *bev, short events, void *user_data);
+
+/**
+ * @brief Fecha a conexão de coleta quando a resposta terminou de sair
+ */
+static void scrape_write_callback(struct bufferevent *bev, void *user_data) {
+    (void)bev;
+    drop_connection((tcp_connection_t*)user_data);
+}
+
+/**
+ * @brief Responde a um pedido HTTP de coleta de métricas
+ *
+ * A leitura é desligada: o restante do pedido (cabeçalhos) é descartado com
+ * a conexão, fechada assim que o buffer de saída esvazia.
+ *
+ * @param conn Conexão
+ * @param request Primeira linha do pedido ("GET <caminho> HTTP/1.x")
+ */
+static void serve_scrape(tcp_connection_t *conn, const char *request) {
+    static char body[METRICS_SCRAPE_BUFFER_SIZE];   // Apenas a thread do loop
+    
+    const char *path = request + 4;
+    size_t path_len = strcspn(path, " ?\r");
+    bool known = (path_len == 8 && strncmp(path, "/metrics", 8) == 0);
+    int len = (known && scrape_callback) ? scrape_callback(body, sizeof(body)) : -1;
+    
+    struct evbuffer *output = bufferevent_get_output(conn->bev);
+    if (len >= 0) {
+        evbuffer_add_printf(output, "HTTP/1.0 200 OK\r\n"
+                            "Content-Type: text/plain; version=0.0.4\r\n"
+                            "Content-Length: %d\r\nConnection: close\r\n\r\n", len);
+        evbuffer_add(output, body, (size_t)len);
+    } else if (known && scrape_callback) {
+        LOG_WARN("TCP", "Métricas não couberam em %d bytes", METRICS_SCRAPE_BUFFER_SIZE);
+        evbuffer_add_printf(output, "HTTP/1.0 500 Internal Server Error\r\n"
+                            "Content-Length: 0\r\nConnection: close\r\n\r\n");
+    } else {
+        evbuffer_add_printf(output, "HTTP/1.0 404 Not Found\r\n"
+                            "Content-Length: 0\r\nConnection: close\r\n\r\n");
+    }
+    
+    LOG_DEBUG("TCP", "Coleta de métricas de %s:%d: %.*s", conn->address, conn->port,
+              (int)path_len, path);
+    
+    bufferevent_disable(conn->bev, EV_READ);
+    bufferevent_setcb(conn->bev, NULL, scrape_write_callback, event_callback, conn);
+}
+
+/**
+ * @brief Callback chamado quando dados são recebidos
+ *
+ * Consome apenas quadros/linhas completos diretamente do evbuffer de entrada
+ * (sem cópia para heap); um quadro parcial permanece no buffer até que o
+ * restante chegue no próximo callback.
+ *
+ * @param bev BufferEvent
+ * @param user_data Conexão associada (tcp_connection_t*)
+ */
+static void read_callback(struct bufferevent *bev, void *user_data) {
+    tcp_connection_t *conn = (tcp_connection_t*)user_data;
+    
+    struct evbuffer *input = bufferevent_get_input(bev);
+    size_t len;
+    
+    while ((len = evbuffer_get_length(input)) > 0) {
+        uint8_t first;
+        evbuffer_copyout(input, &first, 1);
+        
+        // Primeiro byte da conexão define o formato (binário ou texto)
+        if (conn->wire_format == TCP_WIRE_UNKNOWN) {
+            conn->wire_format = (first == TCP_FRAME_MAGIC) ? TCP_WIRE_BINARY : TCP_WIRE_TEXT;
+            LOG_INFO("TCP", "Conexão %s:%d usando protocolo %s", conn->address, conn->port,
+                     conn->wire_format == TCP_WIRE_BINARY ? "binário" : "texto");
+        }
+        
+        size_t consumed;
+        
+        if (first == TCP_FRAME_MAGIC) {
+            if (len < TCP_FRAME_HEADER_SIZE) break;
+            
+            uint8_t header[TCP_FRAME_HEADER_SIZE];
+            evbuffer_copyout(input, header, sizeof(header));
+            
+            size_t payload_len = get_u16(header + 4);
+            if (payload_len > TCP_MAX_PAYLOAD_SIZE) {
+                LOG_ERROR("TCP", "Quadro inválido de %s:%d (payload %zu bytes) - desconectando",
+                          conn->address, conn->port, payload_len);
+                drop_connection(conn);
+                return;
+            }
+            
+            consumed = TCP_FRAME_HEADER_SIZE + payload_len;
+            if (len < consumed) break; // Quadro incompleto - aguarda mais dados
+            
+            const uint8_t *frame = evbuffer_pullup(input, (ev_ssize_t)consumed);
+            process_binary_frame(conn, frame);
+        } else {
+            size_t eol_len = 0;
+            struct evbuffer_ptr eol = evbuffer_search_eol(input, NULL, &eol_len, EVBUFFER_EOL_LF);
+            if (eol.pos < 0) {
+                if (len >= BUFFER_SIZE) {
+                    LOG_ERROR("TCP", "Linha sem terminador de %s:%d (%zu bytes) - desconectando",
+                              conn->address, conn->port, len);
+                    drop_connection(conn);
+                    return;
+                }
+                break; // Linha incompleta - aguarda mais dados
+            }
+            
+            consumed = (size_t)eol.pos + eol_len;
+            
+            // Linha é terminada no próprio buffer; o trecho é descartado em seguida
+            char *line = (char*)evbuffer_pullup(input, (ev_ssize_t)consumed);
+            line[eol.pos] = '\0';
+            
+            // Pedido HTTP de coleta: a conexão passa a só enviar a resposta
+            if (strncmp(line, "GET ", 4) == 0) {
+                conn->bytes_received += consumed;
+                serve_scrape(conn, line);
+                return;
+            }
+            
+            if (eol.pos > 0) {
+                LOG_DEBUG("TCP", "Mensagem recebida de %s:%d: %s", conn->address, conn->port, line);
+                process_simple_message(conn, line);
+            }
+        }
+        
+        evbuffer_drain(input, consumed);
+        conn->bytes_received += consumed;
+    }
+    
+    conn->last_activity = time(NULL);
+}
+
+/**
+ * @brief Callback chamado quando ocorre um evento na conexão
+ * @param bev BufferEvent
+ * @param events Eventos
+ * @param user_data Conexão associada (tcp_connection_t*)
+ */
+static void event_callback(struct bufferevent *bev, short events, void *user_data) {
+    (void)bev; // A conexão já guarda o bufferevent
+    
+    tcp_connection_t *conn = (tcp_connection_t*)user_data;
+    
+    if (events & BEV_EVENT_CONNECTED) {
+        LOG_INFO("TCP", "Conexão estabelecida");
+        return;
+    }
+    
+    if (events & (BEV_EVENT_ERROR | BEV_EVENT_EOF)) {
+        if (events & BEV_EVENT_ERROR) {
+            int err = EVUTIL_SOCKET_ERROR();
+            LOG_ERROR("TCP", "Erro na conexão: %s", evutil_socket_error_to_string(err));
+        } else {
+            LOG_INFO("TCP", "Conexão fechada pelo peer");
+        }
+        
+        drop_connection(conn);
+    }
+}
+
+/**
+ * @brief Callback chamado quando nova conexão é aceita
+ * @param listener Listener
+ * @param fd File descriptor da nova conexão
+ * @param address Endereço do cliente
+ * @param socklen Tamanho do endereço
+ * @param user_data Dados do usuário (não usado)
+ */
+static void accept_callback(struct evconnlistener *listener, evutil_socket_t fd,
+                          struct sockaddr *address, int socklen, void *user_data) {
+    (void)listener;    // Suprimir warning
+    (void)socklen;     // Suprimir warning
+    (void)user_data;   // Suprimir warning
+    
+    struct sockaddr_in *sin = (struct sockaddr_in*)address;
+    char addr_str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &sin->sin_addr, addr_str, INET_ADDRSTRLEN);
+    int port = ntohs(sin->sin_port);
+    
+    LOG_INFO("TCP", "Nova conexão aceita de %s:%d", addr_str, port);
+    
+    // Criar bufferevent para nova conexão
+    struct bufferevent *bev = bufferevent_socket_new(base, fd, BEV_OPT_CLOSE_ON_FREE);
+    if (!bev) {
+        LOG_ERROR("TCP", "Erro ao criar bufferevent");
+        close(fd);
+        return;
+    }
+    
+    // Reservar slot; a conexão vira o contexto dos callbacks
+    tcp_connection_t *conn = add_connection(bev, addr_str, port, false);
+    if (!conn) {
+        bufferevent_free(bev);
+        return;
+    }
+    
+    bufferevent_setcb(bev, read_callback, NULL, event_callback, conn);
+    bufferevent_enable(bev, EV_READ | EV_WRITE);
+}
+
+/**
+ * @brief Callback chamado quando ocorre erro no listener
+ * @param listener Listener
+ * @param user_data Dados do usuário (não usado)
+ */
+static void accept_error_callback(struct evconnlistener *listener, void *user_data) {
+    (void)user_data; // Suprimir warning
+    
+    struct event_base *base = evconnlistener_get_base(listener);
+    int err = EVUTIL_SOCKET_ERROR();
+    LOG_ERROR("TCP", "Erro no listener: %s", evutil_socket_error_to_string(err));
+    event_base_loopexit(base, NULL);
+}
+
+// =============================================================================
+// ENLACES EM MEMÓRIA
+// =============================================================================
+//
+// Central e andares no mesmo processo (servidor_unico): o andar recebe de
+// tcp_client_connect um pseudo-socket e a central vê uma conexão do pool sem
+// bufferevent. As mensagens são cópias de system_message_t em slots do
+// message_pool; o texto de erro é duplicado a cada passagem, então cada lado
+// libera o que recebeu como faria com uma mensagem decodificada.
+
+/**
+ * @brief Copia uma mensagem para um slot do pool (com um texto de erro próprio)
+ * @return Cópia ou NULL se o pool estiver esgotado
+ */
+static system_message_t* message_copy_to_pool(const system_message_t *msg) {
+    system_message_t *copy = message_pool_get();
+    if (!copy) return NULL;
+    
+    *copy = *msg;
+    system_message_copy_refs(copy);
+    return copy;
+}
+
+static void message_pool_discard(system_message_t *msg) {
+    system_message_release(msg);
+    message_pool_put(msg);
+}
+
+static bool is_local_socket(int socket) {
+    return socket >= TCP_LOCAL_SOCKET_BASE && socket < TCP_LOCAL_SOCKET_BASE + MAX_CLIENTS;
+}
+
+/**
+ * @brief Prepara os enlaces para o loop recém-criado (tcp_init)
+ */
+static void local_links_attach(struct event *event, int listen_port) {
+    pthread_mutex_lock(&local_mutex);
+    
+    if (!local_links_initialized) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            pthread_cond_init(&local_links[i].cond, &attr);
+        }
+        pthread_condattr_destroy(&attr);
+        local_links_initialized = true;
+    }
+    
+    local_event = event;
+    local_listen_port = listen_port;
+    outbox_head = outbox_tail = 0;
+    
+    pthread_mutex_unlock(&local_mutex);
+}
+
+/**
+ * @brief Descarta o que o enlace ainda guarda e libera o slot (com local_mutex)
+ */
+static void local_link_free(tcp_local_link_t *link) {
+    while (link->head != link->tail) {
+        message_pool_discard(link->inbox[link->head & (TCP_LOCAL_INBOX_SIZE - 1)]);
+        link->head++;
+    }
+    link->conn = NULL;
+    link->in_use = false;
+}
+
+/**
+ * @brief Encerra os enlaces quando o loop deixa de existir (tcp_cleanup)
+ *
+ * Os andares passam a receber -1 e liberam o enlace ao fechar o socket.
+ */
+static void local_links_detach(void) {
+    pthread_mutex_lock(&local_mutex);
+    
+    while (outbox_head != outbox_tail) {
+        message_pool_discard(local_outbox[outbox_head & (TCP_LOCAL_QUEUE_SIZE - 1)].msg);
+        outbox_head++;
+    }
+    
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        tcp_local_link_t *link = &local_links[i];
+        if (!link->in_use) continue;
+    
+        link->conn = NULL;
+        link->open_requested = false;
+        link->closed = true;
+        if (link->close_requested) {
+            local_link_free(link);
+        }
+        pthread_cond_broadcast(&link->cond);
+    }
+    
+    if (local_event) {
+        event_free(local_event);
+        local_event = NULL;
+    }
+    local_listen_port = 0;
+    
+    pthread_mutex_unlock(&local_mutex);
+}
+
+/**
+ * @brief Cria a conexão da central para um enlace novo (thread do loop)
+ */
+static void local_link_accept(int index) {
+    tcp_connection_t *conn = add_connection(NULL, "local", index, false);
+    
+    pthread_mutex_lock(&local_mutex);
+    tcp_local_link_t *link = &local_links[index];
+    if (conn) {
+        conn->is_local = true;
+        conn->local_link = index;
+        conn->wire_format = TCP_WIRE_LOCAL;
+        link->conn = conn;
+    } else {
+        link->closed = true;
+        pthread_cond_broadcast(&link->cond);
+    }
+    pthread_mutex_unlock(&local_mutex);
+}
+
+/**
+ * @brief Entrega ao callback uma mensagem de um andar (thread do loop)
+ */
+static void local_link_dispatch(tcp_connection_t *conn, const system_message_t *msg) {
+    tcp_message_t message;
+    
+    if (tcp_type_from_system(msg->type, &message.type) != 0) {
+        message.type = (tcp_message_type_t)0;
+    }
+    message.timestamp = msg->timestamp;
+    strncpy(message.source, conn->address, sizeof(message.source) - 1);
+    message.source[sizeof(message.source) - 1] = '\0';
+    message.format = TCP_WIRE_LOCAL;
+    message.msg_type = msg->type;
+    memcpy(message.data, msg, sizeof(*msg));
+    message.data_size = sizeof(*msg);
+    
+    conn->last_activity = time(NULL);
+    conn->bytes_received += sizeof(*msg);
+    
+    if (message_callback) {
+        message_callback(&message, conn);
+    }
+}
+
+/**
+ * @brief Processa aberturas, mensagens e fechamentos dos andares (thread do loop)
+ *
+ * Nesta ordem: mensagens enviadas logo após conectar encontram a conexão
+ * aberta, e as enviadas antes de fechar são entregues antes de ela sair.
+ */
+static void local_callback(evutil_socket_t fd, short events, void *arg) {
+    (void)fd;
+    (void)events;
+    (void)arg;
+    
+    bool opening[MAX_CLIENTS] = {false};
+    
+    pthread_mutex_lock(&local_mutex);
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        opening[i] = local_links[i].open_requested;
+        local_links[i].open_requested = false;
+    }
+    pthread_mutex_unlock(&local_mutex);
+    
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (opening[i]) local_link_accept(i);
+    }
+    
+    for (;;) {
+        pthread_mutex_lock(&local_mutex);
+        if (outbox_head == outbox_tail) {
+            pthread_mutex_unlock(&local_mutex);
+            break;
+        }
+        tcp_local_entry_t entry = local_outbox[outbox_head & (TCP_LOCAL_QUEUE_SIZE - 1)];
+        outbox_head++;
+        tcp_connection_t *conn = local_links[entry.link].conn;
+        pthread_mutex_unlock(&local_mutex);
+    
+        if (conn) {
+            local_link_dispatch(conn, entry.msg);
+        }
+        message_pool_discard(entry.msg);
+    }
+    
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        pthread_mutex_lock(&local_mutex);
+        tcp_local_link_t *link = &local_links[i];
+        bool closing = link->in_use && link->close_requested;
+        tcp_connection_t *conn = closing ? link->conn : NULL;
+        pthread_mutex_unlock(&local_mutex);
+    
+        if (!closing) continue;
+        if (conn) {
+            remove_connection(conn);
+        }
+        pthread_mutex_lock(&local_mutex);
+        local_link_free(link);
+        pthread_mutex_unlock(&local_mutex);
+    }
+}
+
+/**
+ * @brief Enfileira uma mensagem da central para o andar (thread do loop)
+ * @return 0 se sucesso, -1 se o enlace fechou ou a fila está cheia
+ */
+static int local_link_deliver(tcp_connection_t *conn, const system_message_t *msg) {
+    system_message_t *copy = message_copy_to_pool(msg);
+    if (!copy) {
+        LOG_WARN("TCP", "Pool de mensagens esgotado - envio ao enlace %d descartado", conn->local_link);
+        return -1;
+    }
+    
+    pthread_mutex_lock(&local_mutex);
+    tcp_local_link_t *link = &local_links[conn->local_link];
+    if (link->closed || link->tail - link->head == TCP_LOCAL_INBOX_SIZE) {
+        bool closed = link->closed;
+        pthread_mutex_unlock(&local_mutex);
+        if (!closed) {
+            LOG_WARN("TCP", "Fila do enlace em memória %d cheia", conn->local_link);
+        }
+        message_pool_discard(copy);
+        return -1;
+    }
+    link->inbox[link->tail & (TCP_LOCAL_INBOX_SIZE - 1)] = copy;
+    link->tail++;
+    pthread_cond_signal(&link->cond);
+    pthread_mutex_unlock(&local_mutex);
+    
+    conn->last_activity = time(NULL);
+    conn->bytes_sent += sizeof(*msg);
+    return 0;
+}
+
+/**
+ * @brief Desconecta o lado da central; o andar vê -1 na próxima espera
+ */
+static void local_link_disconnect(tcp_connection_t *conn) {
+    int index = conn->local_link;
+    remove_connection(conn);
+    
+    pthread_mutex_lock(&local_mutex);
+    local_links[index].conn = NULL;
+    local_links[index].closed = true;
+    pthread_cond_broadcast(&local_links[index].cond);
+    pthread_mutex_unlock(&local_mutex);
+}
+
+/**
+ * @brief Indica se host:port é o listener deste processo
+ */
+static bool local_link_target(const char *host, int port) {
+    struct in_addr addr;
+    if (inet_pton(AF_INET, host, &addr) <= 0 || (ntohl(addr.s_addr) >> 24) != 127) {
+        return false;
+    }
+    
+    pthread_mutex_lock(&local_mutex);
+    bool local = local_event && local_listen_port > 0 && port == local_listen_port;
+    pthread_mutex_unlock(&local_mutex);
+    return local;
+}
+
+/**
+ * @brief Abre um enlace (thread do andar)
+ * @return Pseudo-socket ou -1 se não houver enlace livre
+ */
+static int local_link_connect(void) {
+    pthread_mutex_lock(&local_mutex);
+    
+    int index = -1;
+    for (int i = 0; i < MAX_CLIENTS && local_event; i++) {
+        if (!local_links[i].in_use) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        pthread_mutex_unlock(&local_mutex);
+        LOG_ERROR("TCP", "Sem enlace em memória livre");
+        return -1;
+    }
+    
+    tcp_local_link_t *link = &local_links[index];
+    link->in_use = true;
+    link->open_requested = true;
+    link->close_requested = false;
+    link->closed = false;
+    link->conn = NULL;
+    link->head = link->tail = 0;
+    clock_gettime(CLOCK_MONOTONIC, &link->last_send);
+    event_active(local_event, 0, 0);
+    
+    pthread_mutex_unlock(&local_mutex);
+    
+    LOG_INFO("TCP", "Conectado à central deste processo (enlace em memória %d)", index);
+    return TCP_LOCAL_SOCKET_BASE + index;
+}
+
+/**
+ * @brief Enfileira uma mensagem do andar para a central
+ * @return 0 se sucesso, -1 se o enlace fechou ou a fila está cheia
+ */
+static int local_link_send(int socket, const system_message_t *msg) {
+    int index = socket - TCP_LOCAL_SOCKET_BASE;
+    system_message_t *copy = message_copy_to_pool(msg);
+    if (!copy) {
+        LOG_WARN("TCP", "Pool de mensagens esgotado - envio à central descartado");
+        return -1;
+    }
+    
+    pthread_mutex_lock(&local_mutex);
+    tcp_local_link_t *link = &local_links[index];
+    bool queued = false;
+    if (link->in_use && !link->closed && local_event &&
+        outbox_tail - outbox_head < TCP_LOCAL_QUEUE_SIZE) {
+        tcp_local_entry_t *entry = &local_outbox[outbox_tail & (TCP_LOCAL_QUEUE_SIZE - 1)];
+        entry->link = index;
+        entry->msg = copy;
+        outbox_tail++;
+        clock_gettime(CLOCK_MONOTONIC, &link->last_send);
+        event_active(local_event, 0, 0);
+        queued = true;
+    }
+    pthread_mutex_unlock(&local_mutex);
+    
+    if (!queued) {
+        message_pool_discard(copy);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Aguarda uma mensagem da central no enlace
+ * @param timeout_ms Espera máxima (< 0 = sem prazo)
+ * @return 1 se recebeu, 0 se expirou, -1 se o enlace fechou
+ */
+static int local_link_wait(int socket, system_message_t *msg, int timeout_ms) {
+    tcp_local_link_t *link = &local_links[socket - TCP_LOCAL_SOCKET_BASE];
+    
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeout_ms > 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+    }
+    
+    pthread_mutex_lock(&local_mutex);
+    while (link->in_use && link->head == link->tail && !link->closed) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&link->cond, &local_mutex);
+        } else if (pthread_cond_timedwait(&link->cond, &local_mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    
+    int ret;
+    if (link->in_use && link->head != link->tail) {
+        system_message_t *queued = link->inbox[link->head & (TCP_LOCAL_INBOX_SIZE - 1)];
+        link->head++;
+        *msg = *queued;             // O texto de erro passa ao chamador
+        message_pool_put(queued);
+        ret = 1;
+    } else {
+        ret = (!link->in_use || link->closed) ? -1 : 0;
+    }
+    pthread_mutex_unlock(&local_mutex);
+    
+    return ret;
+}
+
+/**
+ * @brief Fecha o enlace do lado do andar
+ */
+static void local_link_close(int socket) {
+    pthread_mutex_lock(&local_mutex);
+    tcp_local_link_t *link = &local_links[socket - TCP_LOCAL_SOCKET_BASE];
+    if (link->in_use) {
+        link->closed = true;
+        if (local_event) {
+            link->close_requested = true;
+            event_active(local_event, 0, 0);
+        } else {
+            local_link_free(link);
+        }
+    }
+    pthread_mutex_unlock(&local_mutex);
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS
+// =============================================================================
+
+/**
+ * @brief Inicializa o sistema de comunicação TCP
+ * @param port Porta para escutar conexões (0 = não escutar)
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_init(int listen_port) {
+    if (tcp_initialized) {
+        LOG_WARN("TCP", "TCP já inicializado");
+        return 0;
+    }
+    
+    LOG_INFO("TCP", "Inicializando sistema TCP...");
+    
+    // Habilitar locks do libevent: tcp_stop_loop() é chamado de outra thread
+    static bool threads_enabled = false;
+    if (!threads_enabled) {
+#ifndef EVENT__DISABLE_MM_REPLACEMENT
+        // Antes de qualquer outra chamada ao libevent: buffers das conexões
+        // passam a circular pelo cache de blocos em vez do malloc
+        event_set_mem_functions(message_block_alloc, message_block_realloc, message_block_free);
+#endif
+        if (evthread_use_pthreads() != 0) {
+            LOG_ERROR("TCP", "Erro ao habilitar suporte a threads do libevent");
+            return -1;
+        }
+        threads_enabled = true;
+    }
+    
+    // Criar base de eventos
+    base = event_base_new();
+    if (!base) {
+        LOG_ERROR("TCP", "Erro ao criar base de eventos");
+        return -1;
+    }
+    
+    // Criar listener se porta especificada
+    if (listen_port > 0) {
+        struct sockaddr_in sin;
+        memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_addr.s_addr = INADDR_ANY;
+        sin.sin_port = htons(listen_port);
+        
+        listener = evconnlistener_new_bind(base, accept_callback, NULL,
+                                         LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE,
+                                         -1, (struct sockaddr*)&sin, sizeof(sin));
+        
+        if (!listener) {
+            LOG_ERROR("TCP", "Erro ao criar listener na porta %d: %s", 
+                     listen_port, strerror(errno));
+            event_base_free(base);
+            base = NULL;
+            return -1;
+        }
+        
+        evconnlistener_set_error_cb(listener, accept_error_callback);
+        LOG_INFO("TCP", "Escutando na porta %d", listen_port);
+    }
+    
+    // Difusão e enlaces em memória, acionados a partir de outras threads
+    broadcast_event = event_new(base, -1, 0, broadcast_callback, NULL);
+    struct event *links_event = event_new(base, -1, 0, local_callback, NULL);
+    if (!broadcast_event || !links_event) {
+        LOG_ERROR("TCP", "Erro ao criar evento de difusão");
+        if (broadcast_event) {
+            event_free(broadcast_event);
+            broadcast_event = NULL;
+        }
+        if (links_event) {
+            event_free(links_event);
+        }
+        if (listener) {
+            evconnlistener_free(listener);
+            listener = NULL;
+        }
+        event_base_free(base);
+        base = NULL;
+        return -1;
+    }
+    broadcast_count = 0;
+    
+    // Zerar pool de conexões
+    reset_connection_pool();
+    local_links_attach(links_event, listener ? listen_port : 0);
+    
+    tcp_initialized = true;
+    LOG_INFO("TCP", "Sistema TCP inicializado com sucesso");
+    return 0;
+}
+
+/**
+ * @brief Finaliza o sistema TCP
  */
 void tcp_cleanup(void) {
     if (!tcp_initialized) return;
     
-    LOG_INFO("TCP", "Finalizando sistema TCP...");
+    LOG_INFO("TCP", "Finalizando sistema TCP...");
+    
+    // Fechar todas as conexões
+    pthread_mutex_lock(&tcp_mutex);
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        if (connection_pool[i].in_use && connection_pool[i].bev) {
+            bufferevent_free(connection_pool[i].bev);
+        }
+    }
+    reset_connection_pool();
+    pthread_mutex_unlock(&tcp_mutex);
+    
+    // Andares deste processo passam a ver o enlace fechado
+    local_links_detach();
+    
+    // Liberar listener
+    if (listener) {
+        evconnlistener_free(listener);
+        listener = NULL;
+    }
+    
+    if (broadcast_event) {
+        event_free(broadcast_event);
+        broadcast_event = NULL;
+    }
+    
+    // Liberar base de eventos
+    if (base) {
+        event_base_free(base);
+        base = NULL;
+    }
+    
+    tcp_initialized = false;
+    LOG_INFO("TCP", "Sistema TCP finalizado");
+}
+
+/**
+ * @brief Conecta a um servidor remoto
+ * @param address Endereço IP
+ * @param port Porta
+ * @return Conexão se sucesso, NULL se erro
+ */
+tcp_connection_t* tcp_connect(const char *address, int port) {
+    if (!tcp_initialized || !address) {
+        LOG_ERROR("TCP", "TCP não inicializado ou endereço inválido");
+        return NULL;
+    }
+    
+    LOG_INFO("TCP", "Conectando a %s:%d", address, port);
+    
+    // Criar socket
+    struct bufferevent *bev = bufferevent_socket_new(base, -1, BEV_OPT_CLOSE_ON_FREE);
+    if (!bev) {
+        LOG_ERROR("TCP", "Erro ao criar bufferevent");
+        return NULL;
+    }
+    
+    // Conectar
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    
+    if (inet_pton(AF_INET, address, &sin.sin_addr) <= 0) {
+        LOG_ERROR("TCP", "Endereço IP inválido: %s", address);
+        bufferevent_free(bev);
+        return NULL;
+    }
+    
+    // Reservar slot antes de conectar: os callbacks recebem a conexão
+    tcp_connection_t *conn = add_connection(bev, address, port, true);
+    if (!conn) {
+        bufferevent_free(bev);
+        return NULL;
+    }
+    
+    bufferevent_setcb(bev, read_callback, NULL, event_callback, conn);
+    bufferevent_enable(bev, EV_READ | EV_WRITE);
+    
+    if (bufferevent_socket_connect(bev, (struct sockaddr*)&sin, sizeof(sin)) < 0) {
+        LOG_ERROR("TCP", "Erro ao conectar: %s", strerror(errno));
+        drop_connection(conn);
+        return NULL;
+    }
+    
+    return conn;
+}
+
+/**
+ * @brief Envia uma mensagem para uma conexão
+ * @param conn Conexão
+ * @param message Mensagem
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_connection_send(tcp_connection_t *conn, const tcp_message_t *message) {
+    if (conn && message && conn->is_local) {
+        system_message_t msg;
+        if (tcp_decode_message(message, &msg) != 0) return -1;
+        int ret = local_link_deliver(conn, &msg);
+        system_message_release(&msg);
+        return ret;
+    }
+    
+    if (!conn || !message || !conn->bev) {
+        LOG_ERROR("TCP", "Parâmetros inválidos para envio");
+        return -1;
+    }
+    
+    struct evbuffer *output = bufferevent_get_output(conn->bev);
+    
+    // Mensagens binárias são reenviadas como quadro
+    if (message->format == TCP_WIRE_BINARY) {
+        if (message->data_size > TCP_MAX_PAYLOAD_SIZE) return -1;
+        
+        uint8_t header[TCP_FRAME_HEADER_SIZE];
+        build_frame_header(header, message->msg_type, (uint16_t)message->data_size, message->timestamp);
+        evbuffer_add(output, header, sizeof(header));
+        evbuffer_add(output, message->data, message->data_size);
+        metrics_gauge_set(METRIC_TCP_SEND_QUEUE_BYTES, (uint32_t)evbuffer_get_length(output));
+        
+        conn->last_activity = time(NULL);
+        conn->bytes_sent += sizeof(header) + message->data_size;
+        return 0;
+    }
+    
+    // Criar mensagem simples no formato: type=xxx,data=yyy,timestamp=zzz
+    char msg_buffer[TCP_MAX_LINE_SIZE];
+    
+    // Formatar mensagem
+    snprintf(msg_buffer, sizeof(msg_buffer), "type=%s,timestamp=%ld,source=%s,data=%s",
+             tcp_type_to_string(message->type), (long)message->timestamp,
+             message->source, message->data);
+    
+    size_t msg_len = strlen(msg_buffer);
+    
+    // Enviar dados (adicionar \n ao final)
+    evbuffer_add(output, msg_buffer, msg_len);
+    evbuffer_add(output, "\n", 1);
+    metrics_gauge_set(METRIC_TCP_SEND_QUEUE_BYTES, (uint32_t)evbuffer_get_length(output));
+    
+    // Atualizar estatísticas
+    conn->last_activity = time(NULL);
+    conn->bytes_sent += msg_len + 1;
+    
+    LOG_DEBUG("TCP", "Mensagem enviada para %s:%d: %s", conn->address, conn->port, msg_buffer);
+    
+    return 0;
+}
+
+/**
+ * @brief Serializa e envia uma mensagem do sistema para uma conexão
+ * @param conn Conexão
+ * @param msg Mensagem do sistema
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_connection_send_system(tcp_connection_t *conn, const system_message_t *msg) {
+    if (conn && msg && conn->is_local) {
+        return local_link_deliver(conn, msg);
+    }
+    
+    if (!conn || !msg || !conn->bev) {
+        LOG_ERROR("TCP", "Parâmetros inválidos para envio");
+        return -1;
+    }
+    
+    tcp_wire_format_t format = (conn->wire_format == TCP_WIRE_UNKNOWN) ?
+                               client_wire_format : conn->wire_format;
+    
+    // Serializa direto no espaço reservado do evbuffer de saída (sem cópia)
+    struct evbuffer *output = bufferevent_get_output(conn->bev);
+    struct evbuffer_iovec vec;
+    if (evbuffer_reserve_space(output, TCP_MAX_LINE_SIZE, &vec, 1) < 1 ||
+        vec.iov_len < TCP_MAX_LINE_SIZE) {
+        LOG_ERROR("TCP", "Erro ao enfileirar mensagem para %s:%d", conn->address, conn->port);
+        return -1;
+    }
+    
+    int len = serialize_system_message(msg, format, vec.iov_base, TCP_MAX_LINE_SIZE);
+    if (len < 0) {
+        evbuffer_commit_space(output, &vec, 0);
+        LOG_WARN("TCP", "Tipo de mensagem não suportado: %d", msg->type);
+        return -1;
+    }
+    
+    vec.iov_len = (size_t)len;
+    if (evbuffer_commit_space(output, &vec, 1) != 0) {
+        LOG_ERROR("TCP", "Erro ao enfileirar mensagem para %s:%d", conn->address, conn->port);
+        return -1;
+    }
+    metrics_gauge_set(METRIC_TCP_SEND_QUEUE_BYTES, (uint32_t)evbuffer_get_length(output));
+    
+    conn->last_activity = time(NULL);
+    conn->bytes_sent += (uint64_t)len;
+    return 0;
+}
+
+/**
+ * @brief Envia as mensagens de tcp_broadcast_system (thread do loop)
+ */
+static void broadcast_callback(evutil_socket_t fd, short events, void *arg) {
+    (void)fd;
+    (void)events;
+    (void)arg;
+    
+    system_message_t *pending[TCP_BROADCAST_QUEUE_SIZE];
+    
+    pthread_mutex_lock(&tcp_mutex);
+    int count = broadcast_count;
+    memcpy(pending, broadcast_queue, (size_t)count * sizeof(pending[0]));
+    broadcast_count = 0;
+    pthread_mutex_unlock(&tcp_mutex);
+    
+    // Conexões só mudam nesta thread: o pool pode ser percorrido sem trava
+    for (int i = 0; i < count; i++) {
+        for (int slot = 0; slot < MAX_CONNECTIONS; slot++) {
+            if (connection_pool[slot].in_use) {
+                tcp_connection_send_system(&connection_pool[slot], pending[i]);
+            }
+        }
+        message_pool_discard(pending[i]);
+    }
+}
+
+int tcp_broadcast_system(const system_message_t *msg) {
+    if (!tcp_initialized || !msg || !broadcast_event) {
+        return -1;
+    }
+    
+    // O texto de erro é do chamador: a cópia enfileirada leva o seu
+    system_message_t *queued = message_copy_to_pool(msg);
+    if (!queued) {
+        LOG_WARN("TCP", "Pool de mensagens esgotado - difusão descartada");
+        return -1;
+    }
+    
+    pthread_mutex_lock(&tcp_mutex);
+    if (broadcast_count == TCP_BROADCAST_QUEUE_SIZE) {
+        pthread_mutex_unlock(&tcp_mutex);
+        LOG_WARN("TCP", "Fila de difusão cheia");
+        message_pool_discard(queued);
+        return -1;
+    }
+    broadcast_queue[broadcast_count++] = queued;
+    pthread_mutex_unlock(&tcp_mutex);
+    
+    event_active(broadcast_event, 0, 0);
+    return 0;
+}
+
+/**
+ * @brief Executa o loop de eventos (bloqueante)
+ * @return 0 se saiu normalmente, -1 se erro
+ */
+int tcp_run_loop(void) {
+    if (!tcp_initialized || !base) {
+        LOG_ERROR("TCP", "TCP não inicializado");
+        return -1;
+    }
+    
+    LOG_INFO("TCP", "Iniciando loop de eventos TCP...");
+    
+    // Mantém o loop vivo mesmo sem eventos pendentes (até tcp_stop_loop)
+    int rc = event_base_loop(base, EVLOOP_NO_EXIT_ON_EMPTY);
+    LOG_INFO("TCP", "Loop de eventos TCP finalizado");
+    return (rc < 0) ? -1 : 0;
+}
+
+/**
+ * @brief Para o loop de eventos
+ */
+void tcp_stop_loop(void) {
+    if (base) {
+        event_base_loopexit(base, NULL);
+        LOG_INFO("TCP", "Loop de eventos TCP parado");
+    }
+}
+
+/**
+ * @brief Define callback para mensagens recebidas
+ * @param callback Função callback
+ */
+void tcp_set_message_callback(tcp_message_callback_t callback) {
+    message_callback = callback;
+}
+
+/**
+ * @brief Define callback para eventos de conexão
+ * @param callback Função callback
+ */
+void tcp_set_connection_callback(tcp_connection_callback_t callback) {
+    connection_callback = callback;
+}
+
+/**
+ * @brief Define o gerador da resposta a "GET /metrics"
+ * @param callback Função callback
+ */
+void tcp_set_scrape_callback(tcp_scrape_callback_t callback) {
+    scrape_callback = callback;
+}
+
+/**
+ * @brief Obtém informações sobre conexões ativas
+ * @param connections Array para armazenar conexões
+ * @param max_connections Tamanho máximo do array
+ * @return Número de conexões ativas
+ */
+int tcp_get_connections(tcp_connection_t *connections, int max_connections) {
+    if (!connections || max_connections <= 0) return 0;
+    
+    int count = 0;
+    pthread_mutex_lock(&tcp_mutex);
+    for (int i = 0; i < MAX_CONNECTIONS && count < max_connections; i++) {
+        if (connection_pool[i].in_use) {
+            connections[count++] = connection_pool[i];
+        }
+    }
+    pthread_mutex_unlock(&tcp_mutex);
+    
+    return count;
+}
+
+/**
+ * @brief Resolve um identificador de conexão
+ * @param id Identificador obtido em conn->id
+ * @return Conexão ou NULL se o id não corresponde mais a uma conexão ativa
+ */
+tcp_connection_t* tcp_get_connection(tcp_connection_id_t id) {
+    uint32_t slot = id & 0xFFFF;
+    if (slot >= MAX_CONNECTIONS) return NULL;
+    
+    tcp_connection_t *conn = &connection_pool[slot];
+    pthread_mutex_lock(&tcp_mutex);
+    bool valid = conn->in_use && conn->id == id;
+    pthread_mutex_unlock(&tcp_mutex);
+    
+    return valid ? conn : NULL;
+}
+
+/**
+ * @brief Desconecta uma conexão específica
+ * @param conn Conexão para desconectar
+ */
+void tcp_disconnect(tcp_connection_t *conn) {
+    if (conn && conn->is_local && conn->in_use) {
+        LOG_INFO("TCP", "Desconectando enlace em memória %d", conn->local_link);
+        local_link_disconnect(conn);
+        return;
+    }
+    
+    if (!conn || !conn->bev) return;
+    
+    LOG_INFO("TCP", "Desconectando %s:%d", conn->address, conn->port);
+    drop_connection(conn);
+}
+
+/**
+ * @brief Converte uma mensagem recebida para a estrutura do sistema
+ * @param message Mensagem recebida pelo loop
+ * @param msg Estrutura de saída
+ * @return 0 se sucesso, -1 se tipo ou dados inválidos
+ */
+int tcp_decode_message(const tcp_message_t *message, system_message_t *msg) {
+    if (!message || !msg) return -1;
+    
+    memset(msg, 0, sizeof(system_message_t));
+    msg->timestamp = message->timestamp;
+    
+    if (message->format == TCP_WIRE_BINARY) {
+        return decode_binary_payload(message->msg_type, (const uint8_t*)message->data,
+                                     message->data_size, msg);
+    }
+    
+    // Enlace em memória: a mensagem recebida continua dona do texto ou resumo
+    if (message->format == TCP_WIRE_LOCAL) {
+        if (message->data_size != sizeof(*msg)) return -1;
+        memcpy(msg, message->data, sizeof(*msg));
+        system_message_copy_refs(msg);
+        return 0;
+    }
+    
+    switch (message->type) {
+        case TCP_MSG_PARKING_STATUS: {
+            int floor, offset = 0;
+            unsigned int pne, idoso, comum, cars, seq, spots;
+            if (sscanf(message->data, "floor=%d,pne=%u,idoso=%u,comum=%u,cars=%u,seq=%u,spots=%u,mask=%n",
+                       &floor, &pne, &idoso, &comum, &cars, &seq, &spots, &offset) != 7 ||
+                offset == 0 || floor < 0 || floor >= MAX_FLOORS ||
+                spots > MAX_PARKING_SPOTS_PER_FLOOR) {
+                return -1;
+            }
+            
+            msg->type = MSG_TYPE_PARKING_STATUS;
+            msg->data.parking_status.floor = (floor_id_t)floor;
+            msg->data.parking_status.free_pne = (uint16_t)pne;
+            msg->data.parking_status.free_idoso = (uint16_t)idoso;
+            msg->data.parking_status.free_comum = (uint16_t)comum;
+            msg->data.parking_status.cars = (uint16_t)cars;
+            msg->data.parking_status.seq = seq;
+            msg->data.parking_status.num_spots = (uint16_t)spots;
+            
+            const char *p = message->data + offset;
+            for (unsigned int w = 0; w < (spots + 63) / 64; w++) {
+                char *end;
+                if (w > 0 && *p++ != ':') return -1;
+                msg->data.parking_status.occupied.words[w] = strtoull(p, &end, 16);
+                if (end == p) return -1;
+                p = end;
+            }
+            return 0;
+        }
+        
+        case TCP_MSG_SPOT_DELTA: {
+            int floor, offset = 0;
+            unsigned int seq;
+            if (sscanf(message->data, "floor=%d,seq=%u,spots=%n", &floor, &seq, &offset) != 2 ||
+                offset == 0 || floor < 0 || floor >= MAX_FLOORS) {
+                return -1;
+            }
+            
+            msg->type = MSG_TYPE_SPOT_DELTA;
+            msg->data.spot_delta.floor = (floor_id_t)floor;
+            msg->data.spot_delta.seq = seq;
+            
+            const char *p = message->data + offset;
+            while (*p) {
+                char *end;
+                unsigned long spot = strtoul(p, &end, 10);
+                if (end == p || (*end != '+' && *end != '-') || spot > SPOT_DELTA_INDEX_MASK ||
+                    msg->data.spot_delta.count >= SPOT_DELTA_MAX_ENTRIES) {
+                    return -1;
+                }
+                msg->data.spot_delta.spots[msg->data.spot_delta.count++] =
+                    (uint16_t)(spot | (*end == '+' ? SPOT_DELTA_OCCUPIED : 0));
+                p = end + 1;
+            }
+            return 0;
+        }
+        
+        case TCP_MSG_VEHICLE_ENTRY:
+        case TCP_MSG_VEHICLE_EXIT:
+        case TCP_MSG_VEHICLE_DETECTED: {
+            int floor, confidence, is_exit, accepted;
+            unsigned int ticket, amount;
+            // Placa é o último campo e pode estar vazia
+            if (sscanf(message->data, "floor=%d,confidence=%d,exit=%d,accepted=%d,ticket=%u,amount=%u,plate=%8s",
+                       &floor, &confidence, &is_exit, &accepted, &ticket, &amount,
+                       msg->data.vehicle_event.plate) < 6) {
+                return -1;
+            }
+            msg->type = (message->type == TCP_MSG_VEHICLE_DETECTED) ? MSG_TYPE_VEHICLE_DETECTED :
+                        (message->type == TCP_MSG_VEHICLE_EXIT) ? MSG_TYPE_EXIT_OK : MSG_TYPE_ENTRY_OK;
+            msg->data.vehicle_event.floor = (floor_id_t)floor;
+            msg->data.vehicle_event.confidence = confidence;
+            msg->data.vehicle_event.is_exit = is_exit != 0;
+            msg->data.vehicle_event.accepted = accepted != 0;
+            msg->data.vehicle_event.ticket_id = ticket;
+            msg->data.vehicle_event.amount_cents = amount;
+            return 0;
+        }
+        
+        case TCP_MSG_PASSAGE: {
+            int from, to;
+            if (sscanf(message->data, "from=%d,to=%d,plate=%8s",
+                       &from, &to, msg->data.passage.plate) < 2) {
+                return -1;
+            }
+            msg->type = MSG_TYPE_PASSAGE_DETECTED;
+            msg->data.passage.from_floor = (floor_id_t)from;
+            msg->data.passage.to_floor = (floor_id_t)to;
+            return 0;
+        }
+        
+        case TCP_MSG_SYSTEM_STATUS:
+            msg->type = MSG_TYPE_SYSTEM_STATUS;
+            return 0;
+            
+        case TCP_MSG_EMERGENCY:
+            msg->type = MSG_TYPE_ERROR;
+            sscanf(message->data, "code=%d", &msg->data.error_info.error_code);
+            const char *text = strstr(message->data, ",text=");
+            if (text && text[6]) {
+                msg->data.error_info.text = message_text_put(text + 6, strlen(text + 6));
+            }
+            return 0;
+            
+        case TCP_MSG_LOG_LEVEL: {
+            int level;
+            if (sscanf(message->data, "level=%d,module=%15s", &level,
+                       msg->data.log_level.module) != 2) {
+                return -1;
+            }
+            msg->type = MSG_TYPE_LOG_LEVEL;
+            msg->data.log_level.level = (int8_t)level;
+            return 0;
+        }
+        
+        case TCP_MSG_METRICS: {
+            int floor, offset = 0;
+            metrics_report_t report;
+            memset(&report, 0, sizeof(report));
+            metrics_gauge_t *g = report.gauge;
+            if (sscanf(message->data, "floor=%d,gauges=%u:%u;%u:%u;%u:%u,hists=%n", &floor,
+                       &g[0].value, &g[0].max, &g[1].value, &g[1].max,
+                       &g[2].value, &g[2].max, &offset) != 7 ||
+                offset == 0 || floor < 0 || floor >= MAX_FLOORS) {
+                return -1;
+            }
+            
+            const char *p = message->data + offset;
+            while (*p) {
+                int id, n = 0;
+                metrics_summary_t h;
+                if (sscanf(p, "%d:%u:%u:%u:%u;%n", &id, &h.count, &h.p50, &h.p99, &h.max, &n) != 5 ||
+                    n == 0 || id < 0 || id >= METRICS_MSG_HISTS) {
+                    return -1;
+                }
+                report.hist[id] = h;
+                p += n;
+            }
+            
+            msg->type = MSG_TYPE_METRICS;
+            msg->data.metrics.floor = (floor_id_t)floor;
+            msg->data.metrics.report = message_metrics_put(&report);
+            return 0;
+        }
+    }
+    
+    return -1;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS - API DE SOCKETS
+// =============================================================================
+
+/**
+ * @brief Inicializa o servidor TCP sobre o loop de eventos
+ * @param port Porta para escutar
+ * @return Socket do listener ou -1 se erro
+ */
+int tcp_server_init(int port) {
+    if (port <= 0 || tcp_init(port) != 0 || !listener) {
+        return -1;
+    }
+    
+    return (int)evconnlistener_get_fd(listener);
+}
+
+static void batch_open(int socket);
+
+/**
+ * @brief Inicia uma conexão TCP sem bloquear
+ * @param pending Recebe true se o connect ainda está em andamento
+ * @return Socket ou -1 se erro
+ */
+static int client_connect_start(const char* host, int port, bool *pending) {
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    
+    if (inet_pton(AF_INET, host, &sin.sin_addr) <= 0) {
+        LOG_ERROR("TCP", "Endereço IP inválido: %s", host);
+        return -1;
+    }
+    
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (sock < 0) {
+        LOG_ERROR("TCP", "Erro ao criar socket: %s", strerror(errno));
+        return -1;
+    }
+    
+    if (connect(sock, (struct sockaddr*)&sin, sizeof(sin)) == 0) {
+        *pending = false;
+        return sock;
+    }
+    if (errno == EINPROGRESS) {
+        *pending = true;
+        return sock;
+    }
+    
+    LOG_DEBUG("TCP", "Erro ao conectar a %s:%d: %s", host, port, strerror(errno));
+    close(sock);
+    return -1;
+}
+
+/**
+ * @brief Aguarda um connect em andamento por até timeout_ms
+ * @return 1 se conectou, 0 se ainda em andamento, -1 se falhou (socket fechado)
+ */
+static int client_connect_poll(int sock, int timeout_ms) {
+    struct pollfd pfd = { .fd = sock, .events = POLLOUT, .revents = 0 };
+    int ret = poll(&pfd, 1, timeout_ms);
+    if (ret == 0 || (ret < 0 && errno == EINTR)) {
+        return 0;
+    }
+    
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (ret < 0 || getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+        err = errno;
+    }
+    if (err != 0) {
+        LOG_DEBUG("TCP", "Erro ao conectar: %s", strerror(err));
+        close(sock);
+        return -1;
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief Devolve o socket conectado ao modo bloqueante da API
+ */
+static void client_connect_finish(int sock, const char* host, int port) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(sock, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    
+    // Timeouts de envio/recepção para não travar as threads dos andares
+    struct timeval tv = { .tv_sec = TCP_RECEIVE_TIMEOUT, .tv_usec = 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    tv.tv_sec = TCP_CONNECT_TIMEOUT;
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    
+    LOG_INFO("TCP", "Conectado a %s:%d", host, port);
+    batch_open(sock);
+}
+
+/**
+ * @brief Conecta (bloqueante) a um servidor TCP
+ * @param host Endereço IP do host
+ * @param port Porta do servidor
+ * @return Socket da conexão ou -1 se erro
+ */
+int tcp_client_connect(const char* host, int port) {
+    if (!host) return -1;
+    
+    // Central neste processo: sem loopback nem serialização
+    if (local_link_target(host, port)) {
+        return local_link_connect();
+    }
+    
+    bool pending = false;
+    int sock = client_connect_start(host, port, &pending);
+    if (sock < 0) return -1;
+    
+    if (pending) {
+        int ret = client_connect_poll(sock, TCP_CONNECT_TIMEOUT * 1000);
+        if (ret == 0) {
+            LOG_DEBUG("TCP", "Tempo esgotado ao conectar a %s:%d", host, port);
+            close(sock);
+        }
+        if (ret != 1) return -1;
+    }
+    
+    client_connect_finish(sock, host, port);
+    return sock;
+}
+
+/**
+ * @brief Envia um buffer completo por um socket bloqueante
+ * @return 0 se sucesso, -1 se erro
+ */
+static int send_all(int socket, const void *buffer, size_t length) {
+    const uint8_t *p = buffer;
+    size_t sent = 0;
+    
+    while (sent < length) {
+        ssize_t n = send(socket, p + sent, length - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("TCP", "Erro ao enviar mensagem: %s", strerror(errno));
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Recebe exatamente length bytes de um socket bloqueante
+ * @return 0 se sucesso, -1 se erro ou conexão fechada
+ */
+static int recv_all(int socket, void *buffer, size_t length) {
+    uint8_t *p = buffer;
+    size_t received = 0;
+    
+    while (received < length) {
+        ssize_t n = recv(socket, p + received, length - received, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        received += (size_t)n;
+    }
+    
+    return 0;
+}
+
+// =============================================================================
+// AGRUPAMENTO DE ENVIOS (API DE SOCKETS)
+// =============================================================================
+
+/**
+ * @brief Encontra o lote de um socket (chamar com batch_mutex travado)
+ * @return Lote ou NULL se o socket não agrupa envios
+ */
+static tcp_batch_t* find_batch(int socket) {
+    if (!batches_initialized) return NULL;
+    
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (batches[i].socket == socket) {
+            return &batches[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Envia o conteúdo de um lote (chamar com batch_mutex travado)
+ *
+ * O lote pendente é trocado pelo buffer de saída sob a trava e escrito com
+ * ela liberada: um par lento só atrasa quem está enviando. Se outro
+ * escritor já está enviando, ele leva o pendente ao terminar (a ordem no
+ * socket se mantém) e esta chamada retorna sem esperar.
+ * @return 0 se sucesso ou envio delegado, -1 se erro
+ */
+static int flush_batch(tcp_batch_t *batch) {
+    if (batch->sending) {
+        if (batch->length > 0) batch->flush_requested = true;
+        return 0;
+    }
+    
+    int ret = 0;
+    while (batch->length > 0) {
+        uint8_t *out = batch->data;
+        size_t length = batch->length;
+        int socket = batch->socket;
+        
+        batch->data = batch->out;
+        batch->out = out;
+        batch->length = 0;
+        batch->flush_requested = false;
+        batch->sending = true;
+        
+        pthread_mutex_unlock(&batch_mutex);
+        ret = send_all(socket, out, length);
+        pthread_mutex_lock(&batch_mutex);
+        
+        batch->sending = false;
+        if (ret != 0) {
+            batch->failed = true;
+            break;
+        }
+        if (!batch->flush_requested) break;
+    }
+    
+    pthread_cond_broadcast(&batch_idle_cond);
+    return ret;
+}
+
+/**
+ * @brief Espera o envio em andamento de um lote (chamar com batch_mutex travado)
+ */
+static void wait_batch_idle(tcp_batch_t *batch) {
+    while (batch->sending) {
+        pthread_cond_wait(&batch_idle_cond, &batch_mutex);
+    }
+}
+
+/**
+ * @brief Compara dois instantes (a anterior a b)
+ */
+static bool timespec_before(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static void timespec_add_ms(struct timespec *t, long ms) {
+    t->tv_sec += ms / 1000;
+    t->tv_nsec += (ms % 1000) * 1000000L;
+    t->tv_sec += t->tv_nsec / 1000000000L;
+    t->tv_nsec %= 1000000000L;
+}
+
+/**
+ * @brief Milissegundos de b até a (negativo se a vem antes)
+ */
+static long timespec_diff_ms(const struct timespec *a, const struct timespec *b) {
+    return (long)(a->tv_sec - b->tv_sec) * 1000L + (a->tv_nsec - b->tv_nsec) / 1000000L;
+}
+
+/**
+ * @brief Thread que envia cada lote ao fim da sua janela
+ */
+static void* batch_flush_thread(void *arg) {
+    (void)arg;
+    
+    pthread_mutex_lock(&batch_mutex);
     
-    // Fechar todas as conexões
-    pthread_mutex_lock(&tcp_mutex);
-    for (int i = 0; i < connection_count; i++) {
-        if (active_connections[i].bev) {
-            bufferevent_free(active_connections[i].bev);
+    while (batch_thread_running) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        
+        // Enviar lotes vencidos e achar o próximo a vencer
+        tcp_batch_t *next = NULL;
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            tcp_batch_t *b = &batches[i];
+            if (b->socket < 0 || b->length == 0) continue;
+            
+            if (!timespec_before(&now, &b->deadline)) {
+                flush_batch(b);
+            } else if (!next || timespec_before(&b->deadline, &next->deadline)) {
+                next = b;
+            }
+        }
+        
+        if (next) {
+            pthread_cond_timedwait(&batch_cond, &batch_mutex, &next->deadline);
+        } else {
+            pthread_cond_wait(&batch_cond, &batch_mutex);
         }
     }
-    connection_count = 0;
-    pthread_mutex_unlock(&tcp_mutex);
     
-    // Liberar listener
-    if (listener) {
-        evconnlistener_free(listener);
-        listener = NULL;
+    pthread_mutex_unlock(&batch_mutex);
+    return NULL;
+}
+
+/**
+ * @brief Passa a agrupar os envios de um socket recém-conectado
+ */
+static void batch_open(int socket) {
+    if (TCP_BATCH_WINDOW_MS <= 0) return;
+    
+    pthread_mutex_lock(&batch_mutex);
+    
+    if (!batches_initialized) {
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            batches[i].socket = -1;
+        }
+        
+        // Janela medida em relógio monotônico (imune a ajustes de hora)
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&batch_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        pthread_cond_init(&batch_idle_cond, NULL);
+        pthread_cond_init(&batch_joined_cond, NULL);
+        batches_initialized = true;
     }
     
-    // Liberar base de eventos
-    if (base) {
-        event_base_free(base);
-        base = NULL;
+    // A thread anterior ainda não foi reunida: não criar outra por cima dela
+    while (batch_thread_stopping) {
+        pthread_cond_wait(&batch_joined_cond, &batch_mutex);
     }
     
-    tcp_initialized = false;
-    LOG_INFO("TCP", "Sistema TCP finalizado");
+    tcp_batch_t *batch = find_batch(-1);
+    if (!batch) {
+        LOG_WARN("TCP", "Sem lote livre - envios do socket %d não serão agrupados", socket);
+        pthread_mutex_unlock(&batch_mutex);
+        return;
+    }
+    
+    batch->socket = socket;
+    batch->data = batch->buffers[0];
+    batch->out = batch->buffers[1];
+    batch->length = 0;
+    batch->sending = false;
+    batch->flush_requested = false;
+    batch->failed = false;
+    clock_gettime(CLOCK_MONOTONIC, &batch->last_send);
+    batch_count++;
+    
+    if (!batch_thread_running) {
+        batch_thread_running = true;
+        if (pthread_create(&batch_thread, NULL, batch_flush_thread, NULL) != 0) {
+            LOG_ERROR("TCP", "Erro ao criar thread de envio agrupado");
+            batch_thread_running = false;
+            batch->socket = -1;
+            batch_count--;
+        }
+    }
+    
+    pthread_mutex_unlock(&batch_mutex);
 }
 
 /**
- * @brief Conecta a um servidor remoto
- * @param address Endereço IP
- * @param port Porta
- * @return Conexão se sucesso, NULL se erro
+ * @brief Envia o lote pendente e libera o slot do socket
  */
-tcp_connection_t* tcp_connect(const char *address, int port) {
-    if (!tcp_initialized || !address) {
-        LOG_ERROR("TCP", "TCP não inicializado ou endereço inválido");
-        return NULL;
+static void batch_close(int socket) {
+    pthread_mutex_lock(&batch_mutex);
+    
+    tcp_batch_t *batch = find_batch(socket);
+    if (!batch) {
+        pthread_mutex_unlock(&batch_mutex);
+        return;
     }
     
-    LOG_INFO("TCP", "Conectando a %s:%d", address, port);
+    // Esvaziar por completo: outros produtores podem acrescentar durante o envio
+    wait_batch_idle(batch);
+    while (batch->length > 0 && flush_batch(batch) == 0) {
+        wait_batch_idle(batch);
+    }
+    batch->socket = -1;
     
-    // Criar socket
-    struct bufferevent *bev = bufferevent_socket_new(base, -1, BEV_OPT_CLOSE_ON_FREE);
-    if (!bev) {
-        LOG_ERROR("TCP", "Erro ao criar bufferevent");
-        return NULL;
+    // Último socket fechado: encerrar a thread de envio
+    bool stop_thread = (--batch_count == 0) && batch_thread_running;
+    if (stop_thread) {
+        batch_thread_running = false;
+        batch_thread_stopping = true;
+        pthread_cond_signal(&batch_cond);
     }
     
-    // Configurar callbacks
-    bufferevent_setcb(bev, read_callback, NULL, event_callback, NULL);
-    bufferevent_enable(bev, EV_READ | EV_WRITE);
+    pthread_mutex_unlock(&batch_mutex);
     
-    // Conectar
-    struct sockaddr_in sin;
-    memset(&sin, 0, sizeof(sin));
-    sin.sin_family = AF_INET;
-    sin.sin_port = htons(port);
+    if (stop_thread) {
+        pthread_join(batch_thread, NULL);
+        
+        pthread_mutex_lock(&batch_mutex);
+        batch_thread_stopping = false;
+        pthread_cond_broadcast(&batch_joined_cond);
+        pthread_mutex_unlock(&batch_mutex);
+    }
+}
+
+/**
+ * @brief Indica se a mensagem deve sair sem esperar a janela do lote
+ */
+static bool is_urgent_message(const system_message_t *msg) {
+    tcp_message_type_t type;
+    return tcp_type_from_system(msg->type, &type) == 0 && type == TCP_MSG_EMERGENCY;
+}
+
+/**
+ * @brief Acrescenta uma mensagem serializada ao lote do socket
+ * @param batch Lote (batch_mutex travado)
+ * @param data Mensagem serializada
+ * @param length Tamanho
+ * @param urgent true para enviar o lote imediatamente
+ * @return 0 se sucesso, -1 se erro
+ */
+static int batch_append(tcp_batch_t *batch, const uint8_t *data, size_t length, bool urgent) {
+    // Um lote anterior falhou: o chamador precisa saber (ex.: ressincronizar)
+    if (batch->failed) {
+        batch->failed = false;
+        return -1;
+    }
     
-    if (inet_pton(AF_INET, address, &sin.sin_addr) <= 0) {
-        LOG_ERROR("TCP", "Endereço IP inválido: %s", address);
-        bufferevent_free(bev);
-        return NULL;
+    // Sem espaço: só aqui o produtor espera o par (pressão de volta)
+    if (batch->length + length > TCP_BATCH_MAX_BYTES) {
+        wait_batch_idle(batch);
+        if (flush_batch(batch) != 0) {
+            batch->failed = false;
+            return -1;
+        }
     }
     
-    if (bufferevent_socket_connect(bev, (struct sockaddr*)&sin, sizeof(sin)) < 0) {
-        LOG_ERROR("TCP", "Erro ao conectar: %s", strerror(errno));
-        bufferevent_free(bev);
-        return NULL;
+    if (batch->length == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &batch->deadline);
+        batch->deadline.tv_nsec += (long)TCP_BATCH_WINDOW_MS * 1000000L;
+        batch->deadline.tv_sec += batch->deadline.tv_nsec / 1000000000L;
+        batch->deadline.tv_nsec %= 1000000000L;
+        pthread_cond_signal(&batch_cond);
+    }
+    
+    memcpy(batch->data + batch->length, data, length);
+    batch->length += length;
+    metrics_gauge_set(METRIC_TCP_SEND_QUEUE_BYTES, (uint32_t)batch->length);
+    
+    if (urgent || batch->length >= TCP_BATCH_MAX_BYTES) {
+        int ret = flush_batch(batch);
+        batch->failed = false;
+        return ret;
     }
     
-    // Adicionar à lista de conexões
-    return add_connection(bev, address, port, true);
+    return 0;
 }
 
 /**
- * @brief Envia uma mensagem para uma conexão
- * @param conn Conexão
- * @param message Mensagem
+ * @brief Envia imediatamente as mensagens agrupadas de um socket
+ * @param socket Socket da conexão
  * @return 0 se sucesso, -1 se erro
  */
-int tcp_send_message(tcp_connection_t *conn, const tcp_message_t *message) {
-    if (!conn || !message || !conn->bev) {
-        LOG_ERROR("TCP", "Parâmetros inválidos para envio");
-        return -1;
+int tcp_flush(int socket) {
+    if (socket < 0) return -1;
+    
+    // Enlace em memória não agrupa: a mensagem já está na fila do loop
+    if (is_local_socket(socket)) return 0;
+    
+    pthread_mutex_lock(&batch_mutex);
+    tcp_batch_t *batch = find_batch(socket);
+    int ret = 0;
+    if (batch) {
+        wait_batch_idle(batch);
+        ret = (flush_batch(batch) != 0 || batch->failed) ? -1 : 0;
+        batch->failed = false;
     }
+    pthread_mutex_unlock(&batch_mutex);
     
-    // Criar mensagem simples no formato: type=xxx,data=yyy,timestamp=zzz
-    char msg_buffer[1024];
-    const char *type_str;
+    return ret;
+}
+
+/**
+ * @brief Tempo desde o último envio aceito por um socket
+ * @param socket Socket da conexão
+ * @return Milissegundos (INT32_MAX se o socket não registra envios)
+ */
+int tcp_idle_ms(int socket) {
+    struct timespec now, last;
+    bool known = false;
     
-    switch (message->type) {
-        case TCP_MSG_PARKING_STATUS: type_str = "parking_status"; break;
-        case TCP_MSG_VEHICLE_ENTRY: type_str = "vehicle_entry"; break;
-        case TCP_MSG_VEHICLE_EXIT: type_str = "vehicle_exit"; break;
-        case TCP_MSG_SYSTEM_STATUS: type_str = "system_status"; break;
-        case TCP_MSG_EMERGENCY: type_str = "emergency"; break;
-        default: type_str = "unknown"; break;
+    if (is_local_socket(socket)) {
+        pthread_mutex_lock(&local_mutex);
+        tcp_local_link_t *link = &local_links[socket - TCP_LOCAL_SOCKET_BASE];
+        if (link->in_use) {
+            last = link->last_send;
+            known = true;
+        }
+        pthread_mutex_unlock(&local_mutex);
+    } else if (socket >= 0) {
+        pthread_mutex_lock(&batch_mutex);
+        tcp_batch_t *batch = find_batch(socket);
+        if (batch) {
+            last = batch->last_send;
+            known = true;
+        }
+        pthread_mutex_unlock(&batch_mutex);
     }
     
-    // Formatar mensagem
-    snprintf(msg_buffer, sizeof(msg_buffer), "type=%s,timestamp=%ld,source=%s,data=%s",
-             type_str, message->timestamp, message->source, message->data);
+    if (!known) return INT32_MAX;
     
-    size_t msg_len = strlen(msg_buffer);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long idle = timespec_diff_ms(&now, &last);
+    return idle < 0 ? 0 : (idle > INT32_MAX ? INT32_MAX : (int)idle);
+}
+
+/**
+ * @brief Define o formato usado por tcp_send_message
+ * @param format TCP_WIRE_BINARY ou TCP_WIRE_TEXT
+ */
+void tcp_set_wire_format(tcp_wire_format_t format) {
+    client_wire_format = (format == TCP_WIRE_TEXT) ? TCP_WIRE_TEXT : TCP_WIRE_BINARY;
+    LOG_INFO("TCP", "Protocolo de envio: %s",
+             client_wire_format == TCP_WIRE_BINARY ? "binário" : "texto");
+}
+
+/**
+ * @brief Envia uma mensagem do sistema por um socket bloqueante
+ * @param socket Socket da conexão
+ * @param msg Mensagem
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_send_message(int socket, const system_message_t* msg) {
+    if (socket < 0 || !msg) return -1;
     
-    // Enviar dados (adicionar \n ao final)
-    struct evbuffer *output = bufferevent_get_output(conn->bev);
-    evbuffer_add(output, msg_buffer, msg_len);
-    evbuffer_add(output, "\n", 1);
+    if (is_local_socket(socket)) {
+        return local_link_send(socket, msg);
+    }
     
-    // Atualizar estatísticas
-    conn->last_activity = time(NULL);
-    conn->bytes_sent += msg_len + 1;
+    uint8_t buffer[TCP_MAX_LINE_SIZE];
+    int len = serialize_system_message(msg, client_wire_format, buffer, sizeof(buffer));
+    if (len < 0) {
+        LOG_WARN("TCP", "Tipo de mensagem não suportado: %d", msg->type);
+        return -1;
+    }
     
-    LOG_DEBUG("TCP", "Mensagem enviada para %s:%d: %s", conn->address, conn->port, msg_buffer);
+    if (client_wire_format == TCP_WIRE_TEXT) {
+        LOG_DEBUG("TCP", "Mensagem enviada: %.*s", len - 1, (const char*)buffer);
+    }
     
-    return 0;
+    pthread_mutex_lock(&batch_mutex);
+    tcp_batch_t *batch = find_batch(socket);
+    if (!batch) {
+        pthread_mutex_unlock(&batch_mutex);
+        return send_all(socket, buffer, (size_t)len);
+    }
+    
+    int ret = batch_append(batch, buffer, (size_t)len, is_urgent_message(msg));
+    if (ret == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &batch->last_send);
+    }
+    pthread_mutex_unlock(&batch_mutex);
+    
+    return ret;
 }
 
 /**
- * @brief Executa o loop de eventos (bloqueante)
- * @return 0 se saiu normalmente, -1 se erro
+ * @brief Recebe (bloqueante) uma mensagem do sistema de um socket
+ * @param socket Socket da conexão
+ * @param msg Buffer para mensagem recebida
+ * @return 0 se sucesso, -1 se erro
  */
-int tcp_run_loop(void) {
-    if (!tcp_initialized || !base) {
-        LOG_ERROR("TCP", "TCP não inicializado");
+int tcp_receive_message(int socket, system_message_t* msg) {
+    if (socket < 0 || !msg) return -1;
+    
+    if (is_local_socket(socket)) {
+        return (local_link_wait(socket, msg, -1) == 1) ? 0 : -1;
+    }
+    
+    uint8_t first;
+    if (recv_all(socket, &first, 1) != 0) return -1;
+    
+    tcp_message_t message;
+    
+    if (first == TCP_FRAME_MAGIC) {
+        uint8_t frame[TCP_MAX_FRAME_SIZE];
+        frame[0] = first;
+        if (recv_all(socket, frame + 1, TCP_FRAME_HEADER_SIZE - 1) != 0) return -1;
+        
+        size_t payload_len = get_u16(frame + 4);
+        if (payload_len > TCP_MAX_PAYLOAD_SIZE ||
+            recv_all(socket, frame + TCP_FRAME_HEADER_SIZE, payload_len) != 0) {
+            return -1;
+        }
+        
+        if (parse_binary_frame(frame, &message) != 0) return -1;
+        return tcp_decode_message(&message, msg);
+    }
+    
+    char line[TCP_MAX_LINE_SIZE];
+    size_t len = 0;
+    char c = (char)first;
+    
+    while (c != '\n' && len < sizeof(line) - 1) {
+        line[len++] = c;
+        if (recv_all(socket, &c, 1) != 0) return -1;
+    }
+    line[len] = '\0';
+    
+    if (parse_simple_message(line, &message) != 0) {
         return -1;
     }
     
-    LOG_INFO("TCP", "Iniciando loop de eventos TCP...");
-    return event_base_dispatch(base);
+    return tcp_decode_message(&message, msg);
 }
 
 /**
- * @brief Para o loop de eventos
+ * @brief Aguarda uma mensagem por até timeout_ms
+ * @param socket Socket da conexão
+ * @param msg Buffer para mensagem recebida
+ * @param timeout_ms Tempo máximo de espera em milissegundos
+ * @return 1 se recebeu, 0 se expirou, -1 se erro
  */
-void tcp_stop_loop(void) {
-    if (base) {
-        event_base_loopexit(base, NULL);
-        LOG_INFO("TCP", "Loop de eventos TCP parado");
+int tcp_wait_message(int socket, system_message_t* msg, int timeout_ms) {
+    if (socket < 0 || !msg) return -1;
+    
+    if (is_local_socket(socket)) {
+        return local_link_wait(socket, msg, timeout_ms < 0 ? 0 : timeout_ms);
+    }
+    
+    struct pollfd pfd = { .fd = socket, .events = POLLIN, .revents = 0 };
+    int ret = poll(&pfd, 1, timeout_ms);
+    
+    if (ret < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    if (ret == 0) {
+        return 0;
     }
+    
+    return (tcp_receive_message(socket, msg) == 0) ? 1 : -1;
 }
 
 /**
- * @brief Define callback para mensagens recebidas
- * @param callback Função callback
+ * @brief Fecha um socket bloqueante
+ * @param socket Socket da conexão
  */
-void tcp_set_message_callback(tcp_message_callback_t callback) {
-    message_callback = callback;
+void tcp_close_connection(int socket) {
+    if (is_local_socket(socket)) {
+        local_link_close(socket);
+        return;
+    }
+    
+    if (socket >= 0) {
+        batch_close(socket);
+        close(socket);
+    }
 }
 
+// =============================================================================
+// RECONEXÃO E FILA OFFLINE
+// =============================================================================
+
+#if (TCP_OFFLINE_QUEUE_SIZE & (TCP_OFFLINE_QUEUE_SIZE - 1)) != 0
+#error "TCP_OFFLINE_QUEUE_SIZE deve ser potência de 2"
+#endif
+
 /**
- * @brief Define callback para eventos de conexão
- * @param callback Função callback
+ * @brief Sorteia a espera até a próxima tentativa ("equal jitter")
+ *
+ * O teto dobra a cada falha; a espera fica entre metade e o teto, então
+ * nunca é curta demais e andares que caíram juntos se espalham.
+ *
+ * @return Espera sorteada em milissegundos
  */
-void tcp_set_connection_callback(tcp_connection_callback_t callback) {
-    connection_callback = callback;
+static long reconnect_schedule(tcp_reconnect_t *rc, const struct timespec *now) {
+    long cap = TCP_RECONNECT_MIN_MS;
+    for (uint32_t i = 0; i < rc->failures && cap < TCP_RECONNECT_MAX_MS; i++) {
+        cap *= 2;
+    }
+    if (cap > TCP_RECONNECT_MAX_MS) cap = TCP_RECONNECT_MAX_MS;
+    
+    long delay = cap / 2 + (long)(rand_r(&rc->seed) % (unsigned int)(cap - cap / 2 + 1));
+    rc->next_attempt = *now;
+    timespec_add_ms(&rc->next_attempt, delay);
+    return delay;
 }
 
-/**
- * @brief Obtém informações sobre conexões ativas
- * @param connections Array para armazenar conexões
- * @param max_connections Tamanho máximo do array
- * @return Número de conexões ativas
- */
-int tcp_get_connections(tcp_connection_t *connections, int max_connections) {
-    if (!connections || max_connections <= 0) return 0;
+static void reconnect_failed(tcp_reconnect_t *rc, const char *host, int port) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
     
-    pthread_mutex_lock(&tcp_mutex);
-    int count = (connection_count < max_connections) ? connection_count : max_connections;
-    memcpy(connections, active_connections, count * sizeof(tcp_connection_t));
-    pthread_mutex_unlock(&tcp_mutex);
+    rc->failures++;
+    long delay = reconnect_schedule(rc, &now);
+    LOG_WARN("TCP", "Sem conexão com %s:%d - nova tentativa em %ld ms (falha %u)",
+             host, port, delay, (unsigned int)rc->failures);
+}
+
+static int reconnect_done(tcp_reconnect_t *rc, int sock) {
+    if (rc->failures > 0) {
+        LOG_INFO("TCP", "Reconectado após %u tentativas", (unsigned int)rc->failures);
+    }
+    rc->failures = 0;
+    rc->connected = true;
+    return sock;
+}
+
+int tcp_client_reconnect(tcp_reconnect_t *rc, const char *host, int port, int timeout_ms) {
+    if (!rc || !host) return -1;
+    if (timeout_ms < 0) timeout_ms = 0;
     
-    return count;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    if (rc->seed == 0) {
+        // Semente por cliente: andares do mesmo processo também sorteiam diferente
+        rc->seed = (unsigned int)now.tv_nsec ^ ((unsigned int)getpid() << 16) ^
+                   (unsigned int)(uintptr_t)rc ^ (unsigned int)port;
+        if (rc->seed == 0) rc->seed = 1;
+    }
+    
+    // Conexão perdida: todos os andares percebem juntos, então já espera sorteado
+    if (rc->connected) {
+        rc->connected = false;
+        rc->failures = 0;
+        long delay = reconnect_schedule(rc, &now);
+        LOG_INFO("TCP", "Reconectando a %s:%d em %ld ms", host, port, delay);
+    }
+    
+    if (rc->socket < 0) {
+        if (timespec_before(&now, &rc->next_attempt)) {
+            long wait = timespec_diff_ms(&rc->next_attempt, &now);
+            usleep((useconds_t)(wait < timeout_ms ? wait : timeout_ms) * 1000);
+            return -1;
+        }
+        
+        if (local_link_target(host, port)) {
+            int sock = local_link_connect();
+            if (sock < 0) {
+                reconnect_failed(rc, host, port);
+                return -1;
+            }
+            return reconnect_done(rc, sock);
+        }
+        
+        bool pending = false;
+        int sock = client_connect_start(host, port, &pending);
+        if (sock < 0) {
+            reconnect_failed(rc, host, port);
+            return -1;
+        }
+        if (!pending) {
+            client_connect_finish(sock, host, port);
+            return reconnect_done(rc, sock);
+        }
+        
+        rc->socket = sock;
+        rc->deadline = now;
+        timespec_add_ms(&rc->deadline, TCP_CONNECT_TIMEOUT * 1000L);
+    }
+    
+    // Connect em andamento: espera no máximo timeout_ms por chamada
+    long remaining = timespec_diff_ms(&rc->deadline, &now);
+    if (remaining < 0) remaining = 0;
+    int ret = client_connect_poll(rc->socket, remaining < timeout_ms ? (int)remaining : timeout_ms);
+    
+    if (ret == 1) {
+        int sock = rc->socket;
+        rc->socket = -1;
+        client_connect_finish(sock, host, port);
+        return reconnect_done(rc, sock);
+    }
+    
+    if (ret == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timespec_before(&now, &rc->deadline)) return -1;
+        
+        LOG_DEBUG("TCP", "Tempo esgotado ao conectar a %s:%d", host, port);
+        close(rc->socket);
+    }
+    
+    rc->socket = -1;
+    reconnect_failed(rc, host, port);
+    return -1;
 }
 
-/**
- * @brief Desconecta uma conexão específica
- * @param conn Conexão para desconectar
- */
-void tcp_disconnect(tcp_connection_t *conn) {
-    if (!conn || !conn->bev) return;
+void tcp_client_reconnect_abort(tcp_reconnect_t *rc) {
+    if (!rc || rc->socket < 0) return;
     
-    LOG_INFO("TCP", "Desconectando %s:%d", conn->address, conn->port);
-    remove_connection(conn->bev);
-    bufferevent_free(conn->bev);
+    close(rc->socket);
+    rc->socket = -1;
+}
+
+int tcp_offline_push(tcp_offline_queue_t *queue, const system_message_t *msg) {
+    if (!queue || !msg) return -1;
+    
+    if (queue->tail - queue->head == TCP_OFFLINE_QUEUE_SIZE) {
+        queue->dropped++;
+        return -1;
+    }
+    
+    system_message_t *slot = &queue->messages[queue->tail & (TCP_OFFLINE_QUEUE_SIZE - 1)];
+    // A fila guarda a própria cópia do texto ou resumo: o chamador libera o dele
+    *slot = *msg;
+    system_message_copy_refs(slot);
+    queue->tail++;
+    metrics_gauge_set(METRIC_TCP_OFFLINE_QUEUE, queue->tail - queue->head);
+    return 0;
+}
+
+int tcp_offline_discard(tcp_offline_queue_t *queue, message_type_t type) {
+    if (!queue) return 0;
+    
+    uint32_t kept = queue->head;
+    int removed = 0;
+    
+    for (uint32_t i = queue->head; i != queue->tail; i++) {
+        system_message_t *msg = &queue->messages[i & (TCP_OFFLINE_QUEUE_SIZE - 1)];
+        if (msg->type == type) {
+            system_message_release(msg);
+            removed++;
+            continue;
+        }
+        if (kept != i) {
+            queue->messages[kept & (TCP_OFFLINE_QUEUE_SIZE - 1)] = *msg;
+        }
+        kept++;
+    }
+    
+    queue->tail = kept;
+    metrics_gauge_set(METRIC_TCP_OFFLINE_QUEUE, queue->tail - queue->head);
+    return removed;
+}
+
+int tcp_offline_replay(tcp_offline_queue_t *queue, int socket) {
+    if (!queue) return 0;
+    
+    int sent = 0;
+    while (queue->head != queue->tail) {
+        system_message_t *msg = &queue->messages[queue->head & (TCP_OFFLINE_QUEUE_SIZE - 1)];
+        if (tcp_send_message(socket, msg) != 0) {
+            return -1;
+        }
+        system_message_release(msg);
+        queue->head++;
+        sent++;
+    }
+    metrics_gauge_set(METRIC_TCP_OFFLINE_QUEUE, 0);
+    
+    if (queue->dropped > 0) {
+        LOG_WARN("TCP", "%u mensagens descartadas com a fila offline cheia",
+                 (unsigned int)queue->dropped);
+        queue->dropped = 0;
+    }
+    
+    return sent;
 }
\ No newline at end of file
@@ -8,6 +8,112 @@
 
 #include "parking_system.h"
 
+// =============================================================================
+// TIPOS DO SERVIDOR DE EVENTOS (libevent)
+// =============================================================================
+
+// Tamanho do pool de conexões (slots estáveis; máx. 65535)
+#ifndef MAX_CONNECTIONS
+#define MAX_CONNECTIONS MAX_CLIENTS
+#endif
+
+// Identificador de conexão: [geração:16][slot:16]. Um id antigo deixa de
+// resolver assim que o slot é reutilizado.
+typedef uint32_t tcp_connection_id_t;
+
+#define TCP_CONNECTION_ID_INVALID 0
+
+// =============================================================================
+// PROTOCOLO BINÁRIO
+// =============================================================================
+//
+// Quadro: [magic:1][versão:1][tipo:1][reservado:1][tamanho:2][timestamp:4][payload]
+// Inteiros em big-endian; "tipo" é o message_type_t; "tamanho" conta apenas o
+// payload. O primeiro byte de cada conexão define o formato: TCP_FRAME_MAGIC
+// (não-ASCII) indica binário, qualquer outro valor indica texto key=value.
+
+#define TCP_FRAME_MAGIC         0xA5
+#define TCP_PROTOCOL_VERSION    4   // v2: seq/máscara no status + spot_delta; v3: pedidos de entrada/saída;
+                                    // v4: status só do andar, vagas em bitmap de tamanho variável
+#define TCP_FRAME_HEADER_SIZE   10
+#define TCP_MAX_PAYLOAD_SIZE    256
+#define TCP_MAX_FRAME_SIZE      (TCP_FRAME_HEADER_SIZE + TCP_MAX_PAYLOAD_SIZE)
+#define TCP_MAX_LINE_SIZE       (TCP_MAX_PAYLOAD_SIZE + 96)  // Linha key=value com todos os campos
+
+/**
+ * @brief Formato de serialização usado numa conexão
+ */
+typedef enum {
+    TCP_WIRE_UNKNOWN = 0,   // Ainda não negociado (nenhum byte recebido)
+    TCP_WIRE_BINARY,        // Quadros binários com prefixo de tamanho
+    TCP_WIRE_TEXT,          // Linhas key=value (depuração)
+    TCP_WIRE_LOCAL          // Enlace em memória: data é a própria system_message_t
+} tcp_wire_format_t;
+
+/**
+ * @brief Tipos de mensagem trafegados no protocolo key=value
+ */
+typedef enum {
+    TCP_MSG_PARKING_STATUS = 1,
+    TCP_MSG_VEHICLE_ENTRY,
+    TCP_MSG_VEHICLE_EXIT,
+    TCP_MSG_SYSTEM_STATUS,
+    TCP_MSG_EMERGENCY,
+    TCP_MSG_PASSAGE,
+    TCP_MSG_SPOT_DELTA,
+    TCP_MSG_LOG_LEVEL,
+    TCP_MSG_METRICS,
+    TCP_MSG_VEHICLE_DETECTED    // Pedido de entrada/saída do térreo à central
+} tcp_message_type_t;
+
+/**
+ * @brief Mensagem recebida pelo loop de eventos
+ */
+typedef struct {
+    tcp_message_type_t type;
+    time_t timestamp;
+    char source[INET_ADDRSTRLEN];
+    tcp_wire_format_t format;    // Formato em que a mensagem chegou
+    message_type_t msg_type;     // Tipo nativo (apenas formato binário)
+    char data[TCP_MAX_PAYLOAD_SIZE]; // Texto após "data=" ou payload binário
+    size_t data_size;
+} tcp_message_t;
+
+/**
+ * @brief Conexão ativa gerenciada pelo loop de eventos
+ */
+typedef struct {
+    struct bufferevent *bev;
+    tcp_connection_id_t id;      // Slot + geração (ver tcp_get_connection)
+    bool in_use;
+    char address[INET_ADDRSTRLEN];
+    int port;
+    bool is_outgoing;
+    tcp_wire_format_t wire_format;
+    time_t connected_time;
+    time_t last_activity;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    bool is_local;               // Enlace em memória com um andar deste processo (sem bev)
+    int local_link;
+} tcp_connection_t;
+
+/**
+ * @brief Eventos de conexão notificados ao usuário
+ */
+typedef enum {
+    TCP_EVENT_CONNECTED = 0,
+    TCP_EVENT_DISCONNECTED
+} tcp_event_t;
+
+typedef void (*tcp_message_callback_t)(const tcp_message_t *message, tcp_connection_t *conn);
+typedef void (*tcp_connection_callback_t)(tcp_connection_t *conn, tcp_event_t event);
+typedef int (*tcp_scrape_callback_t)(char *out, size_t size);
+
+// =============================================================================
+// API DE SOCKETS (clientes dos andares)
+// =============================================================================
+
 /**
  * @brief Inicializa servidor TCP
  * @param port Porta para escutar
@@ -17,6 +123,12 @@ int tcp_server_init(int port);
 
 /**
  * @brief Conecta a um servidor TCP
+ *
+ * Se a porta é a escutada por tcp_init neste mesmo processo e o host é de
+ * loopback, devolve um enlace em memória: as mensagens trafegam como
+ * system_message_t por filas, sem serialização nem socket. O valor devolvido
+ * serve às mesmas funções desta API.
+ *
  * @param host Endereço do host
  * @param port Porta do servidor
  * @return Socket da conexão ou -1 se erro
@@ -25,9 +137,14 @@ int tcp_client_connect(const char* host, int port);
 
 /**
  * @brief Envia mensagem via TCP
+ *
+ * Em sockets de tcp_client_connect a mensagem é agrupada por até
+ * TCP_BATCH_WINDOW_MS; uma falha de um lote já aceito é reportada na
+ * chamada seguinte. Emergências (MSG_TYPE_ERROR) são enviadas na hora.
+ *
  * @param socket Socket da conexão
  * @param msg Mensagem a ser enviada
- * @return 0 se sucesso, -1 se erro
+ * @return 0 se sucesso (ou agrupada), -1 se erro
  */
 int tcp_send_message(int socket, const system_message_t* msg);
 
@@ -40,9 +157,240 @@ int tcp_send_message(int socket, const system_message_t* msg);
 int tcp_receive_message(int socket, system_message_t* msg);
 
 /**
- * @brief Fecha conexão TCP
+ * @brief Aguarda uma mensagem por até timeout_ms
+ * @param socket Socket da conexão
+ * @param msg Buffer para mensagem recebida
+ * @param timeout_ms Tempo máximo de espera em milissegundos
+ * @return 1 se recebeu, 0 se expirou, -1 se erro (a conexão deve ser refeita)
+ */
+int tcp_wait_message(int socket, system_message_t* msg, int timeout_ms);
+
+/**
+ * @brief Envia imediatamente as mensagens agrupadas de um socket
+ * @param socket Socket da conexão
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_flush(int socket);
+
+/**
+ * @brief Fecha conexão TCP (envia antes o lote pendente)
  * @param socket Socket da conexão
  */
 void tcp_close_connection(int socket);
 
+/**
+ * @brief Define o formato usado por tcp_send_message (padrão: binário)
+ * @param format TCP_WIRE_BINARY ou TCP_WIRE_TEXT (depuração)
+ */
+void tcp_set_wire_format(tcp_wire_format_t format);
+
+/**
+ * @brief Tempo desde o último envio aceito por um socket
+ *
+ * Usado para mandar heartbeat apenas quando a conexão está ociosa.
+ *
+ * @param socket Socket da conexão
+ * @return Milissegundos (INT32_MAX se o socket não registra envios)
+ */
+int tcp_idle_ms(int socket);
+
+// =============================================================================
+// RECONEXÃO E FILA OFFLINE (clientes dos andares)
+// =============================================================================
+
+/**
+ * @brief Estado da reconexão de um cliente (iniciar com TCP_RECONNECT_INIT)
+ *
+ * A conexão é aberta sem bloquear a thread além de timeout_ms por chamada.
+ * Falhas seguidas dobram a espera até TCP_RECONNECT_MAX_MS, com sorteio
+ * (jitter) para que os andares não voltem todos no mesmo instante quando a
+ * central reinicia.
+ */
+typedef struct {
+    int socket;                     // Conexão em andamento (-1 = nenhuma)
+    uint32_t failures;              // Falhas seguidas desde a última conexão
+    struct timespec next_attempt;   // Próxima tentativa (monotônico)
+    struct timespec deadline;       // Prazo da tentativa em andamento
+    unsigned int seed;              // Sorteio do jitter (0 = ainda não semeado)
+    bool connected;                 // Última chamada devolveu uma conexão
+} tcp_reconnect_t;
+
+#define TCP_RECONNECT_INIT { .socket = -1 }
+
+/**
+ * @brief Avança a (re)conexão a um servidor sem bloquear
+ *
+ * Chamar em laço enquanto não houver conexão. A primeira tentativa é
+ * imediata; depois de uma conexão perdida, espera um intervalo sorteado
+ * antes de tentar de novo. Enlaces em memória (ver tcp_client_connect)
+ * conectam na hora.
+ *
+ * @param rc Estado da reconexão
+ * @param host Endereço do host
+ * @param port Porta do servidor
+ * @param timeout_ms Espera máxima desta chamada
+ * @return Socket conectado, ou -1 se ainda não conectou
+ */
+int tcp_client_reconnect(tcp_reconnect_t *rc, const char *host, int port, int timeout_ms);
+
+/**
+ * @brief Abandona a tentativa em andamento (ao encerrar o cliente)
+ */
+void tcp_client_reconnect_abort(tcp_reconnect_t *rc);
+
+/**
+ * @brief Mensagens guardadas enquanto a central está inacessível
+ *
+ * Sem trava própria: o dono protege com o mesmo mutex dos envios.
+ */
+typedef struct {
+    system_message_t messages[TCP_OFFLINE_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;               // Recusadas por fila cheia
+} tcp_offline_queue_t;
+
+/**
+ * @brief Guarda uma cópia da mensagem para envio na reconexão
+ * @return 0 se guardou, -1 se a fila está cheia
+ */
+int tcp_offline_push(tcp_offline_queue_t *queue, const system_message_t *msg);
+
+/**
+ * @brief Remove da fila as mensagens de um tipo, mantendo a ordem das demais
+ * @return Quantidade removida
+ */
+int tcp_offline_discard(tcp_offline_queue_t *queue, message_type_t type);
+
+/**
+ * @brief Reenvia a fila em ordem pelo socket
+ *
+ * Para no primeiro envio que falhar; a mensagem que falhou e as seguintes
+ * continuam na fila.
+ *
+ * @return Quantidade enviada, ou -1 se um envio falhou
+ */
+int tcp_offline_replay(tcp_offline_queue_t *queue, int socket);
+
+// =============================================================================
+// API DO LOOP DE EVENTOS (servidor central)
+// =============================================================================
+
+/**
+ * @brief Inicializa o sistema de comunicação TCP
+ * @param listen_port Porta para escutar conexões (0 = não escutar)
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_init(int listen_port);
+
+/**
+ * @brief Finaliza o sistema TCP (chamar após o loop terminar)
+ */
+void tcp_cleanup(void);
+
+/**
+ * @brief Conecta a um servidor remoto pelo loop de eventos
+ * @param address Endereço IP
+ * @param port Porta
+ * @return Conexão se sucesso, NULL se erro
+ */
+tcp_connection_t* tcp_connect(const char *address, int port);
+
+/**
+ * @brief Envia uma mensagem para uma conexão do loop de eventos
+ *
+ * Mensagens no formato binário são reenviadas como quadro; as demais como
+ * linha key=value.
+ *
+ * @param conn Conexão
+ * @param message Mensagem
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_connection_send(tcp_connection_t *conn, const tcp_message_t *message);
+
+/**
+ * @brief Serializa e envia uma mensagem do sistema para uma conexão
+ *
+ * Usa o formato já negociado pela conexão (binário se ainda desconhecido).
+ *
+ * @param conn Conexão
+ * @param msg Mensagem do sistema
+ * @return 0 se sucesso, -1 se erro
+ */
+int tcp_connection_send_system(tcp_connection_t *conn, const system_message_t *msg);
+
+/**
+ * @brief Envia uma mensagem do sistema para todas as conexões ativas
+ *
+ * Seguro a partir de qualquer thread: a mensagem é copiada e enviada pela
+ * thread do loop de eventos.
+ *
+ * @param msg Mensagem do sistema
+ * @return 0 se enfileirada, -1 se TCP não inicializado ou fila cheia
+ */
+int tcp_broadcast_system(const system_message_t *msg);
+
+/**
+ * @brief Executa o loop de eventos (bloqueante, rodar em thread própria)
+ * @return 0 se saiu normalmente, -1 se erro
+ */
+int tcp_run_loop(void);
+
+/**
+ * @brief Para o loop de eventos (seguro a partir de outra thread)
+ */
+void tcp_stop_loop(void);
+
+/**
+ * @brief Define callback para mensagens recebidas (chamado na thread do loop)
+ * @param callback Função callback
+ */
+void tcp_set_message_callback(tcp_message_callback_t callback);
+
+/**
+ * @brief Define callback para eventos de conexão
+ * @param callback Função callback
+ */
+void tcp_set_connection_callback(tcp_connection_callback_t callback);
+
+/**
+ * @brief Define o gerador da resposta a "GET /metrics" no listener
+ *
+ * Uma conexão cuja primeira linha é um pedido HTTP recebe o texto do
+ * callback (HTTP/1.0, fechada após o envio) em vez de ser tratada como
+ * andar. Sem callback, ou outro caminho, a resposta é 404.
+ *
+ * @param callback Escreve o corpo em out e devolve o tamanho, ou -1 se erro
+ */
+void tcp_set_scrape_callback(tcp_scrape_callback_t callback);
+
+/**
+ * @brief Obtém informações sobre conexões ativas
+ * @param connections Array para armazenar conexões
+ * @param max_connections Tamanho máximo do array
+ * @return Número de conexões ativas
+ */
+int tcp_get_connections(tcp_connection_t *connections, int max_connections);
+
+/**
+ * @brief Resolve um identificador de conexão
+ * @param id Identificador obtido em conn->id
+ * @return Conexão ou NULL se o id não corresponde mais a uma conexão ativa
+ */
+tcp_connection_t* tcp_get_connection(tcp_connection_id_t id);
+
+/**
+ * @brief Desconecta uma conexão específica
+ * @param conn Conexão para desconectar
+ */
+void tcp_disconnect(tcp_connection_t *conn);
+
+/**
+ * @brief Converte uma mensagem recebida para a estrutura do sistema
+ * @param message Mensagem recebida pelo loop
+ * @param msg Estrutura de saída
+ * @return 0 se sucesso, -1 se tipo ou dados inválidos
+ */
+int tcp_decode_message(const tcp_message_t *message, system_message_t *msg);
+
 #endif // TCP_COMMUNICATION_H
\ No newline at end of file
@@ -1,9 +1,34 @@
 #include "tcp_communication.h"
 #include "system_logger.h"
 #ifdef MOCK_BUILD
-int tcp_server_init(int port){LOG_INFO("TCP-MOCK","server init %d",port);return 1;}
+int tcp_server_init(int port){LOG_INFO("TCP-MOCK","server init %d",port);return tcp_init(port)==0?1:-1;}
 int tcp_client_connect(const char* host,int port){LOG_INFO("TCP-MOCK","connect %s:%d",host,port);return 2;}
 int tcp_send_message(int socket,const system_message_t* msg){(void)socket;(void)msg;LOG_DEBUG("TCP-MOCK","send message stub");return 0;}
 int tcp_receive_message(int socket, system_message_t* msg){(void)socket;(void)msg;return -1;}
+int tcp_wait_message(int socket, system_message_t* msg, int timeout_ms){(void)socket;(void)msg;usleep(timeout_ms*1000);return 0;}
+int tcp_flush(int socket){(void)socket;return 0;}
 void tcp_close_connection(int socket){(void)socket;LOG_INFO("TCP-MOCK","close");}
+void tcp_set_wire_format(tcp_wire_format_t format){LOG_INFO("TCP-MOCK","wire format %d",format);}
+int tcp_idle_ms(int socket){(void)socket;return INT32_MAX;}
+int tcp_client_reconnect(tcp_reconnect_t *rc,const char *host,int port,int timeout_ms){(void)timeout_ms;rc->connected=true;return tcp_client_connect(host,port);}
+void tcp_client_reconnect_abort(tcp_reconnect_t *rc){(void)rc;}
+int tcp_offline_push(tcp_offline_queue_t *queue,const system_message_t *msg){(void)msg;queue->dropped++;return -1;}
+int tcp_offline_discard(tcp_offline_queue_t *queue,message_type_t type){(void)queue;(void)type;return 0;}
+int tcp_offline_replay(tcp_offline_queue_t *queue,int socket){(void)queue;(void)socket;return 0;}
+static volatile bool loop_running = false;
+int tcp_init(int listen_port){loop_running=true;LOG_INFO("TCP-MOCK","init %d",listen_port);return 0;}
+void tcp_cleanup(void){LOG_INFO("TCP-MOCK","cleanup");}
+tcp_connection_t* tcp_connect(const char *address,int port){(void)address;(void)port;return NULL;}
+int tcp_connection_send(tcp_connection_t *conn,const tcp_message_t *message){(void)conn;(void)message;return 0;}
+int tcp_connection_send_system(tcp_connection_t *conn,const system_message_t *msg){(void)conn;(void)msg;return 0;}
+int tcp_broadcast_system(const system_message_t *msg){LOG_DEBUG("TCP-MOCK","broadcast type %d",msg?(int)msg->type:-1);return 0;}
+int tcp_run_loop(void){LOG_INFO("TCP-MOCK","loop");while(loop_running)usleep(100000);return 0;}
+void tcp_stop_loop(void){loop_running=false;}
+void tcp_set_message_callback(tcp_message_callback_t callback){(void)callback;}
+void tcp_set_connection_callback(tcp_connection_callback_t callback){(void)callback;}
+void tcp_set_scrape_callback(tcp_scrape_callback_t callback){(void)callback;}
+int tcp_get_connections(tcp_connection_t *connections,int max_connections){(void)connections;(void)max_connections;return 0;}
+tcp_connection_t* tcp_get_connection(tcp_connection_id_t id){(void)id;return NULL;}
+void tcp_disconnect(tcp_connection_t *conn){(void)conn;}
+int tcp_decode_message(const tcp_message_t *message,system_message_t *msg){(void)message;(void)msg;return -1;}
 #endif
@@ -0,0 +1,633 @@
+/**
+ * @file vehicle_flow.c
+ * @brief Fluxo de entrada/saída do térreo com rastreamento de latência
+ *
+ * Cada cancela é uma faixa com as etapas presença -> leitura da placa ->
+ * pedido à central -> abertura -> passagem -> fechamento. Com leitura de
+ * confiança alta a cancela abre enquanto a resposta da central ainda está a
+ * caminho, sobrepondo as duas etapas mais lentas. Uma thread conduz as duas
+ * faixas; câmera, cancela e envio à central são acionados com a trava solta.
+ */
+
+#include "vehicle_flow.h"
+#include "system_logger.h"
+#include "gpio_control.h"
+#include "gate_control.h"
+#include "modbus_client.h"
+#include "metrics.h"
+#include <pthread.h>
+#include <errno.h>
+
+// =============================================================================
+// TIPOS E ESTADO
+// =============================================================================
+
+typedef enum {
+    LANE_IDLE = 0,      // Aguardando veículo no sensor de presença
+    LANE_READING,       // Captura da placa em andamento
+    LANE_WAIT_ACK,      // Pedido enviado à central
+    LANE_PASSING,       // Liberado: aguardando o veículo deixar o sensor
+    LANE_DENIED         // Recusado: aguardando o veículo sair
+} lane_stage_t;
+
+typedef struct {
+    vehicle_flow_dir_t dir;
+    gate_type_t gate;
+    camera_type_t camera;
+    uint8_t presence_pin;
+    bool watched;               // Presença entregue por alerta
+    
+    lane_stage_t stage;
+    bool presence;
+    uint64_t presence_edge_us;  // Instante da última borda de chegada
+    uint64_t leave_us;          // Veículo saiu do sensor (0 = ainda presente)
+    uint64_t deadline_us;       // Prazo da etapa atual (resposta ou fechamento)
+    vehicle_flow_span_t span;
+    system_message_t request;   // Último pedido enviado à central
+    
+    // Resultados entregues por outras threads
+    bool read_ready;
+    int read_status;
+    plate_reading_t reading;
+    bool reply_ready;
+    bool reply_accepted;
+    uint32_t reply_amount;
+    
+    // Latência presença -> cancela aberta (us), em anel
+    uint32_t gate_samples[VEHICLE_FLOW_SAMPLES];
+    uint32_t sample_count;
+    uint32_t sample_next;
+    uint32_t vehicles;
+    uint32_t denied;
+    uint32_t pre_opened;
+} flow_lane_t;
+
+// Ações decididas com a trava e executadas depois de soltá-la
+typedef struct {
+    bool capture;
+    bool open;
+    bool close;
+    bool send;
+    bool defer;                 // msg é um checkout adiado (não um pedido novo)
+    bool done;
+    system_message_t msg;
+    vehicle_flow_span_t span;
+} lane_actions_t;
+
+static pthread_mutex_t flow_mutex = PTHREAD_MUTEX_INITIALIZER;     // Não é destruído
+static pthread_cond_t flow_cond;                                   // CLOCK_MONOTONIC
+static pthread_t flow_thread;
+static bool flow_running = false;
+static bool flow_initialized = false;
+static vehicle_flow_send_t flow_send = NULL;
+static vehicle_flow_send_t flow_defer = NULL;
+static vehicle_flow_done_t flow_done = NULL;
+static flow_lane_t lanes[2];
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+static uint64_t monotonic_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+/**
+ * @brief Converte um instante CLOCK_REALTIME (bordas do GPIO) para monotônico
+ */
+static uint64_t realtime_to_monotonic_us(uint64_t realtime_us) {
+    struct timespec real;
+    clock_gettime(CLOCK_REALTIME, &real);
+    uint64_t now_real = (uint64_t)real.tv_sec * 1000000u + (uint64_t)real.tv_nsec / 1000u;
+    uint64_t now_mono = monotonic_us();
+    uint64_t age = (now_real > realtime_us) ? now_real - realtime_us : 0;
+    return (age < now_mono) ? now_mono - age : now_mono;
+}
+
+static const char* lane_name(const flow_lane_t* lane) {
+    return (lane->dir == VEHICLE_FLOW_ENTRY) ? "ENTRADA" : "SAÍDA";
+}
+
+static double span_ms(uint64_t from_us, uint64_t to_us) {
+    return (from_us && to_us >= from_us) ? (double)(to_us - from_us) / 1000.0 : 0.0;
+}
+
+static void record_gate_sample(flow_lane_t* lane) {
+    const vehicle_flow_span_t* span = &lane->span;
+    if (!span->gate_open_us || span->gate_open_us < span->presence_us) return;
+    
+    lane->gate_samples[lane->sample_next] = (uint32_t)(span->gate_open_us - span->presence_us);
+    lane->sample_next = (lane->sample_next + 1) % VEHICLE_FLOW_SAMPLES;
+    if (lane->sample_count < VEHICLE_FLOW_SAMPLES) {
+        lane->sample_count++;
+    }
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_ms(const uint32_t* sorted, uint32_t count, int pct) {
+    if (count == 0) return 0.0;
+    uint32_t rank = (uint32_t)(((uint64_t)count * (uint64_t)pct + 99u) / 100u);   // Posto mais próximo
+    if (rank == 0) rank = 1;
+    return (double)sorted[rank - 1] / 1000.0;
+}
+
+static void log_span(const vehicle_flow_span_t* span) {
+    const char* name = (span->dir == VEHICLE_FLOW_ENTRY) ? "ENTRADA" : "SAÍDA";
+    const char* plate = span->plate[0] ? span->plate : "????????";
+    
+    if (!span->accepted) {
+        LOG_INFO("FLOW", "%s %s recusado: placa %.1f ms, central %.1f ms", name, plate,
+                 span_ms(span->presence_us, span->plate_us),
+                 span_ms(span->plate_us, span->ack_us));
+        return;
+    }
+    
+    LOG_INFO("FLOW", "%s %s (conf %d%s%s): placa %.1f ms, central %.1f ms, cancela %.1f ms, "
+             "aberta em %.1f ms, total %.1f ms", name, plate, span->confidence,
+             span->pre_opened ? ", antecipada" : "",
+             span->checkout_pending ? ", checkout adiado" : "",
+             span_ms(span->presence_us, span->plate_us),
+             span_ms(span->plate_us, span->ack_us),
+             span_ms(span->gate_cmd_us, span->gate_open_us),
+             span_ms(span->presence_us, span->gate_open_us),
+             span_ms(span->presence_us, span->done_us));
+}
+
+/**
+ * @brief Encerra o veículo atual e volta a faixa para IDLE (com flow_mutex)
+ */
+static void finish_vehicle(flow_lane_t* lane, uint64_t now_us, lane_actions_t* actions) {
+    lane->span.done_us = now_us;
+    if (lane->span.accepted) {
+        lane->vehicles++;
+        if (lane->span.pre_opened) lane->pre_opened++;
+        record_gate_sample(lane);
+    } else {
+        lane->denied++;
+    }
+    
+    actions->span = lane->span;
+    actions->done = true;
+    lane->stage = LANE_IDLE;
+    lane->leave_us = 0;
+    lane->deadline_us = 0;
+}
+
+static void request_open(flow_lane_t* lane, uint64_t now_us, lane_actions_t* actions) {
+    if (lane->span.gate_cmd_us) return;
+    lane->span.gate_cmd_us = now_us;
+    actions->open = true;
+}
+
+// =============================================================================
+// MÁQUINA DE ETAPAS
+// =============================================================================
+
+/**
+ * @brief Avança uma faixa (com flow_mutex)
+ */
+static void lane_step(flow_lane_t* lane, uint64_t now_us, lane_actions_t* actions) {
+    switch (lane->stage) {
+        case LANE_IDLE:
+            if (!lane->presence) break;
+    
+            memset(&lane->span, 0, sizeof(lane->span));
+            lane->span.dir = lane->dir;
+            lane->span.presence_us = lane->presence_edge_us ? lane->presence_edge_us : now_us;
+            lane->read_ready = false;
+            lane->reply_ready = false;
+            lane->stage = LANE_READING;
+            actions->capture = true;
+            break;
+    
+        case LANE_READING:
+            if (!lane->read_ready) break;
+    
+            lane->read_ready = false;
+            lane->span.plate_us = now_us;
+            metrics_observe(METRIC_LPR_ROUNDTRIP_US, now_us - lane->span.presence_us);
+            if (lane->read_status == 0 && lane->reading.success) {
+                snprintf(lane->span.plate, sizeof(lane->span.plate), "%s", lane->reading.plate);
+                lane->span.confidence = lane->reading.confidence;
+            }
+    
+            // Leitura confiável: abrir já, a resposta da central chega durante a abertura
+            if (lane->span.plate[0] && lane->span.confidence >= VEHICLE_PREOPEN_CONFIDENCE) {
+                lane->span.pre_opened = true;
+                request_open(lane, now_us, actions);
+            }
+    
+            memset(&actions->msg, 0, sizeof(actions->msg));
+            actions->msg.type = MSG_TYPE_VEHICLE_DETECTED;
+            actions->msg.timestamp = time(NULL);
+            memcpy(actions->msg.data.vehicle_event.plate, lane->span.plate,
+                   sizeof(actions->msg.data.vehicle_event.plate));
+            actions->msg.data.vehicle_event.confidence = lane->span.confidence;
+            actions->msg.data.vehicle_event.floor = FLOOR_TERREO;
+            actions->msg.data.vehicle_event.is_exit = (lane->dir == VEHICLE_FLOW_EXIT);
+            actions->send = true;
+            lane->request = actions->msg;
+    
+            lane->stage = LANE_WAIT_ACK;
+            lane->deadline_us = now_us + (uint64_t)VEHICLE_ACK_TIMEOUT_MS * 1000u;
+            break;
+    
+        case LANE_WAIT_ACK:
+            if (lane->reply_ready) {
+                lane->reply_ready = false;
+                lane->span.ack_us = now_us;
+                lane->span.amount_cents = lane->reply_amount;
+    
+                if (lane->reply_accepted) {
+                    lane->span.accepted = true;
+                    request_open(lane, now_us, actions);
+                } else if (lane->span.pre_opened) {
+                    // Cancela já aberta: deixar passar e registrar
+                    lane->span.accepted = true;
+                    LOG_WARN("FLOW", "%s: central recusou %s após abertura antecipada",
+                             lane_name(lane), lane->span.plate);
+                } else {
+                    lane->stage = LANE_DENIED;
+                    break;
+                }
+            } else if (now_us >= lane->deadline_us) {
+                if (lane->dir == VEHICLE_FLOW_ENTRY) {
+                    // Sem resposta: não prender o veículo na cancela
+                    LOG_WARN("FLOW", "%s: central não respondeu em %d ms - liberando",
+                             lane_name(lane), VEHICLE_ACK_TIMEOUT_MS);
+                } else if (lane->span.plate[0]) {
+                    // Saída: liberar só com o checkout guardado para a central
+                    LOG_WARN("FLOW", "%s: central não respondeu em %d ms - liberando %s "
+                             "com checkout adiado", lane_name(lane), VEHICLE_ACK_TIMEOUT_MS,
+                             lane->span.plate);
+                    lane->span.checkout_pending = true;
+                    actions->msg = lane->request;
+                    actions->msg.data.vehicle_event.accepted = true;
+                    actions->defer = true;
+                } else {
+                    // Sem placa não há o que cobrar depois: saída pelo operador
+                    LOG_WARN("FLOW", "%s: central não respondeu em %d ms e placa não lida "
+                             "- saída recusada", lane_name(lane), VEHICLE_ACK_TIMEOUT_MS);
+                    lane->stage = LANE_DENIED;
+                    break;
+                }
+                lane->span.accepted = true;
+                request_open(lane, now_us, actions);
+            } else {
+                break;
+            }
+    
+            lane->stage = LANE_PASSING;
+            lane->leave_us = 0;
+            lane->deadline_us = 0;
+            /* fall through */
+    
+        case LANE_PASSING:
+            if (lane->presence) {
+                lane->leave_us = 0;
+                lane->deadline_us = 0;
+                break;
+            }
+    
+            if (!lane->leave_us) {
+                lane->leave_us = now_us;
+                lane->deadline_us = now_us + (uint64_t)VEHICLE_GATE_HOLD_MS * 1000u;
+                break;
+            }
+    
+            if (now_us >= lane->deadline_us) {
+                actions->close = true;
+                finish_vehicle(lane, now_us, actions);
+            }
+            break;
+    
+        case LANE_DENIED:
+            if (!lane->presence) {
+                finish_vehicle(lane, now_us, actions);
+            }
+            break;
+    }
+}
+
+// =============================================================================
+// CALLBACKS (outras threads)
+// =============================================================================
+
+static void presence_edge(uint8_t pin, bool active, uint64_t time_us, void* userdata) {
+    (void)pin;
+    flow_lane_t* lane = (flow_lane_t*)userdata;
+    uint64_t edge_us = realtime_to_monotonic_us(time_us);
+    
+    pthread_mutex_lock(&flow_mutex);
+    if (active && !lane->presence) {
+        lane->presence_edge_us = edge_us;
+    }
+    lane->presence = active;
+    pthread_cond_signal(&flow_cond);
+    pthread_mutex_unlock(&flow_mutex);
+}
+
+static void plate_read(camera_type_t camera, const plate_reading_t* result, int status,
+                       void* user_data) {
+    // Captura dupla: um só contexto, a faixa sai da câmera
+    flow_lane_t* lane = (flow_lane_t*)user_data;
+    if (!lane) {
+        lane = &lanes[camera == CAMERA_ENTRADA ? VEHICLE_FLOW_ENTRY : VEHICLE_FLOW_EXIT];
+    }
+    
+    pthread_mutex_lock(&flow_mutex);
+    if (flow_running && lane->stage == LANE_READING) {
+        lane->read_status = status;
+        if (result) {
+            lane->reading = *result;
+        } else {
+            memset(&lane->reading, 0, sizeof(lane->reading));
+        }
+        lane->read_ready = true;
+        pthread_cond_signal(&flow_cond);
+    }
+    pthread_mutex_unlock(&flow_mutex);
+}
+
+// Chamado pelo reator das cancelas com a trava dele (ordem: cancelas -> fluxo)
+static void gate_state_changed(gate_type_t gate_type, gate_state_t state, void* user_data) {
+    (void)user_data;
+    flow_lane_t* lane = &lanes[gate_type == GATE_ENTRY ? VEHICLE_FLOW_ENTRY : VEHICLE_FLOW_EXIT];
+    
+    if (state != GATE_STATE_OPEN) return;
+    
+    pthread_mutex_lock(&flow_mutex);
+    if (lane->span.gate_cmd_us && !lane->span.gate_open_us &&
+        (lane->stage == LANE_WAIT_ACK || lane->stage == LANE_PASSING)) {
+        lane->span.gate_open_us = monotonic_us();
+    }
+    pthread_mutex_unlock(&flow_mutex);
+}
+
+// =============================================================================
+// THREAD DO FLUXO
+// =============================================================================
+
+static void perform_actions(flow_lane_t* lane, lane_actions_t* actions) {
+    if (actions->open) {
+        if (gate_open(lane->gate) != 0) {
+            LOG_ERROR("FLOW", "%s: falha ao abrir a cancela", lane_name(lane));
+        } else if (gate_get_state(lane->gate) == GATE_STATE_OPEN) {
+            // Já estava aberta: não haverá transição para o callback
+            pthread_mutex_lock(&flow_mutex);
+            if (!lane->span.gate_open_us) lane->span.gate_open_us = monotonic_us();
+            pthread_mutex_unlock(&flow_mutex);
+        }
+    }
+    
+    if (actions->capture &&
+        modbus_camera_capture_async(lane->camera, plate_read, lane) != 0) {
+        // Sem câmera: seguir como leitura falha (a central decide sem placa)
+        pthread_mutex_lock(&flow_mutex);
+        if (lane->stage == LANE_READING) {
+            lane->read_status = -1;
+            lane->read_ready = true;
+        }
+        pthread_mutex_unlock(&flow_mutex);
+    }
+    
+    if (actions->send && (!flow_send || flow_send(&actions->msg) != 0)) {
+        // Pedido perdido: vencer o prazo da resposta já
+        pthread_mutex_lock(&flow_mutex);
+        if (lane->stage == LANE_WAIT_ACK) {
+            lane->deadline_us = 0;
+        }
+        pthread_mutex_unlock(&flow_mutex);
+    }
+    
+    if (actions->defer && (!flow_defer || flow_defer(&actions->msg) != 0)) {
+        LOG_ERROR("FLOW", "%s: checkout de %s não pôde ser guardado - saída sem cobrança",
+                  lane_name(lane), actions->msg.data.vehicle_event.plate);
+    }
+    
+    if (actions->close) {
+        gate_close(lane->gate);
+    }
+    
+    if (actions->done) {
+        log_span(&actions->span);
+        if (flow_done) flow_done(&actions->span);
+    }
+}
+
+static void* vehicle_flow_thread(void* arg) {
+    (void)arg;
+    
+    LOG_INFO("FLOW", "Thread do fluxo de veículos iniciada");
+    
+    pthread_mutex_lock(&flow_mutex);
+    while (flow_running) {
+        bool polling = false;
+    
+        // Sem alerta: ler a presença aqui (o pino é lido com a trava solta)
+        for (int i = 0; i < 2; i++) {
+            if (lanes[i].watched) continue;
+            polling = true;
+            uint8_t pin = lanes[i].presence_pin;
+            pthread_mutex_unlock(&flow_mutex);
+            bool active = gpio_read_gate_sensor(pin);
+            uint64_t now_us = monotonic_us();
+            pthread_mutex_lock(&flow_mutex);
+            if (active && !lanes[i].presence) {
+                lanes[i].presence_edge_us = now_us;
+            }
+            lanes[i].presence = active;
+        }
+    
+        uint64_t now_us = monotonic_us();
+        lane_actions_t actions[2];
+        bool acted = false;
+        memset(actions, 0, sizeof(actions));
+        for (int i = 0; i < 2; i++) {
+            lane_step(&lanes[i], now_us, &actions[i]);
+            acted |= actions[i].capture || actions[i].open || actions[i].close ||
+                     actions[i].send || actions[i].defer || actions[i].done;
+        }
+    
+        if (acted) {
+            pthread_mutex_unlock(&flow_mutex);
+            // As duas faixas leem juntas: disparos em sequência e polls intercalados
+            if (actions[VEHICLE_FLOW_ENTRY].capture && actions[VEHICLE_FLOW_EXIT].capture &&
+                modbus_camera_capture_both(plate_read, NULL) == 0) {
+                actions[VEHICLE_FLOW_ENTRY].capture = false;
+                actions[VEHICLE_FLOW_EXIT].capture = false;
+            }
+            for (int i = 0; i < 2; i++) {
+                perform_actions(&lanes[i], &actions[i]);
+            }
+            pthread_mutex_lock(&flow_mutex);
+            continue;
+        }
+    
+        // Dormir até um callback, o próximo prazo ou a próxima varredura
+        uint64_t wake_us = polling ? now_us + (uint64_t)VEHICLE_FLOW_POLL_MS * 1000u : UINT64_MAX;
+        for (int i = 0; i < 2; i++) {
+            if (lanes[i].deadline_us && lanes[i].deadline_us < wake_us) {
+                wake_us = lanes[i].deadline_us;
+            }
+        }
+    
+        if (wake_us == UINT64_MAX) {
+            pthread_cond_wait(&flow_cond, &flow_mutex);
+        } else if (wake_us > now_us) {
+            struct timespec deadline;
+            deadline.tv_sec = (time_t)(wake_us / 1000000u);
+            deadline.tv_nsec = (long)(wake_us % 1000000u) * 1000L;
+            pthread_cond_timedwait(&flow_cond, &flow_mutex, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&flow_mutex);
+    
+    LOG_INFO("FLOW", "Thread do fluxo de veículos finalizada");
+    return NULL;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS
+// =============================================================================
+
+int vehicle_flow_init(vehicle_flow_send_t send, vehicle_flow_send_t defer,
+                      vehicle_flow_done_t done) {
+    if (flow_initialized) {
+        LOG_WARN("FLOW", "Fluxo de veículos já inicializado");
+        return 0;
+    }
+    
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&flow_cond, &attr) != 0) {
+        pthread_condattr_destroy(&attr);
+        LOG_ERROR("FLOW", "Erro ao inicializar sincronização do fluxo");
+        return -1;
+    }
+    pthread_condattr_destroy(&attr);
+    
+    memset(lanes, 0, sizeof(lanes));
+    lanes[VEHICLE_FLOW_ENTRY].dir = VEHICLE_FLOW_ENTRY;
+    lanes[VEHICLE_FLOW_ENTRY].gate = GATE_ENTRY;
+    lanes[VEHICLE_FLOW_ENTRY].camera = CAMERA_ENTRADA;
+    lanes[VEHICLE_FLOW_ENTRY].presence_pin = GPIO_TERREO_SENSOR_PRESENCA_ENTRADA;
+    lanes[VEHICLE_FLOW_EXIT].dir = VEHICLE_FLOW_EXIT;
+    lanes[VEHICLE_FLOW_EXIT].gate = GATE_EXIT;
+    lanes[VEHICLE_FLOW_EXIT].camera = CAMERA_SAIDA;
+    lanes[VEHICLE_FLOW_EXIT].presence_pin = GPIO_TERREO_SENSOR_PRESENCA_SAIDA;
+    
+    flow_send = send;
+    flow_defer = defer;
+    flow_done = done;
+    
+    pthread_mutex_lock(&flow_mutex);
+    flow_running = true;
+    for (int i = 0; i < 2; i++) {
+        flow_lane_t* lane = &lanes[i];
+        lane->watched = gpio_input_watch_enable(lane->presence_pin, presence_edge, lane) == 0;
+        // Estado inicial: um veículo já parado no sensor não gera borda
+        lane->presence = gpio_read_gate_sensor(lane->presence_pin);
+    }
+    pthread_mutex_unlock(&flow_mutex);
+    
+    if (!lanes[0].watched || !lanes[1].watched) {
+        LOG_INFO("FLOW", "Sensores de presença por varredura a cada %d ms", VEHICLE_FLOW_POLL_MS);
+    }
+    
+    gate_set_state_callback(gate_state_changed, NULL);
+    
+    if (pthread_create(&flow_thread, NULL, vehicle_flow_thread, NULL) != 0) {
+        LOG_ERROR("FLOW", "Erro ao criar thread do fluxo de veículos");
+        gate_set_state_callback(NULL, NULL);
+        for (int i = 0; i < 2; i++) {
+            gpio_input_watch_disable(lanes[i].presence_pin);
+        }
+        pthread_mutex_lock(&flow_mutex);
+        flow_running = false;
+        pthread_mutex_unlock(&flow_mutex);
+        pthread_cond_destroy(&flow_cond);
+        return -1;
+    }
+    
+    flow_initialized = true;
+    LOG_INFO("FLOW", "Fluxo de veículos inicializado (abertura antecipada com confiança >= %d)",
+             VEHICLE_PREOPEN_CONFIDENCE);
+    
+    return 0;
+}
+
+void vehicle_flow_cleanup(void) {
+    if (!flow_initialized) return;
+    
+    gate_set_state_callback(NULL, NULL);
+    for (int i = 0; i < 2; i++) {
+        gpio_input_watch_disable(lanes[i].presence_pin);
+    }
+    
+    // Capturas ainda em curso encontram flow_running falso e são ignoradas
+    pthread_mutex_lock(&flow_mutex);
+    flow_running = false;
+    pthread_cond_signal(&flow_cond);
+    pthread_mutex_unlock(&flow_mutex);
+    
+    pthread_join(flow_thread, NULL);
+    pthread_cond_destroy(&flow_cond);
+    
+    flow_initialized = false;
+    LOG_INFO("FLOW", "Fluxo de veículos finalizado");
+}
+
+int vehicle_flow_on_reply(const system_message_t* msg) {
+    if (!msg || (msg->type != MSG_TYPE_ENTRY_OK && msg->type != MSG_TYPE_EXIT_OK)) {
+        return -1;
+    }
+    
+    flow_lane_t* lane = &lanes[msg->type == MSG_TYPE_ENTRY_OK ? VEHICLE_FLOW_ENTRY : VEHICLE_FLOW_EXIT];
+    int ret = -1;
+    
+    pthread_mutex_lock(&flow_mutex);
+    if (flow_running && lane->stage == LANE_WAIT_ACK &&
+        strncmp(lane->span.plate, msg->data.vehicle_event.plate, sizeof(lane->span.plate)) == 0) {
+        lane->reply_ready = true;
+        lane->reply_accepted = msg->data.vehicle_event.accepted;
+        lane->reply_amount = msg->data.vehicle_event.amount_cents;
+        pthread_cond_signal(&flow_cond);
+        ret = 0;
+    }
+    pthread_mutex_unlock(&flow_mutex);
+    
+    if (ret != 0) {
+        LOG_DEBUG("FLOW", "Resposta da central sem pedido pendente (%s)", msg->data.vehicle_event.plate);
+    }
+    return ret;
+}
+
+void vehicle_flow_get_stats(vehicle_flow_dir_t dir, vehicle_flow_stats_t* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    
+    const flow_lane_t* lane = &lanes[dir == VEHICLE_FLOW_ENTRY ? VEHICLE_FLOW_ENTRY : VEHICLE_FLOW_EXIT];
+    uint32_t samples[VEHICLE_FLOW_SAMPLES];
+    
+    pthread_mutex_lock(&flow_mutex);
+    stats->vehicles = lane->vehicles;
+    stats->denied = lane->denied;
+    stats->pre_opened = lane->pre_opened;
+    stats->samples = lane->sample_count;
+    memcpy(samples, lane->gate_samples, sizeof(uint32_t) * lane->sample_count);
+    pthread_mutex_unlock(&flow_mutex);
+    
+    qsort(samples, stats->samples, sizeof(uint32_t), compare_u32);
+    stats->gate_p50_ms = percentile_ms(samples, stats->samples, 50);
+    stats->gate_p95_ms = percentile_ms(samples, stats->samples, 95);
+    stats->gate_p99_ms = percentile_ms(samples, stats->samples, 99);
+}
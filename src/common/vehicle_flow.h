@@ -0,0 +1,98 @@
+/**
+ * @file vehicle_flow.h
+ * @brief Fluxo de entrada/saída do térreo: presença -> placa -> central -> cancela
+ */
+
+#ifndef VEHICLE_FLOW_H
+#define VEHICLE_FLOW_H
+
+#include "parking_system.h"
+
+/**
+ * @brief Sentido do fluxo (uma faixa por cancela)
+ */
+typedef enum {
+    VEHICLE_FLOW_ENTRY = 0,
+    VEHICLE_FLOW_EXIT
+} vehicle_flow_dir_t;
+
+/**
+ * @brief Linha do tempo de um veículo (us em CLOCK_MONOTONIC; 0 = etapa não ocorreu)
+ */
+typedef struct {
+    vehicle_flow_dir_t dir;
+    char plate[9];              // Vazia se a leitura falhou
+    int confidence;
+    bool accepted;              // Central aceitou (ou não respondeu a tempo)
+    bool pre_opened;            // Cancela aberta antes da resposta da central
+    bool checkout_pending;      // Saída liberada sem resposta: checkout adiado
+    uint32_t amount_cents;      // Saída: tarifa informada pela central
+    uint64_t presence_us;       // Veículo chegou ao sensor de presença
+    uint64_t plate_us;          // Leitura da câmera concluída
+    uint64_t ack_us;            // Resposta da central
+    uint64_t gate_cmd_us;       // Comando de abertura
+    uint64_t gate_open_us;      // Cancela totalmente aberta
+    uint64_t done_us;           // Veículo passou e a cancela foi fechada
+} vehicle_flow_span_t;
+
+/**
+ * @brief Estatísticas de uma faixa
+ */
+typedef struct {
+    uint32_t vehicles;          // Veículos que passaram
+    uint32_t denied;            // Recusados pela central
+    uint32_t pre_opened;        // Passagens com abertura antecipada
+    uint32_t samples;           // Amostras usadas nos percentis
+    double gate_p50_ms;         // Presença -> cancela aberta
+    double gate_p95_ms;
+    double gate_p99_ms;
+} vehicle_flow_stats_t;
+
+/**
+ * @brief Envia um pedido à central (retorna 0 se enviado, -1 se erro)
+ */
+typedef int (*vehicle_flow_send_t)(const system_message_t* msg);
+
+/**
+ * @brief Notificado ao fim de cada veículo (aceito ou recusado)
+ */
+typedef void (*vehicle_flow_done_t)(const vehicle_flow_span_t* span);
+
+/**
+ * @brief Inicia o fluxo das cancelas de entrada e saída
+ *
+ * Requer gpio_init, gate_system_init e modbus_init. Os callbacks rodam na
+ * thread do fluxo, sem nenhuma trava interna.
+ *
+ * Sem resposta da central a tempo, a entrada é liberada. A saída só é
+ * liberada com placa lida: o pedido volta com accepted = true por defer,
+ * para a central cobrar quando puder; sem placa ela é recusada.
+ *
+ * @param send Envia MSG_TYPE_VEHICLE_DETECTED à central
+ * @param defer Guarda o checkout de uma saída liberada sem resposta
+ * @param done Chamado ao fim de cada veículo (pode ser NULL)
+ * @return 0 se sucesso, -1 se erro
+ */
+int vehicle_flow_init(vehicle_flow_send_t send, vehicle_flow_send_t defer,
+                      vehicle_flow_done_t done);
+
+/**
+ * @brief Para o fluxo (veículos em andamento são descartados)
+ */
+void vehicle_flow_cleanup(void);
+
+/**
+ * @brief Entrega a resposta da central (MSG_TYPE_ENTRY_OK / MSG_TYPE_EXIT_OK)
+ * @param msg Mensagem recebida
+ * @return 0 se correspondia a um pedido pendente, -1 caso contrário
+ */
+int vehicle_flow_on_reply(const system_message_t* msg);
+
+/**
+ * @brief Obtém as estatísticas e percentis de latência de uma faixa
+ * @param dir Faixa
+ * @param stats Estrutura de saída
+ */
+void vehicle_flow_get_stats(vehicle_flow_dir_t dir, vehicle_flow_stats_t* stats);
+
+#endif // VEHICLE_FLOW_H
@@ -0,0 +1,493 @@
+/**
+ * @file vehicle_journal.c
+ * @brief Diário dos veículos em arquivo mapeado com checkpoints do estado
+ *
+ * Layout: [cabeçalho][checkpoint 0][checkpoint 1][registros x capacidade].
+ * Cada checkpoint guarda uma época e uma cópia de parking_status_t; os
+ * registros da mesma época vêm depois dele, em ordem. Um checkpoint novo vai
+ * para o outro slot com a época seguinte, e só então os registros voltam a
+ * ser escritos do início: registros de épocas antigas param a reaplicação.
+ * Somas de verificação descartam o que ficou pela metade numa queda.
+ *
+ * Os checkpoints periódicos são gravados por uma thread própria a partir do
+ * snapshot (seqlock), sem a trava dos escritores; ela só é tomada para a
+ * troca de época, que vale se o estado não mudou desde a cópia.
+ */
+
+#include "vehicle_journal.h"
+#include "parking_logic.h"
+#include "system_logger.h"
+#include "site_config.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stddef.h>
+#include <errno.h>
+
+// Cópias do snapshot invalidadas por escritas antes de desistir até o próximo prazo
+#define CHECKPOINT_ATTEMPTS 3
+
+#define JOURNAL_MAGIC     0x4C4E4A56u   // "VJNL"
+#define JOURNAL_VERSION   3
+
+// =============================================================================
+// FORMATO DO ARQUIVO
+// =============================================================================
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint32_t status_size;       // sizeof(parking_status_t) de quem gravou
+    uint32_t capacity;
+    uint32_t site_hash;         // site_config_fingerprint() de quem gravou
+    uint8_t reserved[44];
+} journal_header_t;
+
+typedef struct {
+    uint64_t epoch;             // 0 = slot nunca gravado
+    int64_t saved_at;           // time_t da gravação
+    parking_status_t status;
+    uint32_t checksum;          // Dos campos acima
+} journal_checkpoint_t;
+
+typedef struct {
+    uint64_t epoch;             // Época do checkpoint que este registro sucede
+    uint32_t seq;               // Posição + 1 dentro da época
+    uint8_t op;                 // vehicle_journal_op_t
+    uint8_t reserved[3];
+    vehicle_record_t record;
+    uint32_t checksum;          // Dos campos acima
+} journal_entry_t;
+
+typedef struct {
+    journal_header_t header;
+    journal_checkpoint_t checkpoints[2];
+    journal_entry_t entries[];
+} journal_file_t;
+
+// =============================================================================
+// ESTADO
+// =============================================================================
+
+static struct {
+    int fd;
+    journal_file_t* map;
+    size_t map_size;
+    uint64_t epoch;             // Época corrente (do último checkpoint)
+    uint32_t next;              // Próxima posição livre em entries
+    bool open;
+    
+    // Slot do próximo checkpoint: a thread o preenche sem a trava dos
+    // escritores (ordem: trava dos escritores -> cp_mutex)
+    pthread_mutex_t cp_mutex;
+    
+    // Thread dos checkpoints periódicos
+    const parking_snapshot_t* snapshot;
+    pthread_mutex_t* writers;
+    pthread_t thread;
+    pthread_mutex_t thread_mutex;
+    pthread_cond_t thread_cond;     // CLOCK_MONOTONIC
+    bool thread_running;
+    bool thread_stop;
+    bool checkpoint_requested;      // Diário a 3/4: não esperar o prazo
+} journal = {
+    .fd = -1,
+    .cp_mutex = PTHREAD_MUTEX_INITIALIZER,
+    .thread_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+#define FNV1A_BASIS 2166136261u
+
+static uint32_t fnv1a_from(uint32_t hash, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t fnv1a(const void* data, size_t size) {
+    return fnv1a_from(FNV1A_BASIS, data, size);
+}
+
+/**
+ * @brief Soma do checkpoint como se cp->epoch valesse epoch
+ *
+ * A época é o primeiro campo: a soma pode ser calculada antes de ela ser
+ * gravada, e o slot só fica válido quando a época for escrita.
+ */
+static uint32_t checkpoint_checksum_for(const journal_checkpoint_t* cp, uint64_t epoch) {
+    uint32_t hash = fnv1a(&epoch, sizeof(epoch));
+    return fnv1a_from(hash, (const uint8_t*)cp + sizeof(cp->epoch),
+                      offsetof(journal_checkpoint_t, checksum) - sizeof(cp->epoch));
+}
+
+static uint32_t checkpoint_checksum(const journal_checkpoint_t* cp) {
+    return checkpoint_checksum_for(cp, cp->epoch);
+}
+
+static uint32_t entry_checksum(const journal_entry_t* entry) {
+    return fnv1a(entry, offsetof(journal_entry_t, checksum));
+}
+
+// Queda do processo não perde páginas já escritas no mapa; MS_SYNC (com
+// VEHICLE_JOURNAL_SYNC) cobre também falta de energia
+#define JOURNAL_SYNC_FLAGS (VEHICLE_JOURNAL_SYNC ? MS_SYNC : MS_ASYNC)
+
+static size_t journal_file_size(void) {
+    return sizeof(journal_file_t) + (size_t)VEHICLE_JOURNAL_CAPACITY * sizeof(journal_entry_t);
+}
+
+/**
+ * @brief Envia ao disco as páginas de um trecho do mapa
+ */
+static void sync_range(const void* addr, size_t size, int flags) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(page - 1);
+    msync((void*)start, (uintptr_t)addr + size - start, flags);
+}
+
+/**
+ * @brief Cria o diretório do arquivo, se houver um no caminho
+ */
+static void ensure_parent_dir(const char* path) {
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s", path);
+    
+    char* slash = strrchr(dir, '/');
+    if (!slash || slash == dir) return;
+    *slash = '\0';
+    
+    if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+        LOG_WARN("JOURNAL", "Não foi possível criar o diretório %s: %s", dir, strerror(errno));
+    }
+}
+
+static bool header_matches(const journal_header_t* header) {
+    return header->magic == JOURNAL_MAGIC && header->version == JOURNAL_VERSION &&
+           header->entry_size == sizeof(journal_entry_t) &&
+           header->status_size == sizeof(parking_status_t) &&
+           header->capacity == VEHICLE_JOURNAL_CAPACITY &&
+           header->site_hash == site_config_fingerprint();
+}
+
+/**
+ * @brief Zera o arquivo mapeado e grava um cabeçalho novo
+ */
+static void format_journal(void) {
+    memset(journal.map, 0, journal.map_size);
+    journal.map->header.magic = JOURNAL_MAGIC;
+    journal.map->header.version = JOURNAL_VERSION;
+    journal.map->header.entry_size = sizeof(journal_entry_t);
+    journal.map->header.status_size = sizeof(parking_status_t);
+    journal.map->header.capacity = VEHICLE_JOURNAL_CAPACITY;
+    journal.map->header.site_hash = site_config_fingerprint();
+    msync(journal.map, journal.map_size, MS_SYNC);
+}
+
+/**
+ * @brief Checkpoint válido de época mais alta, ou NULL
+ */
+static const journal_checkpoint_t* latest_checkpoint(void) {
+    const journal_checkpoint_t* best = NULL;
+    
+    for (int i = 0; i < 2; i++) {
+        const journal_checkpoint_t* cp = &journal.map->checkpoints[i];
+        if (cp->epoch == 0 || cp->checksum != checkpoint_checksum(cp)) continue;
+        if (!best || cp->epoch > best->epoch) best = cp;
+    }
+    return best;
+}
+
+/**
+ * @brief Reaplica os registros da época corrente a partir da posição 0
+ * @return Número de registros reaplicados
+ */
+static uint32_t replay_entries(parking_status_t* status) {
+    uint32_t count = 0;
+    
+    while (count < VEHICLE_JOURNAL_CAPACITY) {
+        const journal_entry_t* entry = &journal.map->entries[count];
+        if (entry->epoch != journal.epoch || entry->seq != count + 1 ||
+            entry->checksum != entry_checksum(entry)) {
+            break;
+        }
+    
+        if (!parking_restore_vehicle(status, &entry->record, entry->op == VEHICLE_JOURNAL_ENTRY)) {
+            LOG_WARN("JOURNAL", "Registro %u inválido (placa %s) ignorado", count, entry->record.plate);
+        }
+        count++;
+    }
+    return count;
+}
+
+// =============================================================================
+// FUNÇÕES PÚBLICAS
+// =============================================================================
+
+int vehicle_journal_open(const char* path, parking_status_t* status) {
+    if (journal.open) {
+        LOG_WARN("JOURNAL", "Diário já aberto");
+        return 0;
+    }
+    if (!path || !status) return -1;
+    
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    ensure_parent_dir(path);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_ERROR("JOURNAL", "Erro ao abrir %s: %s", path, strerror(errno));
+        return -1;
+    }
+    
+    struct stat st;
+    size_t size = journal_file_size();
+    bool fresh = fstat(fd, &st) != 0 || (size_t)st.st_size != size;
+    if (fresh && ftruncate(fd, (off_t)size) != 0) {
+        LOG_ERROR("JOURNAL", "Erro ao dimensionar %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("JOURNAL", "Erro ao mapear %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    
+    journal.fd = fd;
+    journal.map = (journal_file_t*)map;
+    journal.map_size = size;
+    journal.open = true;
+    
+    if (fresh || !header_matches(&journal.map->header)) {
+        if (!fresh) {
+            LOG_WARN("JOURNAL", "Formato de %s incompatível - diário recriado", path);
+        }
+        format_journal();
+    }
+    
+    const journal_checkpoint_t* cp = latest_checkpoint();
+    if (!cp) {
+        // Nada a recuperar: o estado atual vira o primeiro checkpoint
+        journal.epoch = 0;
+        vehicle_journal_checkpoint(status);
+        LOG_INFO("JOURNAL", "Diário novo em %s (%u registros)", path, VEHICLE_JOURNAL_CAPACITY);
+        return 0;
+    }
+    
+    journal.epoch = cp->epoch;
+    parking_restore_status(status, &cp->status);
+    journal.next = replay_entries(status);
+    parking_update_total_stats(status);
+    
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed_ms = (double)(end.tv_sec - start.tv_sec) * 1000.0 +
+                        (double)(end.tv_nsec - start.tv_nsec) / 1e6;
+    
+    LOG_INFO("JOURNAL", "Estado recuperado em %.2f ms: checkpoint de %lds atrás + %u registros "
+             "(%u veículos, próximo ticket %u)", elapsed_ms, (long)(time(NULL) - cp->saved_at),
+             journal.next, status->indexed_plates, status->next_ticket_id + 1);
+    
+    return (int)journal.next;
+}
+
+void vehicle_journal_close(const parking_status_t* status) {
+    if (!journal.open) return;
+    
+    if (status) {
+        vehicle_journal_checkpoint(status);
+    }
+    
+    msync(journal.map, journal.map_size, MS_SYNC);
+    munmap(journal.map, journal.map_size);
+    close(journal.fd);
+    
+    journal.map = NULL;
+    journal.fd = -1;
+    journal.open = false;
+    LOG_INFO("JOURNAL", "Diário fechado");
+}
+
+int vehicle_journal_append(const parking_status_t* status, vehicle_journal_op_t op,
+                           const vehicle_record_t* record) {
+    if (!journal.open || !record) return -1;
+    
+    if (journal.next >= VEHICLE_JOURNAL_CAPACITY) {
+        vehicle_journal_checkpoint(status);
+    }
+    
+    // Montado fora do mapa: bytes de preenchimento zerados entram na soma
+    journal_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.epoch = journal.epoch;
+    entry.seq = journal.next + 1;
+    entry.op = (uint8_t)op;
+    entry.record = *record;
+    entry.checksum = entry_checksum(&entry);
+    
+    journal_entry_t* slot = &journal.map->entries[journal.next];
+    memcpy(slot, &entry, sizeof(entry));
+    journal.next++;
+    
+    sync_range(slot, sizeof(*slot), JOURNAL_SYNC_FLAGS);
+    
+    // Adiantar o checkpoint da thread: cheio, ele seria gravado aqui, com a trava
+    if (journal.next == VEHICLE_JOURNAL_CAPACITY * 3 / 4 && journal.thread_running) {
+        pthread_mutex_lock(&journal.thread_mutex);
+        journal.checkpoint_requested = true;
+        pthread_cond_signal(&journal.thread_cond);
+        pthread_mutex_unlock(&journal.thread_mutex);
+    }
+    
+    return 0;
+}
+
+int vehicle_journal_checkpoint(const parking_status_t* status) {
+    if (!journal.open || !status) return -1;
+    
+    // Espera a thread terminar de preencher o slot, se estiver nisso
+    pthread_mutex_lock(&journal.cp_mutex);
+    
+    uint64_t epoch = journal.epoch + 1;
+    journal_checkpoint_t* cp = &journal.map->checkpoints[epoch & 1];
+    
+    // O slot da época anterior fica intacto até este estar completo
+    cp->epoch = 0;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&cp->status, status, sizeof(cp->status));
+    cp->saved_at = (int64_t)time(NULL);
+    cp->epoch = epoch;
+    cp->checksum = checkpoint_checksum(cp);
+    
+    // Com MS_SYNC os registros só recomeçam depois do checkpoint estar no disco
+    sync_range(cp, sizeof(*cp), JOURNAL_SYNC_FLAGS);
+    
+    journal.epoch = epoch;
+    journal.next = 0;
+    
+    pthread_mutex_unlock(&journal.cp_mutex);
+    
+    LOG_DEBUG("JOURNAL", "Checkpoint da época %llu gravado", (unsigned long long)epoch);
+    return 0;
+}
+
+/**
+ * @brief Checkpoint a partir do snapshot, segurando os escritores só na troca de época
+ * @return 0 se gravado, -1 se o estado mudou a cada cópia (fica para o próximo prazo)
+ */
+static int checkpoint_from_snapshot(void) {
+    for (int attempt = 0; attempt < CHECKPOINT_ATTEMPTS; attempt++) {
+        // Cópia e soma no slot livre, ainda inválido (época 0)
+        pthread_mutex_lock(&journal.cp_mutex);
+        uint64_t epoch = journal.epoch;
+        journal_checkpoint_t* cp = &journal.map->checkpoints[(epoch + 1) & 1];
+        
+        cp->epoch = 0;
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        uint32_t version = parking_snapshot_read(journal.snapshot, &cp->status);
+        cp->saved_at = (int64_t)time(NULL);
+        cp->checksum = checkpoint_checksum_for(cp, epoch + 1);
+        sync_range(cp, sizeof(*cp), JOURNAL_SYNC_FLAGS);
+        pthread_mutex_unlock(&journal.cp_mutex);
+        
+        // Troca de época: vale se nenhum escritor publicou desde a cópia (todo
+        // registro no diário segue uma publicação do estado)
+        pthread_mutex_lock(journal.writers);
+        pthread_mutex_lock(&journal.cp_mutex);
+        bool current = journal.epoch == epoch &&
+                       parking_snapshot_version(journal.snapshot) == version;
+        if (current) {
+            cp->epoch = epoch + 1;
+            sync_range(&cp->epoch, sizeof(cp->epoch), JOURNAL_SYNC_FLAGS);
+            journal.epoch = epoch + 1;
+            journal.next = 0;
+                }
+        pthread_mutex_unlock(&journal.cp_mutex);
+        pthread_mutex_unlock(journal.writers);
+        
+        if (current) {
+            LOG_DEBUG("JOURNAL", "Checkpoint da época %llu gravado (snapshot)",
+                      (unsigned long long)(epoch + 1));
+            return 0;
+        }
+    }
+    
+    LOG_DEBUG("JOURNAL", "Estado mudou durante %d cópias - checkpoint adiado", CHECKPOINT_ATTEMPTS);
+    return -1;
+}
+
+static void* checkpoint_thread_main(void* arg) {
+    (void)arg;
+    
+    pthread_mutex_lock(&journal.thread_mutex);
+    while (!journal.thread_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += VEHICLE_JOURNAL_CHECKPOINT_S;
+        
+        while (!journal.thread_stop && !journal.checkpoint_requested) {
+            if (pthread_cond_timedwait(&journal.thread_cond, &journal.thread_mutex,
+                                       &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (journal.thread_stop) break;
+        journal.checkpoint_requested = false;
+        
+        pthread_mutex_unlock(&journal.thread_mutex);
+        checkpoint_from_snapshot();
+        pthread_mutex_lock(&journal.thread_mutex);
+    }
+    pthread_mutex_unlock(&journal.thread_mutex);
+    
+    return NULL;
+}
+
+int vehicle_journal_start_checkpoints(const parking_snapshot_t* snapshot, pthread_mutex_t* writers) {
+    if (!journal.open || !snapshot || !writers || journal.thread_running) return -1;
+    
+    journal.snapshot = snapshot;
+    journal.writers = writers;
+    journal.thread_stop = false;
+    journal.checkpoint_requested = false;
+    
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&journal.thread_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    
+    if (pthread_create(&journal.thread, NULL, checkpoint_thread_main, NULL) != 0) {
+        LOG_ERROR("JOURNAL", "Erro ao criar thread de checkpoints");
+        pthread_cond_destroy(&journal.thread_cond);
+        return -1;
+    }
+    
+    journal.thread_running = true;
+    return 0;
+}
+
+void vehicle_journal_stop_checkpoints(void) {
+    if (!journal.thread_running) return;
+    
+    pthread_mutex_lock(&journal.thread_mutex);
+    journal.thread_stop = true;
+    pthread_cond_signal(&journal.thread_cond);
+    pthread_mutex_unlock(&journal.thread_mutex);
+    
+    pthread_join(journal.thread, NULL);
+    pthread_cond_destroy(&journal.thread_cond);
+    journal.thread_running = false;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file vehicle_journal.h
+ * @brief Diário persistente dos veículos (arquivo mapeado, registros fixos)
+ */
+
+#ifndef VEHICLE_JOURNAL_H
+#define VEHICLE_JOURNAL_H
+
+#include "parking_system.h"
+
+/**
+ * @brief Operação registrada no diário
+ */
+typedef enum {
+    VEHICLE_JOURNAL_ENTRY = 1,      // Veículo estacionado (registro em sua vaga)
+    VEHICLE_JOURNAL_EXIT            // Saída com tarifa calculada
+} vehicle_journal_op_t;
+
+/**
+ * @brief Abre (ou cria) o diário e recupera o estado gravado
+ *
+ * Restaura o último checkpoint de parking_status_t e reaplica os registros
+ * gravados depois dele. As funções do diário devem ser chamadas com a trava
+ * dos escritores do estado, exceto as que iniciam e param os checkpoints.
+ *
+ * @param path Caminho do arquivo (diretório criado se não existir)
+ * @param status Estado já iniciado por parking_init; recebe o estado recuperado
+ * @return Número de registros reaplicados, ou -1 se erro (estado intacto)
+ */
+int vehicle_journal_open(const char* path, parking_status_t* status);
+
+/**
+ * @brief Grava um checkpoint final e fecha o diário
+ * @param status Estado atual
+ */
+void vehicle_journal_close(const parking_status_t* status);
+
+/**
+ * @brief Acrescenta um registro de veículo ao diário
+ *
+ * Diário cheio gera antes um checkpoint, que libera todos os registros.
+ *
+ * @param status Estado atual (usado se for preciso um checkpoint)
+ * @param op Operação
+ * @param record Registro do veículo após a operação
+ * @return 0 se sucesso, -1 se diário fechado
+ */
+int vehicle_journal_append(const parking_status_t* status, vehicle_journal_op_t op,
+                           const vehicle_record_t* record);
+
+/**
+ * @brief Grava um checkpoint do estado e recomeça o diário
+ * @param status Estado atual
+ * @return 0 se sucesso, -1 se diário fechado
+ */
+int vehicle_journal_checkpoint(const parking_status_t* status);
+
+/**
+ * @brief Inicia a thread dos checkpoints periódicos (sem a trava dos escritores)
+ *
+ * A cada VEHICLE_JOURNAL_CHECKPOINT_S, ou com o diário a 3/4, copia o
+ * snapshot para o slot livre sem travar os escritores; writers só é tomada
+ * para a troca de época.
+ *
+ * @param snapshot Snapshot do estado (parking_snapshot_attach)
+ * @param writers Trava dos escritores do estado
+ * @return 0 se sucesso, -1 se erro (checkpoints só quando o diário encher)
+ */
+int vehicle_journal_start_checkpoints(const parking_snapshot_t* snapshot, pthread_mutex_t* writers);
+
+/**
+ * @brief Para a thread dos checkpoints; chamar sem a trava dos escritores
+ */
+void vehicle_journal_stop_checkpoints(void);
+
+#endif // VEHICLE_JOURNAL_H
@@ -0,0 +1,169 @@
+/**
+ * @file main.c
+ * @brief Decodificador do log binário (parking_system.binlog -> texto)
+ *
+ * Uso: log_decoder [arquivo...]   (sem argumentos ou "-" lê da entrada padrão)
+ * A saída tem o mesmo formato do parking_system.log.
+ */
+
+#include "log_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_MODULES 256
+#define MAX_FORMATS 65536
+
+static const char* level_names[] = {
+    "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
+};
+
+// Definições vistas até agora (redefinições substituem as anteriores)
+static char* modules[MAX_MODULES];
+static char* formats[MAX_FORMATS];
+
+/**
+ * @brief Guarda uma cópia terminada em '\0'
+ */
+static void define(char** slot, const uint8_t* data, size_t size) {
+    free(*slot);
+    *slot = malloc(size + 1);
+    if (!*slot) {
+        fprintf(stderr, "Sem memória\n");
+        exit(1);
+    }
+    memcpy(*slot, data, size);
+    (*slot)[size] = '\0';
+}
+
+/**
+ * @brief Imprime um EVENT ou TEXT
+ */
+static void print_event(log_record_type_t type, const uint8_t* body, size_t size) {
+    uint64_t ts_us;
+    uint16_t format_id;
+    
+    memcpy(&ts_us, body, 8);
+    uint8_t level = body[8];
+    uint8_t module = body[9];
+    memcpy(&format_id, body + 10, 2);
+    
+    const uint8_t* data = body + LOG_EVENT_HEADER_SIZE;
+    size_t data_size = size - LOG_EVENT_HEADER_SIZE;
+    
+    char message[4096];
+    if (type == LOG_REC_EVENT) {
+        if (!formats[format_id]) {
+            snprintf(message, sizeof(message), "<formato %u não definido>", format_id);
+        } else {
+            log_render(formats[format_id], data, data_size, message, sizeof(message));
+        }
+    } else {
+        size_t n = (data_size < sizeof(message) - 1) ? data_size : sizeof(message) - 1;
+        memcpy(message, data, n);
+        message[n] = '\0';
+    }
+    
+    time_t sec = (time_t)(ts_us / 1000000ULL);
+    struct tm tm_info;
+    localtime_r(&sec, &tm_info);
+    
+    printf("[%04d-%02d-%02d %02d:%02d:%02d.%03u] %s [%s] %s\n",
+           tm_info.tm_year + 1900, tm_info.tm_mon + 1, tm_info.tm_mday,
+           tm_info.tm_hour, tm_info.tm_min, tm_info.tm_sec,
+           (unsigned)((ts_us % 1000000ULL) / 1000),
+           (level < sizeof(level_names) / sizeof(level_names[0])) ? level_names[level] : "?",
+           modules[module] ? modules[module] : "?", message);
+}
+
+/**
+ * @brief Decodifica um arquivo inteiro
+ * @return 0 se sucesso, -1 se o arquivo é inválido ou está truncado
+ */
+static int decode_file(FILE* in, const char* name) {
+    uint8_t header[LOG_BINARY_HEADER_SIZE];
+    
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) ||
+        memcmp(header, LOG_BINARY_MAGIC, 4) != 0) {
+        fprintf(stderr, "%s: não é um log binário\n", name);
+        return -1;
+    }
+    
+    if (header[4] != LOG_BINARY_VERSION) {
+        fprintf(stderr, "%s: versão %u não suportada\n", name, header[4]);
+        return -1;
+    }
+    
+    if (header[5] != log_byte_order()) {
+        fprintf(stderr, "%s: gravado com outra ordem de bytes\n", name);
+        return -1;
+    }
+    
+    // Cada arquivo define seus próprios ids
+    for (int i = 0; i < MAX_MODULES; i++) { free(modules[i]); modules[i] = NULL; }
+    for (int i = 0; i < MAX_FORMATS; i++) { free(formats[i]); formats[i] = NULL; }
+    
+    uint8_t body[UINT16_MAX];
+    uint8_t rec[LOG_RECORD_HEADER_SIZE];
+    
+    while (fread(rec, 1, sizeof(rec), in) == sizeof(rec)) {
+        uint16_t size;
+        memcpy(&size, rec + 1, 2);
+        
+        if (fread(body, 1, size, in) != size) {
+            fprintf(stderr, "%s: registro truncado\n", name);
+            return -1;
+        }
+        
+        switch (rec[0]) {
+            case LOG_REC_MODULE:
+                if (size >= 1) define(&modules[body[0]], body + 1, size - 1);
+                break;
+            case LOG_REC_FORMAT:
+                if (size >= 2) {
+                    uint16_t id;
+                    memcpy(&id, body, 2);
+                    define(&formats[id], body + 2, size - 2);
+                }
+                break;
+            case LOG_REC_EVENT:
+            case LOG_REC_TEXT:
+                if (size >= LOG_EVENT_HEADER_SIZE) {
+                    print_event((log_record_type_t)rec[0], body, size);
+                }
+                break;
+            default:
+                break; // Tipo desconhecido: o tamanho permite pular
+        }
+    }
+    
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int rc = 0;
+    
+    if (argc < 2) {
+        return decode_file(stdin, "stdin") == 0 ? 0 : 1;
+    }
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-") == 0) {
+            rc |= decode_file(stdin, "stdin");
+            continue;
+        }
+        
+        FILE* in = fopen(argv[i], "rb");
+        if (!in) {
+            perror(argv[i]);
+            rc = -1;
+            continue;
+        }
+        
+        rc |= decode_file(in, argv[i]);
+        fclose(in);
+    }
+    
+    return rc == 0 ? 0 : 1;
+}
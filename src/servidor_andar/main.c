@@ -0,0 +1,583 @@
+/**
+ * @file servidor_andar/main.c
+ * @brief Servidor de um andar - controla vagas e detecta passagem entre andares
+ *
+ * Um módulo por andar acima do térreo: sem argumento o processo atende todos
+ * os andares do site.conf; "servidor_andar <andar>" atende só um (um processo
+ * por placa). Cada instância tem o seu socket com a central, a sua sequência
+ * de deltas e o par de sensores da rampa do andar (chave passagem).
+ */
+
+#include "parking_system.h"
+#include "system_logger.h"
+#include "gpio_control.h"
+#include "parking_logic.h"
+#include "site_config.h"
+#include "tcp_communication.h"
+#include "passage_detector.h"
+#include "message_pool.h"
+#include "metrics.h"
+#include "server_module.h"
+
+// =============================================================================
+// VARIÁVEIS GLOBAIS
+// =============================================================================
+
+/**
+ * @brief Estado de um servidor de andar (uma instância por andar)
+ */
+typedef struct {
+    floor_id_t floor;
+    char name[16];                  // Nome do módulo ("andar1", ...)
+    volatile bool running;
+
+    // Estado do processo (server_store): no processo único, o mesmo da central
+    parking_status_t* parking_status;
+    pthread_mutex_t* status_mutex;          // Escritores do estado
+    parking_snapshot_t* status_snapshot;    // Lido pelo envio à central sem status_mutex
+
+    // Socket TCP para servidor central
+    int central_socket;
+    pthread_mutex_t send_mutex;
+
+    // Sequência dos deltas de vagas; snapshot só quando a central pode ter
+    // perdido deltas (ambos protegidos por send_mutex)
+    uint32_t status_seq;
+    bool snapshot_pending;
+
+    // Mensagens geradas sem conexão, reenviadas ao reconectar (send_mutex)
+    tcp_offline_queue_t offline_queue;
+
+    // Estatísticas
+    struct {
+        uint32_t movements_up;      // Carros subindo para o andar de cima
+        uint32_t movements_down;    // Carros descendo para o andar de baixo
+        time_t start_time;
+    } stats;
+
+    // Par de sensores da rampa (-1 se o andar não tem ou o detector falhou)
+    int passage_pair;
+
+    pthread_t thread_gpio_scan;
+    pthread_t thread_tcp;
+    pthread_t thread_passage;
+} floor_server_t;
+
+static floor_server_t floor_servers[MAX_FLOORS];
+static server_module_t floor_modules[MAX_FLOORS];
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+/**
+ * @brief Envia uma mensagem à central (serializa escritas de várias threads)
+ *
+ * Sem conexão, ou se o envio falha, a mensagem vai para a fila offline.
+ *
+ * @return 0 se enviada ou guardada, -1 se perdida
+ */
+static int send_to_central(floor_server_t *server, const system_message_t *msg) {
+    pthread_mutex_lock(&server->send_mutex);
+    int ret = (server->central_socket >= 0) ? tcp_send_message(server->central_socket, msg) : -1;
+    if (ret != 0) {
+        ret = tcp_offline_push(&server->offline_queue, msg);
+    }
+    pthread_mutex_unlock(&server->send_mutex);
+    return ret;
+}
+
+/**
+ * @brief Passa a exigir snapshot (chamar com send_mutex travado)
+ *
+ * Deltas guardados na fila offline ficam obsoletos: o snapshot traz o
+ * estado atual com a sequência corrente.
+ */
+static void require_snapshot(floor_server_t *server) {
+    server->snapshot_pending = true;
+    tcp_offline_discard(&server->offline_queue, MSG_TYPE_SPOT_DELTA);
+}
+
+/**
+ * @brief Envia atualização de vagas para o servidor central
+ *
+ * Normalmente envia só as vagas de changed como delta numerado; o snapshot
+ * completo sai apenas na primeira conexão, após falha de envio, fila offline
+ * cheia, mudanças demais para um delta ou pedido da central. Sem vagas
+ * alteradas funciona como heartbeat com a sequência atual. Sem conexão, o
+ * delta espera na fila offline e sai em ordem na reconexão.
+ *
+ * @param changed Vagas alteradas (NULL = heartbeat)
+ */
+static void send_status_to_central(floor_server_t *server, const spot_mask_t *changed) {
+    // send_mutex mantém a ordem de montagem igual à ordem de envio; o estado
+    // vem do snapshot publicado, sem disputar status_mutex com a varredura
+    pthread_mutex_lock(&server->send_mutex);
+
+    floor_status_t floor;
+    parking_snapshot_read_floor(server->status_snapshot, server->floor, &floor);
+
+    system_message_t msg;
+    bool snapshot = server->snapshot_pending;
+    if (changed && !spot_mask_any(changed, floor.spot_words)) {
+        changed = NULL;
+    }
+
+    if (server->central_socket < 0) {
+        // Com snapshot pendente nada precisa esperar: ele cobrirá a mudança
+        if (!snapshot && changed) {
+            server->status_seq++;
+            if (parking_build_spot_delta(server->floor, &floor, changed, server->status_seq, &msg) < 0 ||
+                tcp_offline_push(&server->offline_queue, &msg) != 0) {
+                require_snapshot(server);
+            }
+        }
+        pthread_mutex_unlock(&server->send_mutex);
+        return;
+    }
+
+    if (!snapshot) {
+        if (changed) {
+            server->status_seq++;
+        }
+        snapshot = parking_build_spot_delta(server->floor, &floor, changed, server->status_seq, &msg) < 0;
+    }
+    if (snapshot) {
+        parking_build_floor_status(server->floor, &floor, server->status_seq, &msg);
+    }
+
+    int ret = (server->central_socket >= 0) ? tcp_send_message(server->central_socket, &msg) : -1;
+
+    if (ret != 0) {
+        // A central pode ter perdido este delta: ressincronizar no próximo envio
+        require_snapshot(server);
+    } else if (snapshot) {
+        server->snapshot_pending = false;
+    }
+    pthread_mutex_unlock(&server->send_mutex);
+
+    if (ret != 0) {
+        LOG_WARN("TCP", "%s: erro ao enviar status para central", server->name);
+    } else if (snapshot) {
+        LOG_DEBUG("TCP", "%s: snapshot enviado à central (seq %u)", server->name,
+                  (unsigned int)msg.data.parking_status.seq);
+    }
+}
+
+/**
+ * @brief Marca que o próximo envio deve ser um snapshot completo
+ */
+static void request_snapshot(floor_server_t *server) {
+    pthread_mutex_lock(&server->send_mutex);
+    require_snapshot(server);
+    pthread_mutex_unlock(&server->send_mutex);
+}
+
+/**
+ * @brief Publica a conexão e reenvia em ordem o que ficou na fila offline
+ *
+ * Na mesma seção de send_mutex: nenhum delta novo passa à frente dos
+ * guardados. Se o reenvio falha, os deltas restantes dão lugar a um snapshot.
+ */
+static void replay_offline_queue(floor_server_t *server, int sock) {
+    pthread_mutex_lock(&server->send_mutex);
+    server->central_socket = sock;
+    int sent = (server->offline_queue.head != server->offline_queue.tail)
+        ? tcp_offline_replay(&server->offline_queue, sock) : 0;
+    if (sent < 0) {
+        require_snapshot(server);
+    }
+    pthread_mutex_unlock(&server->send_mutex);
+
+    if (sent > 0) {
+        LOG_INFO("TCP", "%s: %d mensagens da fila offline reenviadas à central", server->name, sent);
+    } else if (sent < 0) {
+        LOG_WARN("TCP", "%s: falha ao reenviar a fila offline - ressincronizando", server->name);
+    }
+}
+
+/**
+ * @brief Fecha a conexão com a central (reconectada pela thread TCP)
+ */
+static void disconnect_from_central(floor_server_t *server) {
+    pthread_mutex_lock(&server->send_mutex);
+    tcp_close_connection(server->central_socket);
+    server->central_socket = -1;
+    pthread_mutex_unlock(&server->send_mutex);
+}
+
+/**
+ * @brief Envia à central o resumo das métricas deste processo
+ *
+ * Sem conexão o resumo é descartado: o próximo já traz valores atuais. No
+ * processo único a central lê o mesmo registro e nada é enviado.
+ */
+static void send_metrics_to_central(floor_server_t *server) {
+#ifndef PARKING_SINGLE_PROCESS
+    system_message_t msg;
+    metrics_build_message(server->floor, &msg);
+
+    pthread_mutex_lock(&server->send_mutex);
+    if (server->central_socket >= 0) {
+        tcp_send_message(server->central_socket, &msg);
+    }
+    pthread_mutex_unlock(&server->send_mutex);
+    system_message_release(&msg);
+#else
+    (void)server;
+#endif
+}
+
+/**
+ * @brief Contabiliza e notifica uma passagem pela rampa do andar
+ *
+ * Com um andar acima, a rampa liga os dois: S1 -> S2 sobe e S2 -> S1 desce.
+ * No último andar ela só leva ao de baixo: S1 -> S2 desce e o sentido
+ * inverso (entrada, já contada pelo andar de baixo) é ignorado.
+ */
+static void report_passage(floor_server_t *server, const passage_event_t *event) {
+    floor_id_t floor = server->floor;
+    bool forward = (event->direction == PASSAGE_FORWARD);
+    bool has_above = site_floor((floor_id_t)(floor + 1)) != NULL;
+    floor_id_t from, to;
+
+    if (has_above) {
+        from = forward ? floor : (floor_id_t)(floor + 1);
+        to = forward ? (floor_id_t)(floor + 1) : floor;
+    } else if (forward) {
+        from = floor;
+        to = (floor_id_t)(floor - 1);
+    } else {
+        LOG_DEBUG("PASSAGE", "Passagem %s -> %s ignorada",
+                  site_floor_name((floor_id_t)(floor - 1)), site_floor_name(floor));
+        return;
+    }
+
+    if (to > from) {
+        server->stats.movements_up++;
+    } else {
+        server->stats.movements_down++;
+    }
+    LOG_INFO("PASSAGE", "Movimento detectado: %s -> %s", site_floor_name(from), site_floor_name(to));
+
+    // Notificar a central (guardada na fila offline se não houver conexão)
+    system_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MSG_TYPE_PASSAGE_DETECTED;
+    msg.timestamp = (time_t)(event->time_us / 1000000u);
+    msg.data.passage.from_floor = from;
+    msg.data.passage.to_floor = to;
+    strcpy(msg.data.passage.plate, ""); // Placa desconhecida na passagem
+
+    send_to_central(server, &msg);
+}
+
+// =============================================================================
+// THREADS DE CONTROLE
+// =============================================================================
+
+/**
+ * @brief Thread de varredura de vagas
+ */
+static void* gpio_scan_thread(void* arg) {
+    floor_server_t *server = (floor_server_t*)arg;
+    floor_id_t floor = server->floor;
+    floor_status_t *status = &server->parking_status->floors[floor];
+
+    LOG_INFO("THREAD", "%s: thread de varredura de vagas iniciada", server->name);
+
+    // Andar conferido por server_run antes do start
+    const gpio_floor_config_t* config = &site_floor(floor)->gpio;
+
+    // Com alertas a thread só acorda por mudança; sem eles, varredura periódica
+    bool event_driven = GPIO_EVENT_DRIVEN && gpio_sensor_events_enable(config) == 0;
+    if (!event_driven) {
+        LOG_INFO("THREAD", "%s: sensores de vaga por varredura a cada %d ms",
+                 server->name, GPIO_SCAN_INTERVAL_MS);
+    }
+
+    while (server->running) {
+        int changes;
+
+        if (event_driven) {
+            gpio_sensor_event_t events[MAX_PARKING_SPOTS_PER_FLOOR];
+            int count = gpio_sensor_sweep(config, events, MAX_PARKING_SPOTS_PER_FLOOR,
+                                          GPIO_SCAN_INTERVAL_MS);
+            if (count < 0) {
+                LOG_WARN("THREAD", "%s: alertas do sensor indisponíveis - voltando à varredura",
+                         server->name);
+                event_driven = false;
+                continue;
+            }
+
+            // Mesmo sem eventos: vagas com filtro pendente podem vencer a janela
+            pthread_mutex_lock(server->status_mutex);
+            changes = parking_apply_sensor_events(floor, status, events, count);
+        } else {
+            pthread_mutex_lock(server->status_mutex);
+            changes = parking_scan_floor(floor, config, status);
+        }
+
+        if (changes > 0) {
+            parking_update_total_stats(server->parking_status);
+            spot_mask_t changed = status->changed_mask;
+            pthread_mutex_unlock(server->status_mutex);
+
+            // Notificar central apenas sobre as vagas que mudaram
+            send_status_to_central(server, &changed);
+        } else {
+            pthread_mutex_unlock(server->status_mutex);
+        }
+
+        if (!event_driven) {
+            usleep(GPIO_SCAN_INTERVAL_MS * 1000);
+        }
+    }
+
+    gpio_sensor_events_disable(config);
+
+    LOG_INFO("THREAD", "%s: thread de varredura finalizada", server->name);
+    return NULL;
+}
+
+/**
+ * @brief Thread de comunicação com servidor central
+ */
+static void* tcp_client_thread(void* arg) {
+    floor_server_t *server = (floor_server_t*)arg;
+
+    LOG_INFO("THREAD", "%s: thread TCP cliente iniciada", server->name);
+
+    tcp_reconnect_t reconnect = TCP_RECONNECT_INIT;
+    uint64_t metrics_due_us = metrics_now_us() + METRICS_EXPORT_INTERVAL_MS * 1000ull;
+
+    while (server->running) {
+        // Conexão sem bloquear: backoff com jitter entre tentativas, e cada
+        // volta do laço espera no máximo TCP_RECONNECT_POLL_MS
+        if (server->central_socket < 0) {
+            int sock = tcp_client_reconnect(&reconnect, SERVER_CENTRAL_IP, SERVER_CENTRAL_PORT,
+                                            TCP_RECONNECT_POLL_MS);
+            if (sock < 0) continue;
+
+            LOG_INFO("TCP", "%s: conectado ao servidor central", server->name);
+            replay_offline_queue(server, sock);
+
+            // Snapshot pendente, ou heartbeat que confirma a sequência atual
+            send_status_to_central(server, NULL);
+        }
+
+        // Heartbeat (delta vazio) só com a conexão ociosa: qualquer envio já
+        // mostra à central que o andar está vivo
+        int idle = tcp_idle_ms(server->central_socket);
+        if (idle >= TCP_HEARTBEAT_INTERVAL_MS) {
+            replay_offline_queue(server, server->central_socket);
+            send_status_to_central(server, NULL);
+            idle = 0;
+        }
+
+        uint64_t now_us = metrics_now_us();
+        if (now_us >= metrics_due_us) {
+            send_metrics_to_central(server);
+            metrics_due_us = now_us + METRICS_EXPORT_INTERVAL_MS * 1000ull;
+        }
+
+        // Aguardar mensagens da central até o próximo heartbeat
+        system_message_t cmd;
+        int ret = tcp_wait_message(server->central_socket, &cmd, TCP_HEARTBEAT_INTERVAL_MS - idle);
+        if (ret < 0) {
+            LOG_WARN("TCP", "%s: conexão com a central perdida", server->name);
+            disconnect_from_central(server);
+        } else if (ret > 0 && cmd.type == MSG_TYPE_SYSTEM_STATUS) {
+            // Central detectou lacuna na sequência de deltas
+            LOG_INFO("TCP", "%s: central solicitou ressincronização", server->name);
+            request_snapshot(server);
+            send_status_to_central(server, NULL);
+        } else if (ret > 0 && cmd.type == MSG_TYPE_LOG_LEVEL) {
+            // Central alterou o nível de log de um módulo
+            logger_set_module_level(cmd.data.log_level.module, cmd.data.log_level.level);
+        }
+
+        if (ret > 0) {
+            system_message_release(&cmd);
+        }
+    }
+
+    tcp_client_reconnect_abort(&reconnect);
+
+    LOG_INFO("THREAD", "%s: thread TCP cliente finalizada", server->name);
+    return NULL;
+}
+
+/**
+ * @brief Thread das passagens da rampa (bordas tratadas pelo detector)
+ */
+static void* passage_thread(void* arg) {
+    floor_server_t *server = (floor_server_t*)arg;
+
+    LOG_INFO("THREAD", "%s: thread de passagens iniciada", server->name);
+
+    while (server->running) {
+        passage_event_t events[PASSAGE_EVENT_QUEUE];
+        int count = passage_detector_wait(server->passage_pair, events, PASSAGE_EVENT_QUEUE, 1000);
+        if (count < 0) {
+            sleep(1);
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            report_passage(server, &events[i]);
+        }
+    }
+
+    LOG_INFO("THREAD", "%s: thread de passagens finalizada", server->name);
+    return NULL;
+}
+
+// =============================================================================
+// MÓDULO
+// =============================================================================
+
+static int andar_start(void* context) {
+    floor_server_t *server = (floor_server_t*)context;
+    const site_floor_t *site = site_floor(server->floor);
+
+    LOG_INFO("MAIN", "═══════════════════════════════════════════════════");
+    LOG_INFO("MAIN", "  SERVIDOR %s - Sistema de Estacionamento", site->name);
+    LOG_INFO("MAIN", "  Versão: %s", SYSTEM_VERSION);
+    LOG_INFO("MAIN", "═══════════════════════════════════════════════════");
+
+    server->running = true;
+    server->stats.start_time = time(NULL);
+
+    // Inicializar lógica de estacionamento
+    // Estado já iniciado por server_run; a varredura só escreve este andar
+    const server_store_t* store = server_store();
+    server->parking_status = store->status;
+    server->status_mutex = store->mutex;
+    server->status_snapshot = store->snapshot;
+
+    // Sensores de passagem da rampa (chave passagem do site.conf)
+    server->passage_pair = -1;
+    if (site->has_passage) {
+        server->passage_pair = passage_detector_add_pair(site->passage_pins[0], site->passage_pins[1]);
+        if (server->passage_pair < 0) {
+            LOG_ERROR("MAIN", "%s: falha ao inicializar detector de passagem", server->name);
+        }
+    } else {
+        LOG_INFO("MAIN", "%s: sem sensores de passagem no site.conf", server->name);
+    }
+
+    // Criar threads
+    pthread_create(&server->thread_gpio_scan, NULL, gpio_scan_thread, server);
+    pthread_create(&server->thread_tcp, NULL, tcp_client_thread, server);
+    if (server->passage_pair >= 0) {
+        pthread_create(&server->thread_passage, NULL, passage_thread, server);
+    }
+
+    LOG_INFO("MAIN", "%s: todas as threads iniciadas - sistema operacional", server->name);
+    return 0;
+}
+
+static void andar_stop(void* context) {
+    floor_server_t *server = (floor_server_t*)context;
+
+    server->running = false;
+
+    // Aguardar threads finalizarem
+    pthread_join(server->thread_gpio_scan, NULL);
+    pthread_join(server->thread_tcp, NULL);
+    if (server->passage_pair >= 0) {
+        pthread_join(server->thread_passage, NULL);
+    }
+
+    // Exibir estatísticas finais
+    time_t uptime = time(NULL) - server->stats.start_time;
+    LOG_INFO("MAIN", "═══════════════════════════════════════════════════");
+    LOG_INFO("MAIN", "  ESTATÍSTICAS FINAIS - %s", site_floor_name(server->floor));
+    LOG_INFO("MAIN", "  Tempo de operação: %ld segundos", uptime);
+    LOG_INFO("MAIN", "  Movimentos subindo: %u", server->stats.movements_up);
+    LOG_INFO("MAIN", "  Movimentos descendo: %u", server->stats.movements_down);
+    LOG_INFO("MAIN", "═══════════════════════════════════════════════════");
+
+    if (server->central_socket >= 0) {
+        disconnect_from_central(server);
+    }
+
+    LOG_INFO("MAIN", "Servidor %s finalizado", site_floor_name(server->floor));
+}
+
+const server_module_t* servidor_andar_module(floor_id_t floor) {
+    if (floor < FLOOR_ANDAR1 || !site_floor(floor)) {
+        return NULL;
+    }
+
+    // Montado na primeira chamada, antes de server_run criar threads
+    server_module_t *module = &floor_modules[floor];
+    if (!module->context) {
+        floor_server_t *server = &floor_servers[floor];
+        server->floor = floor;
+        snprintf(server->name, sizeof(server->name), "andar%d", (int)floor);
+        server->central_socket = -1;
+        server->snapshot_pending = true;
+        server->passage_pair = -1;
+        pthread_mutex_init(&server->send_mutex, NULL);
+
+        module->name = server->name;
+        module->uses = SERVER_USES_GPIO | SERVER_USES_PASSAGE;
+        module->floor = floor;
+        module->context = server;
+        module->start = andar_start;
+        module->stop = andar_stop;
+        module->console = NULL;
+    }
+    return module;
+}
+
+// =============================================================================
+// FUNÇÃO PRINCIPAL
+// =============================================================================
+
+#ifndef PARKING_SINGLE_PROCESS
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        fprintf(stderr, "Uso: %s [andar]\n", argv[0]);
+        return 1;
+    }
+
+    // Topologia antes da lista: os andares vêm do site.conf
+    if (server_init() != 0) {
+        return 1;
+    }
+
+    const server_module_t* modules[MAX_FLOORS];
+    int count = 0;
+
+    if (argc == 2) {
+        // Um andar por processo
+        char* end;
+        long floor = strtol(argv[1], &end, 10);
+        const server_module_t* module = (*argv[1] && *end == '\0' && floor >= FLOOR_ANDAR1 &&
+                                         floor < MAX_FLOORS)
+            ? servidor_andar_module((floor_id_t)floor) : NULL;
+        if (!module) {
+            LOG_FATAL("MAIN", "Andar '%s' inválido: o site.conf declara %d andar(es), "
+                      "e o térreo (0) é do servidor_terreo", argv[1], site_floor_count());
+            logger_cleanup();
+            return 1;
+        }
+        modules[count++] = module;
+    } else {
+        // Todos os andares acima do térreo neste processo
+        for (int floor = FLOOR_ANDAR1; floor < site_floor_count(); floor++) {
+            modules[count++] = servidor_andar_module((floor_id_t)floor);
+        }
+        if (count == 0) {
+            LOG_FATAL("MAIN", "O site.conf não declara andares acima do térreo");
+            logger_cleanup();
+            return 1;
+        }
+    }
+
+    return server_run(modules, count);
+}
+#endif
@@ -3,23 +3,313 @@
 #include "gpio_control.h"
 #include "gate_control.h"
 #include "parking_logic.h"
+#include "site_config.h"
 #include "modbus_client.h"
 #include "tcp_communication.h"
-#include <signal.h>
+#include "vehicle_journal.h"
+#include "tariff.h"
+#include "message_pool.h"
+#include "metrics.h"
+#include "server_module.h"
 
 static volatile bool running = true;
 
-// Estado global do estacionamento
-static parking_status_t g_parking_status;
+// Estado global do estacionamento (server_store; no processo único os
+// andares varrem direto nele)
+static parking_status_t *g_parking_status;
 
-// mutex para recursos compartilhados
-static pthread_mutex_t status_mutex = PTHREAD_MUTEX_INITIALIZER;
+// mutex para recursos compartilhados (escritores do estado)
+static pthread_mutex_t *status_mutex;
+
+// Cópia publicada a cada atualização; o menu lê daqui sem travar a ingestão
+static parking_snapshot_t *g_status_snapshot;
+
+// Cópia lida do snapshot pelos comandos do menu (só a thread do menu usa)
+static parking_status_t g_console_status;
+
+// Thread do loop de eventos TCP (recebe atualizações dos andares)
+static pthread_t tcp_thread;
+static bool tcp_thread_started = false;
+
+// No processo único os andares varrem direto em g_parking_status: snapshots e
+// deltas só acompanham a sequência (reaplicar um atrasado desfaria a varredura)
+#ifdef PARKING_SINGLE_PROCESS
+#define FLOORS_SHARE_STATUS 1
+#else
+#define FLOORS_SHARE_STATUS 0
+#endif
+
+// Sincronização dos deltas por andar (protegido por status_mutex)
+static struct {
+    bool synced;            // Snapshot recebido e sequência contínua
+    bool resync_requested;  // Pedido de snapshot já enviado
+    uint32_t seq;           // Último delta aplicado
+} floor_sync[MAX_FLOORS];
+
+// Último resumo de métricas de cada andar (só a thread do loop TCP acessa)
+static metrics_report_t floor_metrics[MAX_FLOORS];
+static bool floor_metrics_valid[MAX_FLOORS];
 
 /* ========================================================================== */
-static void handle_signal(int sig) {
-    (void)sig;
-    running = false;
-    LOG_WARN("MAIN", "Sinal de término recebido. Encerrando...");
+/**
+ * @brief Pede ao andar um snapshot completo (uma vez por lacuna)
+ * @note Chamar com status_mutex travado
+ */
+static void request_floor_resync(tcp_connection_t *conn, floor_id_t floor) {
+    floor_sync[floor].synced = false;
+    if (floor_sync[floor].resync_requested) return;
+
+    system_message_t req;
+    memset(&req, 0, sizeof(req));
+    req.type = MSG_TYPE_SYSTEM_STATUS;
+    req.timestamp = time(NULL);
+
+    if (tcp_connection_send_system(conn, &req) == 0) {
+        floor_sync[floor].resync_requested = true;
+    }
+}
+
+/**
+ * @brief Aplica um delta de vagas, verificando a sequência
+ *
+ * Deltas com vagas avançam a sequência em 1; deltas vazios (heartbeat)
+ * repetem a última. Qualquer outro valor é lacuna e exige um snapshot.
+ */
+static void apply_floor_delta(const system_message_t *msg, tcp_connection_t *conn) {
+    floor_id_t floor = msg->data.spot_delta.floor;
+    if (floor >= g_parking_status->num_floors) {
+        LOG_WARN("TCP", "Delta de andar fora da topologia (%d)", floor);
+        return;
+    }
+
+    pthread_mutex_lock(status_mutex);
+
+    uint32_t expected = floor_sync[floor].seq + (msg->data.spot_delta.count > 0 ? 1 : 0);
+
+    if (!floor_sync[floor].synced || msg->data.spot_delta.seq != expected) {
+        if (floor_sync[floor].synced) {
+            LOG_WARN("TCP", "Lacuna nos deltas do andar %d (esperado %u, recebido %u)",
+                     floor, (unsigned int)expected, (unsigned int)msg->data.spot_delta.seq);
+        }
+        request_floor_resync(conn, floor);
+        pthread_mutex_unlock(status_mutex);
+        return;
+    }
+
+    floor_status_t *fs = &g_parking_status->floors[floor];
+    if (!FLOORS_SHARE_STATUS && parking_apply_spot_delta(fs, msg) < 0) {
+        LOG_WARN("TCP", "Delta inválido do andar %d", floor);
+        request_floor_resync(conn, floor);
+        pthread_mutex_unlock(status_mutex);
+        return;
+    }
+
+    floor_sync[floor].seq = msg->data.spot_delta.seq;
+    if (!FLOORS_SHARE_STATUS && msg->data.spot_delta.count > 0) {
+        parking_update_total_stats(g_parking_status);
+        LOG_DEBUG("TCP", "Delta andar %d seq %u: %u vagas, %u livres, %u carros",
+                  floor, (unsigned int)msg->data.spot_delta.seq, msg->data.spot_delta.count,
+                  fs->total_free, fs->cars_count);
+    }
+
+    pthread_mutex_unlock(status_mutex);
+}
+
+/**
+ * @brief Responde a um pedido de entrada/saída do térreo (thread do loop)
+ *
+ * Entrada: abre o ticket da placa se houver vaga (anônimo entra sem ticket).
+ * Saída: encerra o ticket e informa a tarifa; placa desconhecida sai sem
+ * cobrança para não prender a cancela. As vagas não são tocadas: a ocupação
+ * vem só dos sensores dos andares. Um checkout adiado pelo térreo (saída
+ * liberada sem resposta) chega com accepted e é cobrado até o horário do
+ * pedido.
+ */
+static void handle_vehicle_request(const system_message_t *req, tcp_connection_t *conn) {
+    const char *plate = req->data.vehicle_event.plate;
+    system_message_t reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.type = req->data.vehicle_event.is_exit ? MSG_TYPE_EXIT_OK : MSG_TYPE_ENTRY_OK;
+    reply.timestamp = time(NULL);
+    memcpy(reply.data.vehicle_event.plate, plate, sizeof(reply.data.vehicle_event.plate));
+    reply.data.vehicle_event.confidence = req->data.vehicle_event.confidence;
+    reply.data.vehicle_event.floor = req->data.vehicle_event.floor;
+    reply.data.vehicle_event.is_exit = req->data.vehicle_event.is_exit;
+    bool deferred = req->data.vehicle_event.is_exit && req->data.vehicle_event.accepted;
+
+    pthread_mutex_lock(status_mutex);
+    if (!req->data.vehicle_event.is_exit) {
+        if (g_parking_status->system_full) {
+            LOG_WARN("TCP", "Estacionamento lotado - entrada de %s recusada",
+                     plate[0] ? plate : "sem placa");
+        } else if (plate[0] == '\0') {
+            reply.data.vehicle_event.accepted = true;
+        } else {
+            const vehicle_record_t *rec = parking_open_ticket(g_parking_status, plate);
+            if (rec) {
+                reply.data.vehicle_event.accepted = true;
+                reply.data.vehicle_event.ticket_id = rec->ticket_id;
+                vehicle_journal_append(g_parking_status, VEHICLE_JOURNAL_ENTRY, rec);
+            }
+        }
+    } else {
+        vehicle_record_t rec;
+        reply.data.vehicle_event.accepted = true;
+        if (plate[0] != '\0' && parking_checkout_vehicle(g_parking_status, plate, &rec)) {
+            // Cobrar até o pedido (checkout adiado chega bem depois da saída)
+            if (req->timestamp > rec.entry_time && req->timestamp < rec.exit_time) {
+                rec.exit_time = req->timestamp;
+            }
+            reply.data.vehicle_event.ticket_id = rec.ticket_id;
+            reply.data.vehicle_event.amount_cents = parking_calculate_fee(rec.entry_time, rec.exit_time);
+            rec.amount_cents = reply.data.vehicle_event.amount_cents;
+            rec.paid = true;
+            vehicle_journal_append(g_parking_status, VEHICLE_JOURNAL_EXIT, &rec);
+        } else if (deferred) {
+            // O pedido original chegou antes e já encerrou o ticket
+            LOG_INFO("TCP", "Checkout adiado de %s já processado", plate);
+        } else {
+            LOG_WARN("TCP", "Saída sem registro de entrada (%s) - liberada sem cobrança",
+                     plate[0] ? plate : "sem placa");
+        }
+    }
+    pthread_mutex_unlock(status_mutex);
+
+    if (tcp_connection_send_system(conn, &reply) != 0) {
+        LOG_WARN("TCP", "Falha ao responder pedido de %s de %s",
+                 req->data.vehicle_event.is_exit ? "saída" : "entrada", conn->address);
+    }
+
+    if (req->data.vehicle_event.is_exit) {
+        LOG_INFO("TCP", "Saída%s %s: ticket %u, R$ %.2f", deferred ? " (checkout adiado)" : "",
+                 plate[0] ? plate : "sem placa",
+                 (unsigned int)reply.data.vehicle_event.ticket_id,
+                 reply.data.vehicle_event.amount_cents / 100.0);
+    } else {
+        LOG_INFO("TCP", "Entrada %s %s (ticket %u)", plate[0] ? plate : "sem placa",
+                 reply.data.vehicle_event.accepted ? "liberada" : "recusada",
+                 (unsigned int)reply.data.vehicle_event.ticket_id);
+    }
+}
+
+/**
+ * @brief Aplica no estado global uma mensagem recebida dos andares
+ *
+ * Executa na thread do loop de eventos; o menu nunca bloqueia a ingestão.
+ */
+static void on_floor_message(const tcp_message_t *message, tcp_connection_t *conn) {
+    system_message_t msg;
+    if (tcp_decode_message(message, &msg) != 0) {
+        LOG_WARN("TCP", "Mensagem inválida de %s:%d: %s",
+                 conn->address, conn->port, message->data);
+        return;
+    }
+
+    switch (msg.type) {
+        case MSG_TYPE_PARKING_STATUS: {
+            floor_id_t floor = msg.data.parking_status.floor;
+            unsigned int pne = msg.data.parking_status.free_pne;
+            unsigned int idoso = msg.data.parking_status.free_idoso;
+            unsigned int comum = msg.data.parking_status.free_comum;
+            unsigned int cars = msg.data.parking_status.cars;
+
+            if (floor >= g_parking_status->num_floors ||
+                msg.data.parking_status.num_spots != g_parking_status->floors[floor].num_spots) {
+                LOG_WARN("TCP", "Status do andar %d não confere com a topologia (%u vagas)",
+                         floor, msg.data.parking_status.num_spots);
+                break;
+            }
+
+            // Snapshot: ocupação por vaga define o estado; deltas seguem de seq
+            pthread_mutex_lock(status_mutex);
+            floor_status_t *fs = &g_parking_status->floors[floor];
+            if (!FLOORS_SHARE_STATUS) {
+                parking_apply_occupied_mask(fs, &msg.data.parking_status.occupied, msg.timestamp);
+                parking_update_total_stats(g_parking_status);
+            }
+            floor_sync[floor].synced = true;
+            floor_sync[floor].resync_requested = false;
+            floor_sync[floor].seq = msg.data.parking_status.seq;
+            pthread_mutex_unlock(status_mutex);
+
+            if (!FLOORS_SHARE_STATUS &&
+                (fs->free_pne != pne || fs->free_idoso != idoso ||
+                 fs->free_comum != comum || fs->cars_count != cars)) {
+                LOG_WARN("TCP", "Contadores do andar %d divergem da ocupação por vaga", floor);
+            }
+
+            LOG_DEBUG("TCP", "Status andar %d (seq %u): %u PNE, %u Idoso+, %u Comuns, %u carros",
+                      floor, (unsigned int)msg.data.parking_status.seq, pne, idoso, comum, cars);
+            break;
+        }
+
+        case MSG_TYPE_SPOT_DELTA:
+            apply_floor_delta(&msg, conn);
+            break;
+
+        case MSG_TYPE_PASSAGE_DETECTED:
+            LOG_INFO("TCP", "Passagem detectada: andar %d -> andar %d",
+                     msg.data.passage.from_floor, msg.data.passage.to_floor);
+            break;
+
+        case MSG_TYPE_VEHICLE_DETECTED:
+            handle_vehicle_request(&msg, conn);
+            break;
+
+        case MSG_TYPE_ENTRY_OK:
+        case MSG_TYPE_EXIT_OK:
+            LOG_INFO("TCP", "Veículo %s %s (andar %d)",
+                     msg.data.vehicle_event.plate,
+                     msg.type == MSG_TYPE_ENTRY_OK ? "entrou" : "saiu",
+                     msg.data.vehicle_event.floor);
+            break;
+
+        case MSG_TYPE_METRICS: {
+            // Resumo copiado para fora do pool: o slot volta junto da mensagem
+            const metrics_report_t *report = message_metrics_get(msg.data.metrics.report);
+            if (report && msg.data.metrics.floor < MAX_FLOORS) {
+                floor_metrics[msg.data.metrics.floor] = *report;
+                floor_metrics_valid[msg.data.metrics.floor] = true;
+            }
+            break;
+        }
+
+        case MSG_TYPE_ERROR:
+            LOG_WARN("TCP", "Erro %d reportado por %s:%d: %s", msg.data.error_info.error_code,
+                     conn->address, conn->port, message_text_get(msg.data.error_info.text));
+            break;
+
+        default:
+            LOG_DEBUG("TCP", "Mensagem tipo %d ignorada", msg.type);
+            break;
+    }
+
+    system_message_release(&msg);
+}
+
+/**
+ * @brief Texto de "GET /metrics": métricas da central e resumos dos andares
+ * @note Executado pela thread do loop TCP
+ */
+static int format_scrape(char *out, size_t size) {
+    int len = metrics_format(out, size);
+    if (len < 0) return -1;
+
+    const metrics_report_t *reports[MAX_FLOORS];
+    for (int i = 0; i < MAX_FLOORS; i++) {
+        reports[i] = floor_metrics_valid[i] ? &floor_metrics[i] : NULL;
+    }
+
+    int floors_len = metrics_format_floors(reports, MAX_FLOORS, out + len, size - (size_t)len);
+    return (floors_len < 0) ? -1 : len + floors_len;
+}
+
+static void* tcp_server_thread(void* arg) {
+    (void)arg;
+    LOG_INFO("THREAD", "Thread do servidor TCP iniciada");
+    tcp_run_loop();
+    LOG_INFO("THREAD", "Thread do servidor TCP finalizada");
+    return NULL;
 }
 
 /* ========================================================================== */
@@ -32,36 +322,45 @@ static void print_menu(void) {
     printf("5 - Fechar cancela de entrada\n");
     printf("6 - Abrir cancela de saída\n");
     printf("7 - Fechar cancela de saída\n");
+    printf("8 - Nível de log por módulo\n");
+    printf("9 - Tickets em aberto (tarifa até agora)\n");
     printf("0 - Sair\n");
     printf("Selecione: ");
     fflush(stdout);
 }
 
+/**
+ * @brief Descarta o resto da linha digitada (para também no fim da entrada)
+ */
+static void discard_line(void) {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
+
 /* ========================================================================== */
 static void cmd_show_status(void) {
-    pthread_mutex_lock(&status_mutex);
-    parking_print_status(&g_parking_status); 
-    pthread_mutex_unlock(&status_mutex);
+    parking_snapshot_read(g_status_snapshot, &g_console_status);
+    parking_print_status(&g_console_status); 
 }
 
 static void cmd_list_floor_spots(void) {
     int floor;
-    printf("Andar (0-%d): ", MAX_FLOORS - 1);
+    printf("Andar (0-%d): ", site_floor_count() - 1);
     if (scanf("%d", &floor) != 1) { 
-        while (getchar()!='\n'); 
+        discard_line(); 
         return; 
     }
-    if (floor < 0 || floor >= MAX_FLOORS) {
+    if (floor < 0 || floor >= site_floor_count()) {
         printf("Andar inválido.\n");
         return;
     }
     
-    pthread_mutex_lock(&status_mutex);
-    
     // CORRIGIDO: usar total_free em vez de free_spots
-    floor_status_t *fs = &g_parking_status.floors[floor];
-    printf("-- Andar %d -- Livre: %u  Bloqueado: %s\n", 
-           floor, fs->total_free, fs->blocked?"SIM":"NÃO");
+    floor_status_t floor_copy;
+    parking_snapshot_read_floor(g_status_snapshot, (floor_id_t)floor, &floor_copy);
+    const floor_status_t *fs = &floor_copy;
+    printf("-- Andar %d (%s) -- Livre: %u  Bloqueado: %s\n", 
+           floor, site_floor_name((floor_id_t)floor), fs->total_free, fs->blocked?"SIM":"NÃO");
     
     printf("   Por tipo: %u PNE | %u Idoso+ | %u Comuns\n",
            fs->free_pne, fs->free_idoso, fs->free_comum);
@@ -69,37 +368,36 @@ static void cmd_list_floor_spots(void) {
     printf("   Carros: %u\n\n", fs->cars_count);
     
     for (int i = 0; i < fs->num_spots; i++) {
-        parking_spot_t *sp = &fs->spots[i];
+        parking_spot_t sp;
+        parking_get_spot(fs, (uint16_t)i, &sp);
         printf("  Vaga %d (%s): %s", 
                i, 
-               spot_type_to_string(sp->type),
-               sp->occupied ? "OCUPADA" : "LIVRE");
+               spot_type_to_string(sp.type),
+               sp.occupied ? "OCUPADA" : "LIVRE");
         
-        if (sp->occupied && strlen(sp->plate) > 0) {
-            printf(" - Placa: %s", sp->plate);
+        if (sp.occupied && strlen(sp.plate) > 0) {
+            printf(" - Placa: %s", sp.plate);
         }
         printf("\n");
     }
-    
-    pthread_mutex_unlock(&status_mutex);
 }
 
 static void cmd_toggle_block_floor(void) {
     int floor; 
-    printf("Andar para (des)bloquear (0-%d): ", MAX_FLOORS - 1);
+    printf("Andar para (des)bloquear (0-%d): ", site_floor_count() - 1);
     if (scanf("%d", &floor) != 1) { 
-        while (getchar()!='\n'); 
+        discard_line(); 
         return; 
     }
-    if (floor < 0 || floor >= MAX_FLOORS) { 
+    if (floor < 0 || floor >= site_floor_count()) { 
         printf("Andar inválido.\n"); 
         return; 
     }
     
-    pthread_mutex_lock(&status_mutex);
-    bool blocked = g_parking_status.floors[floor].blocked;
-    parking_set_floor_blocked(&g_parking_status, (floor_id_t)floor, !blocked);
-    pthread_mutex_unlock(&status_mutex);
+    pthread_mutex_lock(status_mutex);
+    bool blocked = g_parking_status->floors[floor].blocked;
+    parking_set_floor_blocked(g_parking_status, (floor_id_t)floor, !blocked);
+    pthread_mutex_unlock(status_mutex);
     
     LOG_INFO("MAIN", "Andar %d agora %s", floor, blocked?"DESBLOQUEADO":"BLOQUEADO");
 }
@@ -115,44 +413,127 @@ static void cmd_gate_action(gate_type_t type, bool open) {
     }
 }
 
+/**
+ * @brief Ajusta o nível de log de um módulo aqui e em todos os andares
+ *
+ * Módulo "*" altera o nível global; nível DEFAULT remove o ajuste do módulo.
+ */
+static void cmd_set_log_level(void) {
+    char module[LOG_MODULE_MAX];
+    char level_name[16];
+    int level;
+
+    printf("Módulo (ex.: MODBUS, PARKING, * = global): ");
+    if (scanf("%15s", module) != 1) {
+        discard_line();
+        return;
+    }
+    printf("Nível (DEBUG, INFO, WARN, ERROR, FATAL, DEFAULT): ");
+    if (scanf("%15s", level_name) != 1) {
+        discard_line();
+        return;
+    }
+    if (logger_parse_level(level_name, &level) != 0) {
+        printf("Nível inválido.\n");
+        return;
+    }
+    if (logger_set_module_level(module, level) != 0) {
+        printf("Não foi possível alterar o nível (tabela cheia?).\n");
+        return;
+    }
+
+    system_message_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MSG_TYPE_LOG_LEVEL;
+    msg.timestamp = time(NULL);
+    strncpy(msg.data.log_level.module, module, sizeof(msg.data.log_level.module) - 1);
+    msg.data.log_level.level = (int8_t)level;
+
+    if (tcp_broadcast_system(&msg) != 0) {
+        LOG_WARN("MAIN", "Nível de log aplicado apenas localmente");
+    }
+    LOG_INFO("MAIN", "Nível de log de %s: %s", module, logger_level_name(level));
+}
+
 /* ========================================================================== */
-int main(void) {
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
+static void cmd_open_tickets_report(void) {
+    parking_status_t *status = &g_console_status;
+    parking_snapshot_read(g_status_snapshot, status);
+
+    // Tickets contíguos; tariff_fee_batch preenche amount_cents na cópia
+    vehicle_record_t *open = status->vehicles;
+    size_t count = status->indexed_plates;
+
+    tariff_summary_t summary;
+    memset(&summary, 0, sizeof(summary));
+    tariff_fee_batch(tariff_default(), open, count, time(NULL), &summary);
 
-    if (logger_init(LOG_DIR) != 0) {
-        fprintf(stderr, "Falha ao iniciar logger.\n");
-        return 1;
+    char money[32];
+    for (size_t i = 0; i < count; i++) {
+        format_money(open[i].amount_cents, money, sizeof(money));
+        char entry[32];
+        time_to_string(open[i].entry_time, entry, sizeof(entry));
+        printf("Ticket %u  %-8s  entrada %s  %s\n", open[i].ticket_id, open[i].plate, entry, money);
     }
-    logger_set_level(LOG_LEVEL_DEBUG);
+    format_money((uint32_t)summary.total_cents, money, sizeof(money));
+    printf("Total: %u tickets (%u na carência), %s\n", summary.tickets, summary.free_tickets, money);
+}
 
+/* ========================================================================== */
+static int central_start(void* context) {
+    (void)context;
+    
     LOG_INFO("MAIN", "Servidor Central iniciando - versão %s", SYSTEM_VERSION);
 
-    // Inicializa GPIO
-    if (gpio_init() != 0) {
-        LOG_WARN("GPIO", "Falha ao inicializar GPIO (modo MOCK ou erro)");
+    running = true;
+
+    // Estado já iniciado por server_run
+    const server_store_t *store = server_store();
+    g_parking_status = store->status;
+    status_mutex = store->mutex;
+    g_status_snapshot = store->snapshot;
+
+    // Tickets abertos sobrevivem a reinícios: checkpoint + registros do diário
+    pthread_mutex_lock(status_mutex);
+    int journal = vehicle_journal_open(VEHICLE_JOURNAL_PATH, g_parking_status);
+    if (journal < 0) {
+        LOG_WARN("MAIN", "Diário de veículos indisponível - tickets não serão persistidos");
     }
+    pthread_mutex_unlock(status_mutex);
 
-    // Inicializa sistema de cancelas
-    if (gate_system_init() != 0) {
-        LOG_WARN("GATE", "Falha ao inicializar sistema de cancelas");
+    // Checkpoints periódicos fora da thread do loop, a partir do snapshot
+    if (journal >= 0 && vehicle_journal_start_checkpoints(g_status_snapshot, status_mutex) != 0) {
+        LOG_WARN("MAIN", "Checkpoints do diário só quando ele encher");
     }
 
-    // Inicializa lógica de estacionamento
-    parking_init(&g_parking_status);
+    // Servidor TCP: um único loop de eventos atende todos os andares
+    tcp_set_message_callback(on_floor_message);
+    tcp_set_scrape_callback(format_scrape);
+    int server_socket = tcp_server_init(SERVER_CENTRAL_PORT);
+    if (server_socket < 0) { 
+        LOG_ERROR("TCP", "Falha ao iniciar servidor TCP"); 
+    } else if (pthread_create(&tcp_thread, NULL, tcp_server_thread, NULL) != 0) {
+        LOG_ERROR("TCP", "Falha ao criar thread do servidor TCP");
+    } else {
+        tcp_thread_started = true;
+    }
 
-    // TODO: iniciar servidor TCP para receber eventos dos andares
-    // int server_socket = tcp_server_init(SERVER_CENTRAL_PORT);
-    // if (server_socket < 0) { 
-    //     LOG_ERROR("TCP", "Falha ao iniciar servidor TCP"); 
-    // }
+    return 0;
+}
 
-    // Loop principal
+/**
+ * @brief Menu interativo
+ * @return 0 se o operador pediu a saída, -1 se a entrada padrão terminou
+ */
+static int central_console(void* context) {
+    (void)context;
+    
     while (running) {
         print_menu();
         int opt;
         if (scanf("%d", &opt) != 1) {
-            while (getchar()!='\n');
+            if (feof(stdin)) return -1;
+            discard_line();
             continue;
         }
         
@@ -178,21 +559,56 @@ int main(void) {
             case 7: 
                 cmd_gate_action(GATE_EXIT, false); 
                 break;
-            case 0: 
-                running = false; 
+            case 8:
+                cmd_set_log_level();
+                break;
+            case 9:
+                cmd_open_tickets_report();
                 break;
+            case 0: 
+                return 0;
             default: 
                 printf("Opção inválida.\n"); 
                 break;
         }
     }
 
-    LOG_INFO("MAIN", "Encerrando servidor central...");
+    return 0;
+}
 
-    // Cleanup
-    gate_system_cleanup();
-    gpio_cleanup();
-    logger_cleanup();
+static void central_stop(void* context) {
+    (void)context;
     
-    return 0;
-}
\ No newline at end of file
+    running = false;
+
+    LOG_INFO("MAIN", "Encerrando servidor central...");
+
+    if (tcp_thread_started) {
+        tcp_stop_loop();
+        pthread_join(tcp_thread, NULL);
+        tcp_thread_started = false;
+    }
+    tcp_cleanup();
+
+    vehicle_journal_stop_checkpoints();
+    pthread_mutex_lock(status_mutex);
+    vehicle_journal_close(g_parking_status);
+    pthread_mutex_unlock(status_mutex);
+}
+
+const server_module_t servidor_central_module = {
+    .name = "central",
+    .uses = SERVER_USES_GATES,
+    .floor = SERVER_NO_FLOOR,
+    .start = central_start,
+    .stop = central_stop,
+    .console = central_console,
+};
+
+/* ========================================================================== */
+#ifndef PARKING_SINGLE_PROCESS
+int main(void) {
+    const server_module_t* modules[] = { &servidor_central_module };
+    return server_run(modules, 1);
+}
+#endif
\ No newline at end of file
@@ -8,20 +8,35 @@
 #include "gpio_control.h"
 #include "gate_control.h"
 #include "parking_logic.h"
+#include "site_config.h"
 #include "modbus_client.h"
 #include "tcp_communication.h"
-#include <signal.h>
+#include "vehicle_flow.h"
+#include "message_pool.h"
+#include "metrics.h"
+#include "server_module.h"
 
 // =============================================================================
 // VARIÁVEIS GLOBAIS
 // =============================================================================
 
 static volatile bool running = true;
-static parking_status_t g_parking_status;
-static pthread_mutex_t status_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Estado do processo (server_store): no processo único, o mesmo da central
+static parking_status_t* g_parking_status;
+static pthread_mutex_t* status_mutex;           // Escritores do estado
+static parking_snapshot_t* g_status_snapshot;   // Lido pelo envio à central sem status_mutex
 
 // Socket TCP para servidor central
 static int central_socket = -1;
+static pthread_mutex_t send_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Sequência dos deltas de vagas; snapshot só quando a central pode ter
+// perdido deltas (ambos protegidos por send_mutex)
+static uint32_t status_seq = 0;
+static bool snapshot_pending = true;
+
+// Mensagens geradas sem conexão, reenviadas ao reconectar (send_mutex)
+static tcp_offline_queue_t offline_queue;
 
 // Estatísticas
 static struct {
@@ -31,45 +46,199 @@ static struct {
     time_t start_time;
 } stats = {0};
 
-// =============================================================================
-// MANIPULADORES DE SINAL
-// =============================================================================
-
-static void handle_signal(int sig) {
-    (void)sig;
-    running = false;
-    LOG_WARN("MAIN", "Sinal de término recebido");
-}
+static pthread_t thread_gpio_scan;
+static pthread_t thread_tcp;
 
 // =============================================================================
 // FUNÇÕES AUXILIARES
 // =============================================================================
 
 /**
- * @brief Envia status de vagas para o servidor central
+ * @brief Passa a exigir snapshot (chamar com send_mutex travado)
+ *
+ * Deltas guardados na fila offline ficam obsoletos: o snapshot traz o
+ * estado atual com a sequência corrente.
  */
-static void send_status_to_central(void) {
-    if (central_socket < 0) return;
+static void require_snapshot(void) {
+    snapshot_pending = true;
+    tcp_offline_discard(&offline_queue, MSG_TYPE_SPOT_DELTA);
+}
+
+/**
+ * @brief Envia atualização de vagas para o servidor central
+ *
+ * Normalmente envia só as vagas de changed como delta numerado; o snapshot
+ * completo sai apenas na primeira conexão, após falha de envio, fila offline
+ * cheia, mudanças demais para um delta ou pedido da central. Sem vagas
+ * alteradas funciona como heartbeat com a sequência atual. Sem conexão, o
+ * delta espera na fila offline e sai em ordem na reconexão.
+ *
+ * @param changed Vagas alteradas (NULL = heartbeat)
+ */
+static void send_status_to_central(const spot_mask_t *changed) {
+    // send_mutex mantém a ordem de montagem igual à ordem de envio; o estado
+    // vem do snapshot publicado, sem disputar status_mutex com a varredura
+    pthread_mutex_lock(&send_mutex);
     
-    pthread_mutex_lock(&status_mutex);
+    floor_status_t floor;
+    parking_snapshot_read_floor(g_status_snapshot, FLOOR_TERREO, &floor);
     
     system_message_t msg;
-    msg.type = MSG_TYPE_PARKING_STATUS;
-    msg.timestamp = time(NULL);
+    bool snapshot = snapshot_pending;
+    if (changed && !spot_mask_any(changed, floor.spot_words)) {
+        changed = NULL;
+    }
     
-    floor_status_t *floor = &g_parking_status.floors[FLOOR_TERREO];
-    msg.data.parking_status.terreo_pne = floor->free_pne;
-    msg.data.parking_status.terreo_idoso = floor->free_idoso;
-    msg.data.parking_status.terreo_comum = floor->free_comum;
-    msg.data.parking_status.cars_terreo = floor->cars_count;
+    if (central_socket < 0) {
+        // Com snapshot pendente nada precisa esperar: ele cobrirá a mudança
+        if (!snapshot && changed) {
+            status_seq++;
+            if (parking_build_spot_delta(FLOOR_TERREO, &floor, changed, status_seq, &msg) < 0 ||
+                tcp_offline_push(&offline_queue, &msg) != 0) {
+                require_snapshot();
+            }
+        }
+        pthread_mutex_unlock(&send_mutex);
+        return;
+    }
     
-    pthread_mutex_unlock(&status_mutex);
+    if (!snapshot) {
+        if (changed) {
+            status_seq++;
+        }
+        snapshot = parking_build_spot_delta(FLOOR_TERREO, &floor, changed, status_seq, &msg) < 0;
+    }
+    if (snapshot) {
+        parking_build_floor_status(FLOOR_TERREO, &floor, status_seq, &msg);
+    }
+    
+    int ret = (central_socket >= 0) ? tcp_send_message(central_socket, &msg) : -1;
     
-    if (tcp_send_message(central_socket, &msg) != 0) {
+    if (ret != 0) {
+        // A central pode ter perdido este delta: ressincronizar no próximo envio
+        require_snapshot();
+    } else if (snapshot) {
+        snapshot_pending = false;
+    }
+    pthread_mutex_unlock(&send_mutex);
+    
+    if (ret != 0) {
         LOG_WARN("TCP", "Erro ao enviar status para central");
+    } else if (snapshot) {
+        LOG_DEBUG("TCP", "Snapshot enviado à central (seq %u)", (unsigned int)msg.data.parking_status.seq);
     }
 }
 
+/**
+ * @brief Marca que o próximo envio deve ser um snapshot completo
+ */
+static void request_snapshot(void) {
+    pthread_mutex_lock(&send_mutex);
+    require_snapshot();
+    pthread_mutex_unlock(&send_mutex);
+}
+
+/**
+ * @brief Publica a conexão e reenvia em ordem o que ficou na fila offline
+ *
+ * Na mesma seção de send_mutex: nenhum delta novo passa à frente dos
+ * guardados. Se o reenvio falha, os deltas restantes dão lugar a um snapshot.
+ */
+static void replay_offline_queue(int sock) {
+    pthread_mutex_lock(&send_mutex);
+    central_socket = sock;
+    int sent = (offline_queue.head != offline_queue.tail)
+        ? tcp_offline_replay(&offline_queue, sock) : 0;
+    if (sent < 0) {
+        require_snapshot();
+    }
+    pthread_mutex_unlock(&send_mutex);
+    
+    if (sent > 0) {
+        LOG_INFO("TCP", "%d mensagens da fila offline reenviadas à central", sent);
+    } else if (sent < 0) {
+        LOG_WARN("TCP", "Falha ao reenviar a fila offline - ressincronizando");
+    }
+}
+
+/**
+ * @brief Fecha a conexão com a central (reconectada pela thread TCP)
+ */
+static void disconnect_from_central(void) {
+    pthread_mutex_lock(&send_mutex);
+    tcp_close_connection(central_socket);
+    central_socket = -1;
+    pthread_mutex_unlock(&send_mutex);
+}
+
+/**
+ * @brief Envia à central o resumo das métricas deste processo
+ *
+ * Sem conexão o resumo é descartado: o próximo já traz valores atuais. No
+ * processo único a central lê o mesmo registro e nada é enviado.
+ */
+static void send_metrics_to_central(void) {
+#ifndef PARKING_SINGLE_PROCESS
+    system_message_t msg;
+    metrics_build_message(FLOOR_TERREO, &msg);
+    
+    pthread_mutex_lock(&send_mutex);
+    if (central_socket >= 0) {
+        tcp_send_message(central_socket, &msg);
+    }
+    pthread_mutex_unlock(&send_mutex);
+    system_message_release(&msg);
+#endif
+}
+
+/**
+ * @brief Envia um pedido de entrada/saída à central (callback do fluxo)
+ */
+static int send_vehicle_request(const system_message_t *msg) {
+    pthread_mutex_lock(&send_mutex);
+    int ret = -1;
+    if (central_socket >= 0 && tcp_send_message(central_socket, msg) == 0) {
+        // Sem esperar a janela de agrupamento: a cancela aguarda a resposta
+        ret = tcp_flush(central_socket);
+    }
+    pthread_mutex_unlock(&send_mutex);
+    
+    return ret;
+}
+
+/**
+ * @brief Guarda o checkout de uma saída liberada sem resposta (callback do fluxo)
+ *
+ * Vai pela fila offline, em ordem, na reconexão ou no próximo heartbeat; a
+ * central ignora o que o pedido original já tiver encerrado. Fila cheia
+ * abre espaço trocando os deltas guardados por um snapshot.
+ */
+static int defer_vehicle_request(const system_message_t *msg) {
+    pthread_mutex_lock(&send_mutex);
+    int ret = tcp_offline_push(&offline_queue, msg);
+    if (ret != 0) {
+        require_snapshot();
+        ret = tcp_offline_push(&offline_queue, msg);
+    }
+    pthread_mutex_unlock(&send_mutex);
+    
+    return ret;
+}
+
+/**
+ * @brief Contabiliza um veículo concluído pelo fluxo (callback do fluxo)
+ */
+static void on_vehicle_done(const vehicle_flow_span_t *span) {
+    if (!span->accepted) return;
+    
+    if (span->dir == VEHICLE_FLOW_ENTRY) {
+        stats.vehicles_entered++;
+    } else {
+        stats.vehicles_exited++;
+    }
+    stats.gate_operations++;
+}
+
 // =============================================================================
 // THREADS DE CONTROLE
 // =============================================================================
@@ -82,27 +251,56 @@ static void* gpio_scan_thread(void* arg) {
     
     LOG_INFO("THREAD", "Thread de varredura de vagas iniciada");
     
-    const gpio_floor_config_t* config = &GPIO_CONFIGS[FLOOR_TERREO];
+    // Andar conferido por server_run antes do start
+    const gpio_floor_config_t* config = &site_floor(FLOOR_TERREO)->gpio;
+    
+    // Com alertas a thread só acorda por mudança; sem eles, varredura periódica
+    bool event_driven = GPIO_EVENT_DRIVEN && gpio_sensor_events_enable(config) == 0;
+    if (!event_driven) {
+        LOG_INFO("THREAD", "Sensores de vaga por varredura a cada %d ms", GPIO_SCAN_INTERVAL_MS);
+    }
     
     while (running) {
-        pthread_mutex_lock(&status_mutex);
+        int changes;
         
-        int changes = parking_scan_floor(FLOOR_TERREO, config, 
-                                        &g_parking_status.floors[FLOOR_TERREO]);
+        if (event_driven) {
+            gpio_sensor_event_t events[MAX_PARKING_SPOTS_PER_FLOOR];
+            int count = gpio_sensor_sweep(config, events, MAX_PARKING_SPOTS_PER_FLOOR,
+                                          GPIO_SCAN_INTERVAL_MS);
+            if (count < 0) {
+                LOG_WARN("THREAD", "Alertas do sensor indisponíveis - voltando à varredura");
+                event_driven = false;
+                continue;
+            }
+            
+            // Mesmo sem eventos: vagas com filtro pendente podem vencer a janela
+            pthread_mutex_lock(status_mutex);
+            changes = parking_apply_sensor_events(FLOOR_TERREO, &g_parking_status->floors[FLOOR_TERREO],
+                                                  events, count);
+        } else {
+            pthread_mutex_lock(status_mutex);
+            changes = parking_scan_floor(FLOOR_TERREO, config, 
+                                         &g_parking_status->floors[FLOOR_TERREO]);
+        }
         
         if (changes > 0) {
-            parking_update_total_stats(&g_parking_status);
-            pthread_mutex_unlock(&status_mutex);
+            parking_update_total_stats(g_parking_status);
+            spot_mask_t changed = g_parking_status->floors[FLOOR_TERREO].changed_mask;
+            pthread_mutex_unlock(status_mutex);
             
-            // Notificar central sobre mudanças
-            send_status_to_central();
+            // Notificar central apenas sobre as vagas que mudaram
+            send_status_to_central(&changed);
         } else {
-            pthread_mutex_unlock(&status_mutex);
+            pthread_mutex_unlock(status_mutex);
         }
         
-        usleep(GPIO_SCAN_INTERVAL_MS * 1000);
+        if (!event_driven) {
+            usleep(GPIO_SCAN_INTERVAL_MS * 1000);
+        }
     }
     
+    gpio_sensor_events_disable(config);
+    
     LOG_INFO("THREAD", "Thread de varredura finalizada");
     return NULL;
 }
@@ -115,90 +313,113 @@ static void* tcp_client_thread(void* arg) {
     
     LOG_INFO("THREAD", "Thread TCP cliente iniciada");
     
+    tcp_reconnect_t reconnect = TCP_RECONNECT_INIT;
+    uint64_t metrics_due_us = metrics_now_us() + METRICS_EXPORT_INTERVAL_MS * 1000ull;
+    
     while (running) {
-        // Tentar conectar ao servidor central
+        // Conexão sem bloquear: backoff com jitter entre tentativas, e cada
+        // volta do laço espera no máximo TCP_RECONNECT_POLL_MS
         if (central_socket < 0) {
-            LOG_INFO("TCP", "Tentando conectar ao servidor central...");
-            central_socket = tcp_client_connect(SERVER_CENTRAL_IP, SERVER_CENTRAL_PORT);
+            int sock = tcp_client_reconnect(&reconnect, SERVER_CENTRAL_IP, SERVER_CENTRAL_PORT,
+                                            TCP_RECONNECT_POLL_MS);
+            if (sock < 0) continue;
             
-            if (central_socket >= 0) {
-                LOG_INFO("TCP", "Conectado ao servidor central");
-            } else {
-                LOG_WARN("TCP", "Falha ao conectar - tentando novamente em 5s");
-                sleep(5);
-                continue;
-            }
+            LOG_INFO("TCP", "Conectado ao servidor central");
+            replay_offline_queue(sock);
+            
+            // Snapshot pendente, ou heartbeat que confirma a sequência atual
+            send_status_to_central(NULL);
+        }
+        
+        // Heartbeat (delta vazio) só com a conexão ociosa: qualquer envio já
+        // mostra à central que o andar está vivo
+        int idle = tcp_idle_ms(central_socket);
+        if (idle >= TCP_HEARTBEAT_INTERVAL_MS) {
+            replay_offline_queue(central_socket);
+            send_status_to_central(NULL);
+            idle = 0;
         }
         
-        // Enviar heartbeat periódico
-        send_status_to_central();
+        uint64_t now_us = metrics_now_us();
+        if (now_us >= metrics_due_us) {
+            send_metrics_to_central();
+            metrics_due_us = now_us + METRICS_EXPORT_INTERVAL_MS * 1000ull;
+        }
+        
+        // Aguardar mensagens da central até o próximo heartbeat
+        system_message_t cmd;
+        int ret = tcp_wait_message(central_socket, &cmd, TCP_HEARTBEAT_INTERVAL_MS - idle);
+        if (ret < 0) {
+            LOG_WARN("TCP", "Conexão com a central perdida");
+            disconnect_from_central();
+        } else if (ret > 0 && cmd.type == MSG_TYPE_SYSTEM_STATUS) {
+            // Central detectou lacuna na sequência de deltas
+            LOG_INFO("TCP", "Central solicitou ressincronização");
+            request_snapshot();
+            send_status_to_central(NULL);
+        } else if (ret > 0 && (cmd.type == MSG_TYPE_ENTRY_OK || cmd.type == MSG_TYPE_EXIT_OK)) {
+            // Resposta a um pedido do fluxo de entrada/saída
+            vehicle_flow_on_reply(&cmd);
+        } else if (ret > 0 && cmd.type == MSG_TYPE_LOG_LEVEL) {
+            // Central alterou o nível de log de um módulo
+            logger_set_module_level(cmd.data.log_level.module, cmd.data.log_level.level);
+        }
         
-        sleep(2);
+        if (ret > 0) {
+            system_message_release(&cmd);
+        }
     }
     
+    tcp_client_reconnect_abort(&reconnect);
+    
     LOG_INFO("THREAD", "Thread TCP cliente finalizada");
     return NULL;
 }
 
 // =============================================================================
-// FUNÇÃO PRINCIPAL
+// MÓDULO
 // =============================================================================
 
-int main(void) {
-    signal(SIGINT, handle_signal);
-    signal(SIGTERM, handle_signal);
-    
-    // Inicializar logger
-    if (logger_init(LOG_DIR) != 0) {
-        fprintf(stderr, "Falha ao iniciar logger\n");
-        return 1;
-    }
-    logger_set_level(LOG_LEVEL_INFO);
+static int terreo_start(void* context) {
+    (void)context;
     
     LOG_INFO("MAIN", "═══════════════════════════════════════════════════");
     LOG_INFO("MAIN", "  SERVIDOR TÉRREO - Sistema de Estacionamento");
     LOG_INFO("MAIN", "  Versão: %s", SYSTEM_VERSION);
     LOG_INFO("MAIN", "═══════════════════════════════════════════════════");
     
+    running = true;
     stats.start_time = time(NULL);
     
-    // Inicializar GPIO
-    if (gpio_init() != 0) {
-        LOG_ERROR("MAIN", "Falha ao inicializar GPIO");
-#ifndef MOCK_BUILD
-        return 1;
-#else
-        LOG_WARN("MAIN", "Continuando em modo MOCK");
-#endif
-    }
+    // Inicializar lógica de estacionamento
+    // Estado já iniciado por server_run; a varredura só escreve este andar
+    const server_store_t* store = server_store();
+    g_parking_status = store->status;
+    status_mutex = store->mutex;
+    g_status_snapshot = store->snapshot;
     
-    // Inicializar sistema de cancelas
-    if (gate_system_init() != 0) {
-        LOG_ERROR("MAIN", "Falha ao inicializar sistema de cancelas");
+    // Fluxo de entrada/saída: presença -> placa -> central -> cancela
+    if (vehicle_flow_init(send_vehicle_request, defer_vehicle_request, on_vehicle_done) != 0) {
+        LOG_ERROR("MAIN", "Falha ao inicializar fluxo de veículos");
     }
     
-    // Inicializar lógica de estacionamento
-    parking_init(&g_parking_status);
-    
     // Criar threads
-    pthread_t thread_gpio_scan;
-    pthread_t thread_tcp;
-    
     pthread_create(&thread_gpio_scan, NULL, gpio_scan_thread, NULL);
     pthread_create(&thread_tcp, NULL, tcp_client_thread, NULL);
     
     LOG_INFO("MAIN", "Todas as threads iniciadas - sistema operacional");
+    return 0;
+}
+
+static void terreo_stop(void* context) {
+    (void)context;
     
-    // Loop principal - apenas aguarda sinal de término
-    while (running) {
-        sleep(1);
-    }
-    
-    LOG_INFO("MAIN", "Iniciando shutdown...");
+    running = false;
     
     // Aguardar threads finalizarem
     pthread_join(thread_gpio_scan, NULL);
     pthread_join(thread_tcp, NULL);
+    vehicle_flow_cleanup();
     
     // Exibir estatísticas finais
     time_t uptime = time(NULL) - stats.start_time;
@@ -208,18 +429,40 @@ int main(void) {
     LOG_INFO("MAIN", "  Veículos entrada: %u", stats.vehicles_entered);
     LOG_INFO("MAIN", "  Veículos saída: %u", stats.vehicles_exited);
     LOG_INFO("MAIN", "  Operações de cancela: %u", stats.gate_operations);
+    for (int dir = VEHICLE_FLOW_ENTRY; dir <= VEHICLE_FLOW_EXIT; dir++) {
+        vehicle_flow_stats_t flow;
+        vehicle_flow_get_stats((vehicle_flow_dir_t)dir, &flow);
+        LOG_INFO("MAIN", "  Cancela de %s: p50 %.1f ms, p95 %.1f ms, p99 %.1f ms "
+                 "(%u amostras, %u antecipadas, %u recusadas)",
+                 dir == VEHICLE_FLOW_ENTRY ? "entrada" : "saída",
+                 flow.gate_p50_ms, flow.gate_p95_ms, flow.gate_p99_ms,
+                 flow.samples, flow.pre_opened, flow.denied);
+    }
     LOG_INFO("MAIN", "═══════════════════════════════════════════════════");
     
-    // Cleanup
     if (central_socket >= 0) {
-        tcp_close_connection(central_socket);
+        disconnect_from_central();
     }
     
-    gate_system_cleanup();
-    gpio_cleanup();
-    logger_cleanup();
-    
     LOG_INFO("MAIN", "Servidor térreo finalizado");
-    
-    return 0;
-}
\ No newline at end of file
+}
+
+const server_module_t servidor_terreo_module = {
+    .name = "térreo",
+    .uses = SERVER_USES_GPIO | SERVER_USES_GATES | SERVER_USES_MODBUS,
+    .floor = FLOOR_TERREO,
+    .start = terreo_start,
+    .stop = terreo_stop,
+    .console = NULL,
+};
+
+// =============================================================================
+// FUNÇÃO PRINCIPAL
+// =============================================================================
+
+#ifndef PARKING_SINGLE_PROCESS
+int main(void) {
+    const server_module_t* modules[] = { &servidor_terreo_module };
+    return server_run(modules, 1);
+}
+#endif
\ No newline at end of file
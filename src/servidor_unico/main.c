@@ -0,0 +1,35 @@
+/**
+ * @file servidor_unico/main.c
+ * @brief Central e todos os andares do site.conf num só processo (placa única)
+ *
+ * Cada servidor roda como módulo com as suas threads; logger, GPIO,
+ * cancelas, MODBUS e detector de passagem são inicializados uma vez. Os
+ * andares conectam à central pela mesma API de sockets, que aqui entrega
+ * as mensagens por filas em memória em vez do loopback.
+ */
+
+#include "parking_system.h"
+#include "server_module.h"
+#include "site_config.h"
+
+// =============================================================================
+// FUNÇÃO PRINCIPAL
+// =============================================================================
+
+int main(void) {
+    // Topologia antes da lista: um servidor de andar por andar do site.conf
+    if (server_init() != 0) {
+        return 1;
+    }
+
+    // Central primeiro: os andares já encontram o listener ao conectar
+    const server_module_t* modules[MAX_FLOORS + 1];
+    int count = 0;
+    modules[count++] = &servidor_central_module;
+    modules[count++] = &servidor_terreo_module;
+    for (int floor = FLOOR_ANDAR1; floor < site_floor_count(); floor++) {
+        modules[count++] = servidor_andar_module((floor_id_t)floor);
+    }
+
+    return server_run(modules, count);
+}